@@ -0,0 +1,605 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_AirLibBenchmarks_hpp
+#define msr_airlib_AirLibBenchmarks_hpp
+
+#include "common/Benchmark.hpp"
+#include "common/VectorMath.hpp"
+#include "common/EarthUtils.hpp"
+#include "common/GeodeticConverter.hpp"
+#include "common/DelayLine.hpp"
+#include "common/FirstOrderFilter.hpp"
+#include "physics/FastPhysicsEngine.hpp"
+#include "physics/PhysicsBody.hpp"
+#include "physics/Environment.hpp"
+#include "vehicles/Rotor.hpp"
+#include "safety/ObstacleMap.hpp"
+#include "safety/DepthObstacleMapper.hpp"
+#include "safety/SafetyEval.hpp"
+#include "safety/CubeGeoFence.hpp"
+#include "safety/ReciprocalAvoidance.hpp"
+#include "controllers/MpcController.hpp"
+
+#ifndef AIRLIB_NO_RPC
+#include "rpc/RpcLibAdapators.hpp"
+
+#ifndef RPCLIB_MSGPACK
+#define RPCLIB_MSGPACK clmdep_msgpack
+#endif // !RPCLIB_MSGPACK
+#endif
+
+namespace msr { namespace airlib {
+
+/*
+    Benchmark cases for core AirLib math and models. Inputs change on every
+    call so results can't be folded in to constants. Each case owns its state
+    through shared_ptr captured by the operation, so the Benchmark object can
+    outlive this function.
+*/
+class AirLibBenchmarks {
+public:
+    static void addAll(Benchmark& benchmark)
+    {
+        addVectorMath(benchmark);
+        addEarthUtils(benchmark);
+        addPhysics(benchmark);
+        addSafety(benchmark);
+        addDelayLine(benchmark);
+        addMpc(benchmark);
+#ifndef AIRLIB_NO_RPC
+        addRpcPacking(benchmark);
+#endif
+    }
+
+    static void addVectorMath(Benchmark& benchmark)
+    {
+        auto angle = std::make_shared<real_T>(0.0f);
+
+        benchmark.add("VectorMath.rotateVector", [angle]() {
+            *angle += 0.001f;
+            Quaternionr q = VectorMath::toQuaternion(0.1f, 0.2f, *angle);
+            Benchmark::doNotOptimize(VectorMath::rotateVector(Vector3r(1, 2, 3), q, true));
+        });
+        benchmark.add("VectorMath.transformToBodyFrame", [angle]() {
+            *angle += 0.001f;
+            Quaternionr q = VectorMath::toQuaternion(0.1f, 0.2f, *angle);
+            Benchmark::doNotOptimize(VectorMath::transformToBodyFrame(Vector3r(1, 2, 3), q, true));
+        });
+        benchmark.add("VectorMath.toEulerianAngle", [angle]() {
+            *angle += 0.001f;
+            Quaternionr q(std::cos(*angle), std::sin(*angle), 0.1f, 0.2f);
+            real_T pitch, roll, yaw;
+            VectorMath::toEulerianAngle(q, pitch, roll, yaw);
+            Benchmark::doNotOptimize(pitch + roll + yaw);
+        });
+        benchmark.add("VectorMath.toQuaternion", [angle]() {
+            *angle += 0.001f;
+            Benchmark::doNotOptimize(VectorMath::toQuaternion(*angle, 0.2f, 0.3f));
+        });
+    }
+
+    static void addEarthUtils(Benchmark& benchmark)
+    {
+        auto altitude = std::make_shared<real_T>(0.0f);
+        benchmark.add("EarthUtils.atmosphere", [altitude]() {
+            *altitude = *altitude > 1000 ? 0 : *altitude + 0.1f;
+            real_T pressure = EarthUtils::getStandardPressure(*altitude);
+            real_T density = EarthUtils::getAirDensity(*altitude);
+            Benchmark::doNotOptimize(pressure + density);
+        });
+
+        auto geo_point = std::make_shared<GeoPoint>(47.641468, -122.140165, 122);
+        benchmark.add("EarthUtils.getMagField", [geo_point]() {
+            geo_point->longitude = geo_point->longitude > -121 ? -123 : geo_point->longitude + 1E-4;
+            Benchmark::doNotOptimize(EarthUtils::getMagField(*geo_point));
+        });
+
+        auto home = std::make_shared<EarthUtils::HomeGeoPoint>(*geo_point);
+        auto ned = std::make_shared<Vector3r>(0.0f, 0.0f, 0.0f);
+        benchmark.add("EarthUtils.nedToGeodetic", [home, ned]() {
+            ned->x() = ned->x() > 1000 ? 0 : ned->x() + 0.1f;
+            Benchmark::doNotOptimize(EarthUtils::nedToGeodetic(*ned, *home));
+        });
+
+        //same track converted point by point and with batch API
+        auto track = std::make_shared<GeodeticCase>();
+        if (!track->checkBatch())
+            Utils::logError("GeodeticConverter batch check failed: batch results differ from scalar conversions");
+        benchmark.add("GeodeticConverter.ned2Geodetic", [track]() {
+            track->move();
+            track->ned2Geodetic();
+            Benchmark::doNotOptimize(track->getLatitude());
+        });
+        benchmark.add("GeodeticConverter.ned2GeodeticBatch", [track]() {
+            track->move();
+            track->ned2GeodeticBatch();
+            Benchmark::doNotOptimize(track->getLatitude());
+        });
+        benchmark.add("GeodeticConverter.geodetic2Ned", [track]() {
+            track->move();
+            track->geodetic2Ned();
+            Benchmark::doNotOptimize(track->getNorth());
+        });
+        benchmark.add("GeodeticConverter.geodetic2NedBatch", [track]() {
+            track->move();
+            track->geodetic2NedBatch();
+            Benchmark::doNotOptimize(track->getNorth());
+        });
+    }
+
+    static void addPhysics(Benchmark& benchmark)
+    {
+        auto filter = std::make_shared<FirstOrderFilter<real_T>>(0.005f, 0.0f, 0.0f);
+        benchmark.add("FirstOrderFilter.update", [filter]() {
+            filter->setInput(filter->getInput() > 1 ? 0 : filter->getInput() + 0.01f);
+            filter->update();
+            Benchmark::doNotOptimize(filter->getOutput());
+        });
+
+        auto env = std::make_shared<Environment>(Environment::State(Vector3r::Zero(), GeoPoint(47.641468, -122.140165, 122), 0));
+        auto rotor = std::make_shared<Rotor>(Vector3r(0.2f, 0.2f, 0), Vector3r(0, 0, -1),
+            RotorTurningDirection::RotorTurningDirectionCW, RotorParams(), env.get(), 0);
+        //cases keep environment alive, rotor and body only point to it
+        benchmark.add("Rotor.update", [rotor, env]() {
+            rotor->setControlSignal(rotor->getOutput().control_signal_input > 0.9f ? 0.1f : rotor->getOutput().control_signal_input + 0.01f);
+            rotor->update();
+            Benchmark::doNotOptimize(rotor->getOutput());
+        });
+
+        auto body = std::make_shared<QuadBody>(env.get());
+        auto engine = std::make_shared<FastPhysicsEngine>();
+        engine->insert(body.get());
+        benchmark.add("FastPhysicsEngine.step", [engine, body, env]() {
+            body->update();
+            engine->update();
+            Benchmark::doNotOptimize(body->getKinematics());
+        });
+
+        //body dropped on a static floor box with continuous collision, dropped again once it rests
+        auto landing = std::make_shared<LandingCase>();
+        if (!landing->checkLanding())
+            Utils::logError("FastPhysicsEngine landing check failed: body does not come to rest on static floor");
+        benchmark.add("FastPhysicsEngine.landOnStaticFloor", [landing]() {
+            landing->step();
+            Benchmark::doNotOptimize(landing->getBody().getKinematics());
+        });
+    }
+
+    static void addSafety(Benchmark& benchmark)
+    {
+        auto obs_map = std::make_shared<ObstacleMap>(16);
+        for (int tick = 0; tick < 16; tick += 3)
+            obs_map->update(5.0f + tick, tick, 1, 0.9f);
+
+        auto tick = std::make_shared<int>(0);
+        benchmark.add("ObstacleMap.hasObstacle", [obs_map, tick]() {
+            *tick = (*tick + 1) % 16;
+            Benchmark::doNotOptimize(obs_map->hasObstacle(*tick, *tick + 2));
+        });
+        benchmark.add("ObstacleMap.getClosestObstacle", [obs_map]() {
+            Benchmark::doNotOptimize(obs_map->getClosestObstacle());
+        });
+
+        //wall ahead in normalized depth image, raw 0.2 is 20 m with default depth scale
+        const int depth_width = 320, depth_height = 240;
+        auto mapper = std::make_shared<DepthObstacleMapper>(std::make_shared<ObstacleMap>(16), DepthObstacleMapper::Params());
+        auto depth = std::make_shared<vector<float>>(depth_width * depth_height, 0.2f);
+        mapper->process(depth->data(), depth_width, depth_height);
+        if (std::abs(mapper->getObstacleMap()->getClosestObstacle().distance - 20) > 0.1f)
+            Utils::logError("DepthObstacleMapper depth check failed: wall at 20 m is not mapped at 20 m");
+        auto column = std::make_shared<int>(0);
+        benchmark.add("DepthObstacleMapper.process", [mapper, depth, column]() {
+            *column = (*column + 1) % depth_width;
+            (*depth)[depth_width * depth_height / 2 + *column] = 0.1f + *column * 1E-4f;
+            mapper->process(depth->data(), depth_width, depth_height);
+            Benchmark::doNotOptimize(mapper->getObstacleMap()->getClosestObstacle());
+        });
+
+        VehicleParams params;
+        auto fence = std::make_shared<CubeGeoFence>(Vector3r(-1E3f, -1E3f, -1E3f), Vector3r(1E3f, 1E3f, 1E3f),
+            params.distance_accuracy);
+        auto safety = std::make_shared<SafetyEval>(params, fence, obs_map);
+        safety->setSafety(SafetyEval::SafetyViolationType_::All, 2, SafetyEval::ObsAvoidanceStrategy::ClosestMove,
+            VectorMath::nanVector(), Utils::nan<float>(), Utils::nan<float>(), Utils::nan<float>());
+        auto velocity_angle = std::make_shared<real_T>(0.0f);
+        benchmark.add("SafetyEval.isSafeVelocity", [safety, velocity_angle]() {
+            *velocity_angle += 0.01f;
+            Vector3r velocity(5 * std::cos(*velocity_angle), 5 * std::sin(*velocity_angle), 0);
+            Benchmark::doNotOptimize(safety->isSafeVelocity(Vector3r(0, 0, -10), velocity, Quaternionr::Identity()));
+        });
+
+        //dense swarm on a ring converging on its center, heading wobbles between calls
+        const uint agent_count = 500;
+        auto avoidance = std::make_shared<ReciprocalAvoidance>();
+        auto positions = std::make_shared<vector<Vector3r>>();
+        auto velocities = std::make_shared<vector<Vector3r>>(agent_count);
+        auto new_velocities = std::make_shared<vector<Vector3r>>();
+        for (uint i = 0; i < agent_count; ++i) {
+            real_T angle = 2 * M_PIf * i / agent_count;
+            positions->push_back(Vector3r(100 * std::cos(angle), 100 * std::sin(angle), -10.0f - (i % 5)));
+        }
+        auto heading = std::make_shared<real_T>(0.0f);
+        benchmark.add("ReciprocalAvoidance.compute500", [avoidance, positions, velocities, new_velocities, heading]() {
+            *heading += 0.01f;
+            for (uint i = 0; i < positions->size(); ++i) {
+                real_T angle = 2 * M_PIf * i / positions->size() + 0.2f * std::sin(*heading);
+                (*velocities)[i] = Vector3r(-5 * std::cos(angle), -5 * std::sin(angle), 0);
+            }
+            avoidance->compute(*positions, *velocities, *velocities, *new_velocities);
+            Benchmark::doNotOptimize(new_velocities->front());
+        });
+    }
+
+    static void addDelayLine(Benchmark& benchmark)
+    {
+        auto delay_line = std::make_shared<DelayLine<real_T>>(0.0);
+        auto value = std::make_shared<real_T>(0.0f);
+        benchmark.add("DelayLine.pushAndUpdate", [delay_line, value]() {
+            *value += 1;
+            delay_line->push_back(*value);
+            delay_line->update();
+            Benchmark::doNotOptimize(delay_line->getOutput());
+        });
+    }
+
+    static void addMpc(Benchmark& benchmark)
+    {
+        auto mpc = std::make_shared<MpcController>(MpcController::Params(), 0);
+        auto time = std::make_shared<real_T>(0.0f);
+        benchmark.add("MpcController.solve", [mpc, time]() {
+            //circle reference, vehicle state lags slightly behind it
+            *time += 0.01f;
+            Vector3r reference[MpcController::Horizon];
+            for (int k = 0; k < MpcController::Horizon; ++k) {
+                real_T angle = 0.5f * (*time + (k + 1) * mpc->getParams().dt);
+                reference[k] = Vector3r(5 * std::cos(angle), 5 * std::sin(angle), -5);
+            }
+            Vector3r position(5 * std::cos(0.5f * *time - 0.01f), 5 * std::sin(0.5f * *time - 0.01f), -5);
+            Benchmark::doNotOptimize(mpc->solve(position, Vector3r(0, 2.5f, 0), reference));
+        });
+    }
+
+#ifndef AIRLIB_NO_RPC
+    static void addRpcPacking(Benchmark& benchmark)
+    {
+        typedef msr::airlib_rpclib::RpcLibAdapators RpcLibAdapators;
+        auto buffer = std::make_shared<RPCLIB_MSGPACK::sbuffer>();
+        auto x = std::make_shared<real_T>(0.0f);
+
+        benchmark.add("RpcLibAdapators.packVector3r", [buffer, x]() {
+            *x += 1;
+            buffer->clear();
+            RPCLIB_MSGPACK::pack(*buffer, RpcLibAdapators::Vector3r(Vector3r(*x, 2, 3)));
+            Benchmark::doNotOptimize(buffer->size());
+        });
+        benchmark.add("RpcLibAdapators.packQuaternionr", [buffer, x]() {
+            *x += 1;
+            buffer->clear();
+            RPCLIB_MSGPACK::pack(*buffer, RpcLibAdapators::Quaternionr(Quaternionr(1, *x, 0, 0)));
+            Benchmark::doNotOptimize(buffer->size());
+        });
+        benchmark.add("RpcLibAdapators.packGeoPoint", [buffer, x]() {
+            *x += 1;
+            buffer->clear();
+            RPCLIB_MSGPACK::pack(*buffer, RpcLibAdapators::GeoPoint(GeoPoint(47.6, -122.1, *x)));
+            Benchmark::doNotOptimize(buffer->size());
+        });
+    }
+#endif
+
+private:
+    //quad X body with constant rotor signals, enough to exercise a full physics step
+    class QuadBody : public PhysicsBody {
+    public:
+        QuadBody(Environment* environment)
+        {
+            Matrix3x3r inertia = Matrix3x3r::Zero();
+            inertia.diagonal() = Vector3r(0.01f, 0.01f, 0.02f);
+
+            Kinematics::State initial = Kinematics::State::zero();
+            initial.pose.position = Vector3r(0, 0, -10);
+            PhysicsBody::initialize(1, inertia, initial, environment);
+
+            const real_T arm = 0.18f;
+            const RotorTurningDirection directions[] = { RotorTurningDirection::RotorTurningDirectionCCW,
+                RotorTurningDirection::RotorTurningDirectionCCW, RotorTurningDirection::RotorTurningDirectionCW,
+                RotorTurningDirection::RotorTurningDirectionCW };
+            const Vector3r positions[] = { Vector3r(arm, arm, 0), Vector3r(-arm, -arm, 0), Vector3r(arm, -arm, 0), Vector3r(-arm, arm, 0) };
+            for (uint i = 0; i < 4; ++i)
+                rotors_[i].initialize(positions[i], Vector3r(0, 0, -1), directions[i], RotorParams(), environment, i);
+        }
+
+        virtual void kinematicsUpdated() override
+        {
+            for (auto& rotor : rotors_)
+                rotor.setControlSignal(0.6f);
+        }
+        virtual Vector3r getLinearDragFactor() const override
+        {
+            return Vector3r(0.1f, 0.1f, 0.1f);
+        }
+        virtual Vector3r getAngularDragFactor() const override
+        {
+            return Vector3r(0.01f, 0.01f, 0.01f);
+        }
+        virtual uint vertexCount() const override
+        {
+            return 4;
+        }
+        virtual PhysicsBodyVertex& getVertex(uint index) override
+        {
+            return rotors_[index];
+        }
+        virtual const PhysicsBodyVertex& getVertex(uint index) const override
+        {
+            return rotors_[index];
+        }
+        virtual real_T getRestitution() const override
+        {
+            return 0.55f;
+        }
+        virtual real_T getFriction() const override
+        {
+            return 0.5f;
+        }
+
+    private:
+        Rotor rotors_[4];
+    };
+
+    //track of points around home converted between NED and geodetic, each case converts all points
+    class GeodeticCase {
+    public:
+        static constexpr size_t PointCount = 256;
+
+        GeodeticCase()
+            : converter_(47.641468, -122.140165, 122)
+        {
+            for (size_t i = 0; i < PointCount; ++i) {
+                north_[i] = 2.5 * i;
+                east_[i] = 3.0 * (i % 32) - 50;
+                //multiples of 0.25 so scalar API, which takes down and altitude as float, sees same inputs
+                down_[i] = -0.25 * (i % 64);
+            }
+            //geodetic inputs are same track
+            ned2Geodetic();
+            std::copy(result_latitude_, result_latitude_ + PointCount, latitude_);
+            std::copy(result_longitude_, result_longitude_ + PointCount, longitude_);
+            std::copy(result_altitude_, result_altitude_ + PointCount, altitude_);
+        }
+
+        //shifts track north so inputs change on every call, stays within 10 m of start
+        void move()
+        {
+            double shift = ++step_count_ % 1000 == 0 ? -9.99 : 0.01;
+            for (size_t i = 0; i < PointCount; ++i) {
+                north_[i] += shift;
+                latitude_[i] += shift * 1E-5;
+            }
+        }
+
+        void ned2Geodetic()
+        {
+            for (size_t i = 0; i < PointCount; ++i) {
+                float altitude;
+                converter_.ned2Geodetic(north_[i], east_[i], static_cast<float>(down_[i]), &result_latitude_[i], &result_longitude_[i], &altitude);
+                result_altitude_[i] = altitude;
+            }
+        }
+        void ned2GeodeticBatch()
+        {
+            converter_.ned2GeodeticBatch(north_, east_, down_, PointCount, result_latitude_, result_longitude_, result_altitude_);
+        }
+        void geodetic2Ned()
+        {
+            for (size_t i = 0; i < PointCount; ++i)
+                converter_.geodetic2Ned(latitude_[i], longitude_[i], static_cast<float>(altitude_[i]),
+                    &result_north_[i], &result_east_[i], &result_down_[i]);
+        }
+        void geodetic2NedBatch()
+        {
+            converter_.geodetic2NedBatch(latitude_, longitude_, altitude_, PointCount, result_north_, result_east_, result_down_);
+        }
+
+        //scalar and batch conversions of same inputs must agree far below GPS accuracy
+        bool checkBatch()
+        {
+            ned2Geodetic();
+            std::vector<double> latitude(result_latitude_, result_latitude_ + PointCount);
+            std::vector<double> longitude(result_longitude_, result_longitude_ + PointCount);
+            std::vector<double> altitude(result_altitude_, result_altitude_ + PointCount);
+            ned2GeodeticBatch();
+            bool is_match = true;
+            for (size_t i = 0; i < PointCount; ++i) {
+                is_match = is_match && std::abs(result_latitude_[i] - latitude[i]) < 1E-9
+                    && std::abs(result_longitude_[i] - longitude[i]) < 1E-9 && std::abs(result_altitude_[i] - altitude[i]) < 1E-3;
+            }
+
+            geodetic2Ned();
+            std::vector<double> north(result_north_, result_north_ + PointCount);
+            std::vector<double> east(result_east_, result_east_ + PointCount);
+            std::vector<double> down(result_down_, result_down_ + PointCount);
+            geodetic2NedBatch();
+            for (size_t i = 0; i < PointCount; ++i) {
+                is_match = is_match && std::abs(result_north_[i] - north[i]) < 1E-6
+                    && std::abs(result_east_[i] - east[i]) < 1E-6 && std::abs(result_down_[i] - down[i]) < 1E-6;
+            }
+            return is_match;
+        }
+
+        double getLatitude() const
+        {
+            return result_latitude_[step_count_ % PointCount];
+        }
+        double getNorth() const
+        {
+            return result_north_[step_count_ % PointCount];
+        }
+
+    private:
+        GeodeticConverter converter_;
+        double north_[PointCount], east_[PointCount], down_[PointCount];
+        double latitude_[PointCount], longitude_[PointCount], altitude_[PointCount];
+        double result_north_[PointCount], result_east_[PointCount], result_down_[PointCount];
+        double result_latitude_[PointCount], result_longitude_[PointCount], result_altitude_[PointCount];
+        uint step_count_ = 0;
+    };
+
+    //clock that only moves when stepped, so physics results don't depend on timing of the benchmark
+    class SteppedClock : public ClockBase {
+    public:
+        virtual TTimePoint nowNanos() override
+        {
+            return now_;
+        }
+        virtual TTimeDelta fromWallDelta(TTimeDelta dt) override
+        {
+            return dt;
+        }
+        virtual TTimeDelta toWallDelta(TTimeDelta dt) override
+        {
+            return dt;
+        }
+        void step(TTimeDelta dt)
+        {
+            now_ += static_cast<TTimePoint>(dt * 1E9);
+        }
+
+    private:
+        TTimePoint now_ = 0;
+    };
+
+    class SteppedPhysicsEngine : public FastPhysicsEngine {
+    public:
+        SteppedPhysicsEngine(SteppedClock* clock)
+            : clock_(clock)
+        {
+        }
+        virtual ClockBase* clock() override
+        {
+            return clock_;
+        }
+
+    private:
+        SteppedClock* clock_;
+    };
+
+    //unpowered body with propeller sized collision radius but small static radius, like MultiRotor
+    class FallingBody : public PhysicsBody {
+    public:
+        FallingBody(Environment* environment)
+        {
+            Matrix3x3r inertia = Matrix3x3r::Zero();
+            inertia.diagonal() = Vector3r(0.01f, 0.01f, 0.02f);
+            PhysicsBody::initialize(1, inertia, Kinematics::State::zero(), environment);
+        }
+
+        virtual void kinematicsUpdated() override
+        {
+        }
+        virtual Vector3r getLinearDragFactor() const override
+        {
+            return Vector3r::Zero();
+        }
+        virtual Vector3r getAngularDragFactor() const override
+        {
+            return Vector3r::Zero();
+        }
+        virtual uint vertexCount() const override
+        {
+            return 0;
+        }
+        virtual PhysicsBodyVertex& getVertex(uint index) override
+        {
+            unused(index);
+            throw std::out_of_range("FallingBody has no vertices");
+        }
+        virtual const PhysicsBodyVertex& getVertex(uint index) const override
+        {
+            unused(index);
+            throw std::out_of_range("FallingBody has no vertices");
+        }
+        virtual real_T getRestitution() const override
+        {
+            return 0.55f;
+        }
+        virtual real_T getFriction() const override
+        {
+            return 0.5f;
+        }
+        virtual real_T getCollisionRadius() const override
+        {
+            return 0.35f;
+        }
+        virtual real_T getStaticCollisionRadius() const override
+        {
+            return 0.02f;
+        }
+    };
+
+    //floor box with its top at z = 0, environment ground is far below so only the box can stop the body
+    class LandingCase {
+    public:
+        static constexpr real_T DropHeight = 1;
+        static constexpr TTimeDelta Period = 0.003;
+        static constexpr uint RestSteps = 1000;
+
+        LandingCase()
+            : environment_(Environment::State(Vector3r::Zero(), GeoPoint(47.641468, -122.140165, 122), 100)),
+            body_(&environment_), engine_(&clock_)
+        {
+            auto floor = std::make_shared<CollisionWorld>();
+            floor->addBox(Vector3r(0, 0, 0.5f), Quaternionr::Identity(), Vector3r(10, 10, 0.5f));
+            engine_.setContinuousCollision(true, floor);
+            engine_.insert(&body_);
+            drop();
+        }
+
+        void drop()
+        {
+            Kinematics::State state = Kinematics::State::zero();
+            state.pose.position = Vector3r(0, 0, -DropHeight);
+            body_.setKinematics(state);
+            step_count_ = 0;
+        }
+
+        void step()
+        {
+            if (step_count_ >= RestSteps)
+                drop();
+            clock_.step(Period);
+            body_.update();
+            engine_.update();
+            ++step_count_;
+        }
+
+        //drops once, body must end up resting on the floor at its static radius
+        bool checkLanding()
+        {
+            drop();
+            for (uint i = 0; i < RestSteps; ++i)
+                step();
+            const Kinematics::State& state = body_.getKinematics();
+            real_T rest_z = -body_.getStaticCollisionRadius();
+            bool is_landed = std::abs(state.pose.position.z() - rest_z) < 0.01f && std::abs(state.twist.linear.z()) < 0.05f;
+            drop();
+            return is_landed;
+        }
+
+        const PhysicsBody& getBody() const
+        {
+            return body_;
+        }
+
+    private:
+        Environment environment_;
+        FallingBody body_;
+        SteppedClock clock_;
+        SteppedPhysicsEngine engine_;
+        uint step_count_;
+    };
+};
+
+}} //namespace
+#endif
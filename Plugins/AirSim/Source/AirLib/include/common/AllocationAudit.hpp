@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_AllocationAudit_hpp
+#define msr_airlib_AllocationAudit_hpp
+
+#include <cstdint>
+
+namespace msr { namespace airlib {
+
+/*
+    Counts heap allocations made by the current thread so hot paths such as
+    physics ticks can be checked for being allocation free. Counting is done
+    by global operator new replacements in AllocationAudit.cpp which are only
+    compiled when AIRLIB_ALLOCATION_AUDIT is defined. Unreal already replaces
+    operator new, so audit mode is meant for standalone AirLib builds; in
+    other builds isEnabled() is false and all counts stay 0.
+*/
+class AllocationAudit {
+public:
+    //counts allocations made on this thread during lifetime of the object
+    class Scope {
+    public:
+        Scope()
+            : start_(getCount())
+        {
+        }
+        uint64_t getAllocations() const
+        {
+            return getCount() - start_;
+        }
+    private:
+        uint64_t start_;
+    };
+
+public:
+    static bool isEnabled()
+    {
+#ifdef AIRLIB_ALLOCATION_AUDIT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //total allocations made by this thread so far
+    static uint64_t getCount()
+    {
+        return counter();
+    }
+
+    //called by operator new replacements
+    static void recordAllocation()
+    {
+        ++counter();
+    }
+
+private:
+    static uint64_t& counter()
+    {
+        static thread_local uint64_t count = 0;
+        return count;
+    }
+};
+
+}} //namespace
+#endif
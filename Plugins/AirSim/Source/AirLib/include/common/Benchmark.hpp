@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_Benchmark_hpp
+#define msr_airlib_Benchmark_hpp
+
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/AllocationAudit.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Minimal micro-benchmark harness. Each case is a function that performs
+    one operation; harness first finds how many iterations fill min_time_sec
+    and then times that many calls on steady clock. Results are ns per op
+    and heap allocations per op. Allocations are only counted when built
+    with AIRLIB_ALLOCATION_AUDIT (see AllocationAudit), otherwise they are
+    reported as unknown. JSON output is meant to be stored per run so
+    performance changes can be compared against a baseline.
+*/
+class Benchmark {
+public: //types
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void()> Operation;
+
+    struct Result {
+        string name;
+        uint64_t iterations;
+        double ns_per_op;
+        double allocs_per_op;   //negative if allocations were not counted
+    };
+
+public:
+    Benchmark(double min_time_sec = 0.2)
+        : min_time_sec_(min_time_sec)
+    {
+    }
+
+    void add(const string& name, const Operation& operation)
+    {
+        cases_.push_back(Case{ name, operation });
+    }
+
+    //runs cases whose name contains filter, empty filter runs all
+    const vector<Result>& run(const string& filter = "")
+    {
+        results_.clear();
+        for (const auto& bench_case : cases_) {
+            if (filter.empty() || bench_case.name.find(filter) != string::npos)
+                results_.push_back(runCase(bench_case));
+        }
+        return results_;
+    }
+
+    const vector<Result>& getResults() const
+    {
+        return results_;
+    }
+
+    string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        for (const auto& result : results_) {
+            ss << std::left << std::setw(40) << result.name << std::right
+                << std::setw(12) << result.ns_per_op << " ns/op";
+            if (result.allocs_per_op >= 0)
+                ss << std::setw(10) << std::setprecision(2) << result.allocs_per_op << std::setprecision(1) << " allocs/op";
+            else
+                ss << "         ? allocs/op";
+            ss << std::setw(12) << result.iterations << " iterations" << std::endl;
+        }
+        return ss.str();
+    }
+
+    string toJson() const
+    {
+        std::ostringstream ss;
+        ss << std::setprecision(6);
+        ss << "{" << std::endl;
+        ss << "  \"timestamp\": " << Utils::getTimeSinceEpochNanos() / 1000000000ULL << "," << std::endl;
+        ss << "  \"allocation_audit\": " << (AllocationAudit::isEnabled() ? "true" : "false") << "," << std::endl;
+        ss << "  \"min_time_sec\": " << min_time_sec_ << "," << std::endl;
+        ss << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const Result& result = results_[i];
+            ss << (i == 0 ? "" : ",") << std::endl;
+            ss << "    { \"name\": \"" << escapeJson(result.name) << "\", \"iterations\": " << result.iterations
+                << ", \"ns_per_op\": " << result.ns_per_op << ", \"allocs_per_op\": ";
+            if (result.allocs_per_op >= 0)
+                ss << result.allocs_per_op;
+            else
+                ss << "null";
+            ss << " }";
+        }
+        ss << std::endl << "  ]" << std::endl << "}" << std::endl;
+        return ss.str();
+    }
+
+    //keeps compiler from optimizing away computation whose result is otherwise unused
+    template<typename T>
+    static void doNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+private:
+    struct Case {
+        string name;
+        Operation operation;
+    };
+
+    Result runCase(const Case& bench_case) const
+    {
+        //warm up caches and lazily initialized state before measuring
+        bench_case.operation();
+
+        //grow iterations until timing is long enough to extrapolate from
+        uint64_t iterations = 1;
+        double elapsed = 0;
+        while (true) {
+            elapsed = timeIterations(bench_case, iterations, nullptr);
+            if (elapsed >= min_time_sec_ / 10 || iterations >= (1ULL << 40))
+                break;
+            iterations *= 2;
+        }
+        if (elapsed < min_time_sec_)
+            iterations = static_cast<uint64_t>(iterations * min_time_sec_ / std::max(elapsed, 1E-9)) + 1;
+
+        uint64_t allocations = 0;
+        elapsed = timeIterations(bench_case, iterations, &allocations);
+
+        Result result;
+        result.name = bench_case.name;
+        result.iterations = iterations;
+        result.ns_per_op = elapsed * 1E9 / iterations;
+        result.allocs_per_op = AllocationAudit::isEnabled() ? static_cast<double>(allocations) / iterations : -1;
+        return result;
+    }
+
+    static double timeIterations(const Case& bench_case, uint64_t iterations, uint64_t* allocations)
+    {
+        AllocationAudit::Scope audit;
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            bench_case.operation();
+        Clock::time_point end = Clock::now();
+        if (allocations != nullptr)
+            *allocations = audit.getAllocations();
+        return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    }
+
+    static string escapeJson(const string& text)
+    {
+        string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+private:
+    double min_time_sec_;
+    vector<Case> cases_;
+    vector<Result> results_;
+};
+
+}} //namespace
+#endif
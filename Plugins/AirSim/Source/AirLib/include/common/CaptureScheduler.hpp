@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_CaptureScheduler_hpp
+#define msr_airlib_CaptureScheduler_hpp
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Decides which image streams get captured on each rendered frame. A stream
+    is one (vehicle, camera, image type) combination with its own requested
+    rate; rate of 0 means capture on every frame. Capturing render targets is
+    expensive so each frame gets a wall clock budget: due streams are captured
+    most overdue first until the budget is used up and the rest wait for the
+    next frame. At least one capture happens each frame so nothing starves.
+    In Batch mode due streams of the same camera are captured back to back.
+    Periods that pass without capture are counted as dropped frames.
+    Rates use the sim clock (same as sensors), budget uses steady clock.
+*/
+class CaptureScheduler {
+public: //types
+    enum class Mode : int {
+        RoundRobin = 0,
+        Batch = 1
+    };
+
+    struct StreamKey {
+        int vehicle_index;
+        int camera_id;
+        uint image_type;
+        int consumer;   //caller defined, lets several consumers request the same camera and image type
+
+        bool operator==(const StreamKey& other) const
+        {
+            return vehicle_index == other.vehicle_index && camera_id == other.camera_id && image_type == other.image_type
+                && consumer == other.consumer;
+        }
+    };
+
+    struct StreamStats {
+        StreamKey key;
+        real_T requested_rate;          //0 means every frame
+        real_T achieved_rate;           //captures per second over last rate window
+        uint64_t captured_count;
+        uint64_t dropped_count;
+        double mean_capture_sec;        //wall time spent in capture callback
+    };
+
+private:
+    typedef std::chrono::steady_clock WallClock;
+
+    struct Stream {
+        StreamStats stats;
+        TTimePoint next_due;
+        TTimePoint rate_window_start;
+        uint64_t rate_window_count;
+        double total_capture_sec;
+        bool is_active;
+    };
+
+public:
+    CaptureScheduler(double frame_budget_sec = 0.010, Mode mode = Mode::RoundRobin)
+    {
+        initialize(frame_budget_sec, mode);
+    }
+
+    //frame_budget_sec <= 0 means no budget, all due streams are captured
+    void initialize(double frame_budget_sec, Mode mode = Mode::RoundRobin, double rate_window_sec = 1)
+    {
+        frame_budget_sec_ = frame_budget_sec;
+        mode_ = mode;
+        rate_window_sec_ = rate_window_sec;
+        streams_.clear();
+        due_.clear();
+        last_frame_sec_ = 0;
+        last_frame_captures_ = 0;
+        last_frame_deferred_ = 0;
+    }
+
+    /*
+        Call before updating streams of the vehicle, any stream of that vehicle
+        not set again via setStream will be removed by the next removeStale().
+        This lets callers mirror requests from controllers without diffing.
+    */
+    void markStale(int vehicle_index)
+    {
+        for (auto& stream : streams_) {
+            if (stream.stats.key.vehicle_index == vehicle_index)
+                stream.is_active = false;
+        }
+    }
+
+    void setStream(const StreamKey& key, real_T rate)
+    {
+        Stream* stream = findStream(key);
+        if (stream == nullptr) {
+            streams_.push_back(Stream());
+            stream = &streams_.back();
+            stream->stats = StreamStats{ key, rate, 0, 0, 0, 0 };
+            stream->next_due = clock()->nowNanos();
+            stream->rate_window_start = stream->next_due;
+            stream->rate_window_count = 0;
+            stream->total_capture_sec = 0;
+        }
+        else if (stream->stats.requested_rate != rate) {
+            //new rate takes effect immediately
+            stream->next_due = clock()->nowNanos();
+        }
+        stream->stats.requested_rate = std::max(rate, 0.0f);
+        stream->is_active = true;
+    }
+
+    void removeStale()
+    {
+        streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+            [](const Stream& stream) { return !stream.is_active; }), streams_.end());
+    }
+
+    void removeStream(const StreamKey& key)
+    {
+        streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+            [&key](const Stream& stream) { return stream.stats.key == key; }), streams_.end());
+    }
+
+    size_t getStreamCount() const
+    {
+        return streams_.size();
+    }
+
+    /*
+        Runs captures for this frame. capture is called as bool(const StreamKey&)
+        and should return false if image could not be captured, which counts
+        as dropped frame. Returns number of successful captures.
+    */
+    template<typename CaptureFunc>
+    uint runFrame(CaptureFunc capture)
+    {
+        TTimePoint now = clock()->nowNanos();
+        WallClock::time_point frame_start = WallClock::now();
+
+        //collect due streams, reusing storage across frames
+        due_.clear();
+        for (uint i = 0; i < streams_.size(); ++i) {
+            Stream& stream = streams_[i];
+            if (now >= stream.next_due)
+                due_.push_back(i);
+        }
+        sortDue();
+
+        uint captures = 0;
+        last_frame_deferred_ = 0;
+        for (uint i : due_) {
+            Stream& stream = streams_[i];
+
+            double elapsed = toSeconds(WallClock::now() - frame_start);
+            if (captures > 0 && frame_budget_sec_ > 0 && elapsed >= frame_budget_sec_) {
+                //stays due and goes first next frame, lateness of rated streams
+                //is accounted for when they are captured
+                if (stream.stats.requested_rate == 0)
+                    ++stream.stats.dropped_count;
+                ++last_frame_deferred_;
+                continue;
+            }
+
+            WallClock::time_point capture_start = WallClock::now();
+            bool is_captured = capture(stream.stats.key);
+
+            if (is_captured) {
+                stream.total_capture_sec += toSeconds(WallClock::now() - capture_start);
+                ++captures;
+                ++stream.stats.captured_count;
+                ++stream.rate_window_count;
+                stream.stats.mean_capture_sec = stream.total_capture_sec / stream.stats.captured_count;
+            }
+            else
+                ++stream.stats.dropped_count;
+
+            advance(stream, now);
+        }
+
+        for (auto& stream : streams_)
+            updateAchievedRate(stream, now);
+
+        last_frame_captures_ = captures;
+        last_frame_sec_ = toSeconds(WallClock::now() - frame_start);
+        return captures;
+    }
+
+    void getStats(vector<StreamStats>& stats) const
+    {
+        stats.clear();
+        for (const auto& stream : streams_)
+            stats.push_back(stream.stats);
+    }
+
+    double getLastFrameSeconds() const
+    {
+        return last_frame_sec_;
+    }
+    uint getLastFrameCaptures() const
+    {
+        return last_frame_captures_;
+    }
+    uint getLastFrameDeferred() const
+    {
+        return last_frame_deferred_;
+    }
+
+    string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Capture: " << last_frame_captures_ << " this frame, " << last_frame_deferred_ << " deferred, "
+            << last_frame_sec_ * 1E3 << " ms of " << frame_budget_sec_ * 1E3 << " ms budget" << std::endl;
+        for (const auto& stream : streams_) {
+            const StreamStats& stats = stream.stats;
+            ss << "  vehicle " << stats.key.vehicle_index << " camera " << stats.key.camera_id << " type " << stats.key.image_type;
+            if (stats.key.consumer != 0)
+                ss << " consumer " << stats.key.consumer;
+            ss << ": " << stats.achieved_rate << "/" << stats.requested_rate << " Hz, dropped " << stats.dropped_count
+                << ", " << stats.mean_capture_sec * 1E3 << " ms/capture" << std::endl;
+        }
+        return ss.str();
+    }
+
+private:
+    Stream* findStream(const StreamKey& key)
+    {
+        for (auto& stream : streams_) {
+            if (stream.stats.key == key)
+                return &stream;
+        }
+        return nullptr;
+    }
+
+    void sortDue()
+    {
+        if (mode_ == Mode::Batch) {
+            //keep cameras together, within camera most overdue first
+            std::sort(due_.begin(), due_.end(), [this](uint a, uint b) {
+                const Stream& sa = streams_[a];
+                const Stream& sb = streams_[b];
+                if (sa.stats.key.vehicle_index != sb.stats.key.vehicle_index)
+                    return sa.stats.key.vehicle_index < sb.stats.key.vehicle_index;
+                if (sa.stats.key.camera_id != sb.stats.key.camera_id)
+                    return sa.stats.key.camera_id < sb.stats.key.camera_id;
+                return sa.next_due < sb.next_due;
+            });
+        }
+        else {
+            //most overdue first, this round robins among every-frame streams
+            std::stable_sort(due_.begin(), due_.end(), [this](uint a, uint b) {
+                return streams_[a].next_due < streams_[b].next_due;
+            });
+        }
+    }
+
+    void advance(Stream& stream, TTimePoint now)
+    {
+        if (stream.stats.requested_rate == 0) {
+            //every-frame streams are ordered by when they were last served
+            stream.next_due = now;
+            return;
+        }
+
+        TTimeDelta period = 1.0f / stream.stats.requested_rate;
+        TTimeDelta late = ClockBase::elapsedBetween(now, stream.next_due);
+        uint64_t missed = static_cast<uint64_t>(late / period);
+        stream.stats.dropped_count += missed;
+        stream.next_due += static_cast<TTimePoint>((missed + 1) * period * 1.0E9);
+    }
+
+    void updateAchievedRate(Stream& stream, TTimePoint now)
+    {
+        TTimeDelta window = ClockBase::elapsedBetween(now, stream.rate_window_start);
+        if (window >= rate_window_sec_) {
+            stream.stats.achieved_rate = static_cast<real_T>(stream.rate_window_count / window);
+            stream.rate_window_count = 0;
+            stream.rate_window_start = now;
+        }
+    }
+
+    static double toSeconds(WallClock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+    }
+
+    static ClockBase* clock()
+    {
+        return ClockFactory::get();
+    }
+
+private:
+    double frame_budget_sec_;
+    double rate_window_sec_;
+    Mode mode_;
+    vector<Stream> streams_;
+    vector<uint> due_;
+
+    double last_frame_sec_;
+    uint last_frame_captures_;
+    uint last_frame_deferred_;
+};
+
+}} //namespace
+#endif
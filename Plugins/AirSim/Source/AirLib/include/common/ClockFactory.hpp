@@ -4,7 +4,7 @@
 #ifndef airsim_core_ClockFactory_hpp
 #define airsim_core_ClockFactory_hpp
 
-#include "SimClock.hpp"
+#include "ScalableClock.hpp"
 
 namespace msr { namespace airlib {
 
@@ -12,9 +12,13 @@ class ClockFactory {
 public:
     static ClockBase* get()
     {
-        static SimClock clock;
-        
-        return &clock;
+        return getScalable();
+    }
+
+    //simulated seconds per wall second, set before simulation threads start
+    static void setSpeed(double speed)
+    {
+        getScalable()->setSpeed(speed);
     }
 
     //don't allow multiple instances of this class
@@ -24,6 +28,13 @@ public:
 private:
     //disallow instance creation
     ClockFactory(){}
+
+    static ScalableClock* getScalable()
+    {
+        static ScalableClock clock;
+
+        return &clock;
+    }
 };
 
 }} //namespace
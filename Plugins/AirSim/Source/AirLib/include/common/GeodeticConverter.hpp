@@ -5,6 +5,7 @@
 #define air_GeodeticConverter_hpp
 
 #include <cmath>
+#include <cstddef>
 #include "VectorMath.hpp"
 
 namespace msr { namespace airlib {
@@ -31,7 +32,7 @@ class GeodeticConverter
     geodetic2Ecef(home_latitude_, home_longitude_, home_altitude_, &home_ecef_x_, &home_ecef_y_, &home_ecef_z_);
 
     // Compute ECEF to NED and NED to ECEF matrices
-    double phiP = atan2(home_ecef_z_, sqrt(pow(home_ecef_x_, 2) + pow(home_ecef_y_, 2)));
+    double phiP = atan2(home_ecef_z_, sqrt(home_ecef_x_ * home_ecef_x_ + home_ecef_y_ * home_ecef_y_));
 
     ecef_to_ned_matrix_ = nRe(phiP, home_longitude_rad_);
     ned_to_ecef_matrix_ = nRe(home_latitude_rad_, home_longitude_rad_).transpose();    
@@ -51,10 +52,11 @@ class GeodeticConverter
     // http://code.google.com/p/pysatel/source/browse/trunk/coord.py?r=22
     double lat_rad = deg2Rad(latitude);
     double lon_rad = deg2Rad(longitude);
-    double xi = sqrt(1 - kFirstEccentricitySquared * sin(lat_rad) * sin(lat_rad));
-    *x = (kSemimajorAxis / xi + altitude) * cos(lat_rad) * cos(lon_rad);
-    *y = (kSemimajorAxis / xi + altitude) * cos(lat_rad) * sin(lon_rad);
-    *z = (kSemimajorAxis / xi * (1 - kFirstEccentricitySquared) + altitude) * sin(lat_rad);
+    double s_lat = sin(lat_rad), c_lat = cos(lat_rad);
+    double n = kSemimajorAxis / sqrt(1 - kFirstEccentricitySquared * s_lat * s_lat);
+    *x = (n + altitude) * c_lat * cos(lon_rad);
+    *y = (n + altitude) * c_lat * sin(lon_rad);
+    *z = (n * (1 - kFirstEccentricitySquared) + altitude) * s_lat;
   }
 
   void ecef2Geodetic(const double x, const double y, const double z, double* latitude,
@@ -65,21 +67,24 @@ class GeodeticConverter
     // to geodetic coordinates," IEEE Transactions on Aerospace and
     // Electronic Systems, vol. 30, pp. 957-961, 1994.
 
-    double r = sqrt(x * x + y * y);
-    double Esq = kSemimajorAxis * kSemimajorAxis - kSemiminorAxis * kSemiminorAxis;
-    double F = 54 * kSemiminorAxis * kSemiminorAxis * z * z;
-    double G = r * r + (1 - kFirstEccentricitySquared) * z * z - kFirstEccentricitySquared * Esq;
-    double C = (kFirstEccentricitySquared * kFirstEccentricitySquared * F * r * r) / pow(G, 3);
+    // pow(x, 2) and pow(x, 3) are written as multiplies, constant terms are folded in kEsq etc.
+    double r2 = x * x + y * y;
+    double r = sqrt(r2);
+    double z2 = z * z;
+    double F = 54 * kSemiminorAxis * kSemiminorAxis * z2;
+    double G = r2 + (1 - kFirstEccentricitySquared) * z2 - kFirstEccentricitySquared * kEsq;
+    double C = (kFirstEccentricitySquared * kFirstEccentricitySquared * F * r2) / (G * G * G);
     double S = cbrt(1 + C + sqrt(C * C + 2 * C));
-    double P = F / (3 * pow((S + 1 / S + 1), 2) * G * G);
+    double S_term = S + 1 / S + 1;
+    double P = F / (3 * S_term * S_term * G * G);
     double Q = sqrt(1 + 2 * kFirstEccentricitySquared * kFirstEccentricitySquared * P);
     double r_0 = -(P * kFirstEccentricitySquared * r) / (1 + Q)
         + sqrt(
             0.5 * kSemimajorAxis * kSemimajorAxis * (1 + 1.0 / Q)
-                - P * (1 - kFirstEccentricitySquared) * z * z / (Q * (1 + Q)) - 0.5 * P * r * r);
-    double U = sqrt(pow((r - kFirstEccentricitySquared * r_0), 2) + z * z);
-    double V = sqrt(
-        pow((r - kFirstEccentricitySquared * r_0), 2) + (1 - kFirstEccentricitySquared) * z * z);
+                - P * (1 - kFirstEccentricitySquared) * z2 / (Q * (1 + Q)) - 0.5 * P * r2);
+    double r_e = r - kFirstEccentricitySquared * r_0;
+    double U = sqrt(r_e * r_e + z2);
+    double V = sqrt(r_e * r_e + (1 - kFirstEccentricitySquared) * z2);
     double Z_0 = kSemiminorAxis * kSemiminorAxis * z / (kSemimajorAxis * V);
     *altitude = static_cast<float>(U * (1 - kSemiminorAxis * kSemiminorAxis / (kSemimajorAxis * V)));
     *latitude = rad2Deg(atan((z + kSecondEccentricitySquared * Z_0) / r));
@@ -166,6 +171,136 @@ class GeodeticConverter
     ecef2Geodetic(x, y, z, latitude, longitude, altitude);
   }
 
+  /*
+    Batched versions of above for converting whole tracks, fences or swarm
+    outputs at once. Points are passed as separate arrays (structure of arrays)
+    of count n and converted in blocks of kBatchBlock points held in fixed
+    size arrays, so there is no heap allocation and no per point call. Only
+    the arithmetic runs on whole blocks: sin, cos, atan2 and cbrt are still
+    evaluated per element, so throughput is close to the scalar path
+    (ned2Geodetic gains most). Results match scalar versions to rounding
+    error, except that altitudes stay in double here. Output arrays may be
+    the same as inputs.
+  */
+  void geodetic2EcefBatch(const double* latitude, const double* longitude, const double* altitude, size_t n,
+                          double* x, double* y, double* z) const
+  {
+    for (size_t start = 0; start < n; start += kBatchBlock) {
+      const Eigen::Index m = blockSize(n, start);
+      BlockArray lat_rad, lon_rad, s_lat, c_lat, n_curv, alt;
+      lat_rad.head(m) = ConstMap(latitude + start, m) * (M_PI / 180.0);
+      lon_rad.head(m) = ConstMap(longitude + start, m) * (M_PI / 180.0);
+      alt.head(m) = ConstMap(altitude + start, m);
+      s_lat.head(m) = lat_rad.head(m).sin();
+      c_lat.head(m) = lat_rad.head(m).cos();
+      n_curv.head(m) = kSemimajorAxis / (1 - kFirstEccentricitySquared * s_lat.head(m).square()).sqrt();
+
+      Map(x + start, m) = (n_curv.head(m) + alt.head(m)) * c_lat.head(m) * lon_rad.head(m).cos();
+      Map(y + start, m) = (n_curv.head(m) + alt.head(m)) * c_lat.head(m) * lon_rad.head(m).sin();
+      Map(z + start, m) = (n_curv.head(m) * (1 - kFirstEccentricitySquared) + alt.head(m)) * s_lat.head(m);
+    }
+  }
+
+  void ecef2GeodeticBatch(const double* x, const double* y, const double* z, size_t n,
+                          double* latitude, double* longitude, double* altitude) const
+  {
+    const double e2 = kFirstEccentricitySquared;
+    const double b2 = kSemiminorAxis * kSemiminorAxis;
+    for (size_t start = 0; start < n; start += kBatchBlock) {
+      const Eigen::Index m = blockSize(n, start);
+      BlockArray xb, yb, zb, r2, r, z2, F, G, C, S, P, Q, r_0, r_e, U, V, Z_0;
+      xb.head(m) = ConstMap(x + start, m);
+      yb.head(m) = ConstMap(y + start, m);
+      zb.head(m) = ConstMap(z + start, m);
+
+      //same steps as scalar ecef2Geodetic
+      r2.head(m) = xb.head(m).square() + yb.head(m).square();
+      r.head(m) = r2.head(m).sqrt();
+      z2.head(m) = zb.head(m).square();
+      F.head(m) = (54 * b2) * z2.head(m);
+      G.head(m) = r2.head(m) + (1 - e2) * z2.head(m) - e2 * kEsq;
+      C.head(m) = (e2 * e2) * F.head(m) * r2.head(m) / G.head(m).cube();
+      S.head(m) = 1 + C.head(m) + (C.head(m).square() + 2 * C.head(m)).sqrt();
+      for (Eigen::Index i = 0; i < m; ++i)
+        S(i) = cbrt(S(i));
+      P.head(m) = F.head(m) / (3 * (S.head(m) + S.head(m).inverse() + 1).square() * G.head(m).square());
+      Q.head(m) = (1 + (2 * e2 * e2) * P.head(m)).sqrt();
+      r_0.head(m) = -(P.head(m) * e2 * r.head(m)) / (1 + Q.head(m))
+        + (0.5 * kSemimajorAxis * kSemimajorAxis * (1 + Q.head(m).inverse())
+          - P.head(m) * (1 - e2) * z2.head(m) / (Q.head(m) * (1 + Q.head(m))) - 0.5 * P.head(m) * r2.head(m)).sqrt();
+      r_e.head(m) = r.head(m) - e2 * r_0.head(m);
+      U.head(m) = (r_e.head(m).square() + z2.head(m)).sqrt();
+      V.head(m) = (r_e.head(m).square() + (1 - e2) * z2.head(m)).sqrt();
+      Z_0.head(m) = b2 * zb.head(m) / (kSemimajorAxis * V.head(m));
+
+      Map(altitude + start, m) = U.head(m) * (1 - b2 / (kSemimajorAxis * V.head(m)));
+      Map(latitude + start, m) = ((zb.head(m) + kSecondEccentricitySquared * Z_0.head(m)) / r.head(m)).atan() * (180.0 / M_PI);
+      for (Eigen::Index i = 0; i < m; ++i)
+        longitude[start + i] = atan2(yb(i), xb(i)) * (180.0 / M_PI);
+    }
+  }
+
+  void ecef2NedBatch(const double* x, const double* y, const double* z, size_t n,
+                     double* north, double* east, double* down) const
+  {
+    const Matrix3x3d& mat = ecef_to_ned_matrix_;
+    for (size_t start = 0; start < n; start += kBatchBlock) {
+      const Eigen::Index m = blockSize(n, start);
+      BlockArray dx, dy, dz;
+      dx.head(m) = ConstMap(x + start, m) - home_ecef_x_;
+      dy.head(m) = ConstMap(y + start, m) - home_ecef_y_;
+      dz.head(m) = ConstMap(z + start, m) - home_ecef_z_;
+
+      Map(north + start, m) = mat(0, 0) * dx.head(m) + mat(0, 1) * dy.head(m) + mat(0, 2) * dz.head(m);
+      Map(east + start, m) = mat(1, 0) * dx.head(m) + mat(1, 1) * dy.head(m) + mat(1, 2) * dz.head(m);
+      Map(down + start, m) = -(mat(2, 0) * dx.head(m) + mat(2, 1) * dy.head(m) + mat(2, 2) * dz.head(m));
+    }
+  }
+
+  void ned2EcefBatch(const double* north, const double* east, const double* down, size_t n,
+                     double* x, double* y, double* z) const
+  {
+    const Matrix3x3d& mat = ned_to_ecef_matrix_;
+    for (size_t start = 0; start < n; start += kBatchBlock) {
+      const Eigen::Index m = blockSize(n, start);
+      BlockArray nb, eb, ub;
+      nb.head(m) = ConstMap(north + start, m);
+      eb.head(m) = ConstMap(east + start, m);
+      ub.head(m) = -ConstMap(down + start, m);
+
+      Map(x + start, m) = mat(0, 0) * nb.head(m) + mat(0, 1) * eb.head(m) + mat(0, 2) * ub.head(m) + home_ecef_x_;
+      Map(y + start, m) = mat(1, 0) * nb.head(m) + mat(1, 1) * eb.head(m) + mat(1, 2) * ub.head(m) + home_ecef_y_;
+      Map(z + start, m) = mat(2, 0) * nb.head(m) + mat(2, 1) * eb.head(m) + mat(2, 2) * ub.head(m) + home_ecef_z_;
+    }
+  }
+
+  void geodetic2NedBatch(const double* latitude, const double* longitude, const double* altitude, size_t n,
+                         double* north, double* east, double* down) const
+  {
+    //ECEF goes in to output arrays first, ecef2NedBatch allows in-place conversion
+    geodetic2EcefBatch(latitude, longitude, altitude, n, north, east, down);
+    ecef2NedBatch(north, east, down, n, north, east, down);
+  }
+
+  void ned2GeodeticBatch(const double* north, const double* east, const double* down, size_t n,
+                         double* latitude, double* longitude, double* altitude) const
+  {
+    for (size_t start = 0; start < n; start += kBatchBlock) {
+      const Eigen::Index m = blockSize(n, start);
+      //keep down before outputs (which may alias it) are used for ECEF
+      BlockArray down_block;
+      down_block.head(m) = ConstMap(down + start, m);
+
+      ned2EcefBatch(north + start, east + start, down + start, static_cast<size_t>(m),
+        latitude + start, longitude + start, altitude + start);
+      ecef2GeodeticBatch(latitude + start, longitude + start, altitude + start, static_cast<size_t>(m),
+        latitude + start, longitude + start, altitude + start);
+
+      //ned2Geodetic overrides altitude for the reason given there, so do the same here
+      Map(altitude + start, m) = home_altitude_ - down_block.head(m);
+    }
+  }
+
 private:
     typedef msr::airlib::VectorMathf VectorMath;
     typedef VectorMath::Vector3d Vector3d;
@@ -177,6 +312,18 @@ private:
   static constexpr double kFirstEccentricitySquared = 6.69437999014 * 0.001;
   static constexpr double kSecondEccentricitySquared = 6.73949674228 * 0.001;
   static constexpr double kFlattening = 1 / 298.257223563;
+  static constexpr double kEsq = kSemimajorAxis * kSemimajorAxis - kSemiminorAxis * kSemiminorAxis;
+
+  // points converted per block in batch APIs, fixed size keeps temporaries on stack
+  static constexpr size_t kBatchBlock = 64;
+  typedef Eigen::Array<double, kBatchBlock, 1> BlockArray;
+  typedef Eigen::Map<Eigen::Array<double, Eigen::Dynamic, 1>> Map;
+  typedef Eigen::Map<const Eigen::Array<double, Eigen::Dynamic, 1>> ConstMap;
+
+  static Eigen::Index blockSize(size_t n, size_t start)
+  {
+    return static_cast<Eigen::Index>(n - start < kBatchBlock ? n - start : kBatchBlock);
+  }
 
   inline Matrix3x3d nRe(const double lat_radians, const double lon_radians)
   {
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_NeighborIndex_hpp
+#define msr_airlib_NeighborIndex_hpp
+
+#include <algorithm>
+#include <cmath>
+#include "common/Common.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Uniform grid over a set of points, rebuilt every time the points move.
+    Entries are kept as sorted cell keys, so building is one sort, lookups
+    are binary searches and nothing is allocated once the entry buffer has
+    grown to the number of points.
+
+    Points are referred to by their index in the order given to build().
+    Not thread safe to build, concurrent queries on a built index are fine.
+*/
+class NeighborIndex {
+public:
+    NeighborIndex(real_T cell_size = 20)
+        : cell_size_(cell_size)
+    {
+    }
+
+    void setCellSize(real_T cell_size)
+    {
+        cell_size_ = cell_size;
+    }
+    real_T getCellSize() const
+    {
+        return cell_size_;
+    }
+
+    //get_position(i) returns position of point i for i in [0, count)
+    template <typename TGetPosition>
+    void build(uint count, TGetPosition get_position)
+    {
+        entries_.clear();
+        for (uint i = 0; i < count; ++i) {
+            const Vector3r& p = get_position(i);
+            int x = cellOf(p.x()), y = cellOf(p.y()), z = cellOf(p.z());
+            entries_.push_back(Entry{ cellKey(x, y, z), x, y, z, i });
+        }
+        std::sort(entries_.begin(), entries_.end());
+    }
+
+    size_t size() const
+    {
+        return entries_.size();
+    }
+
+    //calls func with index of every point in cells overlapping the box, so may include points outside it
+    template <typename TFunc>
+    void forEachInBox(const Vector3r& min_corner, const Vector3r& max_corner, TFunc func) const
+    {
+        int min_x = cellOf(min_corner.x()), max_x = cellOf(max_corner.x());
+        int min_y = cellOf(min_corner.y()), max_y = cellOf(max_corner.y());
+        int min_z = cellOf(min_corner.z()), max_z = cellOf(max_corner.z());
+        int64_t cell_count = static_cast<int64_t>(max_x - min_x + 1) * (max_y - min_y + 1) * (max_z - min_z + 1);
+
+        //few points spread over a big box: cheaper to test cell of each entry than to look up every cell
+        if (cell_count >= static_cast<int64_t>(entries_.size())) {
+            for (const Entry& entry : entries_) {
+                if (entry.x >= min_x && entry.x <= max_x && entry.y >= min_y && entry.y <= max_y
+                    && entry.z >= min_z && entry.z <= max_z)
+                    func(entry.point);
+            }
+            return;
+        }
+
+        for (int x = min_x; x <= max_x; ++x)
+            for (int y = min_y; y <= max_y; ++y)
+                for (int z = min_z; z <= max_z; ++z) {
+                    Entry probe{ cellKey(x, y, z), x, y, z, 0 };
+                    auto range = std::equal_range(entries_.begin(), entries_.end(), probe);
+                    for (auto it = range.first; it != range.second; ++it)
+                        func(it->point);
+                }
+    }
+
+    //same as forEachInBox for the box around sphere, caller does exact distance test
+    template <typename TFunc>
+    void forEachNear(const Vector3r& center, real_T radius, TFunc func) const
+    {
+        forEachInBox(center - Vector3r::Constant(radius), center + Vector3r::Constant(radius), func);
+    }
+
+private: //types
+    struct Entry {
+        int64_t key;
+        int x, y, z;                        //cell
+        uint point;
+
+        bool operator<(const Entry& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+private:
+    int cellOf(real_T value) const
+    {
+        return static_cast<int>(std::floor(value / cell_size_));
+    }
+
+    //21 bits per axis covers +-20000 km at 20 m cells
+    static int64_t cellKey(int x, int y, int z)
+    {
+        const int64_t mask = (1 << 21) - 1;
+        return ((static_cast<int64_t>(x) & mask) << 42) | ((static_cast<int64_t>(y) & mask) << 21) | (static_cast<int64_t>(z) & mask);
+    }
+
+private:
+    real_T cell_size_;
+    vector<Entry> entries_;
+};
+
+}} //namespace
+#endif
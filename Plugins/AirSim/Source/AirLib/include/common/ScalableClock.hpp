@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_ScalableClock_hpp
+#define airsim_core_ScalableClock_hpp
+
+#include "ClockBase.hpp"
+#include "Common.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Wall clock running speed times faster, e.g. 5 simulates 5 seconds for
+    every wall second. Changing speed continues from the current time so
+    time points taken before stay comparable. Speed is not synchronized,
+    set it before simulation threads start reading the clock.
+*/
+class ScalableClock : public ClockBase {
+public:
+    ScalableClock(double speed = 1)
+        : speed_(1), wall_start_(0), sim_start_(0)
+    {
+        setSpeed(speed);
+    }
+
+    void setSpeed(double speed)
+    {
+        TTimePoint wall_now = Utils::getTimeSinceEpochNanos();
+        sim_start_ = toSim(wall_now);
+        wall_start_ = wall_now;
+        speed_ = speed;
+    }
+    double getSpeed() const
+    {
+        return speed_;
+    }
+
+    virtual TTimePoint nowNanos() override
+    {
+        return toSim(Utils::getTimeSinceEpochNanos());
+    }
+
+    virtual TTimeDelta fromWallDelta(TTimeDelta dt) override
+    {
+        return dt * speed_;
+    }
+    virtual TTimeDelta toWallDelta(TTimeDelta dt) override
+    {
+        return dt / speed_;
+    }
+
+private:
+    TTimePoint toSim(TTimePoint wall) const
+    {
+        if (speed_ == 1 && sim_start_ == wall_start_) //optimized normal route
+            return wall;
+        return sim_start_ + static_cast<TTimePoint>((wall - wall_start_) * speed_);
+    }
+
+private:
+    double speed_;
+    TTimePoint wall_start_, sim_start_;
+};
+
+}} //namespace
+#endif
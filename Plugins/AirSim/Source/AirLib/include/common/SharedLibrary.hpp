@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_SharedLibrary_hpp
+#define msr_airlib_SharedLibrary_hpp
+
+#include <string>
+
+namespace msr { namespace airlib {
+
+/*
+    Minimal wrapper over dlopen/LoadLibrary so platform headers stay out of
+    the rest of AirLib. Library is unloaded when the object is destroyed,
+    so anything obtained from it must not outlive the object.
+*/
+class SharedLibrary {
+public:
+    SharedLibrary() = default;
+    ~SharedLibrary();
+
+    SharedLibrary(const SharedLibrary&) = delete;
+    SharedLibrary& operator=(const SharedLibrary&) = delete;
+
+    //throws std::runtime_error with loader's message if library can't be loaded
+    void load(const std::string& path);
+    void unload();
+
+    bool isLoaded() const
+    {
+        return handle_ != nullptr;
+    }
+    const std::string& getPath() const
+    {
+        return path_;
+    }
+
+    //null if symbol is not exported
+    void* getSymbol(const std::string& name) const;
+
+    template<typename FuncT>
+    FuncT getFunction(const std::string& name) const
+    {
+        return reinterpret_cast<FuncT>(getSymbol(name));
+    }
+
+private:
+    void* handle_ = nullptr;
+    std::string path_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_StartupProfiler_hpp
+#define airsim_core_StartupProfiler_hpp
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include "common/Common.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Collects wall clock time taken by each startup stage (settings, vehicle
+    creation, controller connections, API servers etc) so slow subsystems are
+    visible. Stages may be recorded from worker threads when subsystems are
+    started in parallel, so total wall time can be less than sum of stages.
+    Uses steady clock instead of ClockFactory because sim clock may be scaled.
+*/
+class StartupProfiler {
+public: //types
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        string stage;
+        double start_sec;   //relative to clear()
+        double duration_sec;
+    };
+
+    //measures lifetime of the object as one stage
+    class Scope {
+    public:
+        Scope(const string& stage, StartupProfiler& profiler = StartupProfiler::singleton())
+            : stage_(stage), profiler_(profiler), start_(Clock::now())
+        {
+        }
+        ~Scope()
+        {
+            profiler_.record(stage_, start_, Clock::now());
+        }
+    private:
+        string stage_;
+        StartupProfiler& profiler_;
+        Clock::time_point start_;
+    };
+
+public:
+    static StartupProfiler& singleton()
+    {
+        static StartupProfiler profiler;
+        return profiler;
+    }
+
+    StartupProfiler()
+    {
+        clear();
+    }
+
+    //call at the start of session
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        session_start_ = Clock::now();
+    }
+
+    void record(const string& stage, Clock::time_point start, Clock::time_point end)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back(Entry{ stage, toSeconds(start - session_start_), toSeconds(end - start) });
+    }
+
+    vector<Entry> getEntries() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_;
+    }
+
+    //wall time from clear() to end of last recorded stage
+    double getTotalSeconds() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double total = 0;
+        for (const auto& entry : entries_)
+            total = std::max(total, entry.start_sec + entry.duration_sec);
+        return total;
+    }
+
+    //one line per stage in the order stages started
+    string getReport() const
+    {
+        vector<Entry> entries = getEntries();
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.start_sec < b.start_sec;
+        });
+
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Startup took " << getTotalSeconds() * 1E3 << " ms" << std::endl;
+        for (const auto& entry : entries)
+            ss << "  " << entry.stage << ": " << entry.duration_sec * 1E3 << " ms (at " << entry.start_sec * 1E3 << " ms)" << std::endl;
+        return ss.str();
+    }
+
+private:
+    static double toSeconds(Clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    vector<Entry> entries_;
+    Clock::time_point session_start_;
+};
+
+}} //namespace
+#endif
@@ -18,6 +18,7 @@ namespace msr { namespace airlib {
 class StateReporterWrapper : public UpdatableObject {
 public:
     static constexpr real_T DefaultReportFreq = 3.0f;
+    static constexpr int DtWindowSize = 1000;
 
     StateReporterWrapper(bool enabled = false, int float_precision = 3, bool is_scientific_notation = false)
     {
@@ -27,7 +28,9 @@ public:
     {
         enabled_ = enabled;
         report_.initialize(float_precision, is_scientific_notation);
-        report_freq_.initialize(DefaultReportFreq);
+        report_freq_value_ = DefaultReportFreq;
+        report_freq_.initialize(report_freq_value_);
+        dt_window_stats_.initialize(DtWindowSize);
         StateReporterWrapper::reset();
     }
 
@@ -43,6 +46,7 @@ public:
         last_time_ = clock()->nowNanos();
         clearReport();
         dt_stats_.clear();
+        dt_window_stats_.clear();
         report_freq_.reset();
     }
 
@@ -52,6 +56,7 @@ public:
 
         if (enabled_) {
             dt_stats_.insert(dt);
+            dt_window_stats_.insert(dt);
             report_freq_.update();
             is_wait_complete = is_wait_complete || report_freq_.isWaitComplete();
         }
@@ -63,6 +68,13 @@ public:
         report_.writeValueOnly(dt_stats_.mean());
         report_.writeValueOnly(dt_stats_.variance());
         report_.writeValueOnly(dt_stats_.size(), true);
+
+        //jitter over recent updates
+        report_.writeNameOnly("dt window");
+        report_.writeValueOnly(dt_window_stats_.mean());
+        report_.writeValueOnly(dt_window_stats_.standardDeviation());
+        report_.writeValueOnly(dt_window_stats_.percentile(0.99));
+        report_.writeValueOnly(dt_window_stats_.max(), true);
     }
     //*** End: UpdatableState implementation ***//
 
@@ -81,9 +93,12 @@ public:
         return report_.getOutput();
     }
 
+    //kept across setEnable
     void setReportFreq(real_T freq)
     {
-        report_freq_.initialize(freq);
+        report_freq_value_ = freq;
+        if (enabled_)
+            report_freq_.initialize(freq);
     }
 
     void setEnable(bool enable)
@@ -93,7 +108,7 @@ public:
 
         enabled_ = enable;
         if (enable)
-            report_freq_.initialize(DefaultReportFreq);
+            report_freq_.initialize(report_freq_value_);
         else
             report_freq_.initialize(0);
     }
@@ -104,12 +119,15 @@ public:
 
 private:
     typedef common_utils::OnlineStats OnlineStats;
+    typedef common_utils::RollingOnlineStats RollingOnlineStats;
 
     StateReporter report_;
 
     OnlineStats dt_stats_;
+    RollingOnlineStats dt_window_stats_;
 
     FrequencyLimiter report_freq_;
+    real_T report_freq_value_;
     bool enabled_;
     bool is_wait_complete = false;
     TTimePoint last_time_;
@@ -69,6 +69,13 @@ public:
         return parentFolder + kPathSeparator + child;
     }
 
+    static bool isAbsolutePath(const std::string& path) {
+        if (path.size() > 0 && (path[0] == '/' || path[0] == '\\'))
+            return true;
+        //drive letter such as C:
+        return path.size() > 1 && path[1] == ':';
+    }
+
 	static void removeLeaf(std::string& path) {
 		size_t size = path.size();
 		size_t pos = path.find_last_of('/');
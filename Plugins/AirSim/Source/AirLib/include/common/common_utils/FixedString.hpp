@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef common_utils_FixedString_hpp
+#define common_utils_FixedString_hpp
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "StrictMode.hpp"
+
+namespace common_utils {
+
+/*
+    String with storage inside the object so it never touches the heap. Meant
+    for messages built in per-tick or per-command code. Text that doesn't fit
+    in Capacity - 1 chars is truncated.
+*/
+template <size_t Capacity>
+class FixedString {
+public:
+    FixedString()
+    {
+        clear();
+    }
+    FixedString(const char* text)
+    {
+        clear();
+        append(text);
+    }
+
+    void clear()
+    {
+        size_ = 0;
+        buffer_[0] = '\0';
+    }
+
+    FixedString& append(const char* text)
+    {
+        size_t len = std::strlen(text);
+        size_t available = Capacity - 1 - size_;
+        if (len > available)
+            len = available;
+        std::memcpy(buffer_ + size_, text, len);
+        size_ += len;
+        buffer_[size_] = '\0';
+        return *this;
+    }
+
+    FixedString& appendf(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+
+        size_t available = Capacity - size_;
+        IGNORE_FORMAT_STRING_ON
+        int written = vsnprintf(buffer_ + size_, available, format, args);
+        IGNORE_FORMAT_STRING_OFF
+        va_end(args);
+
+        if (written > 0)
+            size_ += static_cast<size_t>(written) < available ? static_cast<size_t>(written) : available - 1;
+        return *this;
+    }
+
+    const char* c_str() const
+    {
+        return buffer_;
+    }
+    size_t size() const
+    {
+        return size_;
+    }
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+    static constexpr size_t capacity()
+    {
+        return Capacity - 1;
+    }
+
+    //allocates, use only outside of hot paths
+    std::string str() const
+    {
+        return std::string(buffer_, size_);
+    }
+
+private:
+    char buffer_[Capacity];
+    size_t size_;
+};
+
+} //namespace
+#endif
@@ -0,0 +1,248 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef common_utils_IndexableSkiplist_hpp
+#define common_utils_IndexableSkiplist_hpp
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <cstdint>
+
+namespace common_utils {
+
+/*
+    Sorted multiset with O(log n) insert, remove, rank and access by index.
+    Each link stores how many level-0 steps it skips, which lets us find
+    the k-th smallest value without walking the list.
+    Ref: Raymond Hettinger, "Efficient Running Median using an Indexable Skiplist"
+         http://code.activestate.com/recipes/577073/
+
+    All nodes are allocated once in initialize() so insert/remove never touch
+    the heap. Capacity is fixed; inserting into a full list throws. NaN is
+    rejected because it has no place in the ordering and remove() can't find it.
+*/
+template <typename T>
+class IndexableSkiplist {
+public:
+    IndexableSkiplist()
+    {
+        initialize(0);
+    }
+    IndexableSkiplist(int capacity)
+    {
+        initialize(capacity);
+    }
+
+    void initialize(int capacity)
+    {
+        capacity_ = capacity;
+        max_levels_ = 1;
+        while ((1 << max_levels_) < capacity_ + 1 && max_levels_ < 31)
+            ++max_levels_;
+
+        //last two nodes in pool are head and nil sentinels
+        head_ = capacity_;
+        nil_ = capacity_ + 1;
+        values_.assign(capacity_ + 2, T());
+        heights_.assign(capacity_ + 2, 0);
+        next_.assign((capacity_ + 2) * max_levels_, nil_);
+        width_.assign((capacity_ + 2) * max_levels_, 1);
+        chain_.resize(max_levels_);
+        steps_at_level_.resize(max_levels_);
+        free_.reserve(capacity_);
+
+        clear();
+    }
+
+    void clear()
+    {
+        free_.clear();
+        for (int i = capacity_ - 1; i >= 0; --i)
+            free_.push_back(i);
+
+        heights_[head_] = max_levels_;
+        for (int level = 0; level < max_levels_; ++level) {
+            next(head_, level) = nil_;
+            width(head_, level) = 1;
+        }
+        size_ = 0;
+        rand_.seed(42);
+    }
+
+    int size() const
+    {
+        return size_;
+    }
+
+    int capacity() const
+    {
+        return capacity_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    void insert(const T& value)
+    {
+        if (free_.empty())
+            throw std::length_error("IndexableSkiplist is full");
+        if (value != value)
+            throw std::invalid_argument("IndexableSkiplist can't hold NaN");
+
+        int node = head_;
+        for (int level = max_levels_ - 1; level >= 0; --level) {
+            steps_at_level_[level] = 0;
+            while (next(node, level) != nil_ && values_[next(node, level)] <= value) {
+                steps_at_level_[level] += width(node, level);
+                node = next(node, level);
+            }
+            chain_[level] = node;
+        }
+
+        int new_node = free_.back();
+        free_.pop_back();
+        values_[new_node] = value;
+        int height = randomHeight();
+        heights_[new_node] = height;
+
+        int steps = 0;
+        for (int level = 0; level < height; ++level) {
+            int prev = chain_[level];
+            next(new_node, level) = next(prev, level);
+            next(prev, level) = new_node;
+            width(new_node, level) = width(prev, level) - steps;
+            width(prev, level) = steps + 1;
+            steps += steps_at_level_[level];
+        }
+        for (int level = height; level < max_levels_; ++level)
+            width(chain_[level], level) += 1;
+
+        ++size_;
+    }
+
+    //removes one occurrence of value, returns false if value wasn't found
+    bool remove(const T& value)
+    {
+        int node = head_;
+        for (int level = max_levels_ - 1; level >= 0; --level) {
+            while (next(node, level) != nil_ && values_[next(node, level)] < value)
+                node = next(node, level);
+            chain_[level] = node;
+        }
+
+        int target = next(chain_[0], 0);
+        if (target == nil_ || values_[target] != value)
+            return false;
+
+        int height = heights_[target];
+        for (int level = 0; level < height; ++level) {
+            int prev = chain_[level];
+            width(prev, level) += width(target, level) - 1;
+            next(prev, level) = next(target, level);
+        }
+        for (int level = height; level < max_levels_; ++level)
+            width(chain_[level], level) -= 1;
+
+        free_.push_back(target);
+        --size_;
+        return true;
+    }
+
+    //k-th smallest value, 0 based
+    const T& at(int index) const
+    {
+        if (index < 0 || index >= size_)
+            throw std::out_of_range("IndexableSkiplist index is out of range");
+
+        int node = head_;
+        int remaining = index + 1;
+        for (int level = max_levels_ - 1; level >= 0; --level) {
+            while (width(node, level) <= remaining) {
+                remaining -= width(node, level);
+                node = next(node, level);
+            }
+        }
+        return values_[node];
+    }
+
+    const T& operator[](int index) const
+    {
+        return at(index);
+    }
+
+    //number of values strictly less than value
+    int countLess(const T& value) const
+    {
+        int node = head_, count = 0;
+        for (int level = max_levels_ - 1; level >= 0; --level) {
+            while (next(node, level) != nil_ && values_[next(node, level)] < value) {
+                count += width(node, level);
+                node = next(node, level);
+            }
+        }
+        return count;
+    }
+
+    //number of values less than or equal to value
+    int countLessEqual(const T& value) const
+    {
+        int node = head_, count = 0;
+        for (int level = max_levels_ - 1; level >= 0; --level) {
+            while (next(node, level) != nil_ && values_[next(node, level)] <= value) {
+                count += width(node, level);
+                node = next(node, level);
+            }
+        }
+        return count;
+    }
+
+private:
+    int& next(int node, int level)
+    {
+        return next_[node * max_levels_ + level];
+    }
+    int next(int node, int level) const
+    {
+        return next_[node * max_levels_ + level];
+    }
+    int& width(int node, int level)
+    {
+        return width_[node * max_levels_ + level];
+    }
+    int width(int node, int level) const
+    {
+        return width_[node * max_levels_ + level];
+    }
+
+    int randomHeight()
+    {
+        //geometric distribution with p = 0.5
+        int height = 1;
+        uint32_t bits = rand_();
+        while ((bits & 1) && height < max_levels_) {
+            ++height;
+            bits >>= 1;
+        }
+        return height;
+    }
+
+private:
+    int capacity_, max_levels_, size_;
+    int head_, nil_;
+
+    std::vector<T> values_;
+    std::vector<int> heights_;
+    std::vector<int> next_, width_;
+    std::vector<int> free_;
+
+    //scratch space for insert/remove so we don't allocate per call
+    std::vector<int> chain_, steps_at_level_;
+
+    std::mt19937 rand_;
+};
+
+} //namespace
+#endif
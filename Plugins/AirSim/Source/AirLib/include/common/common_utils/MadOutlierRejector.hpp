@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef common_utils_MadOutlierRejector_hpp
+#define common_utils_MadOutlierRejector_hpp
+
+#include <cmath>
+#include <cstdint>
+#include "StreamingMedian.hpp"
+
+namespace common_utils {
+
+/*
+    Rolling Hampel filter: sample is an outlier if it is further than
+    threshold * sigma from median of last window_size samples, where sigma
+    is estimated as 1.4826 * MAD (consistent with std dev for gaussian noise).
+    Outliers are replaced by window median. Every sample still goes in to the
+    window so the filter follows genuine step changes after window_size/2 samples.
+    min_deviation keeps constant signals (MAD = 0) from rejecting everything.
+*/
+template <typename T>
+class MadOutlierRejector {
+public:
+    static constexpr double MadToSigma = 1.4826;
+
+    MadOutlierRejector()
+    {
+        initialize(1, 3);
+    }
+    MadOutlierRejector(int window_size, T threshold, T min_deviation = T(), int min_samples = 3)
+    {
+        initialize(window_size, threshold, min_deviation, min_samples);
+    }
+
+    void initialize(int window_size, T threshold, T min_deviation = T(), int min_samples = 3)
+    {
+        threshold_ = threshold;
+        min_deviation_ = min_deviation;
+        min_samples_ = min_samples;
+        stats_.initialize(window_size);
+        clear();
+    }
+
+    void clear()
+    {
+        stats_.clear();
+        rejected_count_ = 0;
+        sample_count_ = 0;
+        last_rejected_ = false;
+    }
+
+    bool isOutlier(const T& value) const
+    {
+        if (stats_.size() < min_samples_)
+            return false;
+
+        T deviation = static_cast<T>(std::abs(value - stats_.median()));
+        T limit = static_cast<T>(threshold_ * MadToSigma * stats_.mad());
+        if (limit < min_deviation_)
+            limit = min_deviation_;
+        return deviation > limit;
+    }
+
+    //returns value as-is if it is inlier else returns median of window
+    T filter(const T& value)
+    {
+        last_rejected_ = isOutlier(value);
+        T output = last_rejected_ ? stats_.median() : value;
+
+        stats_.insert(value);
+        ++sample_count_;
+        if (last_rejected_)
+            ++rejected_count_;
+
+        return output;
+    }
+
+    bool isLastRejected() const
+    {
+        return last_rejected_;
+    }
+    uint64_t getRejectedCount() const
+    {
+        return rejected_count_;
+    }
+    uint64_t getSampleCount() const
+    {
+        return sample_count_;
+    }
+    const StreamingMedian<T>& getStats() const
+    {
+        return stats_;
+    }
+
+private:
+    StreamingMedian<T> stats_;
+    T threshold_, min_deviation_;
+    int min_samples_;
+    uint64_t rejected_count_, sample_count_;
+    bool last_rejected_;
+};
+
+} //namespace
+#endif
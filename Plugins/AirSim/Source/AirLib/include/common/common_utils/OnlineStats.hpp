@@ -5,6 +5,10 @@
 #define common_utils_OnlineStats_hpp
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "StreamingMedian.hpp"
 
 namespace common_utils {
 
@@ -108,5 +112,135 @@ private:
 
 }; //class
 
+/*
+    Same as OnlineStats but only over last window_size samples, so recent
+    jitter or latency doesn't get diluted by the whole history. Mean and variance
+    are updated in O(1) by adding new sample and removing the oldest one.
+    Min, max and percentiles are O(log w) from sorted view of the window.
+*/
+class RollingOnlineStats {
+public:
+    RollingOnlineStats(int window_size = 100)
+    {
+        initialize(window_size);
+    }
+
+    void initialize(int window_size)
+    {
+        window_size_ = std::max(window_size, 1);
+        window_.assign(window_size_, 0.0);
+        order_stats_.initialize(window_size_);
+        clear();
+    }
+
+    void clear()
+    {
+        n = 0;
+        next_index_ = 0;
+        total_count_ = 0;
+        m1 = m2 = 0.0;
+        order_stats_.clear();
+    }
+
+    //non-finite samples are skipped, they would poison mean and variance for good
+    void insert(double x)
+    {
+        if (!std::isfinite(x))
+            return;
+
+        if (n == window_size_)
+            remove(window_[next_index_]);
+
+        window_[next_index_] = x;
+        next_index_ = (next_index_ + 1) % window_size_;
+        order_stats_.insert(x);
+        ++total_count_;
+
+        n++;
+        double delta = x - m1;
+        m1 += delta / n;
+        m2 += delta * (x - m1);
+    }
+
+    int64_t size() const
+    {
+        return n;
+    }
+
+    //number of samples ever inserted since clear
+    int64_t totalCount() const
+    {
+        return total_count_;
+    }
+
+    int windowSize() const
+    {
+        return window_size_;
+    }
+
+    double mean() const
+    {
+        return m1;
+    }
+
+    double variance() const
+    {
+        return m2/(n-1.0f);
+    }
+
+    double standardDeviation() const
+    {
+        return sqrt(variance());
+    }
+
+    double min() const
+    {
+        return order_stats_.percentile(0);
+    }
+
+    double max() const
+    {
+        return order_stats_.percentile(1);
+    }
+
+    double median() const
+    {
+        return order_stats_.median();
+    }
+
+    //fraction is in [0, 1], for example 0.99 for p99 latency
+    double percentile(double fraction) const
+    {
+        return order_stats_.percentile(fraction);
+    }
+
+private:
+    void remove(double x)
+    {
+        //inverse of Welford update in insert
+        n--;
+        if (n == 0) {
+            m1 = m2 = 0.0;
+        }
+        else {
+            double delta = x - m1;
+            m1 -= delta / n;
+            m2 -= delta * (x - m1);
+            if (m2 < 0)
+                m2 = 0;
+        }
+    }
+
+private:
+    int64_t n;
+    int64_t total_count_;
+    double m1, m2;
+
+    int window_size_;
+    int next_index_;
+    std::vector<double> window_;
+    StreamingMedian<double> order_stats_;
+}; //class
+
 }  //namespace
 #endif
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef common_utils_StreamingMedian_hpp
+#define common_utils_StreamingMedian_hpp
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include "IndexableSkiplist.hpp"
+
+namespace common_utils {
+
+/*
+    Median and median absolute deviation (MAD) over sliding window of last
+    window_size samples. Samples are kept in ring buffer in arrival order and
+    in indexable skiplist in sorted order so each insert is O(log w), median
+    is O(log w) and MAD is O(log^2 w) instead of sorting the window each time.
+    Until the window fills up, statistics are computed over samples seen so far.
+*/
+template <typename T>
+class StreamingMedian {
+public:
+    StreamingMedian()
+    {
+        initialize(1);
+    }
+    StreamingMedian(int window_size)
+    {
+        initialize(window_size);
+    }
+
+    void initialize(int window_size)
+    {
+        window_size_ = std::max(window_size, 1);
+        window_.assign(window_size_, T());
+        sorted_.initialize(window_size_);
+        clear();
+    }
+
+    void clear()
+    {
+        sorted_.clear();
+        next_index_ = 0;
+    }
+
+    //adds sample, dropping the oldest one if window is full, and returns new median
+    //NaN samples are skipped: they never compare equal so could never be removed again
+    T insert(const T& value)
+    {
+        if (value != value)
+            return median();
+
+        if (isFull())
+            sorted_.remove(window_[next_index_]);
+
+        window_[next_index_] = value;
+        sorted_.insert(value);
+        next_index_ = (next_index_ + 1) % window_size_;
+
+        return median();
+    }
+
+    int size() const
+    {
+        return sorted_.size();
+    }
+
+    int windowSize() const
+    {
+        return window_size_;
+    }
+
+    bool isFull() const
+    {
+        return sorted_.size() == window_size_;
+    }
+
+    //upper median for even sizes, same as sorting window and picking [n/2]
+    T median() const
+    {
+        if (sorted_.empty())
+            return std::numeric_limits<T>::quiet_NaN();
+        return sorted_[sorted_.size() / 2];
+    }
+
+    //k-th smallest sample in window
+    T at(int index) const
+    {
+        return sorted_[index];
+    }
+
+    //value below which given fraction [0, 1] of window falls
+    T percentile(double fraction) const
+    {
+        if (sorted_.empty())
+            return std::numeric_limits<T>::quiet_NaN();
+        int index = static_cast<int>(fraction * (sorted_.size() - 1) + 0.5);
+        index = std::min(std::max(index, 0), sorted_.size() - 1);
+        return sorted_[index];
+    }
+
+    //median(|x_i - median(x)|)
+    T mad() const
+    {
+        int n = sorted_.size();
+        if (n == 0)
+            return std::numeric_limits<T>::quiet_NaN();
+
+        /*
+            Deviations from median come as two sorted runs: values below median
+            read right to left and values at or above median read left to right.
+            MAD is k-th smallest of the merge of these runs which we find by
+            binary search on how many elements come from the lower run.
+        */
+        T m = median();
+        int lower_count = sorted_.countLess(m);
+        int upper_count = n - lower_count;
+        int k = n / 2 + 1; //number of smallest deviations we need
+
+        int lo = std::max(0, k - upper_count), hi = std::min(k, lower_count);
+        while (lo < hi) {
+            int i = (lo + hi) / 2;
+            int j = k - i;
+            //if i-th lower deviation is smaller than j-1-th upper deviation, we need more from lower run
+            if (lowerDeviation(m, lower_count, i) < upperDeviation(m, lower_count, j - 1))
+                lo = i + 1;
+            else
+                hi = i;
+        }
+
+        int i = lo, j = k - lo;
+        T result = T();
+        bool has_result = false;
+        if (i > 0) {
+            result = lowerDeviation(m, lower_count, i - 1);
+            has_result = true;
+        }
+        if (j > 0) {
+            T upper = upperDeviation(m, lower_count, j - 1);
+            result = has_result ? std::max(result, upper) : upper;
+        }
+        return result;
+    }
+
+private:
+    T lowerDeviation(const T& m, int lower_count, int index) const
+    {
+        return m - sorted_[lower_count - 1 - index];
+    }
+    T upperDeviation(const T& m, int lower_count, int index) const
+    {
+        return sorted_[lower_count + index] - m;
+    }
+
+private:
+    int window_size_;
+    int next_index_;
+    std::vector<T> window_;
+    IndexableSkiplist<T> sorted_;
+};
+
+} //namespace
+#endif
@@ -126,42 +126,50 @@ public:
         return static_cast<float>(radians * 180.0f / M_PI);
     }
 
-    static void logMessage(const char* format, ...) {
-        va_list args;
-        va_start(args, format);
+    //messages that fit in this many chars are formatted on stack, only longer ones go to heap
+    static constexpr size_t LogBufferSize = 512;
 
+    static const char* formatLogMessage(char (&stack_buf)[LogBufferSize], std::unique_ptr<char[]>& heap_buf,
+        const char* format, va_list args) {
         auto size = _vscprintf(format, args) + 1U;
-        std::unique_ptr<char[]> buf(new char[size]);
+        char* buf = stack_buf;
+        if (size > LogBufferSize) {
+            heap_buf.reset(new char[size]);
+            buf = heap_buf.get();
+        }
 
 #ifndef _MSC_VER
         IGNORE_FORMAT_STRING_ON
-        vsnprintf(buf.get(), size, format, args);
+        vsnprintf(buf, size, format, args);
         IGNORE_FORMAT_STRING_OFF
 #else
-        vsnprintf_s(buf.get(), size, _TRUNCATE, format, args);
+        vsnprintf_s(buf, size, _TRUNCATE, format, args);
 #endif
+        return buf;
+    }
+
+    static void logMessage(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+
+        char stack_buf[LogBufferSize];
+        std::unique_ptr<char[]> heap_buf;
+        const char* message = formatLogMessage(stack_buf, heap_buf, format, args);
         va_end(args);
 
-        Log::getLog()->logMessage(buf.get());
+        Log::getLog()->logMessage(message);
     }
 
     static void logError(const char* format, ...) {
         va_list args;
         va_start(args, format);
 
-        auto size = _vscprintf(format, args) + 1U;
-        std::unique_ptr<char[]> buf(new char[size]);
-
-#ifndef _MSC_VER
-        IGNORE_FORMAT_STRING_ON
-        vsnprintf(buf.get(), size, format, args);
-        IGNORE_FORMAT_STRING_OFF
-#else
-        vsnprintf_s(buf.get(), size, _TRUNCATE, format, args);
-#endif
+        char stack_buf[LogBufferSize];
+        std::unique_ptr<char[]> heap_buf;
+        const char* message = formatLogMessage(stack_buf, heap_buf, format, args);
         va_end(args);
 
-        Log::getLog()->logError(buf.get());
+        Log::getLog()->logError(message);
     }
 
     template <typename T>
@@ -0,0 +1,344 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_CommandEngine_hpp
+#define msr_airlib_CommandEngine_hpp
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+#include "common/UpdatableObject.hpp"
+#include "DroneControllerBase.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Runs move commands of any number of drones without a thread per
+    command. Commands are submitted as MotionTasks and get a handle back
+    right away; the simulator adds the engine to its world so update()
+    runs on the physics thread after the vehicles, and each active task is
+    stepped once its command period has passed. So a command costs one
+    step per period on the physics thread instead of a sleeping thread, and
+    its timing follows physics ticks rather than OS scheduling or the
+    rendered frame rate.
+    Tasks are stepped outside the engine lock, so a slow controller doesn't
+    hold up API calls for other drones.
+
+    Like the blocking API each drone runs one command at a time: submitting
+    a new task, or starting a blocking command through
+    DroneControllerCancelable, cancels the running one.
+
+    Status of finished commands is kept for the last max_finished handles,
+    callers can poll getStatus() or block in wait() from any thread.
+*/
+class CommandEngine : public UpdatableObject {
+public: //types
+    typedef uint64_t Handle;
+
+    enum class Status : int {
+        Unknown = 0,    //never issued or forgotten
+        Running = 1,
+        Completed = 2,
+        Cancelled = 3,
+        Failed = 4
+    };
+
+    struct Params {
+        uint max_finished = 10000;
+        int stats_window = 1000;
+    };
+
+public:
+    CommandEngine()
+        : CommandEngine(Params())
+    {
+    }
+    CommandEngine(const Params& params)
+        : params_(params), next_handle_(1), is_stopped_(false), completed_count_(0), cancelled_count_(0), failed_count_(0)
+    {
+        tick_times_.initialize(params.stats_window);
+        CommandEngine::reset();
+    }
+
+    ~CommandEngine()
+    {
+        stop();
+    }
+
+    //task starts at next tick(), throws if engine was stopped
+    Handle submit(DroneControllerBase* controller, DroneControllerBase::MotionTaskPtr task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (is_stopped_)
+            throw VehicleControllerException("Cannot start the command because simulation is shutting down");
+
+        Slot& slot = getSlot(controller);
+        if (isRunning(slot))
+            finish(slot, Status::Cancelled, "");
+
+        slot.handle = next_handle_++;
+        slot.task = std::move(task);
+        running_[slot.handle] = &slot;
+        slot.is_started = false;
+        //first step happens on the next tick
+        slot.elapsed = slot.task->getStepPeriod();
+        return slot.handle;
+    }
+
+    //returns false if command was not running
+    bool cancel(Handle handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = running_.find(handle);
+        if (it == running_.end())
+            return false;
+        finish(*it->second, Status::Cancelled, "");
+        return true;
+    }
+
+    //cancels whatever is running for controller and waits if it is being stepped right now,
+    //so the caller can issue its own commands; must not be called from a task step
+    void cancel(DroneControllerBase* controller)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = slot_index_.find(controller);
+        if (it == slot_index_.end())
+            return;
+        Slot& slot = *it->second;
+        if (isRunning(slot))
+            finish(slot, Status::Cancelled, "");
+        finished_cv_.wait(lock, [&slot]() { return !slot.is_stepping; });
+    }
+
+    Status getStatus(Handle handle, string* message = nullptr) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return getStatusLocked(handle, message);
+    }
+
+    //blocks until command is no longer running or timeout passes, negative timeout waits forever
+    Status wait(Handle handle, float timeout_sec, string* message = nullptr)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto is_done = [&]() {
+            return getStatusLocked(handle, nullptr) != Status::Running;
+        };
+        if (timeout_sec < 0)
+            finished_cv_.wait(lock, is_done);
+        else
+            finished_cv_.wait_for(lock, std::chrono::duration<double>(timeout_sec), is_done);
+        return getStatusLocked(handle, message);
+    }
+
+    //*** Start: UpdatableState implementation ***//
+    virtual void reset() override
+    {
+        last_update_ = clock()->nowNanos();
+    }
+
+    virtual void update() override
+    {
+        tick(static_cast<float>(clock()->updateSince(last_update_)));
+    }
+    //*** End: UpdatableState implementation ***//
+
+    //dt in seconds; each task is stepped at most once per call so rate is capped by the caller's rate
+    void tick(float dt)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+
+        //take due tasks out of their slots, they are stepped without holding the lock
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            due_.clear();
+            for (Slot& slot : slots_) {
+                if (slot.task == nullptr)
+                    continue;
+                float period = slot.task->getStepPeriod();
+                slot.elapsed += dt;
+                if (slot.elapsed < period)
+                    continue;
+                //keep the remainder so steps follow the period on average, but don't let it
+                //build up to more than one step as drone state doesn't change within a tick
+                slot.elapsed = std::min(slot.elapsed - period, period);
+
+                slot.is_stepping = true;
+                due_.push_back(Step{ &slot, slot.handle, std::move(slot.task), slot.is_started, Status::Running, "" });
+                slot.is_started = false;
+            }
+        }
+
+        for (Step& step : due_) {
+            try {
+                if (!step.is_started) {
+                    if (step.slot->controller->loopCommandPre())
+                        step.is_started = true;
+                    else {
+                        step.status = Status::Failed;
+                        step.message = "Cannot start the command because loopCommandPre returned failed status";
+                        continue;
+                    }
+                }
+                if (step.task->step())
+                    step.status = Status::Completed;
+            }
+            catch (const std::exception& ex) {
+                step.status = Status::Failed;
+                step.message = ex.what();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Step& step : due_) {
+            Slot& slot = *step.slot;
+            slot.is_stepping = false;
+            if (running_.find(step.handle) != running_.end()) {
+                slot.task = std::move(step.task);
+                slot.is_started = step.is_started;
+                if (step.status != Status::Running)
+                    finish(slot, step.status, step.message);
+            }
+            else {
+                //cancelled or replaced while it was stepping, status is already recorded
+                if (step.is_started)
+                    slot.controller->loopCommandPost();
+            }
+        }
+        if (due_.size() > 0) {
+            finished_cv_.notify_all();
+            tick_times_.insert(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+        }
+        due_.clear();
+    }
+
+    //cancels everything and refuses new commands, wakes up all waiters
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopped_ = true;
+        for (Slot& slot : slots_) {
+            if (isRunning(slot))
+                finish(slot, Status::Cancelled, "");
+        }
+    }
+
+    string getReport() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Commands: " << running_.size() << " running, " << completed_count_ << " completed, " << cancelled_count_
+            << " cancelled, " << failed_count_ << " failed";
+        if (tick_times_.size() > 0)
+            ss << ", tick p50 " << tick_times_.percentile(0.5) * 1E6 << " us, max " << tick_times_.max() * 1E6 << " us";
+        ss << std::endl;
+        return ss.str();
+    }
+
+private: //types
+    struct Slot {
+        DroneControllerBase* controller;
+        Handle handle;
+        DroneControllerBase::MotionTaskPtr task;
+        bool is_started;
+        float elapsed;
+        //task is out of the slot in tick(), being stepped
+        bool is_stepping;
+    };
+
+    struct Step {
+        Slot* slot;
+        Handle handle;
+        DroneControllerBase::MotionTaskPtr task;
+        bool is_started;
+        Status status;
+        string message;
+    };
+
+    struct Finished {
+        Status status;
+        string message;
+    };
+
+private:
+    Slot& getSlot(DroneControllerBase* controller)
+    {
+        auto it = slot_index_.find(controller);
+        if (it != slot_index_.end())
+            return *it->second;
+        slots_.push_back(Slot{ controller, 0, nullptr, false, 0, false });
+        slot_index_[controller] = &slots_.back();
+        return slots_.back();
+    }
+
+    bool isRunning(const Slot& slot) const
+    {
+        return running_.find(slot.handle) != running_.end();
+    }
+
+    Status getStatusLocked(Handle handle, string* message) const
+    {
+        if (message != nullptr)
+            message->clear();
+
+        if (running_.find(handle) != running_.end())
+            return Status::Running;
+        auto it = finished_.find(handle);
+        if (it == finished_.end())
+            return Status::Unknown;
+        if (message != nullptr)
+            *message = it->second.message;
+        return it->second.status;
+    }
+
+    void finish(Slot& slot, Status status, const string& message)
+    {
+        if (slot.is_started)
+            slot.controller->loopCommandPost();
+        slot.task.reset();
+        slot.is_started = false;
+        running_.erase(slot.handle);
+
+        finished_[slot.handle] = Finished{ status, message };
+        finished_order_.push_back(slot.handle);
+        while (finished_order_.size() > params_.max_finished) {
+            finished_.erase(finished_order_.front());
+            finished_order_.pop_front();
+        }
+
+        if (status == Status::Completed)
+            ++completed_count_;
+        else if (status == Status::Cancelled)
+            ++cancelled_count_;
+        else
+            ++failed_count_;
+        finished_cv_.notify_all();
+    }
+
+private:
+    Params params_;
+    //one per controller ever seen, slot with null task is idle or being stepped; deque keeps pointers to slots valid
+    std::deque<Slot> slots_;
+    //tasks taken out for stepping, only used by tick() so it is reused without lock
+    vector<Step> due_;
+    unordered_map<DroneControllerBase*, Slot*> slot_index_;
+    unordered_map<Handle, Slot*> running_;
+    unordered_map<Handle, Finished> finished_;
+    std::deque<Handle> finished_order_;
+    Handle next_handle_;
+    bool is_stopped_;
+    TTimePoint last_update_;
+    uint64_t completed_count_, cancelled_count_, failed_count_;
+    common_utils::RollingOnlineStats tick_times_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable finished_cv_;
+};
+
+}} //namespace
+#endif
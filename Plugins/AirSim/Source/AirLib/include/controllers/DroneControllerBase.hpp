@@ -8,12 +8,18 @@
 #include "common/Common.hpp"
 #include "Waiter.hpp"
 #include "safety/SafetyEval.hpp"
+#include "planning/PathPlanner.hpp"
+#include "planning/MultiAgentPlanner.hpp"
+#include "MpcController.hpp"
+#include "sensors/detection/TargetDetector.hpp"
 #include "common/CommonStructs.hpp"
 #include "VehicleControllerBase.hpp"
 #include "DroneCommon.hpp"
 
 namespace msr { namespace airlib {
 
+class CommandEngine;
+
 /// DroneControllerBase represents a generic drone that can be controlled and queried for current state.
 /// All control methods return a boolean where true means the command was completed successfully, and
 /// false means the command was cancelled.  
@@ -69,6 +75,39 @@ public: //types
     };
     typedef common_utils::EnumFlags<ImageType>  ImageTypeFlags;
 
+    /// Move command as a resumable state machine. Blocking move commands run one of these with a Waiter
+    /// between steps, CommandEngine steps many of them from the simulation tick instead so concurrent
+    /// commands don't need a thread each.
+    class MotionTask {
+    public:
+        MotionTask(float step_period)
+            : step_period_(step_period)
+        {
+        }
+        virtual ~MotionTask() = default;
+
+        /// Sends commands for one step, returns true once the command has completed.
+        /// Throws the same exceptions as the blocking command would.
+        virtual bool step() = 0;
+
+        /// Seconds between steps, the command period of the drone
+        float getStepPeriod() const
+        {
+            return step_period_;
+        }
+
+    private:
+        float step_period_;
+    };
+    typedef unique_ptr<MotionTask> MotionTaskPtr;
+
+    //one stream of images the simulator should capture for this drone
+    struct ImageRequest {
+        int camera_id;
+        ImageType image_type;   //single type, never a combination
+        float rate;             //images per second, 0 means every rendered frame
+    };
+
 public: //interface for outside world
     /// The drone must be armed before it will fly.  Set arm to true to arm the drone.  
     /// On some drones arming may cause the motors to spin on low throttle, this is normal.
@@ -150,6 +189,23 @@ public: //interface for outside world
     virtual bool moveToPosition(float x, float y, float z, float velocity, DrivetrainType drivetrain,
         const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action);
 
+    /// Same as moveToPosition except the path is planned around obstacles known to the simulator (see setPathPlanner).
+    /// If obstacle map changes while flying and remaining path becomes blocked, path is planned again from the current
+    /// position. Throws VehicleMoveException if no collision free path exists.
+    virtual bool moveToPositionPlanned(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action);
+
+    /// Fly a time parameterized trajectory such as one from planTrajectories: positions[i] is the target at
+    /// i * step_sec seconds after the call. Drone tracks the moving target rather than path geometry so that
+    /// several drones started together keep the separation the trajectories were planned with. If MPC is
+    /// enabled (see enableMpc) it is used for tracking, otherwise position setpoints follow the target.
+    virtual bool moveOnTrajectory(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode,
+        CancelableBase& cancelable_action);
+
+    /// Non-blocking velocity setpoint for in-sim controllers that run their own loop, such as OpponentAi.
+    /// Goes through the same safety checks as moveByVelocity. Caller is responsible for loopCommandPre/Post.
+    virtual bool setVelocitySetpoint(const Vector3r& velocity, const YawMode& yaw_mode);
+
     /// moveToZ is a shortcut for moveToPosition at the current x, y location.
     virtual bool moveToZ(float z, float velocity, const YawMode& yaw_mode,
         float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action);
@@ -167,6 +223,31 @@ public: //interface for outside world
     /// and move back to the location it was at when this command was received and hover there.  
     virtual bool hover(CancelableBase& cancelable_action);
 
+    /// Tasks for the move commands above: same arguments and validation as the blocking call, but nothing
+    /// is sent to the drone until step() is called. The task keeps a reference to this controller.
+    virtual MotionTaskPtr createMoveByAngleTask(float pitch, float roll, float z, float yaw, float duration);
+    virtual MotionTaskPtr createMoveByVelocityTask(float vx, float vy, float vz, float duration, DrivetrainType drivetrain,
+        const YawMode& yaw_mode);
+    virtual MotionTaskPtr createMoveByVelocityZTask(float vx, float vy, float z, float duration, DrivetrainType drivetrain,
+        const YawMode& yaw_mode);
+    virtual MotionTaskPtr createMoveOnPathTask(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead);
+    virtual MotionTaskPtr createMoveToPositionTask(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead);
+    virtual MotionTaskPtr createMoveOnTrajectoryTask(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode);
+    virtual MotionTaskPtr createMoveToZTask(float z, float velocity, const YawMode& yaw_mode,
+        float lookahead, float adaptive_lookahead);
+    virtual MotionTaskPtr createRotateToYawTask(float yaw, float margin);
+    virtual MotionTaskPtr createRotateByYawRateTask(float yaw_rate, float duration);
+    virtual MotionTaskPtr createHoverTask();
+    /// Climbs to getTakeoffZ() above where the task starts, fails after max_wait_seconds. Unlike takeoff() it
+    /// doesn't use the firmware's takeoff mode, so it can run on the command engine for any controller.
+    virtual MotionTaskPtr createTakeoffTask(float max_wait_seconds);
+
+    /// Engine that runs tasks submitted through the non-blocking API, set by the simulator; may be null.
+    virtual void setCommandEngine(const shared_ptr<CommandEngine> command_engine);
+    virtual shared_ptr<CommandEngine> getCommandEngine() const;
+
     /// get the current local position in NED coordinate (x=North/y=East,z=Down) so z is negative.
     virtual Vector3r getPosition() = 0;
 
@@ -209,11 +290,48 @@ public: //interface for outside world
         float obs_avoidance_vel, const Vector3r& origin, float xy_length, float max_z, float min_z);
     virtual const VehicleParams& getVehicleParams() = 0;
 
+    //optional MPC for trajectory tracking, solve time budget is the command period
+    virtual void enableMpc(const MpcController::Params& params);
+    //null if MPC is not enabled
+    virtual const MpcController* getMpcController() const;
+
+    //controller specific lines for simulator report, empty by default
+    virtual string getReport();
+
+    //path planning, origin_offset is position of this vehicle's NED origin in planner coordinates,
+    //vehicle_origins are the same for every simulated vehicle
+    virtual void setPathPlanner(const shared_ptr<PathPlanner> path_planner, const Vector3r& origin_offset,
+        const vector<Vector3r>& vehicle_origins);
+    /// Plan collision free path from current position to goal, returns waypoints after the current position
+    /// ending at goal or empty path if planning failed or no planner is available.
+    virtual vector<Vector3r> planPath(const Vector3r& goal);
+    /// Plan mutually collision free trajectories for a group of drones from starts to goals, all in this
+    /// drone's NED frame. Trajectory of an agent is empty if planning failed for it. Trajectories are meant
+    /// to be flown with moveOnTrajectory, all started at the same time, each after moving it in to the frame
+    /// of the vehicle flying it with getVehicleOrigins.
+    virtual vector<MultiAgentPlanner::Trajectory> planTrajectories(const vector<Vector3r>& starts, const vector<Vector3r>& goals,
+        float velocity, float separation);
+    /// NED origin of each simulated vehicle in this drone's frame, in simulator vehicle order. Subtract origins[k]
+    /// from a position in this drone's frame, such as a planTrajectories result, to get it in vehicle k's frame.
+    /// Empty if path planning is not enabled.
+    virtual vector<Vector3r> getVehicleOrigins();
+
 
     /// Call this method when you want to start requesting certain types of images for a given camera.  Camera id's start at 0
     /// and increment from there.  The number of cameras you can configure depends on the drone (or simulator).
+    /// The type may be a combination of flags, for example Scene | Depth, to get several image types from the same camera.
     virtual void setImageTypeForCamera(int camera_id, ImageType type);
 
+    /// Set how many images per second you want for the given camera and image type, 0 (the default) means every rendered frame.
+    /// The simulator may not achieve the rate if many streams are requested, see capture stats in the simulator report.
+    virtual void setImageRateForCamera(int camera_id, ImageType type, float rate);
+
+    /// Get the rate set by setImageRateForCamera
+    virtual float getImageRateForCamera(int camera_id, ImageType type);
+
+    /// All image streams enabled via setImageTypeForCamera, one entry per camera and single image type
+    virtual void getImageRequests(vector<ImageRequest>& requests);
+
     /// Get the image type that is configured for the given camera id.
     virtual ImageType getImageTypeForCamera(int camera_id);
 
@@ -223,6 +341,13 @@ public: //interface for outside world
 
     /// bugbug: what is this doing here?  This should be a private implementation detail of the particular drone implementation.
     virtual void setImageForCamera(int camera_id, ImageType type, const vector<uint8_t>& image);
+    /// Same as above but copies from raw buffer in to storage kept from previous image so per frame capture doesn't allocate.
+    virtual void setImageForCamera(int camera_id, ImageType type, const uint8_t* data, size_t size);
+
+    /// Vehicles seen by this vehicle's cameras at the last detection update, empty unless detection is enabled in settings.
+    virtual vector<TargetDetector::Detection> getDetections();
+    /// Called by the simulator with detections of this vehicle, copies in to storage kept from previous call.
+    virtual void setDetections(const TargetDetector::Detection* detections, size_t count);
 
     //*********************************common pre & post for move commands***************************************************
     //TODO: make these protected
@@ -269,6 +394,8 @@ protected: //must implement interface by derived class
     using EnumClassUnorderedMap = std::unordered_map<Key, T, EnumClassHashType<Key>>;
 
     unordered_map<int, EnumClassUnorderedMap<ImageType, vector<uint8_t>>> images;
+    unordered_map<int, EnumClassUnorderedMap<ImageType, float>> image_rates;
+    vector<TargetDetector::Detection> detections;
 
 protected: //optional oveerides recommanded for any drones, default implementation may work
     virtual float getAutoLookahead(float velocity, float adaptive_lookahead,
@@ -284,20 +411,27 @@ protected: //utility functions and data members for derived classes
 
     //useful for derived class to check after takeoff
     virtual bool waitForZ(float max_wait_seconds, float z, float margin, CancelableBase& cancelable_action);
+    virtual MotionTaskPtr createWaitForZTask(float max_wait_seconds, float z, float margin);
+
+    //steps task at command period until it completes (true) or action is cancelled (false)
+    bool runTask(MotionTask& task, CancelableBase& cancelable_action);
 
 
     //*********************************safe wrapper around low level commands***************************************************
-    virtual bool moveByVelocity(float vx, float vy, float vz, const YawMode& yaw_mode);
-    virtual bool moveByVelocityZ(float vx, float vy, float z, const YawMode& yaw_mode);
-    virtual bool moveToPosition(const Vector3r& dest, const YawMode& yaw_mode);
+    //yaw_mode is as sent to the drone, already adjusted for drivetrain (see adjustYaw)
+    virtual bool moveByVelocity(float vx, float vy, float vz, DrivetrainType drivetrain, const YawMode& yaw_mode);
+    virtual bool moveByVelocityZ(float vx, float vy, float z, DrivetrainType drivetrain, const YawMode& yaw_mode);
+    virtual bool moveToPosition(const Vector3r& dest, DrivetrainType drivetrain, const YawMode& yaw_mode);
     virtual bool moveByRollPitchZ(float pitch, float roll, float z, float yaw);
     //****************************************************************************************************************************
 
     /************* safety checks & emergency manuevers ************/
-    virtual bool emergencyManeuverIfUnsafe(const SafetyEval::EvalResult& result);
-    virtual bool safetyCheckVelocity(const Vector3r& velocity);
-    virtual bool safetyCheckVelocityZ(float vx, float vy, float z);
-    virtual bool safetyCheckDestination(const Vector3r& dest_loc);
+    //heading is direction the command moves in, avoidance keeps the command's yaw mode and drivetrain
+    virtual bool emergencyManeuverIfUnsafe(const SafetyEval::EvalResult& result, const Vector3r& heading,
+        DrivetrainType drivetrain, const YawMode& yaw_mode);
+    virtual bool safetyCheckVelocity(const Vector3r& velocity, DrivetrainType drivetrain, const YawMode& yaw_mode);
+    virtual bool safetyCheckVelocityZ(float vx, float vy, float z, DrivetrainType drivetrain, const YawMode& yaw_mode);
+    virtual bool safetyCheckDestination(const Vector3r& dest_loc, DrivetrainType drivetrain, const YawMode& yaw_mode);
     /************* safety checks & emergency manuevers ************/
 
     void logHomePoint();
@@ -347,6 +481,15 @@ private:    //types
         }
     };
 
+    //MotionTask implementations, defined in the .cpp
+    class SetpointTask;
+    class PathTask;
+    class TrajectoryTask;
+    class RotateToYawTask;
+    class RotateByYawRateTask;
+    class WaitForZTask;
+    class TakeoffTask;
+
 private: //methods
     float setNextPathPosition(const vector<Vector3r>& path, const vector<PathSegment>& path_segs,
         const PathPosition& cur_path_loc, float next_dist, PathPosition& next_path_loc);
@@ -359,8 +502,16 @@ private: //methods
 
     bool isYawWithinMargin(float yaw_target, float margin);
 
+    static Vector3r getTrajectoryPosition(const vector<Vector3r>& positions, float step_sec, float time_sec);
+
 private:// vars
     shared_ptr<SafetyEval> safety_eval_ptr_;
+    shared_ptr<PathPlanner> path_planner_;
+    Vector3r path_planner_offset_ = Vector3r::Zero();
+    vector<Vector3r> vehicle_origins_;
+    shared_ptr<MultiAgentPlanner> multi_agent_planner_;
+    std::unique_ptr<MpcController> mpc_;
+    shared_ptr<CommandEngine> command_engine_;
     float obs_avoidance_vel_ = 0.5f;
     bool log_to_file_ = false;
 
@@ -6,6 +6,7 @@
 
 #include "common/Common.hpp"
 #include "controllers/DroneControllerBase.hpp"
+#include "controllers/CommandEngine.hpp"
 #include "Waiter.hpp"
 #include <atomic>
 
@@ -95,6 +96,35 @@ public:
         return controller_->moveToPosition(x, y, z, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead, *this);
     }
 
+    bool moveToPositionPlanned(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+    {
+        CallLock lock(controller_, action_mutex_, &is_cancelled_, true);
+        return controller_->moveToPositionPlanned(x, y, z, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead, *this);
+    }
+
+    vector<Vector3r> planPath(const Vector3r& goal)
+    {
+        return controller_->planPath(goal);
+    }
+
+    vector<MultiAgentPlanner::Trajectory> planTrajectories(const vector<Vector3r>& starts, const vector<Vector3r>& goals,
+        float velocity, float separation)
+    {
+        return controller_->planTrajectories(starts, goals, velocity, separation);
+    }
+
+    vector<Vector3r> getVehicleOrigins()
+    {
+        return controller_->getVehicleOrigins();
+    }
+
+    bool moveOnTrajectory(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode)
+    {
+        CallLock lock(controller_, action_mutex_, &is_cancelled_, true);
+        return controller_->moveOnTrajectory(positions, step_sec, yaw_mode, *this);
+    }
+
     bool moveToZ(float z, float velocity, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
     {
         CallLock lock(controller_, action_mutex_, &is_cancelled_, true);
@@ -133,6 +163,61 @@ public:
         return controller_->hover(*this);
     }
 
+    //non-blocking versions of move commands, they return right away with handle to pass to
+    //getCommandStatus, waitForCommand or cancelCommand while the simulator steps the command
+    CommandEngine::Handle moveByVelocityAsync(float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
+    {
+        return submit(controller_->createMoveByVelocityTask(vx, vy, vz, duration, drivetrain, yaw_mode));
+    }
+    CommandEngine::Handle moveByVelocityZAsync(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
+    {
+        return submit(controller_->createMoveByVelocityZTask(vx, vy, z, duration, drivetrain, yaw_mode));
+    }
+    CommandEngine::Handle moveOnPathAsync(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode,
+        float lookahead, float adaptive_lookahead)
+    {
+        return submit(controller_->createMoveOnPathTask(path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead));
+    }
+    CommandEngine::Handle moveToPositionAsync(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+    {
+        return submit(controller_->createMoveToPositionTask(x, y, z, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead));
+    }
+    CommandEngine::Handle moveOnTrajectoryAsync(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode)
+    {
+        return submit(controller_->createMoveOnTrajectoryTask(positions, step_sec, yaw_mode));
+    }
+    CommandEngine::Handle moveToZAsync(float z, float velocity, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+    {
+        return submit(controller_->createMoveToZTask(z, velocity, yaw_mode, lookahead, adaptive_lookahead));
+    }
+    CommandEngine::Handle rotateToYawAsync(float yaw, float margin)
+    {
+        return submit(controller_->createRotateToYawTask(yaw, margin));
+    }
+    CommandEngine::Handle rotateByYawRateAsync(float yaw_rate, float duration)
+    {
+        return submit(controller_->createRotateByYawRateTask(yaw_rate, duration));
+    }
+    CommandEngine::Handle hoverAsync()
+    {
+        return submit(controller_->createHoverTask());
+    }
+
+    CommandEngine::Status getCommandStatus(CommandEngine::Handle handle, string* message = nullptr)
+    {
+        return getCommandEngine().getStatus(handle, message);
+    }
+    //negative timeout waits until command finishes
+    CommandEngine::Status waitForCommand(CommandEngine::Handle handle, float timeout_sec, string* message = nullptr)
+    {
+        return getCommandEngine().wait(handle, timeout_sec, message);
+    }
+    bool cancelCommand(CommandEngine::Handle handle)
+    {
+        return getCommandEngine().cancel(handle);
+    }
+
     //status getters
     //TODO: add single call to get all of the state
     Vector3r getPosition()
@@ -201,15 +286,31 @@ public:
     {
         return controller_->getImageTypeForCamera(camera_id);
     }
+    void setImageRateForCamera(int camera_id, DroneControllerBase::ImageType type, float rate)
+    {
+        controller_->setImageRateForCamera(camera_id, type, rate);
+    }
+    float getImageRateForCamera(int camera_id, DroneControllerBase::ImageType type)
+    {
+        return controller_->getImageRateForCamera(camera_id, type);
+    }
     //get/set image
     void setImageForCamera(int camera_id, DroneControllerBase::ImageType type, const vector<uint8_t>& image)
     {
         return controller_->setImageForCamera(camera_id, type, image);
     }
+    void setImageForCamera(int camera_id, DroneControllerBase::ImageType type, const uint8_t* data, size_t size)
+    {
+        controller_->setImageForCamera(camera_id, type, data, size);
+    }
     vector<uint8_t> getImageForCamera(int camera_id, DroneControllerBase::ImageType type)
     {
         return controller_->getImageForCamera(camera_id, type);
     }
+    vector<TargetDetector::Detection> getDetections()
+    {
+        return controller_->getDetections();
+    }
 
 
     /*** Implementation of CancelableBase ***/
@@ -223,6 +324,23 @@ public:
     }
     /*** Implementation of CancelableBase ***/
 
+private: //methods
+    CommandEngine& getCommandEngine()
+    {
+        auto engine = controller_->getCommandEngine();
+        if (engine == nullptr)
+            throw VehicleControllerException("Non-blocking commands are not available because there is no command engine for this vehicle");
+        return *engine;
+    }
+
+    CommandEngine::Handle submit(DroneControllerBase::MotionTaskPtr task)
+    {
+        CommandEngine& engine = getCommandEngine();
+        //only one command at a time, this stops any blocking command in progress
+        CallLock lock(controller_, action_mutex_, &is_cancelled_);
+        return engine.submit(controller_, std::move(task));
+    }
+
 private:// types
     struct CallLock {
         CallLock(DroneControllerBase* controller, std::mutex& mtx, std::atomic_bool* is_cancelled, bool is_loop_command = false)
@@ -237,6 +355,11 @@ private:// types
             //reset cancellation before we proceed
             *is_cancelled_ = false;
 
+            //commands started via the non-blocking API are stopped too
+            auto engine = controller_->getCommandEngine();
+            if (engine != nullptr)
+                engine->cancel(controller_);
+
             if (is_loop_command) {
                 if (!controller_->loopCommandPre())
                     throw VehicleControllerException("Cannot start the command because loopCommandPre returned failed status");
@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_MpcController_hpp
+#define msr_airlib_MpcController_hpp
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/EarthUtils.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Model predictive controller for tracking reference trajectory. Vehicle
+    is modeled as double integrator on each axis with acceleration as input,
+    and acceleration limits come from max tilt (horizontal) and thrust range
+    (vertical). Each solve minimizes position and velocity tracking error
+    plus control effort over fixed horizon:
+
+        min 1/2 u'Hu + g'u  subject to  lower <= u <= upper
+
+    which is a small box constrained QP in condensed form. H only depends on
+    params so it's built once in initialize(), per solve only g changes.
+    Axes are independent so the three QPs are solved together as columns of
+    one matrix by accelerated projected gradient (FISTA), warm started from
+    previous solution shifted by one step. All matrices are fixed size so a
+    solve never touches the heap.
+
+    Solve times are kept over a rolling window and compared against budget,
+    typically the command period of the controller, so the report shows if
+    MPC fits in to control loop.
+*/
+class MpcController {
+public: //types
+    static constexpr int Horizon = 20;
+    typedef Eigen::Matrix<float, Horizon, Horizon> HorizonMatrix;
+    typedef Eigen::Matrix<float, Horizon, 3> HorizonVectors;
+
+    struct Params {
+        real_T dt = 0.1f;                   //prediction step, horizon covers Horizon * dt seconds
+        real_T position_weight = 1;
+        real_T velocity_weight = 0.2f;
+        real_T acceleration_weight = 0.05f;
+        real_T max_tilt = 0.5f;             //radians, limits horizontal acceleration
+        real_T max_thrust_accel = 2 * EarthUtils::Gravity;  //max thrust / mass
+        real_T min_thrust_accel = 0;        //min thrust / mass
+        uint max_iterations = 50;
+        real_T tolerance = 1E-4f;           //stop when no input changes more than this, m/s^2
+        int stats_window = 1000;            //solves kept for percentiles
+    };
+
+    struct SolveStats {
+        uint64_t solves = 0;
+        uint64_t over_budget = 0;
+        double p50_sec = 0, p90_sec = 0, p99_sec = 0, max_sec = 0;
+        double avg_iterations = 0;
+    };
+
+public:
+    MpcController()
+    {
+        initialize(Params(), 0);
+    }
+    MpcController(const Params& params, double budget_sec)
+    {
+        initialize(params, budget_sec);
+    }
+
+    void initialize(const Params& params, double budget_sec)
+    {
+        params_ = params;
+        budget_sec_ = budget_sec;
+
+        //predicted position and velocity at steps 1..Horizon as linear function of inputs
+        float dt = params.dt;
+        position_gain_.setZero();
+        velocity_gain_.setZero();
+        for (int k = 0; k < Horizon; ++k) {
+            for (int j = 0; j <= k; ++j) {
+                position_gain_(k, j) = (k - j + 0.5f) * dt * dt;
+                velocity_gain_(k, j) = dt;
+            }
+        }
+
+        hessian_ = params.position_weight * position_gain_.transpose() * position_gain_
+            + params.velocity_weight * velocity_gain_.transpose() * velocity_gain_;
+        hessian_.diagonal().array() += params.acceleration_weight;
+
+        //gradient step needs largest eigenvalue of H, power iteration is enough
+        Eigen::Matrix<float, Horizon, 1> v = Eigen::Matrix<float, Horizon, 1>::Ones();
+        float lipschitz = 1;
+        for (int i = 0; i < 100; ++i) {
+            Eigen::Matrix<float, Horizon, 1> hv = hessian_ * v;
+            lipschitz = hv.norm();
+            v = hv / lipschitz;
+        }
+        step_ = 1 / (lipschitz * 1.01f);
+
+        //NED: negative z is up so thrust gives acceleration of gravity - thrust
+        float max_horizontal = EarthUtils::Gravity * std::tan(params.max_tilt);
+        lower_ << -max_horizontal, -max_horizontal, EarthUtils::Gravity - params.max_thrust_accel;
+        upper_ << max_horizontal, max_horizontal, EarthUtils::Gravity - params.min_thrust_accel;
+
+        reset();
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        solve_times_.initialize(params.stats_window);
+        solve_count_ = over_budget_count_ = total_iterations_ = 0;
+    }
+
+    //drops warm start, call when starting to track new trajectory
+    void reset()
+    {
+        inputs_.setZero();
+    }
+
+    /*
+        reference[k] is desired position at (k + 1) * dt from now, for k in
+        [0, Horizon). Returns acceleration to apply now, with horizontal part
+        limited by max tilt.
+    */
+    Vector3r solve(const Vector3r& position, const Vector3r& velocity, const Vector3r* reference)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+
+        //tracking error of free response, i.e. if inputs were zero
+        float dt = params_.dt;
+        for (int k = 0; k < Horizon; ++k) {
+            Vector3r ref_velocity = (k + 1 < Horizon ? reference[k + 1] - reference[k] : reference[k] - reference[k - 1]) / dt;
+            Vector3r free_position = position + velocity * ((k + 1) * dt);
+            position_error_.row(k) = (free_position - reference[k]).transpose();
+            velocity_error_.row(k) = (velocity - ref_velocity).transpose();
+        }
+        gradient_.noalias() = params_.position_weight * position_gain_.transpose() * position_error_;
+        gradient_.noalias() += params_.velocity_weight * velocity_gain_.transpose() * velocity_error_;
+
+        //warm start: previous solution advanced by one step
+        for (int k = 0; k + 1 < Horizon; ++k)
+            inputs_.row(k) = inputs_.row(k + 1);
+        project(inputs_);
+
+        //FISTA
+        momentum_ = inputs_;
+        float t = 1;
+        uint iterations = 0;
+        while (iterations < params_.max_iterations) {
+            ++iterations;
+            previous_ = inputs_;
+            inputs_.noalias() = momentum_ - step_ * (hessian_ * momentum_ + gradient_);
+            project(inputs_);
+
+            float t_next = (1 + std::sqrt(1 + 4 * t * t)) / 2;
+            momentum_ = inputs_ + ((t - 1) / t_next) * (inputs_ - previous_);
+            t = t_next;
+
+            if ((inputs_ - previous_).cwiseAbs().maxCoeff() < params_.tolerance)
+                break;
+        }
+
+        Vector3r accel = inputs_.row(0).transpose();
+        Vector2r horizontal(accel.x(), accel.y());
+        float max_horizontal = upper_.x();
+        if (horizontal.norm() > max_horizontal) {
+            horizontal *= max_horizontal / horizontal.norm();
+            accel.x() = horizontal.x();
+            accel.y() = horizontal.y();
+        }
+
+        recordSolve(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count(), iterations);
+        return accel;
+    }
+
+    const Params& getParams() const
+    {
+        return params_;
+    }
+
+    SolveStats getSolveStats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        SolveStats stats;
+        stats.solves = solve_count_;
+        stats.over_budget = over_budget_count_;
+        if (solve_times_.size() > 0) {
+            stats.p50_sec = solve_times_.percentile(0.5);
+            stats.p90_sec = solve_times_.percentile(0.9);
+            stats.p99_sec = solve_times_.percentile(0.99);
+            stats.max_sec = solve_times_.max();
+        }
+        stats.avg_iterations = solve_count_ > 0 ? static_cast<double>(total_iterations_) / solve_count_ : 0;
+        return stats;
+    }
+
+    string getReport() const
+    {
+        SolveStats stats = getSolveStats();
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "MPC solve: p50 " << stats.p50_sec * 1E6 << " us, p90 " << stats.p90_sec * 1E6 << " us, p99 "
+            << stats.p99_sec * 1E6 << " us, max " << stats.max_sec * 1E6 << " us, budget " << budget_sec_ * 1E6 << " us, "
+            << stats.over_budget << "/" << stats.solves << " over, " << stats.avg_iterations << " iterations avg" << std::endl;
+        return ss.str();
+    }
+
+private:
+    void project(HorizonVectors& inputs) const
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            inputs.col(axis) = inputs.col(axis).cwiseMax(lower_(axis)).cwiseMin(upper_(axis));
+    }
+
+    void recordSolve(double solve_sec, uint iterations)
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        solve_times_.insert(solve_sec);
+        ++solve_count_;
+        total_iterations_ += iterations;
+        if (budget_sec_ > 0 && solve_sec > budget_sec_)
+            ++over_budget_count_;
+    }
+
+private:
+    Params params_;
+    double budget_sec_;
+
+    HorizonMatrix position_gain_, velocity_gain_, hessian_;
+    float step_;
+    Vector3r lower_, upper_;
+
+    //solver workspace, columns are x, y, z axes
+    HorizonVectors inputs_, previous_, momentum_, gradient_;
+    HorizonVectors position_error_, velocity_error_;
+
+    mutable std::mutex stats_mutex_;
+    common_utils::RollingOnlineStats solve_times_;
+    uint64_t solve_count_, over_budget_count_, total_iterations_;
+};
+
+}} //namespace
+#endif
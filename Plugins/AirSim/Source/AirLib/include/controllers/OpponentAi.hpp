@@ -0,0 +1,401 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_OpponentAi_hpp
+#define msr_airlib_OpponentAi_hpp
+
+#include <thread>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+#include "DroneControllerBase.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Scripted opponents evaluated inside the simulator. All vehicles taking
+    part, opponents and the ones they react to, are added with their
+    controller and origin offset so everything is computed in one shared
+    frame. Every control period the worker thread takes snapshot of all
+    vehicle states, evaluates every opponent's behavior against the same
+    snapshot and sends velocity setpoints straight to the controllers.
+
+    Behaviors:
+        Pursuit: proportional navigation towards target plus closing
+            acceleration along line of sight.
+        Evasion: flee from threat when it comes within evasion radius,
+            breaking sideways to its velocity, otherwise hold position.
+        Patrol: fly through waypoints in a loop.
+        Formation: hold offset from leader, offset is rotated with
+            leader's heading when leader is moving.
+
+    Commands are limited by max speed and max acceleration so opponents
+    can't do what the real vehicle couldn't.
+*/
+class OpponentAi {
+public: //types
+    enum class Behavior {
+        None, Pursuit, Evasion, Patrol, Formation
+    };
+
+    struct Params {
+        real_T control_period = 0.02f;  //seconds between evaluations
+        real_T max_speed = 8;
+        real_T max_accel = 6;
+        real_T navigation_gain = 4;     //proportional navigation constant
+        real_T closing_gain = 1;        //1/s, pursuit acceleration along line of sight towards max speed
+        real_T evasion_radius = 20;
+        real_T position_gain = 1;       //1/s, for patrol and formation position errors
+        real_T waypoint_tolerance = 2;
+        bool takeoff = true;            //arm and take off opponents when started
+        int stats_window = 1000;
+    };
+
+public:
+    OpponentAi()
+        : OpponentAi(Params())
+    {
+    }
+    OpponentAi(const Params& params)
+        : params_(params), is_running_(false), tick_count_(0)
+    {
+        tick_times_.initialize(params.stats_window);
+    }
+
+    ~OpponentAi()
+    {
+        stop();
+    }
+
+    //returns index used to refer to the vehicle, origin_offset is vehicle's NED origin in the shared frame
+    int addVehicle(DroneControllerBase* controller, const Vector3r& origin_offset)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vehicle vehicle;
+        vehicle.controller = controller;
+        vehicle.origin_offset = origin_offset;
+        vehicles_.push_back(vehicle);
+        snapshot_.push_back(VehicleState());
+        return static_cast<int>(vehicles_.size() - 1);
+    }
+
+    void setPursuit(int index, int target)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vehicle& vehicle = getVehicle(index, target);
+        vehicle.behavior = Behavior::Pursuit;
+        vehicle.other = target;
+    }
+
+    void setEvasion(int index, int threat)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vehicle& vehicle = getVehicle(index, threat);
+        vehicle.behavior = Behavior::Evasion;
+        vehicle.other = threat;
+    }
+
+    //waypoints are in the shared frame
+    void setPatrol(int index, const vector<Vector3r>& waypoints)
+    {
+        if (waypoints.size() == 0)
+            throw std::invalid_argument("Patrol needs at least one waypoint");
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vehicle& vehicle = getVehicle(index, index);
+        vehicle.behavior = Behavior::Patrol;
+        vehicle.waypoints = waypoints;
+        vehicle.waypoint_index = 0;
+    }
+
+    //offset is in leader's heading frame: x forward, y right, z down
+    void setFormation(int index, int leader, const Vector3r& offset)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vehicle& vehicle = getVehicle(index, leader);
+        vehicle.behavior = Behavior::Formation;
+        vehicle.other = leader;
+        vehicle.formation_offset = offset;
+    }
+
+    void clearBehavior(int index)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        getVehicle(index, index).behavior = Behavior::None;
+    }
+
+    //vehicle controllers must already be running, opponents are armed and take off through them
+    void start()
+    {
+        if (is_running_)
+            return;
+        is_running_ = true;
+        worker_ = std::thread(&OpponentAi::workerLoop, this);
+    }
+
+    void stop()
+    {
+        is_running_ = false;
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    //evaluates all behaviors once on calling thread, dt is time since last call
+    void update(real_T dt)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        //everyone reacts to the same state
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            snapshot_[i].position = vehicles_[i].controller->getPosition() + vehicles_[i].origin_offset;
+            snapshot_[i].velocity = vehicles_[i].controller->getVelocity();
+        }
+
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            Vehicle& vehicle = vehicles_[i];
+            if (vehicle.behavior == Behavior::None)
+                continue;
+
+            const VehicleState& self = snapshot_[i];
+            Vector3r velocity = limitCommand(self.velocity, getDesiredVelocity(vehicle, self), dt);
+            vehicle.controller->setVelocitySetpoint(velocity, YawMode(true, 0));
+        }
+
+        ++tick_count_;
+        tick_times_.insert(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+    }
+
+    string getReport() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint opponents = 0;
+        for (const Vehicle& vehicle : vehicles_) {
+            if (vehicle.behavior != Behavior::None)
+                ++opponents;
+        }
+
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Opponents: " << opponents << " of " << vehicles_.size() << " vehicles, " << tick_count_ << " ticks";
+        if (tick_times_.size() > 0) {
+            ss << ", tick p50 " << tick_times_.percentile(0.5) * 1E6 << " us, p99 " << tick_times_.percentile(0.99) * 1E6
+                << " us, " << tick_times_.mean() / params_.control_period * 100 << "% of a core";
+        }
+        ss << std::endl;
+        return ss.str();
+    }
+
+private:
+    struct VehicleState {
+        Vector3r position = Vector3r::Zero();
+        Vector3r velocity = Vector3r::Zero();
+    };
+
+    struct Vehicle {
+        DroneControllerBase* controller = nullptr;
+        Vector3r origin_offset = Vector3r::Zero();
+        Behavior behavior = Behavior::None;
+        int other = -1;     //target, threat or leader
+        vector<Vector3r> waypoints;
+        size_t waypoint_index = 0;
+        Vector3r formation_offset = Vector3r::Zero();
+        Vector3r hold_position = VectorMath::nanVector();
+    };
+
+    //stops blocking setup calls such as takeoff when AI is stopped
+    class StopCancelable : public CancelableBase {
+    public:
+        StopCancelable(const std::atomic<bool>& is_running)
+            : is_running_(is_running)
+        {
+        }
+        virtual bool isCancelled() override
+        {
+            return !is_running_;
+        }
+        virtual void cancelAllTasks() override
+        {
+        }
+
+    private:
+        const std::atomic<bool>& is_running_;
+    };
+
+    Vehicle& getVehicle(int index, int other)
+    {
+        if (index < 0 || index >= static_cast<int>(vehicles_.size()) || other < 0 || other >= static_cast<int>(vehicles_.size()))
+            throw std::out_of_range(Utils::stringf("Vehicle index %d or %d is not valid", index, other));
+        return vehicles_[index];
+    }
+
+    Vector3r getDesiredVelocity(Vehicle& vehicle, const VehicleState& self)
+    {
+        switch (vehicle.behavior) {
+        case Behavior::Pursuit:
+            return getPursuitVelocity(self, snapshot_[vehicle.other]);
+        case Behavior::Evasion:
+            return getEvasionVelocity(vehicle, self, snapshot_[vehicle.other]);
+        case Behavior::Patrol:
+            return getPatrolVelocity(vehicle, self);
+        case Behavior::Formation:
+            return getFormationVelocity(vehicle, self, snapshot_[vehicle.other]);
+        default:
+            return Vector3r::Zero();
+        }
+    }
+
+    /*
+        Proportional navigation: acceleration normal to line of sight is
+        N * closing speed * line of sight rate. Velocity controlled vehicle
+        doesn't have airspeed of a missile, so there is also acceleration
+        along line of sight towards max speed.
+    */
+    Vector3r getPursuitVelocity(const VehicleState& self, const VehicleState& target) const
+    {
+        Vector3r range = target.position - self.position;
+        real_T distance = range.norm();
+        if (distance < 1E-3f)
+            return target.velocity;
+
+        Vector3r los = range / distance;
+        Vector3r relative_velocity = target.velocity - self.velocity;
+        Vector3r los_rate = range.cross(relative_velocity) / (distance * distance);
+        real_T closing_speed = -relative_velocity.dot(los);
+        Vector3r pn_accel = params_.navigation_gain * closing_speed * los_rate.cross(los);
+        Vector3r closing_accel = params_.closing_gain * (params_.max_speed - self.velocity.dot(los)) * los;
+
+        return self.velocity + (pn_accel + closing_accel) * params_.control_period;
+    }
+
+    Vector3r getEvasionVelocity(Vehicle& vehicle, const VehicleState& self, const VehicleState& threat) const
+    {
+        Vector3r away = self.position - threat.position;
+        real_T distance = away.norm();
+        if (distance > params_.evasion_radius) {
+            if (VectorMath::hasNan(vehicle.hold_position))
+                vehicle.hold_position = self.position;
+            return (vehicle.hold_position - self.position) * params_.position_gain;
+        }
+        vehicle.hold_position = VectorMath::nanVector();
+
+        //break perpendicular to threat's velocity, on whichever side we already are
+        Vector3r flee = distance > 1E-3f ? Vector3r(away / distance) : Vector3r(1, 0, 0);
+        Vector3r side = threat.velocity.cross(Vector3r(0, 0, 1));
+        if (side.norm() > 1E-3f) {
+            side.normalize();
+            if (side.dot(flee) < 0)
+                side = -side;
+            flee += side;
+        }
+        flee.z() = 0;   //stay at altitude, ground is the usual end of diving away
+        real_T norm = flee.norm();
+        return norm > 1E-3f ? Vector3r(flee * (params_.max_speed / norm)) : Vector3r::Zero();
+    }
+
+    Vector3r getPatrolVelocity(Vehicle& vehicle, const VehicleState& self) const
+    {
+        if ((vehicle.waypoints[vehicle.waypoint_index] - self.position).norm() < params_.waypoint_tolerance)
+            vehicle.waypoint_index = (vehicle.waypoint_index + 1) % vehicle.waypoints.size();
+        return (vehicle.waypoints[vehicle.waypoint_index] - self.position) * params_.position_gain;
+    }
+
+    Vector3r getFormationVelocity(const Vehicle& vehicle, const VehicleState& self, const VehicleState& leader) const
+    {
+        Vector3r offset = vehicle.formation_offset;
+        Vector2r leader_xy(leader.velocity.x(), leader.velocity.y());
+        if (leader_xy.norm() > 0.5f) {
+            real_T yaw = std::atan2(leader_xy.y(), leader_xy.x());
+            real_T c = std::cos(yaw), s = std::sin(yaw);
+            offset = Vector3r(c * offset.x() - s * offset.y(), s * offset.x() + c * offset.y(), offset.z());
+        }
+        return leader.velocity + (leader.position + offset - self.position) * params_.position_gain;
+    }
+
+    Vector3r limitCommand(const Vector3r& current, const Vector3r& desired, real_T dt) const
+    {
+        Vector3r change = desired - current;
+        real_T max_change = params_.max_accel * dt;
+        if (change.norm() > max_change)
+            change *= max_change / change.norm();
+
+        Vector3r velocity = current + change;
+        if (velocity.norm() > params_.max_speed)
+            velocity *= params_.max_speed / velocity.norm();
+        return velocity;
+    }
+
+    void workerLoop()
+    {
+        vector<std::pair<int, DroneControllerBase*>> opponents;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < vehicles_.size(); ++i) {
+                if (vehicles_[i].behavior != Behavior::None)
+                    opponents.push_back(std::make_pair(static_cast<int>(i), vehicles_[i].controller));
+            }
+        }
+
+        if (params_.takeoff)
+            takeoff(opponents);
+        for (const auto& opponent : opponents)
+            opponent.second->loopCommandPre();
+
+        ClockBase* clock = ClockFactory::get();
+        TTimePoint last_tick = clock->nowNanos();
+        while (is_running_) {
+            TTimePoint now = clock->nowNanos();
+            real_T dt = static_cast<real_T>(clock->elapsedBetween(now, last_tick));
+            last_tick = now;
+            update(dt > 0 ? dt : params_.control_period);
+
+            double remaining = params_.control_period - clock->elapsedSince(now);
+            if (remaining > 0)
+                clock->sleep_for(clock->toWallDelta(remaining));
+        }
+
+        for (const auto& opponent : opponents)
+            opponent.second->loopCommandPost();
+    }
+
+    //takeoff blocks until altitude is reached, so all opponents take off at the same time
+    void takeoff(const vector<std::pair<int, DroneControllerBase*>>& opponents)
+    {
+        StopCancelable cancelable(is_running_);
+        vector<std::future<void>> takeoffs;
+        for (const auto& opponent : opponents) {
+            takeoffs.push_back(std::async(std::launch::async, [&opponent, &cancelable]() {
+                try {
+                    opponent.second->armDisarm(true, cancelable);
+                    opponent.second->takeoff(15, cancelable);
+                }
+                catch (const std::exception& ex) {
+                    //vehicle still gets its behavior, velocity setpoints can lift it off as well
+                    Utils::logError("Opponent %d could not take off: %s", opponent.first, ex.what());
+                }
+            }));
+        }
+        for (auto& takeoff : takeoffs)
+            takeoff.get();
+    }
+
+private:
+    Params params_;
+    mutable std::mutex mutex_;
+    vector<Vehicle> vehicles_;
+    vector<VehicleState> snapshot_;
+
+    std::thread worker_;
+    std::atomic<bool> is_running_;
+    uint64_t tick_count_;
+    common_utils::RollingOnlineStats tick_times_;
+};
+
+}} //namespace
+#endif
@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <string>
+#include <vector>
 
 #include "common/common_utils/Utils.hpp"
 #include "common/common_utils/FileSystem.hpp"
@@ -48,6 +49,22 @@ namespace msr {
 
                 return singleton();
             }
+            //loads any json file in to this instance, path is relative to AirSim folder unless absolute
+            bool loadFile(std::string fileName)
+            {
+                std::string path = common_utils::FileSystem::isAbsolutePath(fileName) ? fileName : getFullPath(fileName);
+                file_ = fileName;
+                load_success_ = false;
+
+                std::ifstream s;
+                common_utils::FileSystem::openTextFile(path, s);
+                if (!s.fail()) {
+                    s >> doc_;
+                    load_success_ = true;
+                }
+                return load_success_;
+            }
+
             bool isLoadSuccess()
             {
                 return load_success_;
@@ -75,6 +92,22 @@ namespace msr {
                 return false;
             }
 
+            //elements of an array of objects, returns false if name is missing or not such an array
+            bool getChildren(std::string name, std::vector<Settings>& children) const
+            {
+                children.clear();
+                if (doc_.count(name) != 1 || doc_[name].type() != nlohmann::detail::value_t::array)
+                    return false;
+                for (const auto& element : doc_[name]) {
+                    if (element.type() != nlohmann::detail::value_t::object)
+                        return false;
+                    Settings child;
+                    child.doc_ = element;
+                    children.push_back(child);
+                }
+                return true;
+            }
+
             std::string getString(std::string name, std::string defaultValue) const
             {
                 if (doc_.count(name) == 1) {
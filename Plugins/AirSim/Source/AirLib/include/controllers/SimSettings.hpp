@@ -0,0 +1,873 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_SimSettings_hpp
+#define msr_airlib_SimSettings_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include <exception>
+#include "common/Common.hpp"
+#include "controllers/Settings.hpp"
+#include "controllers/MavLinkDroneController.hpp"
+#include "common/EarthUtils.hpp"
+#include "sensors/barometer/BarometerSimpleParams.hpp"
+#include "sensors/distance/DistanceSimpleParams.hpp"
+#include "sensors/opticalflow/OpticalFlowSimpleParams.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Typed view of settings.json. The json document is traversed once in load()
+    and everything else works off the plain structs below, so spawning or
+    resetting vehicles never touches json. All problems found while parsing
+    (wrong types, out of range values, unknown vehicle names) are collected in
+    getErrors() so they can be reported at startup instead of at first use.
+    Offending values fall back to their defaults.
+*/
+class SimSettings {
+public: //types
+    struct RpcSettings {
+        bool enabled = true;
+        std::string server_address = "127.0.0.1";
+        uint16_t port = 41451;
+    };
+
+    struct RecordingSettings {
+        std::string record_filename = "airsim_rec";
+        std::string image_prefix = "img_";
+    };
+
+    struct CaptureSettings {
+        //wall clock time per rendered frame that image capture may use, 0 for no limit
+        float frame_budget_ms = 10;
+        //RoundRobin or Batch, see CaptureScheduler
+        std::string mode = "RoundRobin";
+    };
+
+    struct PathPlanningSettings {
+        bool enabled = false;
+        //voxel map is built around FPV vehicle start, z goes from size_z above start to 2 m below it
+        float size_x = 200, size_y = 200, size_z = 50;
+        float resolution = 1;
+        float inflation_radius = 1;
+        int max_expansions = 500000;
+    };
+
+    struct MpcSettings {
+        bool enabled = false;
+        float prediction_step = 0.1f;       //seconds, horizon is fixed number of steps
+        float max_tilt_deg = 30;
+        float max_thrust_accel = 19.6f;     //max thrust / mass in m/s^2
+        float min_thrust_accel = 0;
+        int max_iterations = 50;
+    };
+
+    //non-FPV vehicles become opponents of the FPV vehicle
+    struct OpponentSettings {
+        bool enabled = false;
+        std::string behavior = "Pursuit";   //Pursuit, Evasion, Patrol or Formation
+        float max_speed = 8;
+        float max_accel = 6;
+        float control_period_ms = 20;
+        float patrol_radius = 10;
+        float patrol_altitude = 5;
+    };
+
+    //vehicles yield to each other in velocity commands, see ReciprocalAvoidance
+    struct ReciprocalAvoidanceSettings {
+        bool enabled = false;
+        //turn on Reciprocal safety check of every vehicle at start, else clients enable it with setSafety
+        bool enable_for_all = true;
+        float radius = 0.5f;
+        float time_horizon = 2;
+        float neighbor_distance = 15;
+        int max_neighbors = 10;
+        float max_speed = 10;
+        float control_period_ms = 20;
+        //0 means one per hardware thread
+        int threads = 0;
+    };
+
+    //analytic detection of other vehicles in cameras, see TargetDetector
+    struct DetectionSettings {
+        bool enabled = false;
+        float rate = 30;                    //updates per second
+        float min_range = 0.5f;
+        float max_range = 100;
+        float reliable_range = 60;
+        float target_radius = 0.3f;
+        float false_negative_rate = 0;
+        float false_positive_rate = 0;
+        float bearing_noise_deg = 0;
+        float range_noise = 0;              //as fraction of range
+        bool occlusion = true;              //needs PathPlanning to be enabled for its voxel map
+    };
+
+    struct BenchmarkSettings {
+        //run AirLib micro-benchmarks at startup and write JSON results to log folder
+        bool enabled = false;
+        std::string file_prefix = "airlib_benchmark";
+        //only cases whose name contains this are run, empty runs all
+        std::string filter = "";
+        float min_time_ms = 200;
+    };
+
+    //load test of the RPC server over a stub vehicle, see RpcLoadBenchmark
+    struct RpcBenchmarkSettings {
+        bool enabled = false;
+        std::string file_prefix = "rpc_benchmark";
+        uint16_t port = 41460;              //separate from ApiServerPort so it can run next to the real server
+        float duration_sec = 10;
+        //connections per kind of call and calls per second of each, 0 disables the kind
+        int getter_clients = 8;
+        float getter_rate = 100;
+        int image_clients = 2;
+        float image_rate = 20;
+        int command_clients = 1;
+        float command_rate = 2;
+        int image_bytes = 256 * 144 * 3;
+        float command_duration_ms = 200;
+    };
+
+    //randomized dataset generation, see DatasetGenerator
+    struct DatasetSettings {
+        bool enabled = false;
+        //Poses: free camera at random poses, Flight: FPV vehicle flies to random waypoints
+        std::string mode = "Poses";
+        std::string file_prefix = "dataset";
+        int frames = 1000;                  //0 runs until simulation ends
+        int seed = 0;
+        int camera_id = 0;                  //camera of FPV vehicle used in Flight mode
+        bool scene = true;
+        bool depth = true;
+        bool segmentation = true;
+        int width = 0;                      //Poses mode render target size, 0 keeps asset size
+        int height = 0;
+        bool compress = false;              //PNG for scene and segmentation, costs encoder time
+        //sampling ranges, positions are meters around FPV vehicle start
+        float area_size = 100;
+        float min_altitude = 2;
+        float max_altitude = 30;
+        float pitch_min_deg = -45;
+        float pitch_max_deg = 10;
+        float fov_min_deg = 60;
+        float fov_max_deg = 110;
+        float exposure_min = 0;
+        float exposure_max = 0;
+        bool randomize_light = true;
+        float light_intensity_min = 2;
+        float light_intensity_max = 10;
+        float flight_speed = 5;
+        //frames between setting a pose and its readback finishing, at least 2 so rendering overlaps readback
+        int pipeline_depth = 3;
+        int encoder_threads = 0;            //0 uses all but one hardware thread
+        int max_queued_frames = 16;
+        int chunk_mb = 256;
+    };
+
+    //match setup run inside the simulator, see Scenario
+    struct ScenarioSettings {
+        //empty means no scenario, relative paths are in AirSim folder
+        std::string file = "";
+        //write metrics and quit when scenario finishes, for unattended runs
+        bool exit_on_finish = false;
+        std::string metrics_file_prefix = "scenario";
+    };
+
+    struct PhysicsSettings {
+        //sweep vehicles against level geometry and each other so fast vehicles can't tunnel
+        bool continuous_collision = false;
+        //grid cell size of static collision boxes, meters
+        float collision_cell_size = 4;
+        //components without simple collision shapes are used as their bounds only if smaller than this, meters
+        float max_static_box_size = 50;
+        //simulated seconds per wall second; physics ticks proportionally faster so each still covers the same
+        //simulated time, only flight stacks running on the simulation clock (not MavLink) keep up above 1
+        float clock_speed = 1;
+    };
+
+    //how vehicle poses from physics are applied to pawns every frame
+    struct RenderSyncSettings {
+        //move pawns without sweeping when ContinuousCollision already handles collisions in physics;
+        //only takes effect if every collider of the level could be converted to a static box
+        bool skip_sweeps = false;
+        //rotor animation is updated only when speed changes more than this, rad/s
+        float rotor_speed_tolerance = 1;
+    };
+
+    //on screen report shown with R key
+    struct HudSettings {
+        //how often the HUD pulls a new report snapshot, Hz
+        float report_rate = 3;
+    };
+
+    struct SensorSettings {
+        bool imu = true;
+        bool magnetometer = true;
+        bool gps = true;
+        bool barometer = true;
+        //analytic downward range finder and optical flow, computed from ground truth
+        bool distance = false;
+        bool optical_flow = false;
+        BarometerSimpleParams barometer_params;
+        DistanceSimpleParams distance_params;
+        OpticalFlowSimpleParams optical_flow_params;
+    };
+
+    //feeds SafetyEval obstacle map from depth images of one of the vehicle cameras
+    struct ObstacleMapSettings {
+        bool enabled = false;
+        int camera_id = 0;
+        int ticks = 16;
+        float rate = 10;
+        float horizontal_fov_deg = 90;
+        //raw depth value times this gives meters, depth capture writes planar depth normalized by its 100 m far plane
+        float depth_scale = 100;
+        float max_distance = 50;
+        //band of image rows used, as fraction of image height
+        float row_start = 0.25f;
+        float row_end = 0.75f;
+    };
+
+    //controller loaded from shared library, see AirSimControllerPlugin.h
+    struct PluginSettings {
+        std::string path = "";
+        //passed to plugin as is, format is up to the plugin
+        std::string config = "";
+        float budget_us = 1000;
+        int stats_window = 10000;
+    };
+
+    //used by RosFlight vehicles only
+    struct RosFlightSettings {
+        //restore IMU calibration of earlier runs instead of calibrating on every start and reset
+        bool cache_calibration = true;
+        //json file in AirSim folder, empty keeps calibration for this process only
+        std::string calibration_file = "rosflight_calibration.json";
+        //calibrate on the first tick from noise free IMU samples
+        bool burst_calibration = false;
+    };
+
+    struct VehicleSettings {
+        std::string vehicle_name;
+        //used by PX4 vehicles only
+        MavLinkDroneController::ConnectionInfo connection_info;
+        //-1 means no RC
+        int remote_control_id = 0;
+        SensorSettings sensors;
+        ObstacleMapSettings obstacle_map;
+        //used by Plugin vehicles only
+        PluginSettings plugin;
+        RosFlightSettings rosflight;
+    };
+
+public:
+    static SimSettings& singleton()
+    {
+        static SimSettings settings;
+        return settings;
+    }
+
+    static const std::vector<std::string>& getKnownVehicleNames()
+    {
+        static const std::vector<std::string> names = { "Pixhawk", "RosFlight", "Plugin" };
+        return names;
+    }
+
+    SimSettings()
+    {
+        load(Settings());
+    }
+
+    //parse whole document, returns true if there were no errors
+    bool load(const Settings& settings)
+    {
+        errors_.clear();
+        vehicles_.clear();
+
+        rpc_ = RpcSettings();
+        rpc_.enabled = readBool(settings, "", "RpcEnabled", rpc_.enabled);
+        rpc_.server_address = readString(settings, "", "LocalHostIp", rpc_.server_address);
+        rpc_.port = static_cast<uint16_t>(readInt(settings, "", "ApiServerPort", rpc_.port, 1, 65535));
+
+        //do not save this default in json as this will change in near future
+        fpv_vehicle_name_ = readString(settings, "", "FpvVehicleName", "Pixhawk");
+
+        recording_ = RecordingSettings();
+        Settings recording_child;
+        if (settings.getChild("Recording", recording_child)) {
+            recording_.record_filename = readString(recording_child, "Recording", "FileName", recording_.record_filename);
+            recording_.image_prefix = readString(recording_child, "Recording", "ImagePrefix", recording_.image_prefix);
+        }
+
+        capture_ = CaptureSettings();
+        Settings capture_child;
+        if (settings.getChild("Capture", capture_child)) {
+            capture_.frame_budget_ms = static_cast<float>(readDouble(capture_child, "Capture", "FrameBudgetMs", capture_.frame_budget_ms));
+            if (capture_.frame_budget_ms < 0) {
+                addError("Capture", "FrameBudgetMs", "value must not be negative");
+                capture_.frame_budget_ms = CaptureSettings().frame_budget_ms;
+            }
+            capture_.mode = readString(capture_child, "Capture", "Mode", capture_.mode);
+            if (capture_.mode != "RoundRobin" && capture_.mode != "Batch") {
+                addError("Capture", "Mode", "value '" + capture_.mode + "' must be RoundRobin or Batch");
+                capture_.mode = CaptureSettings().mode;
+            }
+        }
+
+        path_planning_ = PathPlanningSettings();
+        Settings path_planning_child;
+        if (settings.getChild("PathPlanning", path_planning_child)) {
+            path_planning_.enabled = readBool(path_planning_child, "PathPlanning", "Enabled", path_planning_.enabled);
+            path_planning_.size_x = readPositive(path_planning_child, "PathPlanning", "SizeX", path_planning_.size_x);
+            path_planning_.size_y = readPositive(path_planning_child, "PathPlanning", "SizeY", path_planning_.size_y);
+            path_planning_.size_z = readPositive(path_planning_child, "PathPlanning", "SizeZ", path_planning_.size_z);
+            path_planning_.resolution = readPositive(path_planning_child, "PathPlanning", "Resolution", path_planning_.resolution);
+            path_planning_.inflation_radius = static_cast<float>(readDouble(path_planning_child, "PathPlanning", "InflationRadius",
+                path_planning_.inflation_radius));
+            if (path_planning_.inflation_radius < 0) {
+                addError("PathPlanning", "InflationRadius", "value must not be negative");
+                path_planning_.inflation_radius = PathPlanningSettings().inflation_radius;
+            }
+            path_planning_.max_expansions = readInt(path_planning_child, "PathPlanning", "MaxExpansions", path_planning_.max_expansions,
+                1, Utils::max<int>());
+        }
+
+        mpc_ = MpcSettings();
+        Settings mpc_child;
+        if (settings.getChild("Mpc", mpc_child)) {
+            mpc_.enabled = readBool(mpc_child, "Mpc", "Enabled", mpc_.enabled);
+            mpc_.prediction_step = readPositive(mpc_child, "Mpc", "PredictionStep", mpc_.prediction_step);
+            mpc_.max_tilt_deg = readPositive(mpc_child, "Mpc", "MaxTiltDeg", mpc_.max_tilt_deg);
+            if (mpc_.max_tilt_deg >= 90) {
+                addError("Mpc", "MaxTiltDeg", "value must be less than 90");
+                mpc_.max_tilt_deg = MpcSettings().max_tilt_deg;
+            }
+            mpc_.max_thrust_accel = readPositive(mpc_child, "Mpc", "MaxThrustAccel", mpc_.max_thrust_accel);
+            mpc_.min_thrust_accel = static_cast<float>(readDouble(mpc_child, "Mpc", "MinThrustAccel", mpc_.min_thrust_accel));
+            if (mpc_.min_thrust_accel < 0 || mpc_.min_thrust_accel >= mpc_.max_thrust_accel) {
+                addError("Mpc", "MinThrustAccel", "value must be in [0, MaxThrustAccel)");
+                mpc_.min_thrust_accel = MpcSettings().min_thrust_accel;
+            }
+            mpc_.max_iterations = readInt(mpc_child, "Mpc", "MaxIterations", mpc_.max_iterations, 1, 10000);
+        }
+
+        opponents_ = OpponentSettings();
+        Settings opponents_child;
+        if (settings.getChild("Opponents", opponents_child)) {
+            opponents_.enabled = readBool(opponents_child, "Opponents", "Enabled", opponents_.enabled);
+            opponents_.behavior = readString(opponents_child, "Opponents", "Behavior", opponents_.behavior);
+            if (opponents_.behavior != "Pursuit" && opponents_.behavior != "Evasion" && opponents_.behavior != "Patrol"
+                && opponents_.behavior != "Formation") {
+                addError("Opponents", "Behavior", "value '" + opponents_.behavior + "' must be Pursuit, Evasion, Patrol or Formation");
+                opponents_.behavior = OpponentSettings().behavior;
+            }
+            opponents_.max_speed = readPositive(opponents_child, "Opponents", "MaxSpeed", opponents_.max_speed);
+            opponents_.max_accel = readPositive(opponents_child, "Opponents", "MaxAccel", opponents_.max_accel);
+            opponents_.control_period_ms = readPositive(opponents_child, "Opponents", "ControlPeriodMs", opponents_.control_period_ms);
+            opponents_.patrol_radius = readPositive(opponents_child, "Opponents", "PatrolRadius", opponents_.patrol_radius);
+            opponents_.patrol_altitude = readPositive(opponents_child, "Opponents", "PatrolAltitude", opponents_.patrol_altitude);
+        }
+
+        detection_ = DetectionSettings();
+        Settings detection_child;
+        if (settings.getChild("Detection", detection_child)) {
+            detection_.enabled = readBool(detection_child, "Detection", "Enabled", detection_.enabled);
+            detection_.rate = readPositive(detection_child, "Detection", "Rate", detection_.rate);
+            detection_.min_range = readPositive(detection_child, "Detection", "MinRange", detection_.min_range);
+            detection_.max_range = readPositive(detection_child, "Detection", "MaxRange", detection_.max_range);
+            if (detection_.min_range >= detection_.max_range) {
+                addError("Detection", "MinRange", "value must be less than MaxRange");
+                detection_.min_range = DetectionSettings().min_range;
+                detection_.max_range = DetectionSettings().max_range;
+            }
+            detection_.reliable_range = readPositive(detection_child, "Detection", "ReliableRange", detection_.reliable_range);
+            detection_.target_radius = readPositive(detection_child, "Detection", "TargetRadius", detection_.target_radius);
+            detection_.false_negative_rate = static_cast<float>(readDouble(detection_child, "Detection", "FalseNegativeRate",
+                detection_.false_negative_rate));
+            if (detection_.false_negative_rate < 0 || detection_.false_negative_rate > 1) {
+                addError("Detection", "FalseNegativeRate", "value must be in [0, 1]");
+                detection_.false_negative_rate = DetectionSettings().false_negative_rate;
+            }
+            detection_.false_positive_rate = static_cast<float>(readDouble(detection_child, "Detection", "FalsePositiveRate",
+                detection_.false_positive_rate));
+            if (detection_.false_positive_rate < 0) {
+                addError("Detection", "FalsePositiveRate", "value must not be negative");
+                detection_.false_positive_rate = DetectionSettings().false_positive_rate;
+            }
+            detection_.bearing_noise_deg = static_cast<float>(readDouble(detection_child, "Detection", "BearingNoiseDeg",
+                detection_.bearing_noise_deg));
+            detection_.range_noise = static_cast<float>(readDouble(detection_child, "Detection", "RangeNoise", detection_.range_noise));
+            if (detection_.bearing_noise_deg < 0 || detection_.range_noise < 0) {
+                addError("Detection", "BearingNoiseDeg", "noise values must not be negative");
+                detection_.bearing_noise_deg = DetectionSettings().bearing_noise_deg;
+                detection_.range_noise = DetectionSettings().range_noise;
+            }
+            detection_.occlusion = readBool(detection_child, "Detection", "Occlusion", detection_.occlusion);
+        }
+
+        benchmark_ = BenchmarkSettings();
+        Settings benchmark_child;
+        if (settings.getChild("Benchmark", benchmark_child)) {
+            benchmark_.enabled = readBool(benchmark_child, "Benchmark", "Enabled", benchmark_.enabled);
+            benchmark_.file_prefix = readString(benchmark_child, "Benchmark", "FilePrefix", benchmark_.file_prefix);
+            benchmark_.filter = readString(benchmark_child, "Benchmark", "Filter", benchmark_.filter);
+            benchmark_.min_time_ms = static_cast<float>(readDouble(benchmark_child, "Benchmark", "MinTimeMs", benchmark_.min_time_ms));
+            if (benchmark_.min_time_ms <= 0) {
+                addError("Benchmark", "MinTimeMs", "value must be positive");
+                benchmark_.min_time_ms = BenchmarkSettings().min_time_ms;
+            }
+        }
+
+        rpc_benchmark_ = RpcBenchmarkSettings();
+        Settings rpc_benchmark_child;
+        if (settings.getChild("RpcBenchmark", rpc_benchmark_child)) {
+            rpc_benchmark_.enabled = readBool(rpc_benchmark_child, "RpcBenchmark", "Enabled", rpc_benchmark_.enabled);
+            rpc_benchmark_.file_prefix = readString(rpc_benchmark_child, "RpcBenchmark", "FilePrefix", rpc_benchmark_.file_prefix);
+            rpc_benchmark_.port = static_cast<uint16_t>(readInt(rpc_benchmark_child, "RpcBenchmark", "Port", rpc_benchmark_.port, 1, 65535));
+            rpc_benchmark_.duration_sec = readPositive(rpc_benchmark_child, "RpcBenchmark", "DurationSec", rpc_benchmark_.duration_sec);
+            rpc_benchmark_.getter_clients = readInt(rpc_benchmark_child, "RpcBenchmark", "GetterClients", rpc_benchmark_.getter_clients, 0, 256);
+            rpc_benchmark_.getter_rate = readNonNegative(rpc_benchmark_child, "RpcBenchmark", "GetterRate", rpc_benchmark_.getter_rate);
+            rpc_benchmark_.image_clients = readInt(rpc_benchmark_child, "RpcBenchmark", "ImageClients", rpc_benchmark_.image_clients, 0, 256);
+            rpc_benchmark_.image_rate = readNonNegative(rpc_benchmark_child, "RpcBenchmark", "ImageRate", rpc_benchmark_.image_rate);
+            rpc_benchmark_.command_clients = readInt(rpc_benchmark_child, "RpcBenchmark", "CommandClients", rpc_benchmark_.command_clients, 0, 256);
+            rpc_benchmark_.command_rate = readNonNegative(rpc_benchmark_child, "RpcBenchmark", "CommandRate", rpc_benchmark_.command_rate);
+            rpc_benchmark_.image_bytes = readInt(rpc_benchmark_child, "RpcBenchmark", "ImageBytes", rpc_benchmark_.image_bytes, 1, 64 * 1024 * 1024);
+            rpc_benchmark_.command_duration_ms = readPositive(rpc_benchmark_child, "RpcBenchmark", "CommandDurationMs",
+                rpc_benchmark_.command_duration_ms);
+        }
+
+        dataset_ = DatasetSettings();
+        Settings dataset_child;
+        if (settings.getChild("Dataset", dataset_child)) {
+            dataset_.enabled = readBool(dataset_child, "Dataset", "Enabled", dataset_.enabled);
+            dataset_.mode = readString(dataset_child, "Dataset", "Mode", dataset_.mode);
+            if (dataset_.mode != "Poses" && dataset_.mode != "Flight") {
+                addError("Dataset", "Mode", "expected Poses or Flight");
+                dataset_.mode = DatasetSettings().mode;
+            }
+            dataset_.file_prefix = readString(dataset_child, "Dataset", "FilePrefix", dataset_.file_prefix);
+            dataset_.frames = readInt(dataset_child, "Dataset", "Frames", dataset_.frames, 0, Utils::max<int>());
+            dataset_.seed = readInt(dataset_child, "Dataset", "Seed", dataset_.seed, 0, Utils::max<int>());
+            dataset_.camera_id = readInt(dataset_child, "Dataset", "CameraID", dataset_.camera_id, 0, Utils::max<int>());
+            dataset_.scene = readBool(dataset_child, "Dataset", "Scene", dataset_.scene);
+            dataset_.depth = readBool(dataset_child, "Dataset", "Depth", dataset_.depth);
+            dataset_.segmentation = readBool(dataset_child, "Dataset", "Segmentation", dataset_.segmentation);
+            dataset_.width = readInt(dataset_child, "Dataset", "Width", dataset_.width, 0, 16384);
+            dataset_.height = readInt(dataset_child, "Dataset", "Height", dataset_.height, 0, 16384);
+            dataset_.compress = readBool(dataset_child, "Dataset", "Compress", dataset_.compress);
+            dataset_.area_size = readPositive(dataset_child, "Dataset", "AreaSize", dataset_.area_size);
+            dataset_.min_altitude = static_cast<float>(readDouble(dataset_child, "Dataset", "MinAltitude", dataset_.min_altitude));
+            dataset_.max_altitude = static_cast<float>(readDouble(dataset_child, "Dataset", "MaxAltitude", dataset_.max_altitude));
+            dataset_.pitch_min_deg = static_cast<float>(readDouble(dataset_child, "Dataset", "PitchMinDeg", dataset_.pitch_min_deg));
+            dataset_.pitch_max_deg = static_cast<float>(readDouble(dataset_child, "Dataset", "PitchMaxDeg", dataset_.pitch_max_deg));
+            dataset_.fov_min_deg = readPositive(dataset_child, "Dataset", "FovMinDeg", dataset_.fov_min_deg);
+            dataset_.fov_max_deg = readPositive(dataset_child, "Dataset", "FovMaxDeg", dataset_.fov_max_deg);
+            dataset_.exposure_min = static_cast<float>(readDouble(dataset_child, "Dataset", "ExposureMin", dataset_.exposure_min));
+            dataset_.exposure_max = static_cast<float>(readDouble(dataset_child, "Dataset", "ExposureMax", dataset_.exposure_max));
+            dataset_.randomize_light = readBool(dataset_child, "Dataset", "RandomizeLight", dataset_.randomize_light);
+            dataset_.light_intensity_min = readNonNegative(dataset_child, "Dataset", "LightIntensityMin", dataset_.light_intensity_min);
+            dataset_.light_intensity_max = readNonNegative(dataset_child, "Dataset", "LightIntensityMax", dataset_.light_intensity_max);
+            dataset_.flight_speed = readPositive(dataset_child, "Dataset", "FlightSpeed", dataset_.flight_speed);
+            dataset_.pipeline_depth = readInt(dataset_child, "Dataset", "PipelineDepth", dataset_.pipeline_depth, 2, 16);
+            dataset_.encoder_threads = readInt(dataset_child, "Dataset", "EncoderThreads", dataset_.encoder_threads, 0, 256);
+            dataset_.max_queued_frames = readInt(dataset_child, "Dataset", "MaxQueuedFrames", dataset_.max_queued_frames, 1, 1024);
+            dataset_.chunk_mb = readInt(dataset_child, "Dataset", "ChunkMB", dataset_.chunk_mb, 1, 1024 * 1024);
+            if (!(dataset_.fov_max_deg >= dataset_.fov_min_deg) || dataset_.fov_max_deg >= 180) {
+                addError("Dataset", "FovMaxDeg", "must be at least FovMinDeg and below 180");
+                dataset_.fov_min_deg = DatasetSettings().fov_min_deg;
+                dataset_.fov_max_deg = DatasetSettings().fov_max_deg;
+            }
+        }
+
+        scenario_ = ScenarioSettings();
+        Settings scenario_child;
+        if (settings.getChild("Scenario", scenario_child)) {
+            scenario_.file = readString(scenario_child, "Scenario", "File", scenario_.file);
+            scenario_.exit_on_finish = readBool(scenario_child, "Scenario", "ExitOnFinish", scenario_.exit_on_finish);
+            scenario_.metrics_file_prefix = readString(scenario_child, "Scenario", "MetricsFilePrefix", scenario_.metrics_file_prefix);
+        }
+
+        physics_ = PhysicsSettings();
+        Settings physics_child;
+        if (settings.getChild("Physics", physics_child)) {
+            physics_.continuous_collision = readBool(physics_child, "Physics", "ContinuousCollision", physics_.continuous_collision);
+            physics_.collision_cell_size = static_cast<float>(readDouble(physics_child, "Physics", "CollisionCellSize", physics_.collision_cell_size));
+            if (physics_.collision_cell_size <= 0) {
+                addError("Physics", "CollisionCellSize", "value must be positive");
+                physics_.collision_cell_size = PhysicsSettings().collision_cell_size;
+            }
+            physics_.max_static_box_size = static_cast<float>(readDouble(physics_child, "Physics", "MaxStaticBoxSize", physics_.max_static_box_size));
+            physics_.clock_speed = static_cast<float>(readDouble(physics_child, "Physics", "ClockSpeed", physics_.clock_speed));
+            if (!(physics_.clock_speed > 0)) {
+                addError("Physics", "ClockSpeed", "value must be positive");
+                physics_.clock_speed = PhysicsSettings().clock_speed;
+            }
+        }
+
+        render_sync_ = RenderSyncSettings();
+        Settings render_sync_child;
+        if (settings.getChild("RenderSync", render_sync_child)) {
+            render_sync_.skip_sweeps = readBool(render_sync_child, "RenderSync", "SkipSweeps", render_sync_.skip_sweeps);
+            render_sync_.rotor_speed_tolerance = static_cast<float>(readDouble(render_sync_child, "RenderSync", "RotorSpeedTolerance",
+                render_sync_.rotor_speed_tolerance));
+            if (render_sync_.rotor_speed_tolerance < 0) {
+                addError("RenderSync", "RotorSpeedTolerance", "value must not be negative");
+                render_sync_.rotor_speed_tolerance = RenderSyncSettings().rotor_speed_tolerance;
+            }
+        }
+
+        hud_ = HudSettings();
+        Settings hud_child;
+        if (settings.getChild("Hud", hud_child))
+            hud_.report_rate = readPositive(hud_child, "Hud", "ReportRate", hud_.report_rate);
+
+        reciprocal_avoidance_ = ReciprocalAvoidanceSettings();
+        Settings reciprocal_child;
+        if (settings.getChild("ReciprocalAvoidance", reciprocal_child)) {
+            auto& reciprocal = reciprocal_avoidance_;
+            reciprocal.enabled = readBool(reciprocal_child, "ReciprocalAvoidance", "Enabled", reciprocal.enabled);
+            reciprocal.enable_for_all = readBool(reciprocal_child, "ReciprocalAvoidance", "EnableForAll", reciprocal.enable_for_all);
+            reciprocal.radius = readPositive(reciprocal_child, "ReciprocalAvoidance", "Radius", reciprocal.radius);
+            reciprocal.time_horizon = readPositive(reciprocal_child, "ReciprocalAvoidance", "TimeHorizon", reciprocal.time_horizon);
+            reciprocal.neighbor_distance = readPositive(reciprocal_child, "ReciprocalAvoidance", "NeighborDistance", reciprocal.neighbor_distance);
+            reciprocal.max_neighbors = readInt(reciprocal_child, "ReciprocalAvoidance", "MaxNeighbors", reciprocal.max_neighbors, 1, 100);
+            reciprocal.max_speed = readPositive(reciprocal_child, "ReciprocalAvoidance", "MaxSpeed", reciprocal.max_speed);
+            reciprocal.control_period_ms = readPositive(reciprocal_child, "ReciprocalAvoidance", "ControlPeriodMs", reciprocal.control_period_ms);
+            reciprocal.threads = readInt(reciprocal_child, "ReciprocalAvoidance", "Threads", reciprocal.threads, 0, 256);
+        }
+
+        for (const auto& name : getKnownVehicleNames()) {
+            Settings child;
+            settings.getChild(name, child);
+            vehicles_[name] = readVehicle(child, name);
+        }
+
+        if (vehicles_.find(fpv_vehicle_name_) == vehicles_.end()) {
+            addError("", "FpvVehicleName", "vehicle name '" + fpv_vehicle_name_ + "' is not recognized");
+            fpv_vehicle_name_ = "Pixhawk";
+        }
+        if (fpv_vehicle_name_ == "Plugin" && vehicles_["Plugin"].plugin.path.empty())
+            addError("Plugin", "PluginPath", "path of controller library is required for Plugin vehicle");
+
+        return errors_.empty();
+    }
+
+    const RpcSettings& getRpcSettings() const
+    {
+        return rpc_;
+    }
+
+    const RecordingSettings& getRecordingSettings() const
+    {
+        return recording_;
+    }
+
+    const CaptureSettings& getCaptureSettings() const
+    {
+        return capture_;
+    }
+
+    const PathPlanningSettings& getPathPlanningSettings() const
+    {
+        return path_planning_;
+    }
+
+    const MpcSettings& getMpcSettings() const
+    {
+        return mpc_;
+    }
+
+    const OpponentSettings& getOpponentSettings() const
+    {
+        return opponents_;
+    }
+
+    const ReciprocalAvoidanceSettings& getReciprocalAvoidanceSettings() const
+    {
+        return reciprocal_avoidance_;
+    }
+
+    const DetectionSettings& getDetectionSettings() const
+    {
+        return detection_;
+    }
+
+    const DatasetSettings& getDatasetSettings() const
+    {
+        return dataset_;
+    }
+
+    const BenchmarkSettings& getBenchmarkSettings() const
+    {
+        return benchmark_;
+    }
+
+    const RpcBenchmarkSettings& getRpcBenchmarkSettings() const
+    {
+        return rpc_benchmark_;
+    }
+
+    const ScenarioSettings& getScenarioSettings() const
+    {
+        return scenario_;
+    }
+
+    const PhysicsSettings& getPhysicsSettings() const
+    {
+        return physics_;
+    }
+
+    const RenderSyncSettings& getRenderSyncSettings() const
+    {
+        return render_sync_;
+    }
+
+    const HudSettings& getHudSettings() const
+    {
+        return hud_;
+    }
+
+    const std::string& getFpvVehicleName() const
+    {
+        return fpv_vehicle_name_;
+    }
+
+    const VehicleSettings& getVehicleSettings(const std::string& vehicle_name) const
+    {
+        auto it = vehicles_.find(vehicle_name);
+        if (it == vehicles_.end())
+            throw std::invalid_argument(Utils::stringf("Cannot find settings for vehicle '%s' because the name is not recognized", vehicle_name.c_str()));
+        return it->second;
+    }
+
+    const std::vector<std::string>& getErrors() const
+    {
+        return errors_;
+    }
+
+private:
+    VehicleSettings readVehicle(const Settings& child, const std::string& name)
+    {
+        VehicleSettings vehicle;
+        vehicle.vehicle_name = name;
+
+        // allow json overrides on a per-vehicle basis.
+        auto& connection_info = vehicle.connection_info;
+        connection_info.sim_sysid = static_cast<uint8_t>(readInt(child, name, "SimSysID", connection_info.sim_sysid, 0, 255));
+        connection_info.sim_compid = readInt(child, name, "SimCompID", connection_info.sim_compid, 0, 255);
+
+        connection_info.vehicle_sysid = static_cast<uint8_t>(readInt(child, name, "VehicleSysID", connection_info.vehicle_sysid, 0, 255));
+        connection_info.vehicle_compid = readInt(child, name, "VehicleCompID", connection_info.vehicle_compid, 0, 255);
+
+        connection_info.offboard_sysid = static_cast<uint8_t>(readInt(child, name, "OffboardSysID", connection_info.offboard_sysid, 0, 255));
+        connection_info.offboard_compid = readInt(child, name, "OffboardCompID", connection_info.offboard_compid, 0, 255);
+
+        connection_info.logviewer_ip_address = readString(child, name, "LogViewerHostIp", connection_info.logviewer_ip_address);
+        connection_info.logviewer_ip_port = readInt(child, name, "LogViewerPort", connection_info.logviewer_ip_port, 0, 65535);
+        connection_info.logviewer_ip_sport = readInt(child, name, "LogViewerSendPort", connection_info.logviewer_ip_sport, 0, 65535);
+
+        connection_info.qgc_ip_address = readString(child, name, "QgcHostIp", connection_info.qgc_ip_address);
+        connection_info.qgc_ip_port = readInt(child, name, "QgcPort", connection_info.qgc_ip_port, 0, 65535);
+
+        connection_info.sitl_ip_address = readString(child, name, "SitlIp", connection_info.sitl_ip_address);
+        connection_info.sitl_ip_port = readInt(child, name, "SitlPort", connection_info.sitl_ip_port, 0, 65535);
+
+        connection_info.local_host_ip = readString(child, name, "LocalHostIp", connection_info.local_host_ip);
+
+        connection_info.use_serial = readBool(child, name, "UseSerial", connection_info.use_serial);
+        connection_info.ip_address = readString(child, name, "UdpIp", connection_info.ip_address);
+        connection_info.ip_port = readInt(child, name, "UdpPort", connection_info.ip_port, 0, 65535);
+        connection_info.serial_port = readString(child, name, "SerialPort", connection_info.serial_port);
+        connection_info.baud_rate = readInt(child, name, "SerialBaudRate", connection_info.baud_rate, 1, Utils::max<int>());
+        connection_info.model = readString(child, name, "Model", connection_info.model);
+
+        vehicle.remote_control_id = readInt(child, name, "RemoteControlID", vehicle.remote_control_id, -1, Utils::max<int>());
+
+        Settings sensors_child;
+        if (child.getChild("Sensors", sensors_child)) {
+            std::string path = name + ".Sensors";
+            auto& sensors = vehicle.sensors;
+            sensors.imu = readBool(sensors_child, path, "Imu", sensors.imu);
+            sensors.magnetometer = readBool(sensors_child, path, "Magnetometer", sensors.magnetometer);
+            sensors.gps = readBool(sensors_child, path, "Gps", sensors.gps);
+            sensors.barometer = readBool(sensors_child, path, "Barometer", sensors.barometer);
+
+            auto& baro = sensors.barometer_params;
+            baro.qnh = static_cast<real_T>(readDouble(sensors_child, path, "BarometerQnh", baro.qnh));
+            baro.median_filter_window = readInt(sensors_child, path, "BarometerMedianFilterWindow", baro.median_filter_window, 0, 100000);
+            baro.median_filter_outlier_factor = static_cast<real_T>(
+                readDouble(sensors_child, path, "BarometerOutlierFactor", baro.median_filter_outlier_factor));
+
+            sensors.distance = readBool(sensors_child, path, "Distance", sensors.distance);
+            auto& distance = sensors.distance_params;
+            distance.min_distance = readPositive(sensors_child, path, "DistanceMin", distance.min_distance);
+            distance.max_distance = readPositive(sensors_child, path, "DistanceMax", distance.max_distance);
+            distance.noise_sigma = static_cast<real_T>(readDouble(sensors_child, path, "DistanceNoiseSigma", distance.noise_sigma));
+            distance.update_frequency = readPositive(sensors_child, path, "DistanceRate", distance.update_frequency);
+            distance.update_latency = static_cast<real_T>(readDouble(sensors_child, path, "DistanceLatency", distance.update_latency));
+
+            sensors.optical_flow = readBool(sensors_child, path, "OpticalFlow", sensors.optical_flow);
+            auto& flow = sensors.optical_flow_params;
+            flow.min_distance = readPositive(sensors_child, path, "OpticalFlowMinDistance", flow.min_distance);
+            flow.max_distance = readPositive(sensors_child, path, "OpticalFlowMaxDistance", flow.max_distance);
+            flow.flow_noise_sigma = static_cast<real_T>(readDouble(sensors_child, path, "OpticalFlowNoiseSigma", flow.flow_noise_sigma));
+            flow.max_angular_rate = readPositive(sensors_child, path, "OpticalFlowMaxAngularRate", flow.max_angular_rate);
+            flow.update_frequency = readPositive(sensors_child, path, "OpticalFlowRate", flow.update_frequency);
+            flow.update_latency = static_cast<real_T>(readDouble(sensors_child, path, "OpticalFlowLatency", flow.update_latency));
+        }
+
+        Settings obstacle_map_child;
+        if (child.getChild("ObstacleMap", obstacle_map_child))
+            vehicle.obstacle_map = readObstacleMap(obstacle_map_child, name + ".ObstacleMap");
+
+        auto& plugin = vehicle.plugin;
+        plugin.path = readString(child, name, "PluginPath", plugin.path);
+        plugin.config = readString(child, name, "PluginConfig", plugin.config);
+        plugin.budget_us = readPositive(child, name, "PluginBudgetUs", plugin.budget_us);
+        plugin.stats_window = readInt(child, name, "PluginStatsWindow", plugin.stats_window, 1, 1000000);
+
+        auto& rosflight = vehicle.rosflight;
+        rosflight.cache_calibration = readBool(child, name, "CacheCalibration", rosflight.cache_calibration);
+        rosflight.calibration_file = readString(child, name, "CalibrationFile", rosflight.calibration_file);
+        rosflight.burst_calibration = readBool(child, name, "BurstCalibration", rosflight.burst_calibration);
+
+        return vehicle;
+    }
+
+    ObstacleMapSettings readObstacleMap(const Settings& child, const std::string& path)
+    {
+        ObstacleMapSettings obs;
+        obs.enabled = readBool(child, path, "Enabled", obs.enabled);
+        obs.camera_id = readInt(child, path, "CameraID", obs.camera_id, 0, Utils::max<int>());
+        obs.ticks = readInt(child, path, "Ticks", obs.ticks, 4, 360);
+        obs.rate = static_cast<float>(readDouble(child, path, "Rate", obs.rate));
+        obs.horizontal_fov_deg = static_cast<float>(readDouble(child, path, "HorizontalFov", obs.horizontal_fov_deg));
+        obs.depth_scale = static_cast<float>(readDouble(child, path, "DepthScale", obs.depth_scale));
+        obs.max_distance = static_cast<float>(readDouble(child, path, "MaxDistance", obs.max_distance));
+        obs.row_start = static_cast<float>(readDouble(child, path, "RowStart", obs.row_start));
+        obs.row_end = static_cast<float>(readDouble(child, path, "RowEnd", obs.row_end));
+
+        const ObstacleMapSettings defaults;
+        if (obs.rate < 0) {
+            addError(path, "Rate", "value must not be negative");
+            obs.rate = defaults.rate;
+        }
+        if (obs.horizontal_fov_deg <= 0 || obs.horizontal_fov_deg >= 180) {
+            addError(path, "HorizontalFov", "value must be between 0 and 180 degrees");
+            obs.horizontal_fov_deg = defaults.horizontal_fov_deg;
+        }
+        if (obs.depth_scale <= 0) {
+            addError(path, "DepthScale", "value must be positive");
+            obs.depth_scale = defaults.depth_scale;
+        }
+        if (obs.row_start < 0 || obs.row_end > 1 || obs.row_start >= obs.row_end) {
+            addError(path, "RowStart", "RowStart and RowEnd must satisfy 0 <= RowStart < RowEnd <= 1");
+            obs.row_start = defaults.row_start;
+            obs.row_end = defaults.row_end;
+        }
+        return obs;
+    }
+
+    void addError(const std::string& path, const std::string& name, const std::string& message)
+    {
+        errors_.push_back((path.empty() ? name : path + "." + name) + ": " + message);
+    }
+
+    //getters in Settings throw if json type doesn't match, we record that and keep default
+    std::string readString(const Settings& settings, const std::string& path, const std::string& name, const std::string& default_val)
+    {
+        try {
+            return settings.getString(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, std::string("expected string, ") + ex.what());
+            return default_val;
+        }
+    }
+
+    bool readBool(const Settings& settings, const std::string& path, const std::string& name, bool default_val)
+    {
+        try {
+            return settings.getBool(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, std::string("expected true or false, ") + ex.what());
+            return default_val;
+        }
+    }
+
+    double readDouble(const Settings& settings, const std::string& path, const std::string& name, double default_val)
+    {
+        try {
+            return settings.getDouble(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, std::string("expected number, ") + ex.what());
+            return default_val;
+        }
+    }
+
+    float readPositive(const Settings& settings, const std::string& path, const std::string& name, float default_val)
+    {
+        float val = static_cast<float>(readDouble(settings, path, name, default_val));
+        if (!(val > 0)) {
+            addError(path, name, "value must be positive");
+            return default_val;
+        }
+        return val;
+    }
+
+    float readNonNegative(const Settings& settings, const std::string& path, const std::string& name, float default_val)
+    {
+        float val = static_cast<float>(readDouble(settings, path, name, default_val));
+        if (!(val >= 0)) {
+            addError(path, name, "value must not be negative");
+            return default_val;
+        }
+        return val;
+    }
+
+    int readInt(const Settings& settings, const std::string& path, const std::string& name, int default_val, int min_val, int max_val)
+    {
+        int val;
+        try {
+            val = settings.getInt(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, std::string("expected integer, ") + ex.what());
+            return default_val;
+        }
+
+        if (val < min_val || val > max_val) {
+            addError(path, name, Utils::stringf("value %d is outside of valid range [%d, %d]", val, min_val, max_val));
+            return default_val;
+        }
+        return val;
+    }
+
+private:
+    RpcSettings rpc_;
+    RecordingSettings recording_;
+    CaptureSettings capture_;
+    PathPlanningSettings path_planning_;
+    MpcSettings mpc_;
+    OpponentSettings opponents_;
+    ReciprocalAvoidanceSettings reciprocal_avoidance_;
+    DetectionSettings detection_;
+    DatasetSettings dataset_;
+    BenchmarkSettings benchmark_;
+    RpcBenchmarkSettings rpc_benchmark_;
+    ScenarioSettings scenario_;
+    PhysicsSettings physics_;
+    RenderSyncSettings render_sync_;
+    HudSettings hud_;
+    std::string fpv_vehicle_name_;
+    std::map<std::string, VehicleSettings> vehicles_;
+    std::vector<std::string> errors_;
+};
+
+}} //namespace
+#endif
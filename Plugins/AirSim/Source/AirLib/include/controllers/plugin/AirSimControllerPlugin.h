@@ -0,0 +1,161 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+/*
+    Stable C interface for controllers built as shared libraries (.so/.dll)
+    and loaded by the simulator, one instance per vehicle. This header is
+    the only thing a plugin needs, it has no AirLib or C++ dependencies.
+
+    Life cycle, all calls from the same physics thread:
+
+        airsim_plugin_abi_version()  must return AIRSIM_PLUGIN_ABI_VERSION
+        airsim_plugin_create()       once per vehicle at startup
+        airsim_plugin_update()       every physics tick
+        airsim_plugin_reset()        optional, when vehicle is reset
+        airsim_plugin_destroy()      when vehicle goes away
+
+    In update() the plugin reads state, sensors, remote control and the
+    current setpoint from the input and writes one control signal in
+    [0, 1] per rotor in to output->rotor_signals. All buffers are owned by the simulator and are
+    allocated before the first call, so a plugin can run without touching
+    the heap. Each input carries the time budget for the call and how long
+    the previous call took, the simulator keeps latency percentiles and
+    counts calls over budget.
+
+    Structs start with struct_size so fields can be appended later without
+    breaking binaries built against older versions of this header; never
+    reorder or remove fields without bumping AIRSIM_PLUGIN_ABI_VERSION.
+
+    Units: SI, angles in radians unless noted, frames are NED (+x North,
+    +y East, +z down) and body FRD, quaternions are w, x, y, z.
+*/
+
+#ifndef AIRSIM_CONTROLLER_PLUGIN_H
+#define AIRSIM_CONTROLLER_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIRSIM_PLUGIN_ABI_VERSION 1
+#define AIRSIM_PLUGIN_MAX_ROTORS 16
+
+#if defined(_WIN32)
+#define AIRSIM_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define AIRSIM_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* bits of AirSimPluginSensors.valid */
+#define AIRSIM_PLUGIN_SENSOR_IMU 0x1u
+#define AIRSIM_PLUGIN_SENSOR_BAROMETER 0x2u
+#define AIRSIM_PLUGIN_SENSOR_MAGNETOMETER 0x4u
+#define AIRSIM_PLUGIN_SENSOR_GPS 0x8u
+
+/* fixed description of the vehicle, passed to create() */
+typedef struct AirSimPluginVehicleInfo {
+    uint32_t struct_size;
+    const char* vehicle_name;
+    const char* config;             /* PluginConfig string from settings, never null */
+    uint32_t rotor_count;
+    double mass;                    /* kg */
+    double inertia[3];              /* diagonal of inertia matrix, kg m^2 */
+    double max_thrust;              /* per rotor at control signal 1, N */
+    double max_torque;              /* per rotor at control signal 1, N m */
+    double rotor_positions[AIRSIM_PLUGIN_MAX_ROTORS][3];   /* body frame, m */
+    int32_t rotor_directions[AIRSIM_PLUGIN_MAX_ROTORS];    /* -1 for CCW, 1 for CW */
+    double budget_sec;              /* time budget of one update() call */
+} AirSimPluginVehicleInfo;
+
+/* ground truth from physics */
+typedef struct AirSimPluginState {
+    uint32_t struct_size;
+    double timestamp;               /* simulation time, s */
+    double position[3];
+    double orientation[4];
+    double linear_velocity[3];      /* world frame */
+    double angular_velocity[3];     /* body frame */
+    double linear_acceleration[3];  /* world frame */
+    double angular_acceleration[3]; /* body frame */
+} AirSimPluginState;
+
+/* simulated sensor outputs, fields of sensors not set in valid are zero */
+typedef struct AirSimPluginSensors {
+    uint32_t struct_size;
+    uint32_t valid;
+    double imu_orientation[4];
+    double imu_angular_velocity[3];
+    double imu_linear_acceleration[3];
+    double barometer_altitude;      /* m */
+    double barometer_pressure;      /* Pa */
+    double magnetic_field_body[3];  /* Gauss */
+    double gps_latitude, gps_longitude, gps_altitude;  /* degrees, degrees, m */
+    double gps_velocity[3];
+    int32_t gps_fix_type;           /* 0 no fix, 2 2D fix, 3 3D fix */
+} AirSimPluginSensors;
+
+typedef enum AirSimPluginSetpointType {
+    AIRSIM_PLUGIN_SETPOINT_NONE = 0,
+    AIRSIM_PLUGIN_SETPOINT_ROLL_PITCH_Z = 1,   /* values: roll, pitch (radians), z */
+    AIRSIM_PLUGIN_SETPOINT_VELOCITY = 2,       /* values: vx, vy, vz */
+    AIRSIM_PLUGIN_SETPOINT_VELOCITY_Z = 3,     /* values: vx, vy, z */
+    AIRSIM_PLUGIN_SETPOINT_POSITION = 4        /* values: x, y, z */
+} AirSimPluginSetpointType;
+
+/* latest command from APIs, plugin is free to ignore it */
+typedef struct AirSimPluginSetpoint {
+    uint32_t struct_size;
+    int32_t type;                   /* AirSimPluginSetpointType */
+    double values[3];
+    int32_t yaw_is_rate;            /* if set yaw is rate in rad/s, otherwise angle */
+    double yaw;
+    int32_t armed;
+} AirSimPluginSetpoint;
+
+/* remote control channels of the vehicle, all zero while no RC is connected */
+typedef struct AirSimPluginRC {
+    uint32_t struct_size;
+    int32_t connected;              /* other fields are valid only if set */
+    double timestamp;               /* simulation time of last RC reading, s */
+    double roll, pitch, yaw;        /* sticks, -1 to 1 */
+    double throttle;
+    uint32_t switches[8];
+} AirSimPluginRC;
+
+typedef struct AirSimPluginInput {
+    uint32_t struct_size;
+    const AirSimPluginState* state;
+    const AirSimPluginSensors* sensors;
+    const AirSimPluginSetpoint* setpoint;
+    double dt;                      /* simulation time since previous update(), s */
+    double budget_sec;
+    double last_call_sec;           /* wall clock time previous update() took */
+    const AirSimPluginRC* rc;
+} AirSimPluginInput;
+
+typedef struct AirSimPluginOutput {
+    uint32_t struct_size;
+    uint32_t rotor_count;
+    double* rotor_signals;          /* rotor_count entries in [0, 1], keeps last values between calls */
+} AirSimPluginOutput;
+
+/* functions a plugin exports, update() returns 0 on success */
+typedef uint32_t (*AirSimPluginAbiVersionFunc)(void);
+typedef void* (*AirSimPluginCreateFunc)(const AirSimPluginVehicleInfo* info);
+typedef int32_t (*AirSimPluginUpdateFunc)(void* instance, const AirSimPluginInput* input, AirSimPluginOutput* output);
+typedef void (*AirSimPluginResetFunc)(void* instance);
+typedef void (*AirSimPluginDestroyFunc)(void* instance);
+
+#define AIRSIM_PLUGIN_ABI_VERSION_SYMBOL "airsim_plugin_abi_version"
+#define AIRSIM_PLUGIN_CREATE_SYMBOL "airsim_plugin_create"
+#define AIRSIM_PLUGIN_UPDATE_SYMBOL "airsim_plugin_update"
+#define AIRSIM_PLUGIN_RESET_SYMBOL "airsim_plugin_reset"
+#define AIRSIM_PLUGIN_DESTROY_SYMBOL "airsim_plugin_destroy"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
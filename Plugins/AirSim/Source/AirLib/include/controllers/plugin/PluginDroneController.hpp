@@ -0,0 +1,499 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_PluginDroneController_hpp
+#define msr_airlib_PluginDroneController_hpp
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include "controllers/DroneControllerBase.hpp"
+#include "controllers/SimSettings.hpp"
+#include "sensors/SensorCollection.hpp"
+#include "sensors/imu/ImuBase.hpp"
+#include "sensors/barometer/BarometerBase.hpp"
+#include "sensors/magnetometer/MagnetometerBase.hpp"
+#include "sensors/gps/GpsBase.hpp"
+#include "physics/Environment.hpp"
+#include "physics/Kinematics.hpp"
+#include "vehicles/MultiRotorParams.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/SharedLibrary.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+#include "common/Common.hpp"
+#include "AirSimControllerPlugin.h"
+
+namespace msr { namespace airlib {
+
+/*
+    Runs a controller from a shared library that implements the C interface
+    in AirSimControllerPlugin.h. Library is loaded and the plugin instance
+    created when the vehicle is set up, after that each update() copies
+    ground truth, sensor outputs, RC channels and the latest API setpoint
+    in to preallocated structs, calls the plugin and keeps the rotor
+    signals it wrote for getVertexControlSignal(). Like ROSFlight, there is no state
+    estimation here: plugin gets physics ground truth along with sensors.
+
+    API commands only record the setpoint, closing the loop is entirely up
+    to the plugin. Wall clock time of every plugin call is recorded so the
+    report shows latency percentiles against the configured budget.
+*/
+class PluginDroneController : public DroneControllerBase {
+public:
+    PluginDroneController(const SensorCollection* sensors, const MultiRotorParams* vehicle_params,
+        const SimSettings::VehicleSettings& vehicle_settings)
+        : vehicle_params_(vehicle_params), sensors_(sensors), kinematics_(nullptr), environment_(nullptr),
+        remote_control_id_(vehicle_settings.remote_control_id), vehicle_name_(vehicle_settings.vehicle_name)
+    {
+        const auto& plugin_settings = vehicle_settings.plugin;
+        budget_sec_ = plugin_settings.budget_us * 1E-6;
+        call_times_.initialize(plugin_settings.stats_window);
+
+        const auto& params = vehicle_params_->getParams();
+        if (params.rotor_count > AIRSIM_PLUGIN_MAX_ROTORS)
+            throw std::invalid_argument(Utils::stringf("Controller plugin supports at most %d rotors", AIRSIM_PLUGIN_MAX_ROTORS));
+        rotor_signals_.assign(params.rotor_count, 0);
+
+        imu_ = static_cast<const ImuBase*>(sensors_->getByType(SensorCollection::SensorType::Imu));
+        baro_ = static_cast<const BarometerBase*>(sensors_->getByType(SensorCollection::SensorType::Barometer));
+        mag_ = static_cast<const MagnetometerBase*>(sensors_->getByType(SensorCollection::SensorType::Magnetometer));
+        gps_ = static_cast<const GpsBase*>(sensors_->getByType(SensorCollection::SensorType::Gps));
+
+        loadPlugin(plugin_settings.path, plugin_settings.config);
+    }
+
+    virtual ~PluginDroneController()
+    {
+        if (instance_ != nullptr)
+            destroy_func_(instance_);
+    }
+
+    void initializePhysics(const Environment* environment, const Kinematics::State* kinematics)
+    {
+        environment_ = environment;
+        kinematics_ = kinematics;
+    }
+
+    //latency of plugin calls, also shown in simulator report
+    string getReport() override
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Plugin " << vehicle_name_ << ": ";
+        if (call_times_.size() > 0) {
+            ss << "p50 " << call_times_.percentile(0.5) * 1E6 << " us, p99 " << call_times_.percentile(0.99) * 1E6
+                << " us, max " << call_times_.max() * 1E6 << " us, ";
+        }
+        ss << "budget " << budget_sec_ * 1E6 << " us, " << over_budget_count_ << "/" << call_count_ << " over, "
+            << error_count_ << " errors" << std::endl;
+        return ss.str();
+    }
+
+public:
+    //*** Start: VehicleControllerBase implementation ***//
+    virtual void reset() override
+    {
+        std::fill(rotor_signals_.begin(), rotor_signals_.end(), 0.0);
+        last_update_time_ = 0;
+        last_call_sec_ = 0;
+        {
+            std::lock_guard<std::mutex> lock(setpoint_mutex_);
+            pending_setpoint_ = AirSimPluginSetpoint();
+            pending_setpoint_.struct_size = sizeof(AirSimPluginSetpoint);
+        }
+        if (reset_func_ != nullptr)
+            reset_func_(instance_);
+    }
+
+    virtual void update() override
+    {
+        if (kinematics_ == nullptr)
+            return;
+
+        TTimePoint now = ClockFactory::get()->nowNanos();
+        input_.dt = last_update_time_ == 0 ? 0 : ClockBase::elapsedBetween(now, last_update_time_);
+        last_update_time_ = now;
+
+        fillState(now);
+        fillSensors();
+        {
+            std::lock_guard<std::mutex> lock(setpoint_mutex_);
+            setpoint_ = pending_setpoint_;
+            rc_ = pending_rc_;
+        }
+        input_.last_call_sec = last_call_sec_;
+
+        auto start_time = std::chrono::steady_clock::now();
+        int32_t result = update_func_(instance_, &input_, &output_);
+        last_call_sec_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        recordCall(last_call_sec_, result);
+    }
+
+    virtual size_t getVertexCount() override
+    {
+        return rotor_signals_.size();
+    }
+
+    virtual real_T getVertexControlSignal(unsigned int rotor_index) override
+    {
+        //plugin output is not trusted to be in range
+        return static_cast<real_T>(Utils::clip(rotor_signals_.at(rotor_index), 0.0, 1.0));
+    }
+
+    virtual void getStatusMessages(std::vector<std::string>& messages) override
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        messages.insert(messages.end(), status_messages_.begin(), status_messages_.end());
+        status_messages_.clear();
+    }
+
+    virtual bool isOffboardMode() override
+    {
+        return true;
+    }
+
+    virtual bool isSimulationMode() override
+    {
+        return true;
+    }
+
+    virtual void setOffboardMode(bool is_set) override
+    {
+        //plugin always takes commands from APIs
+        unused(is_set);
+    }
+
+    virtual void setSimulationMode(bool is_set) override
+    {
+        if (!is_set)
+            throw VehicleCommandNotImplementedException("setting non-simulation mode is not supported for controller plugins");
+    }
+    //*** End: VehicleControllerBase implementation ***//
+
+//*** Start: DroneControllerBase implementation ***//
+public:
+    Vector3r getPosition() override
+    {
+        return kinematics_->pose.position;
+    }
+
+    Vector3r getVelocity() override
+    {
+        return kinematics_->twist.linear;
+    }
+
+    Quaternionr getOrientation() override
+    {
+        return kinematics_->pose.orientation;
+    }
+
+    virtual int getRemoteControlID()  override
+    {
+        return remote_control_id_;
+    }
+
+    RCData getRCData() override
+    {
+        return RCData();
+    }
+
+    void setRCData(const RCData& rcData) override
+    {
+        std::lock_guard<std::mutex> lock(setpoint_mutex_);
+        pending_rc_.connected = rcData.is_connected ? 1 : 0;
+        if (rcData.is_connected) {
+            pending_rc_.timestamp = rcData.timestamp * 1E-9;
+            pending_rc_.roll = rcData.roll;
+            pending_rc_.pitch = rcData.pitch;
+            pending_rc_.yaw = rcData.yaw;
+            pending_rc_.throttle = rcData.throttle;
+            const unsigned int switches[] = { rcData.switch1, rcData.switch2, rcData.switch3, rcData.switch4,
+                rcData.switch5, rcData.switch6, rcData.switch7, rcData.switch8 };
+            std::copy(std::begin(switches), std::end(switches), pending_rc_.switches);
+        }
+        else {
+            pending_rc_ = AirSimPluginRC();
+            pending_rc_.struct_size = sizeof(AirSimPluginRC);
+        }
+    }
+
+    bool armDisarm(bool arm, CancelableBase& cancelable_action) override
+    {
+        unused(cancelable_action);
+        std::lock_guard<std::mutex> lock(setpoint_mutex_);
+        pending_setpoint_.armed = arm ? 1 : 0;
+        return true;
+    }
+
+    bool takeoff(float max_wait_seconds, CancelableBase& cancelable_action) override
+    {
+        Vector3r position = getPosition();
+        commandPosition(position.x(), position.y(), getTakeoffZ(), YawMode(true, 0));
+        return waitForZ(max_wait_seconds, getTakeoffZ(), getDistanceAccuracy(), cancelable_action);
+    }
+
+    bool land(CancelableBase& cancelable_action) override
+    {
+        //descend until vertical speed stays near zero, i.e. vehicle is on the ground
+        commandVelocity(0, 0, LandingVelocity, YawMode(true, 0));
+        int still_count = 0;
+        int min_still_count = std::max(1, static_cast<int>(1 / getCommandPeriod()));
+        return waitForFunction([&]() {
+            still_count = std::abs(getVelocity().z()) < LandingVelocity / 5 ? still_count + 1 : 0;
+            return still_count >= min_still_count;
+        }, MaxLandingSeconds, cancelable_action);
+    }
+
+    bool goHome(CancelableBase& cancelable_action) override
+    {
+        return moveToPosition(0, 0, getPosition().z(), 5, DrivetrainType::MaxDegreeOfFreedome, YawMode(true, 0),
+            -1, 1, cancelable_action);
+    }
+
+    GeoPoint getHomePoint() override
+    {
+        return environment_->getInitialState().geo_point;
+    }
+
+    GeoPoint getGpsLocation() override
+    {
+        return environment_->getState().geo_point;
+    }
+
+    float getCommandPeriod() override
+    {
+        return 1.0f/50; //50hz for API command loops, plugin itself runs every physics tick
+    }
+
+    float getTakeoffZ() override
+    {
+        return -3.0f;
+    }
+
+    float getDistanceAccuracy() override
+    {
+        return 0.5f;
+    }
+
+protected:
+    void commandRollPitchZ(float pitch, float roll, float z, float yaw) override
+    {
+        setSetpoint(AIRSIM_PLUGIN_SETPOINT_ROLL_PITCH_Z, roll, pitch, z, false, yaw);
+    }
+
+    void commandVelocity(float vx, float vy, float vz, const YawMode& yaw_mode) override
+    {
+        setSetpoint(AIRSIM_PLUGIN_SETPOINT_VELOCITY, vx, vy, vz, yaw_mode.is_rate, Utils::degreesToRadians(yaw_mode.yaw_or_rate));
+    }
+
+    void commandVelocityZ(float vx, float vy, float z, const YawMode& yaw_mode) override
+    {
+        setSetpoint(AIRSIM_PLUGIN_SETPOINT_VELOCITY_Z, vx, vy, z, yaw_mode.is_rate, Utils::degreesToRadians(yaw_mode.yaw_or_rate));
+    }
+
+    void commandPosition(float x, float y, float z, const YawMode& yaw_mode) override
+    {
+        setSetpoint(AIRSIM_PLUGIN_SETPOINT_POSITION, x, y, z, yaw_mode.is_rate, Utils::degreesToRadians(yaw_mode.yaw_or_rate));
+    }
+
+    const VehicleParams& getVehicleParams() override
+    {
+        //used for safety algos. For now just use defaults
+        static const VehicleParams safety_params;
+        return safety_params;
+    }
+    //*** End: DroneControllerBase implementation ***//
+
+private:
+    static constexpr float LandingVelocity = 0.5f;
+    static constexpr float MaxLandingSeconds = 60;
+
+    void loadPlugin(const std::string& path, const std::string& config)
+    {
+        if (path.empty())
+            throw std::invalid_argument(Utils::stringf("PluginPath is not set for vehicle %s", vehicle_name_.c_str()));
+        library_.load(path);
+
+        auto version_func = library_.getFunction<AirSimPluginAbiVersionFunc>(AIRSIM_PLUGIN_ABI_VERSION_SYMBOL);
+        auto create_func = library_.getFunction<AirSimPluginCreateFunc>(AIRSIM_PLUGIN_CREATE_SYMBOL);
+        update_func_ = library_.getFunction<AirSimPluginUpdateFunc>(AIRSIM_PLUGIN_UPDATE_SYMBOL);
+        destroy_func_ = library_.getFunction<AirSimPluginDestroyFunc>(AIRSIM_PLUGIN_DESTROY_SYMBOL);
+        reset_func_ = library_.getFunction<AirSimPluginResetFunc>(AIRSIM_PLUGIN_RESET_SYMBOL);   //optional
+        if (version_func == nullptr || create_func == nullptr || update_func_ == nullptr || destroy_func_ == nullptr)
+            throw std::runtime_error(Utils::stringf("Controller plugin '%s' does not export required functions", path.c_str()));
+        if (version_func() != AIRSIM_PLUGIN_ABI_VERSION)
+            throw std::runtime_error(Utils::stringf("Controller plugin '%s' has ABI version %u but %u is required",
+                path.c_str(), version_func(), AIRSIM_PLUGIN_ABI_VERSION));
+
+        const auto& params = vehicle_params_->getParams();
+        AirSimPluginVehicleInfo info;
+        std::memset(&info, 0, sizeof(info));
+        info.struct_size = sizeof(info);
+        info.vehicle_name = vehicle_name_.c_str();
+        info.config = config.c_str();
+        info.rotor_count = params.rotor_count;
+        info.mass = params.mass;
+        for (int i = 0; i < 3; ++i)
+            info.inertia[i] = params.inertia(i, i);
+        info.max_thrust = params.rotor_params.max_thrust;
+        info.max_torque = params.rotor_params.max_torque;
+        for (uint i = 0; i < params.rotor_count; ++i) {
+            copyVector(params.rotor_poses.at(i).position, info.rotor_positions[i]);
+            info.rotor_directions[i] = static_cast<int32_t>(params.rotor_poses.at(i).direction);
+        }
+        info.budget_sec = budget_sec_;
+
+        instance_ = create_func(&info);
+        if (instance_ == nullptr)
+            throw std::runtime_error(Utils::stringf("Controller plugin '%s' failed to create instance for vehicle %s",
+                path.c_str(), vehicle_name_.c_str()));
+
+        //everything plugin sees during update() lives here, set up once
+        std::memset(&state_, 0, sizeof(state_));
+        state_.struct_size = sizeof(state_);
+        std::memset(&sensors_output_, 0, sizeof(sensors_output_));
+        sensors_output_.struct_size = sizeof(sensors_output_);
+        std::memset(&setpoint_, 0, sizeof(setpoint_));
+        setpoint_.struct_size = sizeof(setpoint_);
+        pending_setpoint_ = setpoint_;
+        std::memset(&rc_, 0, sizeof(rc_));
+        rc_.struct_size = sizeof(rc_);
+        pending_rc_ = rc_;
+
+        std::memset(&input_, 0, sizeof(input_));
+        input_.struct_size = sizeof(input_);
+        input_.state = &state_;
+        input_.sensors = &sensors_output_;
+        input_.setpoint = &setpoint_;
+        input_.rc = &rc_;
+        input_.budget_sec = budget_sec_;
+
+        output_.struct_size = sizeof(output_);
+        output_.rotor_count = static_cast<uint32_t>(rotor_signals_.size());
+        output_.rotor_signals = rotor_signals_.data();
+    }
+
+    void fillState(TTimePoint now)
+    {
+        state_.timestamp = now * 1E-9;
+        copyVector(kinematics_->pose.position, state_.position);
+        copyQuaternion(kinematics_->pose.orientation, state_.orientation);
+        copyVector(kinematics_->twist.linear, state_.linear_velocity);
+        copyVector(kinematics_->twist.angular, state_.angular_velocity);
+        copyVector(kinematics_->accelerations.linear, state_.linear_acceleration);
+        copyVector(kinematics_->accelerations.angular, state_.angular_acceleration);
+    }
+
+    void fillSensors()
+    {
+        sensors_output_.valid = 0;
+        if (imu_ != nullptr) {
+            const auto& output = imu_->getOutput();
+            copyQuaternion(output.orientation, sensors_output_.imu_orientation);
+            copyVector(output.angular_velocity, sensors_output_.imu_angular_velocity);
+            copyVector(output.linear_acceleration, sensors_output_.imu_linear_acceleration);
+            sensors_output_.valid |= AIRSIM_PLUGIN_SENSOR_IMU;
+        }
+        if (baro_ != nullptr) {
+            const auto& output = baro_->getOutput();
+            sensors_output_.barometer_altitude = output.altitude;
+            sensors_output_.barometer_pressure = output.pressure;
+            sensors_output_.valid |= AIRSIM_PLUGIN_SENSOR_BAROMETER;
+        }
+        if (mag_ != nullptr) {
+            copyVector(mag_->getOutput().magnetic_field_body, sensors_output_.magnetic_field_body);
+            sensors_output_.valid |= AIRSIM_PLUGIN_SENSOR_MAGNETOMETER;
+        }
+        if (gps_ != nullptr && gps_->getOutput().is_valid) {
+            const auto& gnss = gps_->getOutput().gnss;
+            sensors_output_.gps_latitude = gnss.geo_point.latitude;
+            sensors_output_.gps_longitude = gnss.geo_point.longitude;
+            sensors_output_.gps_altitude = gnss.geo_point.altitude;
+            copyVector(gnss.velocity, sensors_output_.gps_velocity);
+            sensors_output_.gps_fix_type = gnss.fix_type;
+            sensors_output_.valid |= AIRSIM_PLUGIN_SENSOR_GPS;
+        }
+    }
+
+    void setSetpoint(AirSimPluginSetpointType type, float v0, float v1, float v2, bool yaw_is_rate, float yaw)
+    {
+        std::lock_guard<std::mutex> lock(setpoint_mutex_);
+        pending_setpoint_.type = type;
+        pending_setpoint_.values[0] = v0;
+        pending_setpoint_.values[1] = v1;
+        pending_setpoint_.values[2] = v2;
+        pending_setpoint_.yaw_is_rate = yaw_is_rate ? 1 : 0;
+        pending_setpoint_.yaw = yaw;
+    }
+
+    void recordCall(double call_sec, int32_t result)
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        call_times_.insert(call_sec);
+        ++call_count_;
+        if (budget_sec_ > 0 && call_sec > budget_sec_)
+            ++over_budget_count_;
+        if (result != 0) {
+            //only first error goes to status messages, others are counted in report
+            if (error_count_ == 0)
+                status_messages_.push_back(Utils::stringf("Controller plugin returned error %d", result));
+            ++error_count_;
+        }
+    }
+
+    static void copyVector(const Vector3r& v, double* out)
+    {
+        out[0] = v.x(); out[1] = v.y(); out[2] = v.z();
+    }
+    static void copyQuaternion(const Quaternionr& q, double* out)
+    {
+        out[0] = q.w(); out[1] = q.x(); out[2] = q.y(); out[3] = q.z();
+    }
+
+private:
+    const MultiRotorParams* vehicle_params_;
+    const SensorCollection* sensors_;
+    const Kinematics::State* kinematics_;
+    const Environment* environment_;
+    const ImuBase* imu_;
+    const BarometerBase* baro_;
+    const MagnetometerBase* mag_;
+    const GpsBase* gps_;
+
+    int remote_control_id_;
+    std::string vehicle_name_;
+    double budget_sec_;
+
+    SharedLibrary library_;
+    void* instance_ = nullptr;
+    AirSimPluginUpdateFunc update_func_ = nullptr;
+    AirSimPluginResetFunc reset_func_ = nullptr;
+    AirSimPluginDestroyFunc destroy_func_ = nullptr;
+
+    AirSimPluginState state_;
+    AirSimPluginSensors sensors_output_;
+    AirSimPluginSetpoint setpoint_;
+    AirSimPluginRC rc_;
+    AirSimPluginInput input_;
+    AirSimPluginOutput output_;
+    vector<double> rotor_signals_;
+    TTimePoint last_update_time_ = 0;
+    double last_call_sec_ = 0;
+
+    //API threads write commands and connector writes RC here, update() copies them to setpoint_ and rc_
+    std::mutex setpoint_mutex_;
+    AirSimPluginSetpoint pending_setpoint_;
+    AirSimPluginRC pending_rc_;
+
+    std::mutex stats_mutex_;
+    common_utils::RollingOnlineStats call_times_;
+    uint64_t call_count_ = 0, over_budget_count_ = 0, error_count_ = 0;
+    vector<string> status_messages_;
+};
+
+}} //namespace
+#endif
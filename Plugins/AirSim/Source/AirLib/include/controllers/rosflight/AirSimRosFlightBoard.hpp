@@ -16,6 +16,7 @@
 #include "sensors/imu/ImuSimple.hpp"
 #include "sensors/gps/GpsSimple.hpp"
 #include "sensors/magnetometer/MagnetometerSimple.hpp"
+#include "sensors/distance/DistanceSimple.hpp"
 
 namespace msr { namespace airlib {
 
@@ -47,6 +48,19 @@ public:
             imu_updated_callback_();
     }
 
+    //while set, IMU reads return these values instead of sensor output, body frame SI units
+    void setImuOverride(const Vector3r& linear_acceleration, const Vector3r& angular_velocity)
+    {
+        override_linear_acceleration_ = linear_acceleration;
+        override_angular_velocity_ = angular_velocity;
+        is_imu_overridden_ = true;
+    }
+
+    void clearImuOverride()
+    {
+        is_imu_overridden_ = false;
+    }
+
 public:
     //Board interface implementation --------------------------------------------------------------------------
     virtual void init() override 
@@ -54,6 +68,7 @@ public:
         imu_ = static_cast<const ImuBase*>(sensors_->getByType(SensorCollection::SensorType::Imu));
         baro_ = static_cast<const BarometerBase*>(sensors_->getByType(SensorCollection::SensorType::Barometer));
         mag_ = static_cast<const MagnetometerBase*>(sensors_->getByType(SensorCollection::SensorType::Magnetometer));
+        distance_ = static_cast<const DistanceBase*>(sensors_->getByType(SensorCollection::SensorType::Distance));
     }
 
     virtual uint64_t micros() override 
@@ -79,6 +94,7 @@ public:
         case SensorType::Gps: return enabled_sensors_->gps;
         case SensorType::Imu: return enabled_sensors_->imu;
         case SensorType::Mag: return enabled_sensors_->magnetometer;
+        case SensorType::Sonar: return enabled_sensors_->distance;
         default:
             return false;
         }
@@ -150,20 +166,20 @@ public:
 
     virtual void read_accel(int16_t accel_adc[3]) override 
     {
-        const auto& output = imu_->getOutput();
+        const Vector3r& linear_acceleration = is_imu_overridden_ ? override_linear_acceleration_ : imu_->getOutput().linear_acceleration;
         //convert from SI units in NED to ADC output
-        accel_adc[0] = accel_to_adc(output.linear_acceleration.x());
-        accel_adc[1] = -accel_to_adc(output.linear_acceleration.y());
-        accel_adc[2] = -accel_to_adc(output.linear_acceleration.z());
+        accel_adc[0] = accel_to_adc(linear_acceleration.x());
+        accel_adc[1] = -accel_to_adc(linear_acceleration.y());
+        accel_adc[2] = -accel_to_adc(linear_acceleration.z());
     }
 
     virtual void read_gyro(int16_t gyro_adc[3]) override 
     {
-        const auto& output = imu_->getOutput();
+        const Vector3r& angular_velocity = is_imu_overridden_ ? override_angular_velocity_ : imu_->getOutput().angular_velocity;
         //convert from SI units in NED to ADC output
-        gyro_adc[0] = angular_vel_to_adc(output.angular_velocity.x());
-        gyro_adc[1] = -angular_vel_to_adc(output.angular_velocity.y());
-        gyro_adc[2] = -angular_vel_to_adc(output.angular_velocity.z());
+        gyro_adc[0] = angular_vel_to_adc(angular_velocity.x());
+        gyro_adc[1] = -angular_vel_to_adc(angular_velocity.y());
+        gyro_adc[2] = -angular_vel_to_adc(angular_velocity.z());
     }
 
     virtual void read_temperature(int16_t& temp) override
@@ -191,7 +207,9 @@ public:
 
     virtual float read_sonar() override 
     {
-        throw std::runtime_error("Sonar sensor is not available");
+        if (distance_ == nullptr)
+            throw std::runtime_error("Sonar sensor is not available");
+        return distance_->getOutput().distance;
     }
 
     virtual void read_mag(int16_t mag_adc[3]) override 
@@ -247,6 +265,7 @@ private: //types and consts
     const ImuBase* imu_;
     const BarometerBase* baro_;
     const MagnetometerBase* mag_;
+    const DistanceBase* distance_;
 
     const uint16_t kAccelAdcBits = 512 * 8; //for mpu6050 as per breezystm32/drv_mpu6050.c
     const float kAccelScale = 1.0; //as set in PARAM_ACCEL_SCALE in ROSFlight
@@ -266,6 +285,10 @@ private:
     uint16_t input_channels_[InputChannelCount];
 
     std::function<void(void)> imu_updated_callback_;
+
+    bool is_imu_overridden_ = false;
+    Vector3r override_linear_acceleration_;
+    Vector3r override_angular_velocity_;
 };
 
 }} //namespace
@@ -5,6 +5,7 @@
 #define msr_airlib_AirSimRosFlightCommLink_hpp
 
 #include <exception>
+#include <iterator>
 #include "firmware/commlink.hpp"
 #include "common/Common.hpp"
 #include "vehicles/MultiRotorParams.hpp"
@@ -19,7 +20,7 @@ public: // derived class specific methods
     void getStatusMessages(std::vector<std::string>& messages)
     {
         if (messages_.size() > 0) {
-            messages.insert(messages.end(), messages_.begin(), messages_.end());
+            messages.insert(messages.end(), std::make_move_iterator(messages_.begin()), std::make_move_iterator(messages_.end()));
             messages_.clear();
         }
     }
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_RosFlightCalibrationCache_hpp
+#define msr_airlib_RosFlightCalibrationCache_hpp
+
+#include <map>
+#include <mutex>
+#include "common/Common.hpp"
+#include "controllers/Settings.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    IMU calibration results of ROSFlight vehicles, keyed by vehicle config.
+    Simulated IMUs give the same biases on every run, so once a calibration
+    has completed it is restored on later starts and resets instead of
+    collecting samples again. Results are kept for the process and, if a
+    file name is given, in a json file in the AirSim folder so they survive
+    restarts. Shared by all vehicles, calls may come from any thread.
+*/
+class RosFlightCalibrationCache {
+public: //types
+    struct Calibration {
+        Vector3r gyro_bias;
+        Vector3r accel_bias;
+    };
+
+public:
+    static RosFlightCalibrationCache& singleton()
+    {
+        static RosFlightCalibrationCache cache;
+        return cache;
+    }
+
+    //file is relative to AirSim folder, empty file uses memory only
+    bool get(const std::string& key, const std::string& file, Calibration& calibration)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            calibration = it->second;
+            return true;
+        }
+
+        Settings doc, child;
+        if (file.empty() || !loadFile(file, doc) || !doc.getChild(key, child))
+            return false;
+        calibration.gyro_bias = Vector3r(static_cast<real_T>(child.getDouble("GyroBiasX", 0)),
+            static_cast<real_T>(child.getDouble("GyroBiasY", 0)), static_cast<real_T>(child.getDouble("GyroBiasZ", 0)));
+        calibration.accel_bias = Vector3r(static_cast<real_T>(child.getDouble("AccelBiasX", 0)),
+            static_cast<real_T>(child.getDouble("AccelBiasY", 0)), static_cast<real_T>(child.getDouble("AccelBiasZ", 0)));
+        entries_[key] = calibration;
+        return true;
+    }
+
+    void put(const std::string& key, const std::string& file, const Calibration& calibration)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        entries_[key] = calibration;
+        if (file.empty())
+            return;
+
+        //keep entries of other configs already in the file
+        Settings doc, child;
+        loadFile(file, doc);
+        child.setDouble("GyroBiasX", calibration.gyro_bias.x());
+        child.setDouble("GyroBiasY", calibration.gyro_bias.y());
+        child.setDouble("GyroBiasZ", calibration.gyro_bias.z());
+        child.setDouble("AccelBiasX", calibration.accel_bias.x());
+        child.setDouble("AccelBiasY", calibration.accel_bias.y());
+        child.setDouble("AccelBiasZ", calibration.accel_bias.z());
+        doc.setChild(key, child);
+        try {
+            doc.saveJSonFile(file);
+        }
+        catch (std::exception& ex) {
+            Utils::logError("Cannot save ROSFlight calibration to %s: %s", file.c_str(), ex.what());
+        }
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+private:
+    //damaged file is treated as missing, it is rewritten on next put
+    static bool loadFile(const std::string& file, Settings& doc)
+    {
+        try {
+            return doc.loadFile(file);
+        }
+        catch (std::exception& ex) {
+            Utils::logError("Cannot read ROSFlight calibration from %s: %s", file.c_str(), ex.what());
+            doc = Settings();
+            return false;
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, Calibration> entries_;
+};
+
+}} //namespace
+#endif
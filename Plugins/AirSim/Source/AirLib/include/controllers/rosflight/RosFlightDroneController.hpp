@@ -12,7 +12,7 @@
 #include "common/Common.hpp"
 #include "AirSimRosFlightBoard.hpp"
 #include "AirSimRosFlightCommLink.hpp"
-#include "controllers/Settings.hpp"
+#include "RosFlightCalibrationCache.hpp"
 
 STRICT_MODE_OFF
 #include "firmware/firmware.hpp"
@@ -21,10 +21,21 @@ STRICT_MODE_ON
 namespace msr { namespace airlib {
 
 class RosFlightDroneController : public DroneControllerBase {
+public: //types
+    struct CalibrationParams {
+        //restore IMU calibration of same config from RosFlightCalibrationCache instead of calibrating again
+        bool use_cache = true;
+        std::string cache_key = "RosFlight";
+        //json file in AirSim folder that keeps calibration across runs, empty for memory only
+        std::string cache_file = "";
+        //calibrate gyro and accel on the first tick from noise free IMU samples instead of waiting for arming
+        bool burst = false;
+    };
 
 public:
-    RosFlightDroneController(const SensorCollection* sensors, const MultiRotorParams* vehicle_params)
-        : vehicle_params_(vehicle_params)
+    RosFlightDroneController(const SensorCollection* sensors, const MultiRotorParams* vehicle_params, int remote_control_id,
+        const CalibrationParams& calibration_params)
+        : vehicle_params_(vehicle_params), remote_control_id_(remote_control_id), calibration_params_(calibration_params)
     {
         sensors_ = sensors;
 
@@ -33,9 +44,7 @@ public:
         firmware_.reset(new rosflight::Firmware(board_.get(), comm_link_.get()));
         firmware_->setup();
 
-        Settings child;
-        Settings::singleton().getChild("RosFlight", child);
-        remote_control_id_ = child.getInt("RemoteControlID", 0);
+        restoreCalibration();
     }
 
     void initializePhysics(const Environment* environment, const Kinematics::State* kinematics)
@@ -49,12 +58,19 @@ public:
     virtual void reset() override
     {
         board_->system_reset(false);
+        restoreCalibration();
     }
 
     virtual void update() override
     {
+        if (is_calibration_burst_pending_ && kinematics_ != nullptr)
+            runCalibrationBurst();
+
         board_->notifySensorUpdated(rosflight::Board::SensorType::Imu);
         firmware_->loop();
+
+        if (calibration_params_.use_cache && !is_calibration_cached_)
+            cacheCalibration();
     }
 
     virtual void start() override
@@ -249,6 +265,60 @@ protected:
     //*** End: DroneControllerBase implementation ***//
 
 private:
+    void restoreCalibration()
+    {
+        is_calibration_cached_ = false;
+        is_calibration_burst_pending_ = false;
+
+        RosFlightCalibrationCache::Calibration calibration;
+        if (calibration_params_.use_cache && RosFlightCalibrationCache::singleton().get(
+                calibration_params_.cache_key, calibration_params_.cache_file, calibration)) {
+            firmware_->get_sensors()->set_imu_calibration(toVector(calibration.gyro_bias), toVector(calibration.accel_bias));
+            is_calibration_cached_ = true;
+        }
+        else
+            is_calibration_burst_pending_ = calibration_params_.burst;
+    }
+
+    void runCalibrationBurst()
+    {
+        is_calibration_burst_pending_ = false;
+
+        //what ImuSimple would output without noise, the same for every sample of the burst
+        Vector3r linear_acceleration = VectorMath::transformToBodyFrame(
+            kinematics_->accelerations.linear - environment_->getState().gravity, kinematics_->pose.orientation, true);
+        board_->setImuOverride(linear_acceleration, kinematics_->twist.angular);
+
+        rosflight::Sensors* sensors = firmware_->get_sensors();
+        sensors->start_imu_calibration();
+        if (!sensors->run_calibration_burst())
+            comm_link_->log_message("IMU calibration burst failed, vehicle must be still", 2);
+
+        board_->clearImuOverride();
+    }
+
+    void cacheCalibration()
+    {
+        vector_t gyro_bias, accel_bias;
+        if (!firmware_->get_sensors()->get_imu_calibration(gyro_bias, accel_bias))
+            return;
+
+        RosFlightCalibrationCache::Calibration calibration;
+        calibration.gyro_bias = Vector3r(gyro_bias.x, gyro_bias.y, gyro_bias.z);
+        calibration.accel_bias = Vector3r(accel_bias.x, accel_bias.y, accel_bias.z);
+        RosFlightCalibrationCache::singleton().put(calibration_params_.cache_key, calibration_params_.cache_file, calibration);
+        is_calibration_cached_ = true;
+    }
+
+    static vector_t toVector(const Vector3r& v)
+    {
+        vector_t result;
+        result.x = v.x();
+        result.y = v.y();
+        result.z = v.z();
+        return result;
+    }
+
     //convert pitch, roll, yaw from -1 to 1 to PWM
     static uint16_t angleToPwm(float angle)
     {
@@ -265,11 +335,14 @@ private:
 
 private:
     const MultiRotorParams* vehicle_params_;
-    const Kinematics::State* kinematics_;
-    const Environment* environment_;
+    const Kinematics::State* kinematics_ = nullptr;
+    const Environment* environment_ = nullptr;
     const SensorCollection* sensors_;
 
     int remote_control_id_ = 0;
+    CalibrationParams calibration_params_;
+    bool is_calibration_cached_ = false;
+    bool is_calibration_burst_pending_ = false;
 
     unique_ptr<AirSimRosFlightBoard> board_;
     unique_ptr<AirSimRosFlightCommLink> comm_link_;
@@ -21,14 +21,23 @@ public:
     bool start_gyro_calibration(void);
     bool gyro_calibration_complete(void);
 
+    // Calibration results for simulated boards that restore them instead of calibrating every run.
+    // get returns false until a gyro calibration has completed or one was restored.
+    bool get_imu_calibration(vector_t& gyro_bias, vector_t& accel_bias);
+    void set_imu_calibration(const vector_t& gyro_bias, const vector_t& accel_bias);
+    // Runs pending calibrations to completion on back to back IMU reads, returns false if they failed
+    bool run_calibration_burst(void);
+
     void get_imu_measurements(vector_t& accel, vector_t& gyro, uint64_t& imu_time);
 
 private:
     volatile uint8_t accel_status, gyro_status, temp_status;
     float accel_scale;
     float gyro_scale;
-    bool calibrating_acc_flag;
-    bool calibrating_gyro_flag;
+    bool calibrating_acc_flag = false;
+    bool calibrating_gyro_flag = false;
+    bool imu_calibrated = false;
+    bool calibration_restored = false;
     void calibrate_accel(void);
     void calibrate_gyro(void);
     void correct_imu(void);
@@ -170,6 +179,9 @@ bool Sensors::start_imu_calibration(void)
 {
     comm_link->log_message("Starting IMU calibration...", 0);
 
+    // explicit request always calibrates again
+    calibration_restored = false;
+
     start_gyro_calibration();
 
     calibrating_acc_flag = true;
@@ -181,6 +193,10 @@ bool Sensors::start_imu_calibration(void)
 
 bool Sensors::start_gyro_calibration(void)
 {
+    // arming asks for gyro calibration every time, restored biases are kept instead
+    if (calibration_restored)
+        return true;
+
     comm_link->log_message("Starting gyro calibration...", 0);
 
     calibrating_gyro_flag = true;
@@ -195,6 +211,56 @@ bool Sensors::gyro_calibration_complete(void)
     return !calibrating_gyro_flag;
 }
 
+bool Sensors::get_imu_calibration(vector_t& gyro_bias, vector_t& accel_bias)
+{
+    if (!imu_calibrated || calibrating_gyro_flag || calibrating_acc_flag)
+        return false;
+
+    gyro_bias.x = params->get_param_float(Params::PARAM_GYRO_X_BIAS);
+    gyro_bias.y = params->get_param_float(Params::PARAM_GYRO_Y_BIAS);
+    gyro_bias.z = params->get_param_float(Params::PARAM_GYRO_Z_BIAS);
+    accel_bias.x = params->get_param_float(Params::PARAM_ACC_X_BIAS);
+    accel_bias.y = params->get_param_float(Params::PARAM_ACC_Y_BIAS);
+    accel_bias.z = params->get_param_float(Params::PARAM_ACC_Z_BIAS);
+    return true;
+}
+
+void Sensors::set_imu_calibration(const vector_t& gyro_bias, const vector_t& accel_bias)
+{
+    params->set_param_float(Params::PARAM_GYRO_X_BIAS, gyro_bias.x);
+    params->set_param_float(Params::PARAM_GYRO_Y_BIAS, gyro_bias.y);
+    params->set_param_float(Params::PARAM_GYRO_Z_BIAS, gyro_bias.z);
+    params->set_param_float(Params::PARAM_ACC_X_BIAS, accel_bias.x);
+    params->set_param_float(Params::PARAM_ACC_Y_BIAS, accel_bias.y);
+    params->set_param_float(Params::PARAM_ACC_Z_BIAS, accel_bias.z);
+
+    // drop any calibration in progress, same as its completion would
+    calibrating_gyro_flag = false;
+    calibrating_acc_flag = false;
+    calib_gyro_count = 0;
+    calib_gyro_sum = { 0.0f, 0.0f, 0.0f };
+    calib_accel_count = 0;
+    calib_accel_sum = { 0.0f, 0.0f, 0.0f };
+    acc_temp_sum = 0.0f;
+
+    imu_calibrated = true;
+    calibration_restored = true;
+    estimator->reset_adaptive_bias();
+    estimator->reset_state();
+    comm_link->log_message("IMU calibration restored", 0);
+}
+
+bool Sensors::run_calibration_burst(void)
+{
+    // accel calibration takes the most samples and may restart once after fixing accel scale
+    for (int i = 0; i < 2 * 1002 && (calibrating_acc_flag || calibrating_gyro_flag); i++)
+    {
+        imu_ISR();
+        update_imu();
+    }
+    return imu_calibrated && !calibrating_acc_flag && !calibrating_gyro_flag;
+}
+
 
 void Sensors::imu_ISR(void)
 {
@@ -269,6 +335,7 @@ void Sensors::calibrate_gyro()
 
             // Tell the estimator to reset it's bias estimate, because it should be zero now
             estimator->reset_adaptive_bias();
+            imu_calibrated = true;
         } else
         {
             comm_link->log_message("Too much movement for gyro cal", 3);
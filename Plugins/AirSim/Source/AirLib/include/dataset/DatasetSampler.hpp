@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_DatasetSampler_hpp
+#define msr_airlib_DatasetSampler_hpp
+
+#include <random>
+#include "common/Common.hpp"
+#include "common/VectorMath.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Draws randomized dataset samples: camera pose, camera settings and scene
+    variant, each uniformly within its range. Positions are NED meters
+    relative to the dataset origin, angles are degrees. Same seed gives the
+    same sequence, so a dataset can be regenerated or extended.
+*/
+class DatasetSampler {
+public: //types
+    struct Params {
+        uint32_t seed = 0;
+        Vector3r position_min = Vector3r(-50, -50, -30);
+        Vector3r position_max = Vector3r(50, 50, -2);
+        real_T pitch_min = -45, pitch_max = 10;
+        real_T roll_min = 0, roll_max = 0;
+        real_T fov_min = 60, fov_max = 110;
+        real_T exposure_min = 0, exposure_max = 0;      //exposure bias in stops
+        bool randomize_light = true;
+        real_T light_pitch_min = -80, light_pitch_max = -10;
+        real_T light_intensity_min = 2, light_intensity_max = 10;
+    };
+
+    struct Sample {
+        uint64_t index;
+        Vector3r position;
+        Quaternionr orientation;
+        real_T fov;
+        real_T exposure;
+        //NaN when lighting is not randomized
+        real_T light_pitch, light_yaw, light_intensity;
+    };
+
+public:
+    DatasetSampler()
+        : DatasetSampler(Params())
+    {
+    }
+
+    DatasetSampler(const Params& params)
+        : params_(params)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        random_.seed(params_.seed);
+        next_index_ = 0;
+    }
+
+    Sample next()
+    {
+        Sample sample;
+        sample.index = next_index_++;
+        sample.position = Vector3r(uniform(params_.position_min.x(), params_.position_max.x()),
+            uniform(params_.position_min.y(), params_.position_max.y()),
+            uniform(params_.position_min.z(), params_.position_max.z()));
+
+        real_T pitch = uniform(params_.pitch_min, params_.pitch_max);
+        real_T roll = uniform(params_.roll_min, params_.roll_max);
+        real_T yaw = uniform(-180, 180);
+        sample.orientation = VectorMath::toQuaternion(Utils::degreesToRadians(pitch), Utils::degreesToRadians(roll),
+            Utils::degreesToRadians(yaw));
+
+        sample.fov = uniform(params_.fov_min, params_.fov_max);
+        sample.exposure = uniform(params_.exposure_min, params_.exposure_max);
+
+        //always draw so that other fields don't depend on this setting
+        real_T light_pitch = uniform(params_.light_pitch_min, params_.light_pitch_max);
+        real_T light_yaw = uniform(-180, 180);
+        real_T light_intensity = uniform(params_.light_intensity_min, params_.light_intensity_max);
+        if (params_.randomize_light) {
+            sample.light_pitch = light_pitch;
+            sample.light_yaw = light_yaw;
+            sample.light_intensity = light_intensity;
+        }
+        else
+            sample.light_pitch = sample.light_yaw = sample.light_intensity = Utils::nan<real_T>();
+
+        return sample;
+    }
+
+    //column names matching toValues
+    static vector<string> getValueNames()
+    {
+        return { "x", "y", "z", "qw", "qx", "qy", "qz", "fov", "exposure", "light_pitch", "light_yaw", "light_intensity" };
+    }
+
+    //appends sample fields with pose given separately, so flights can log the pose actually reached
+    static void toValues(const Sample& sample, const Vector3r& position, const Quaternionr& orientation, vector<real_T>& values)
+    {
+        values.push_back(position.x());
+        values.push_back(position.y());
+        values.push_back(position.z());
+        values.push_back(orientation.w());
+        values.push_back(orientation.x());
+        values.push_back(orientation.y());
+        values.push_back(orientation.z());
+        values.push_back(sample.fov);
+        values.push_back(sample.exposure);
+        values.push_back(sample.light_pitch);
+        values.push_back(sample.light_yaw);
+        values.push_back(sample.light_intensity);
+    }
+
+    const Params& getParams() const
+    {
+        return params_;
+    }
+
+private:
+    real_T uniform(real_T min_val, real_T max_val)
+    {
+        if (!(max_val > min_val))
+            return min_val;
+        return std::uniform_real_distribution<real_T>(min_val, max_val)(random_);
+    }
+
+private:
+    Params params_;
+    std::mt19937 random_;
+    uint64_t next_index_;
+};
+
+}} //namespace
+#endif
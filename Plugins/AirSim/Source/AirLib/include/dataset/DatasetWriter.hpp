@@ -0,0 +1,382 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_DatasetWriter_hpp
+#define msr_airlib_DatasetWriter_hpp
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/common_utils/FileSystem.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Writes dataset frames from a pool of encoder threads in to a chunked
+    container, so the simulator only hands over raw pixels and goes on
+    rendering.
+
+    Frames come from a fixed pool: acquireFrame() gives an empty frame (or
+    null when all are in flight, which is the back pressure signal for the
+    producer), the producer fills images and per frame values and calls
+    submit(). Encoder threads run the optional encode function on each image
+    (e.g. PNG compression or channel reduction), then append the frame to
+    the current chunk and return it to the pool. Buffers of pooled frames
+    keep their capacity, so steady state capture doesn't allocate.
+
+    Container, for base path B:
+        B_chunk000.bin, B_chunk001.bin, ...  image records, a new chunk is
+            started once chunk_bytes is reached; all images of one frame are
+            contiguous in one chunk
+        B_frames.tsv  one line per frame: index, timestamp, chunk, offset of
+            its first record, then the caller's values (names in header line)
+    Each record is a RecordHeader followed by data_size bytes. Frames are
+    written in the order encoding finishes, use the index to sort.
+*/
+class DatasetWriter {
+public: //types
+    enum class PixelFormat : uint32_t {
+        Bgra8 = 0,      //4 bytes per pixel
+        Rgba32F = 1,    //16 bytes per pixel
+        Float32 = 2,    //4 bytes per pixel, single channel
+        Png = 3         //encoded file
+    };
+
+    struct Image {
+        int camera_id;
+        uint image_type;
+        int width, height;
+        PixelFormat format;
+        vector<uint8_t> data;
+    };
+
+    struct Frame {
+        uint64_t index;
+        TTimePoint timestamp;
+        //same order as value_names given to open()
+        vector<real_T> values;
+        vector<Image> images;
+    };
+
+    //header of each image record in chunk files, 48 bytes, little endian
+    struct RecordHeader {
+        char magic[4];              //"ADSR"
+        uint32_t header_size;
+        uint64_t frame_index;
+        int32_t camera_id;
+        uint32_t image_type;
+        int32_t width;
+        int32_t height;
+        uint32_t format;            //PixelFormat
+        uint32_t reserved;
+        uint64_t data_size;
+    };
+
+    //runs on encoder threads, may change image format and data in place, scratch is per thread
+    typedef std::function<void(Image& image, vector<uint8_t>& scratch)> EncodeFunc;
+
+    struct Params {
+        uint encoder_threads = 0;                   //0 means one less than hardware threads
+        uint max_frames = 16;                       //size of frame pool
+        uint64_t chunk_bytes = 256 * 1024 * 1024;
+        int stats_window = 100;
+    };
+
+public:
+    DatasetWriter()
+        : DatasetWriter(Params())
+    {
+    }
+
+    DatasetWriter(const Params& params)
+        : params_(params), is_open_(false), is_stopping_(false), encoder_count_(0)
+    {
+        static_assert(sizeof(RecordHeader) == 48, "RecordHeader must be packed without padding");
+    }
+
+    ~DatasetWriter()
+    {
+        close();
+    }
+
+    //throws if files can't be created
+    void open(const string& base_path, const vector<string>& value_names, EncodeFunc encode = nullptr)
+    {
+        close();
+
+        base_path_ = base_path;
+        encode_ = encode;
+        chunk_offset_ = 0;
+        written_count_ = 0;
+        written_bytes_ = 0;
+        error_count_ = 0;
+        encode_times_.initialize(params_.stats_window);
+        write_times_.initialize(params_.stats_window);
+
+        common_utils::FileSystem::createTextFile(base_path_ + "_frames.tsv", index_file_);
+        index_file_ << "index\ttimestamp\tchunk\toffset";
+        for (const auto& name : value_names)
+            index_file_ << "\t" << name;
+        index_file_ << "\n";
+        openChunk(0);
+
+        frames_.clear();
+        free_frames_.clear();
+        queue_.clear();
+        for (uint i = 0; i < std::max(params_.max_frames, 1u); ++i) {
+            frames_.push_back(std::unique_ptr<Frame>(new Frame()));
+            free_frames_.push_back(frames_.back().get());
+        }
+
+        uint thread_count = params_.encoder_threads;
+        if (thread_count == 0)
+            thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        encoder_count_ = thread_count;
+        is_stopping_ = false;
+        is_open_ = true;
+        start_time_ = std::chrono::steady_clock::now();
+        last_write_time_ = start_time_;
+        for (uint i = 0; i < thread_count; ++i)
+            encoders_.emplace_back(&DatasetWriter::encoderLoop, this);
+    }
+
+    //writes all submitted frames, then stops encoder threads
+    void close()
+    {
+        if (!is_open_)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_stopping_ = true;
+        }
+        queue_cv_.notify_all();
+        for (auto& encoder : encoders_)
+            encoder.join();
+        encoders_.clear();
+
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        chunk_file_.close();
+        index_file_.close();
+        is_open_ = false;
+    }
+
+    bool isOpen() const
+    {
+        return is_open_;
+    }
+
+    //empty frame from pool, null if all frames are in flight
+    Frame* acquireFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!is_open_ || free_frames_.empty())
+            return nullptr;
+        Frame* frame = free_frames_.back();
+        free_frames_.pop_back();
+        frame->values.clear();
+        //images keep their buffers, producer resizes the list as needed
+        return frame;
+    }
+
+    void submit(Frame* frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(frame);
+        }
+        queue_cv_.notify_one();
+    }
+
+    //returns frame to pool without writing it
+    void release(Frame* frame)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_frames_.push_back(frame);
+    }
+
+    uint64_t getWrittenCount() const
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        return written_count_;
+    }
+
+    uint64_t getWrittenBytes() const
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        return written_bytes_;
+    }
+
+    uint getQueuedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<uint>(queue_.size());
+    }
+
+    uint getFreeCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<uint>(free_frames_.size());
+    }
+
+    //frames written per second from open to last write
+    double getFramesPerSecond() const
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        double elapsed = std::chrono::duration<double>(last_write_time_ - start_time_).count();
+        return elapsed > 0 ? written_count_ / elapsed : 0;
+    }
+
+    std::string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        double elapsed = std::chrono::duration<double>(last_write_time_ - start_time_).count();
+        ss << "Dataset writer: " << written_count_ << " frames, " << written_bytes_ / (1024.0 * 1024.0) << " MB in "
+            << (chunk_index_ + 1) << " chunks, " << (elapsed > 0 ? written_count_ / elapsed : 0) << " frames/s, "
+            << encoder_count_ << " encoders";
+        if (encode_times_.size() > 0)
+            ss << std::setprecision(2) << ", encode " << encode_times_.mean() * 1E3 << " ms, write " << write_times_.mean() * 1E3 << " ms";
+        if (error_count_ > 0)
+            ss << ", " << error_count_ << " write errors";
+        ss << std::endl;
+        return ss.str();
+    }
+
+private:
+    void encoderLoop()
+    {
+        vector<uint8_t> scratch;
+        while (true) {
+            Frame* frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                queue_cv_.wait(lock, [this]() { return !queue_.empty() || is_stopping_; });
+                //queue is drained before stopping so close() loses nothing
+                if (queue_.empty())
+                    break;
+                frame = queue_.front();
+                queue_.pop_front();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            if (encode_) {
+                for (Image& image : frame->images)
+                    encode_(image, scratch);
+            }
+            auto encoded = std::chrono::steady_clock::now();
+            write(*frame, std::chrono::duration<double>(encoded - start).count());
+
+            release(frame);
+        }
+    }
+
+    void write(const Frame& frame, double encode_sec)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(file_mutex_);
+
+        if (chunk_offset_ >= params_.chunk_bytes) {
+            try {
+                openChunk(chunk_index_ + 1);
+            }
+            catch (const std::ios_base::failure& ex) {
+                //frame is dropped, next frame tries the same chunk again
+                if (error_count_++ == 0)
+                    Utils::logError("%s", ex.what());
+                return;
+            }
+        }
+
+        uint64_t frame_offset = chunk_offset_;
+        for (const Image& image : frame.images) {
+            RecordHeader header;
+            header.magic[0] = 'A'; header.magic[1] = 'D'; header.magic[2] = 'S'; header.magic[3] = 'R';
+            header.header_size = sizeof(RecordHeader);
+            header.frame_index = frame.index;
+            header.camera_id = image.camera_id;
+            header.image_type = image.image_type;
+            header.width = image.width;
+            header.height = image.height;
+            header.format = static_cast<uint32_t>(image.format);
+            header.reserved = 0;
+            header.data_size = image.data.size();
+
+            chunk_file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            chunk_file_.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+            chunk_offset_ += sizeof(header) + image.data.size();
+        }
+
+        index_file_ << frame.index << "\t" << frame.timestamp << "\t" << chunk_index_ << "\t" << frame_offset;
+        for (real_T value : frame.values)
+            index_file_ << "\t" << value;
+        index_file_ << "\n";
+
+        if (!chunk_file_.good() || !index_file_.good()) {
+            //report once, disk full or similar won't fix itself
+            if (error_count_++ == 0)
+                Utils::logError("Cannot write dataset to %s", base_path_.c_str());
+        }
+        else {
+            ++written_count_;
+            written_bytes_ += chunk_offset_ - frame_offset;
+        }
+
+        last_write_time_ = std::chrono::steady_clock::now();
+        encode_times_.insert(encode_sec);
+        write_times_.insert(std::chrono::duration<double>(last_write_time_ - start).count());
+    }
+
+    //throws if file can't be created, current chunk is closed either way
+    void openChunk(uint index)
+    {
+        chunk_file_.close();
+        std::ostringstream ss;
+        ss << base_path_ << "_chunk" << std::setw(3) << std::setfill('0') << index << ".bin";
+        common_utils::FileSystem::createBinaryFile(ss.str(), chunk_file_);
+        if (!chunk_file_.is_open())
+            throw std::ios_base::failure("Cannot create dataset chunk " + ss.str());
+        chunk_index_ = index;
+        chunk_offset_ = 0;
+    }
+
+private:
+    Params params_;
+    string base_path_;
+    EncodeFunc encode_;
+    bool is_open_;
+
+    //guards frame pool and queue
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    bool is_stopping_;
+    vector<std::unique_ptr<Frame>> frames_;
+    vector<Frame*> free_frames_;
+    std::deque<Frame*> queue_;
+    vector<std::thread> encoders_;
+    uint encoder_count_;
+
+    //guards files and stats
+    mutable std::mutex file_mutex_;
+    std::ofstream chunk_file_;
+    std::ofstream index_file_;
+    uint chunk_index_;
+    uint64_t chunk_offset_;
+    uint64_t written_count_;
+    uint64_t written_bytes_;
+    uint64_t error_count_;
+    std::chrono::steady_clock::time_point start_time_, last_write_time_;
+    common_utils::RollingOnlineStats encode_times_;
+    common_utils::RollingOnlineStats write_times_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,219 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_CollisionWorld_hpp
+#define airsim_core_CollisionWorld_hpp
+
+#include <cmath>
+#include <unordered_map>
+#include <algorithm>
+#include "common/Common.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Static geometry for continuous collision detection, as oriented boxes
+    in NED meters. The simulator fills it once at startup from the level's
+    simple collision shapes and after that it is only queried, by the
+    physics thread. Queries reuse a scratch buffer so they must not run
+    concurrently.
+
+    Bodies are swept as spheres: a sphere moving from start to end hits a
+    box when its center enters the box grown by the radius. Growing the
+    box instead of rounding its edges makes corners hit slightly early,
+    which is the safe side for keeping fast vehicles out of thin geometry.
+
+    Boxes are bucketed in a uniform grid so a sweep only tests boxes near
+    its path.
+*/
+class CollisionWorld {
+public: //types
+    struct Box {
+        Vector3r center;
+        Matrix3x3r axes;        //columns are box axes in world frame
+        Vector3r half_extents;
+    };
+
+    struct Hit {
+        real_T time;            //fraction of the sweep in [0, 1]
+        Vector3r normal;        //unit, points away from the obstacle
+    };
+
+public:
+    CollisionWorld(real_T cell_size = 4)
+        : cell_size_(cell_size)
+    {
+    }
+
+    void addBox(const Vector3r& center, const Quaternionr& orientation, const Vector3r& half_extents)
+    {
+        Box box;
+        box.center = center;
+        box.axes = orientation.toRotationMatrix();
+        box.half_extents = half_extents.cwiseAbs();
+        boxes_.push_back(box);
+
+        //world AABB of the box decides which cells it goes in
+        Vector3r extent = box.axes.cwiseAbs() * box.half_extents;
+        forEachCell(center - extent, center + extent, [&](uint64_t key) {
+            cells_[key].push_back(static_cast<uint>(boxes_.size() - 1));
+        });
+    }
+
+    size_t getBoxCount() const
+    {
+        return boxes_.size();
+    }
+    const Box& getBox(size_t index) const
+    {
+        return boxes_.at(index);
+    }
+
+    //earliest hit of sphere moving from start to end, false if path is clear
+    bool sweepSphere(const Vector3r& start, const Vector3r& end, real_T radius, Hit& hit) const
+    {
+        if (boxes_.size() == 0)
+            return false;
+
+        Vector3r margin = Vector3r::Constant(radius);
+        candidates_buffer_.clear();
+        forEachCell(start.cwiseMin(end) - margin, start.cwiseMax(end) + margin, [&](uint64_t key) {
+            auto it = cells_.find(key);
+            if (it != cells_.end())
+                candidates_buffer_.insert(candidates_buffer_.end(), it->second.begin(), it->second.end());
+        });
+        //boxes spanning several cells show up more than once
+        std::sort(candidates_buffer_.begin(), candidates_buffer_.end());
+        candidates_buffer_.erase(std::unique(candidates_buffer_.begin(), candidates_buffer_.end()), candidates_buffer_.end());
+
+        bool is_hit = false;
+        Hit box_hit;
+        for (uint index : candidates_buffer_) {
+            if (sweepBox(boxes_[index], start, end - start, radius, box_hit) && (!is_hit || box_hit.time < hit.time)) {
+                hit = box_hit;
+                is_hit = true;
+            }
+        }
+        return is_hit;
+    }
+
+    /*
+        Time of impact of two spheres moving linearly over the same interval,
+        as fraction in [0, 1]. Spheres already touching count as hit at 0 only
+        if they are still closing, so separating bodies are not held together.
+    */
+    static bool sweepSpheres(const Vector3r& a_start, const Vector3r& a_end, real_T a_radius,
+        const Vector3r& b_start, const Vector3r& b_end, real_T b_radius, real_T& time)
+    {
+        Vector3r p = a_start - b_start;
+        Vector3r d = (a_end - a_start) - (b_end - b_start);
+        real_T r = a_radius + b_radius;
+
+        real_T b = p.dot(d);
+        if (b >= 0)
+            return false;   //not closing
+        real_T c = p.squaredNorm() - r * r;
+        if (c <= 0) {
+            time = 0;
+            return true;
+        }
+        real_T a = d.squaredNorm();
+        real_T discriminant = b * b - a * c;
+        if (discriminant < 0)
+            return false;
+        time = (-b - std::sqrt(discriminant)) / a;
+        return time <= 1;
+    }
+
+private:
+    //slab test of sweep against box grown by radius, in box frame
+    static bool sweepBox(const Box& box, const Vector3r& start, const Vector3r& delta, real_T radius, Hit& hit)
+    {
+        Vector3r p = box.axes.transpose() * (start - box.center);
+        Vector3r d = box.axes.transpose() * delta;
+        Vector3r h = box.half_extents + Vector3r::Constant(radius);
+
+        real_T t_enter = -Utils::max<real_T>(), t_exit = Utils::max<real_T>();
+        int enter_axis = -1;
+        real_T enter_sign = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (std::abs(d(axis)) < 1E-9f) {
+                if (std::abs(p(axis)) > h(axis))
+                    return false;
+                continue;
+            }
+            real_T t1 = (-h(axis) - p(axis)) / d(axis);
+            real_T t2 = (h(axis) - p(axis)) / d(axis);
+            if (t1 > t2)
+                std::swap(t1, t2);
+            if (t1 > t_enter) {
+                t_enter = t1;
+                enter_axis = axis;
+                //moving in +axis enters through the negative face
+                enter_sign = d(axis) > 0 ? -1.0f : 1.0f;
+            }
+            t_exit = std::min(t_exit, t2);
+            if (t_enter > t_exit || t_exit < 0 || t_enter > 1)
+                return false;
+        }
+
+        if (t_enter >= 0 && enter_axis >= 0) {
+            hit.time = t_enter;
+            hit.normal = box.axes.col(enter_axis) * enter_sign;
+            return true;
+        }
+
+        //already inside: push out through the nearest face, but only if still moving inwards
+        int axis = 0;
+        real_T sign = 1, min_depth = Utils::max<real_T>();
+        for (int i = 0; i < 3; ++i) {
+            if (h(i) - p(i) < min_depth) {
+                min_depth = h(i) - p(i);
+                axis = i;
+                sign = 1;
+            }
+            if (h(i) + p(i) < min_depth) {
+                min_depth = h(i) + p(i);
+                axis = i;
+                sign = -1;
+            }
+        }
+        if (d(axis) * sign >= 0)
+            return false;
+        hit.time = 0;
+        hit.normal = box.axes.col(axis) * sign;
+        return true;
+    }
+
+    template<typename TFunc>
+    void forEachCell(const Vector3r& min_corner, const Vector3r& max_corner, TFunc func) const
+    {
+        int x0 = toCell(min_corner.x()), y0 = toCell(min_corner.y()), z0 = toCell(min_corner.z());
+        int x1 = toCell(max_corner.x()), y1 = toCell(max_corner.y()), z1 = toCell(max_corner.z());
+        for (int z = z0; z <= z1; ++z)
+            for (int y = y0; y <= y1; ++y)
+                for (int x = x0; x <= x1; ++x)
+                    func(toKey(x, y, z));
+    }
+
+    int toCell(real_T value) const
+    {
+        return static_cast<int>(std::floor(value / cell_size_));
+    }
+
+    //21 bits per axis is +-1M cells, far more than any level
+    static uint64_t toKey(int x, int y, int z)
+    {
+        const uint64_t mask = (1ULL << 21) - 1;
+        return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) | (static_cast<uint64_t>(z) & mask);
+    }
+
+private:
+    real_T cell_size_;
+    vector<Box> boxes_;
+    std::unordered_map<uint64_t, vector<uint>> cells_;
+    mutable vector<uint> candidates_buffer_;
+};
+
+}} //namespace
+#endif
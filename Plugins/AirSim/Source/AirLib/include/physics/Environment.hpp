@@ -18,6 +18,8 @@ public:
         GeoPoint geo_point;
         real_T min_z_over_ground;
         Vector3r position;
+        //NED z of ground right below vehicle, NaN if not known
+        real_T ground_z = Utils::nan<real_T>();
 
         //these fields are computed
         Vector3r gravity;
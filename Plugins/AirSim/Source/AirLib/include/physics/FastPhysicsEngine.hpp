@@ -7,9 +7,9 @@
 #include "common/Common.hpp"
 #include "physics/PhysicsEngineBase.hpp"
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include "common/CommonStructs.hpp"
+#include "physics/CollisionWorld.hpp"
 
 namespace msr { namespace airlib {
 
@@ -38,23 +38,91 @@ public:
 
     virtual void update() override
     {
-        for (PhysicsBody* body_ptr : *this) {
-            updatePhysics(*body_ptr);
+        if (!is_ccd_enabled_) {
+            for (PhysicsBody* body_ptr : *this) {
+                updatePhysics(*body_ptr);
+            }
+            return;
         }
+
+        //with continuous collision all bodies are integrated first so they can be swept against each other's paths
+        steps_.resize(size());
+        for (uint i = 0; i < size(); ++i)
+            integrate(*at(i), steps_[i]);
+        sweepBodies();
+        sweepStatic();
+        for (uint i = 0; i < size(); ++i)
+            applyStep(*at(i), steps_[i]);
     }
     virtual void reportState(StateReporter& reporter) override
     {
-        for (PhysicsBody* body_ptr : *this) {
-            reporter.writeValue("Phys", debug_string_.str());
-            reporter.writeValue("Is Gounded", grounded_);
-            reporter.writeValue("Force (world)", body_ptr->getWrench().force);
-            reporter.writeValue("Torque (body)", body_ptr->getWrench().torque);
-        }
+        for (PhysicsBody* body_ptr : *this)
+            reportBody(*body_ptr, reporter);
+        reportSummary(reporter);
         //call base
         UpdatableObject::reportState(reporter);
     }
+
+    //values of one body, for reports that page through vehicles
+    void reportBody(const PhysicsBody& body, StateReporter& reporter) const
+    {
+        reporter.writeValue("Is Gounded", grounded_);
+        reporter.writeValue("Force (world)", body.getWrench().force);
+        reporter.writeValue("Torque (body)", body.getWrench().torque);
+    }
+
+    //engine wide values only
+    void reportSummary(StateReporter& reporter) const
+    {
+        if (is_ccd_enabled_) {
+            reporter.writeValue("Swept hits (static)", static_hit_count_);
+            reporter.writeValue("Swept hits (bodies)", body_hit_count_);
+        }
+    }
     //*** End: UpdatableState implementation ***//
 
+    /*
+        Continuous collision detection: each step every body with a collision
+        radius is swept as a sphere from its current to its next position,
+        against the other bodies' sweeps and against static_world (may be null
+        to only sweep bodies against each other). At the time of impact the
+        body is put at the contact, gets the usual impulse response and moves
+        for the rest of the step with the new velocity, re-sweeping that rest
+        a few times. This keeps thin geometry and other vehicles from being
+        tunneled through at any physics period. Must be set before updates start.
+    */
+    void setContinuousCollision(bool enabled, std::shared_ptr<const CollisionWorld> static_world)
+    {
+        is_ccd_enabled_ = enabled;
+        static_world_ = static_world;
+    }
+
+    //position of body's NED origin in frame of static world, bodies not set are at its origin
+    void setCollisionOrigin(const PhysicsBody* body, const Vector3r& origin)
+    {
+        collision_origins_[body] = origin;
+    }
+
+private: //types
+    static constexpr uint MaxSweepIterations = 3;
+
+    struct Step {
+        TTimeDelta dt;
+        Kinematics::State next;
+        Wrench next_wrench;
+        //rest of the step still to be swept, from start at start_time fraction of dt to next position
+        Vector3r start;
+        real_T start_time;
+        Vector3r origin;
+        bool is_contact;    //reported collision was responded to, no sweeping
+        bool is_swept_hit;
+    };
+
+    struct PairHit {
+        real_T time;
+        uint first, second;
+    };
+
 private:
     void initPhysicsBody(PhysicsBody* body_ptr)
     {
@@ -80,6 +148,200 @@ private:
         body.kinematicsUpdated();
     }
 
+    void integrate(PhysicsBody& body, Step& step)
+    {
+        step.dt = clock()->updateSince(body.last_kinematics_time);
+        const Kinematics::State& current = body.getKinematics();
+        getNextKinematicsNoCollison(step.dt, body, current, step.next, step.next_wrench);
+        step.is_contact = getNextKinematicsOnCollison(step.dt, body, current, step.next, step.next_wrench);
+        step.start = current.pose.position;
+        step.start_time = 0;
+        auto origin = collision_origins_.find(&body);
+        step.origin = origin == collision_origins_.end() ? Vector3r::Zero() : origin->second;
+        step.is_swept_hit = false;
+    }
+
+    void applyStep(PhysicsBody& body, Step& step)
+    {
+        if (!step.is_contact)
+            getNextKinematicsOnGround(step.dt, body, body.getKinematics(), step.next, step.next_wrench);
+
+        body.setKinematics(step.next);
+        body.setWrench(step.next_wrench);
+        body.kinematicsUpdated();
+    }
+
+    //velocities at fraction t of the step, once a body has been hit they are constant for rest of the step
+    static void getVelocityAt(const PhysicsBody& body, const Step& step, real_T t, Vector3r& linear, Vector3r& angular)
+    {
+        if (step.is_swept_hit) {
+            linear = step.next.twist.linear;
+            angular = step.next.twist.angular;
+        }
+        else {
+            const Twist& current = body.getKinematics().twist;
+            linear = current.linear + (step.next.twist.linear - current.linear) * t;
+            angular = current.angular + (step.next.twist.angular - current.angular) * t;
+        }
+    }
+
+    //body is at contact at fraction t of the step with velocities after response, it moves freely for the rest
+    static void continueFromContact(Step& step, const Vector3r& contact, real_T t, const Vector3r& linear, const Vector3r& angular)
+    {
+        step.start = contact;
+        step.start_time = t;
+        step.next.pose.position = contact + linear * static_cast<real_T>((1 - t) * step.dt);
+        step.next.twist.linear = linear;
+        step.next.twist.angular = angular;
+        //there is no acceleration during collison response
+        step.next.accelerations.linear = Vector3r::Zero();
+        step.next.accelerations.angular = Vector3r::Zero();
+        step.next_wrench = Wrench::zero();
+        step.is_swept_hit = true;
+    }
+
+    //earliest impact per pair is resolved first, a body takes part in at most one pair impact per step
+    void sweepBodies()
+    {
+        pair_hits_.clear();
+        for (uint i = 0; i < size(); ++i) {
+            real_T radius_i = at(i)->getCollisionRadius();
+            if (radius_i <= 0 || steps_[i].is_contact)
+                continue;
+            for (uint j = i + 1; j < size(); ++j) {
+                real_T radius_j = at(j)->getCollisionRadius();
+                if (radius_j <= 0 || steps_[j].is_contact)
+                    continue;
+                real_T time;
+                const Step& first = steps_[i];
+                const Step& second = steps_[j];
+                if (CollisionWorld::sweepSpheres(first.start + first.origin, first.next.pose.position + first.origin, radius_i,
+                    second.start + second.origin, second.next.pose.position + second.origin, radius_j, time))
+                    pair_hits_.push_back(PairHit{ time, i, j });
+            }
+        }
+        std::sort(pair_hits_.begin(), pair_hits_.end(), [](const PairHit& a, const PairHit& b) { return a.time < b.time; });
+
+        for (const PairHit& pair_hit : pair_hits_) {
+            Step& first = steps_[pair_hit.first];
+            Step& second = steps_[pair_hit.second];
+            if (first.is_swept_hit || second.is_swept_hit)
+                continue;
+            const PhysicsBody& first_body = *at(pair_hit.first);
+            const PhysicsBody& second_body = *at(pair_hit.second);
+
+            real_T t = pair_hit.time;
+            Vector3r first_position = first.start + (first.next.pose.position - first.start) * t;
+            Vector3r second_position = second.start + (second.next.pose.position - second.start) * t;
+            Vector3r first_linear, first_angular, second_linear, second_angular;
+            getVelocityAt(first_body, first, t, first_linear, first_angular);
+            getVelocityAt(second_body, second, t, second_linear, second_angular);
+
+            //impulse along line of centers between two free bodies, no spin as spheres touch on that line
+            Vector3r normal = (first_position + first.origin) - (second_position + second.origin);
+            if (normal.norm() < 1E-6f)
+                normal = second_linear - first_linear;
+            normal.normalize();
+            real_T closing = (first_linear - second_linear).dot(normal);
+            if (closing < 0) {
+                real_T restitution = (first_body.getRestitution() + second_body.getRestitution()) / 2;
+                real_T impulse_mag = -(1 + restitution) * closing / (1 / first_body.getMass() + 1 / second_body.getMass());
+                first_linear += normal * (impulse_mag / first_body.getMass());
+                second_linear -= normal * (impulse_mag / second_body.getMass());
+            }
+
+            continueFromContact(first, first_position, t, first_linear, first_angular);
+            continueFromContact(second, second_position, t, second_linear, second_angular);
+            ++body_hit_count_;
+        }
+    }
+
+    void sweepStatic()
+    {
+        if (static_world_ == nullptr)
+            return;
+
+        for (uint i = 0; i < size(); ++i) {
+            Step& step = steps_[i];
+            const PhysicsBody& body = *at(i);
+            //smaller than radius against other bodies, so landed bodies don't overlap the floor and bounce off it every step
+            real_T radius = body.getStaticCollisionRadius();
+            if (radius <= 0 || step.is_contact)
+                continue;
+            //swept sphere includes the skin, so a body resting at contact is still touching on the next step
+            //instead of free falling through the skin gap and hitting the surface with speed
+            real_T sweep_radius = radius + contact_skin_;
+
+            CollisionWorld::Hit hit;
+            uint iteration = 0;
+            for (; iteration < MaxSweepIterations; ++iteration) {
+                if (!static_world_->sweepSphere(step.start + step.origin, step.next.pose.position + step.origin, sweep_radius, hit))
+                    break;
+
+                real_T t = step.start_time + (1 - step.start_time) * hit.time;
+                Vector3r contact = step.start + (step.next.pose.position - step.start) * hit.time;
+                Vector3r linear, angular;
+                getVelocityAt(body, step, t, linear, angular);
+                real_T closing = -linear.dot(hit.normal);
+                if (closing > 0) {
+                    //resting contact, e.g. landed on a floor: the bounce wouldn't lift the body out of the skin or
+                    //gravity alone gives this speed in a couple of steps, so stop it along the normal instead of
+                    //bouncing it every step
+                    real_T gravity = body.getEnvironment().getState().gravity.norm();
+                    bool is_resting = closing * body.getRestitution() < std::sqrt(2 * gravity * contact_skin_)
+                        || closing < 2 * gravity * static_cast<real_T>(step.dt);
+                    if (is_resting)
+                        linear += hit.normal * closing;
+                    else
+                        getCollisionResponse(body, hit.normal, -hit.normal * radius, linear, angular);
+                }
+                continueFromContact(step, contact, t, linear, angular);
+                ++static_hit_count_;
+            }
+            //still blocked after all iterations, e.g. wedged in a corner: stay at contact
+            if (iteration == MaxSweepIterations && static_world_->sweepSphere(step.start + step.origin, step.next.pose.position + step.origin, sweep_radius, hit))
+                step.next.pose.position = step.start;
+        }
+    }
+
+    /*
+        GafferOnGames - Collison response with columb friction
+        http://gafferongames.com/virtual-go/collision-response-and-coulomb-friction/
+        Assuming collison is with static fixed body,
+        impulse magnitude = j = -(1 + R)V.N / (1/m + (I'(r X N) X r).N)
+        Physics Part 3, Collison Response, Chris Hecker, eq 4(a)
+        http://chrishecker.com/images/e/e7/Gdmphys3.pdf
+        V(t+1) = V(t) + j*N / m
+        r is contact point relative to center of gravity, velocities are updated in place.
+    */
+    static void getCollisionResponse(const PhysicsBody& body, const Vector3r& normal, const Vector3r& r, Vector3r& linear, Vector3r& angular)
+    {
+        //velocity at contact point
+        Vector3r contact_vel = linear + angular.cross(r);
+
+        real_T impulse_mag_denom = 1.0f / body.getMass() + 
+            (body.getInertiaInv() * r.cross(normal))
+            .cross(r)
+            .dot(normal);
+        real_T impulse_mag = -contact_vel.dot(normal) * (1 + body.getRestitution()) / impulse_mag_denom;
+
+        linear = linear + normal * (impulse_mag / body.getMass());
+        angular = angular + r.cross(normal) * impulse_mag;
+
+        //above would modify component in direction of normal
+        //we will use friction to modify component in direction of tangent
+        Vector3r contact_tang = contact_vel - normal * normal.dot(contact_vel);
+        Vector3r contact_tang_unit = contact_tang.normalized();
+        real_T friction_mag_denom =  1.0f / body.getMass() + 
+            (body.getInertiaInv() * r.cross(contact_tang_unit))
+            .cross(r)
+            .dot(contact_tang_unit);
+        real_T friction_mag = -contact_tang.norm() * body.getFriction() / friction_mag_denom;
+
+        linear += contact_tang_unit * friction_mag;
+        angular += r.cross(contact_tang_unit) * (friction_mag / body.getMass());
+    }
+
     bool getNextKinematicsOnCollison(TTimeDelta dt, const PhysicsBody& body, const Kinematics::State& current, Kinematics::State& next, Wrench& next_wrench)
     {
         static constexpr uint kCollisionResponseCycles = 1;
@@ -106,39 +368,10 @@ private:
 
                     //contact point vector
                     Vector3r r = collison_info.impact_point - collison_info.position;
-                    //velocity at contact point
-                    Vector3r contact_vel = vcur_avg + angular_avg.cross(r);
-
-                    /*
-                        GafferOnGames - Collison response with columb friction
-                        http://gafferongames.com/virtual-go/collision-response-and-coulomb-friction/
-                        Assuming collison is with static fixed body,
-                        impulse magnitude = j = -(1 + R)V.N / (1/m + (I'(r X N) X r).N)
-                        Physics Part 3, Collison Response, Chris Hecker, eq 4(a)
-                        http://chrishecker.com/images/e/e7/Gdmphys3.pdf
-                        V(t+1) = V(t) + j*N / m
-                    */
-                    real_T impulse_mag_denom = 1.0f / body.getMass() + 
-                        (body.getInertiaInv() * r.cross(collison_info.normal))
-                        .cross(r)
-                        .dot(collison_info.normal);
-                    real_T impulse_mag = -contact_vel.dot(collison_info.normal) * (1 + body.getRestitution()) / impulse_mag_denom;
-
-                    next.twist.linear = vcur_avg + collison_info.normal * (impulse_mag / body.getMass());
-                    next.twist.angular = angular_avg + r.cross(collison_info.normal) * impulse_mag;
-
-                    //above would modify component in direction of normal
-                    //we will use friction to modify component in direction of tangent
-                    Vector3r contact_tang = contact_vel - collison_info.normal * collison_info.normal.dot(contact_vel);
-                    Vector3r contact_tang_unit = contact_tang.normalized();
-                    real_T friction_mag_denom =  1.0f / body.getMass() + 
-                        (body.getInertiaInv() * r.cross(contact_tang_unit))
-                        .cross(r)
-                        .dot(contact_tang_unit);
-                    real_T friction_mag = -contact_tang.norm() * body.getFriction() / friction_mag_denom;
-
-                    next.twist.linear += contact_tang_unit * friction_mag;
-                    next.twist.angular += r.cross(contact_tang_unit) * (friction_mag / body.getMass());
+
+                    next.twist.linear = vcur_avg;
+                    next.twist.angular = angular_avg;
+                    getCollisionResponse(body, collison_info.normal, r, next.twist.linear, next.twist.angular);
                 }
                 else
                     next.twist.linear = vcur_avg;
@@ -303,8 +536,16 @@ private:
     }
 
 private:
-    std::stringstream debug_string_;
     int grounded_;
+
+    bool is_ccd_enabled_ = false;
+    std::shared_ptr<const CollisionWorld> static_world_;
+    vector<Step> steps_;
+    vector<PairHit> pair_hits_;
+    unordered_map<const PhysicsBody*, Vector3r> collision_origins_;
+    uint64_t static_hit_count_ = 0, body_hit_count_ = 0;
+    //kept between body and obstacle after a swept hit so next sweep doesn't start in contact
+    const real_T contact_skin_ = 1E-3f; // 'static constexpr' here would need out of class definition
 };
 
 }} //namespace
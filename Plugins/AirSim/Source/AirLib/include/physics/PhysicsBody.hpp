@@ -56,6 +56,19 @@ public: //methods
     }
 
 
+    //radius of sphere around center of gravity used by continuous collision detection, 0 opts out
+    virtual real_T getCollisionRadius() const
+    {
+        return 0;
+    }
+
+    //radius of sphere swept against static geometry; a sphere enclosing propellers would keep a landed body
+    //overlapping the floor, so bodies resting on something should return a radius within their lowest point
+    virtual real_T getStaticCollisionRadius() const
+    {
+        return getCollisionRadius();
+    }
+
     //*** Start: UpdatableState implementation ***//
     virtual void reset() override
     {
@@ -5,11 +5,13 @@
 #define airsim_core_World_hpp
 
 #include <functional>
+#include <atomic>
 #include "common/Common.hpp"
 #include "common/UpdatableContainer.hpp"
 #include "PhysicsEngineBase.hpp"
 #include "PhysicsBody.hpp"
 #include "common/common_utils/ScheduledExecutor.hpp"
+#include "common/AllocationAudit.hpp"
 
 namespace msr { namespace airlib {
 
@@ -56,7 +58,7 @@ public:
 
     virtual void reportState(StateReporter& reporter) override
     {
-        reporter.writeValue("Sleep", 1.0f / executor_.getSleepTimeAvg());
+        reportSummary(reporter);
         if (physics_engine_)
             physics_engine_->reportState(reporter);
 
@@ -65,6 +67,16 @@ public:
     }
     //*** End: UpdatableState implementation ***//
 
+    //world level values only, without members and per body physics, so cost doesn't grow with vehicle count
+    void reportSummary(StateReporter& reporter)
+    {
+        reporter.writeValue("Sleep", 1.0f / executor_.getSleepTimeAvg());
+        if (AllocationAudit::isEnabled()) {
+            reporter.writeValue("Allocs/tick", static_cast<int>(last_tick_allocations_));
+            reporter.writeValue("Alloc failures", static_cast<int>(allocation_audit_failures_));
+        }
+    }
+
     //override membership modification methods so we can synchronize physics engine
     virtual void clear() override
     { 
@@ -108,11 +120,19 @@ public:
         executor_.unlock();
     }
 
+    //number of ticks after warmup that allocated, always 0 unless built with AIRLIB_ALLOCATION_AUDIT
+    uint64_t getAllocationAuditFailures() const
+    {
+        return allocation_audit_failures_;
+    }
+
 private:
     bool worldUpdatorAsync(long long dt_nanos)
     {
         try {
+            AllocationAudit::Scope audit;
             update();
+            auditTick(audit.getAllocations());
         }
         catch(const std::exception& ex) {
             Utils::logError("Exception occurred while updating world: %s", ex.what());
@@ -123,8 +143,29 @@ private:
         return true;
     }
 
+    //first ticks may grow containers to their working size, after that ticks must not allocate
+    void auditTick(uint64_t allocations)
+    {
+        last_tick_allocations_ = allocations;
+        if (audit_ticks_ < AllocationAuditWarmupTicks) {
+            ++audit_ticks_;
+            return;
+        }
+
+        if (allocations > 0) {
+            ++allocation_audit_failures_;
+            Utils::logError("Allocation audit: world tick made %llu heap allocations",
+                static_cast<unsigned long long>(allocations));
+        }
+    }
+
 private:
+    static constexpr uint AllocationAuditWarmupTicks = 100;
+
     PhysicsEngineBase* physics_engine_ = nullptr;
+    uint audit_ticks_ = 0;
+    std::atomic<uint64_t> last_tick_allocations_{ 0 };
+    std::atomic<uint64_t> allocation_audit_failures_{ 0 };
 
     common_utils::ScheduledExecutor executor_;
 };
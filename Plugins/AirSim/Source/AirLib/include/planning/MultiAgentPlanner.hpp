@@ -0,0 +1,428 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_MultiAgentPlanner_hpp
+#define msr_airlib_MultiAgentPlanner_hpp
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "PathPlanner.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Plans time parameterized, mutually collision free trajectories for many
+    vehicles over the map of a PathPlanner.
+
+    Approach is prioritized planning with a space-time reservation table.
+    Low level search is A* over (voxel, time step) where each step is a move
+    to one of 26 neighbour voxels or waiting in place. Accepted trajectories
+    are written in to the reservation table, inflated by separation, and
+    later agents plan around them. Agent that reached its goal parks there,
+    so its goal stays reserved for the rest of time.
+
+    To use all cores, agents are planned in rounds of one agent per thread:
+    agents of a round are searched in parallel against the table as it was
+    at start of the round, then accepted in priority order. Those that
+    conflict with trajectories accepted earlier in the same round are
+    searched again in the next one. First agent of a round always gets
+    accepted so the number of rounds is bounded, and with one thread this
+    is plain sequential prioritized planning.
+
+    Prioritized planning is not complete, with dense goals or narrow passages
+    some agents can fail even though a solution exists; those are reported
+    in stats. Map is read locked for the duration of plan().
+*/
+class MultiAgentPlanner {
+public: //types
+    struct Params {
+        real_T velocity = 2;            //max speed along trajectory, sets the time step
+        real_T separation = 2;          //min distance kept between agents at any time
+        uint max_steps = 1000;          //trajectory horizon in time steps
+        uint max_expansions = 200000;   //per agent and round
+        uint threads = 0;               //0 means one per hardware thread
+        double max_planning_sec = 1;    //whole plan() call gives up after this
+    };
+
+    struct Agent {
+        Vector3r start, goal;
+    };
+
+    //position i is where agent should be at time i * step_sec after start
+    struct Trajectory {
+        vector<Vector3r> positions;
+        real_T step_sec = 0;
+    };
+
+    struct Stats {
+        bool success = false;
+        uint agents = 0;
+        uint failed_agents = 0;
+        uint rounds = 0;
+        uint64_t expansions = 0;
+        double planning_sec = 0;
+        string message;
+    };
+
+public:
+    MultiAgentPlanner(const shared_ptr<PathPlanner>& path_planner)
+        : path_planner_(path_planner)
+    {
+    }
+
+    /*
+        Plans trajectory for each agent, trajectories are in the same order
+        as agents. Priority doesn't follow list order, agents with longer
+        start to goal distance go first because they have least freedom.
+        Returns false if any agent failed, its trajectory is then empty while
+        trajectories of others are still valid.
+    */
+    bool plan(const vector<Agent>& agents, const Params& params, vector<Trajectory>& trajectories)
+    {
+        std::lock_guard<std::mutex> lock(plan_mutex_);
+        auto start_time = std::chrono::steady_clock::now();
+        Stats stats;
+        stats.agents = static_cast<uint>(agents.size());
+
+        trajectories.assign(agents.size(), Trajectory());
+        path_planner_->readGrid([&](const VoxelGrid& grid) {
+            planAll(grid, agents, params, start_time, trajectories, stats);
+        });
+
+        stats.planning_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        stats.success = stats.failed_agents == 0;
+
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        last_stats_ = stats;
+        return stats.success;
+    }
+
+    Stats getLastStats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return last_stats_;
+    }
+
+    string getReport() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Multi-agent planner: " << last_stats_.agents << " agents, " << last_stats_.failed_agents << " failed, "
+            << last_stats_.rounds << " rounds, " << last_stats_.expansions << " expansions, "
+            << last_stats_.planning_sec * 1E3 << " ms";
+        if (!last_stats_.message.empty())
+            ss << " (" << last_stats_.message << ")";
+        ss << std::endl;
+        return ss.str();
+    }
+
+private:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    /*
+        Space-time cells claimed by accepted trajectories. Each trajectory
+        voxel is inserted with all voxels within separation around it, so a
+        lookup is a single hash probe. Separation is at least one voxel which
+        also rules out agents swapping or crossing voxels between two steps.
+    */
+    class ReservationTable {
+    public:
+        void initialize(const VoxelGrid& grid, int radius)
+        {
+            voxel_count_ = grid.getVoxelCount();
+            radius_ = radius;
+            cells_.clear();
+            parked_.clear();
+            last_step_.clear();
+        }
+
+        bool isReserved(uint32_t linear, uint32_t step) const
+        {
+            if (cells_.count(step * voxel_count_ + linear) != 0)
+                return true;
+            auto parked = parked_.find(linear);
+            return parked != parked_.end() && parked->second <= step;
+        }
+
+        //agent may only park at voxel after every reservation of it has passed
+        bool canParkAt(uint32_t linear, uint32_t step) const
+        {
+            auto last = last_step_.find(linear);
+            return last == last_step_.end() || last->second < step;
+        }
+
+        bool isFree(const vector<uint32_t>& path) const
+        {
+            for (uint32_t step = 1; step < path.size(); ++step) {
+                if (isReserved(path[step], step))
+                    return false;
+            }
+            return canParkAt(path.back(), static_cast<uint32_t>(path.size() - 1));
+        }
+
+        void reserve(const VoxelGrid& grid, const vector<uint32_t>& path)
+        {
+            uint32_t last = static_cast<uint32_t>(path.size() - 1);
+            for (uint32_t step = 0; step <= last; ++step) {
+                forEachAround(grid, path[step], [&](uint32_t linear) {
+                    if (step < last) {
+                        cells_.insert(step * voxel_count_ + linear);
+                        uint32_t& last_step = last_step_[linear];
+                        last_step = std::max(last_step, step);
+                    }
+                    else {
+                        auto parked = parked_.find(linear);
+                        if (parked == parked_.end() || parked->second > step)
+                            parked_[linear] = step;
+                    }
+                });
+            }
+        }
+
+    private:
+        template<typename Func>
+        void forEachAround(const VoxelGrid& grid, uint32_t center, Func func) const
+        {
+            VoxelGrid::Index index = grid.fromLinear(center);
+            for (int dz = -radius_; dz <= radius_; ++dz)
+                for (int dy = -radius_; dy <= radius_; ++dy)
+                    for (int dx = -radius_; dx <= radius_; ++dx) {
+                        VoxelGrid::Index around(index.x + dx, index.y + dy, index.z + dz);
+                        if (grid.isInside(around))
+                            func(static_cast<uint32_t>(grid.toLinear(around)));
+                    }
+        }
+
+    private:
+        uint64_t voxel_count_ = 0;
+        int radius_ = 1;
+        std::unordered_set<uint64_t> cells_;
+        std::unordered_map<uint32_t, uint32_t> parked_;     //voxel -> step from which it is taken forever
+        std::unordered_map<uint32_t, uint32_t> last_step_;  //voxel -> last step it is reserved at
+    };
+
+    //A* over (voxel, step), one instance per worker thread so buffers are reused across agents and rounds
+    class SpaceTimeSearch {
+    public:
+        //on success path has linear voxel index for each step starting with start voxel
+        bool search(const VoxelGrid& grid, const ReservationTable& table, const Agent& agent, const Params& params,
+            const TimePoint& deadline, vector<uint32_t>& path, string& message)
+        {
+            path.clear();
+            expansions_ = 0;
+            VoxelGrid::Index start = grid.toIndex(agent.start), goal = grid.toIndex(agent.goal);
+            if (!grid.isInside(start) || !grid.isInside(goal)) {
+                message = "start or goal is outside of planning volume";
+                return false;
+            }
+            if (grid.isBlocked(goal)) {
+                message = "goal is too close to an obstacle";
+                return false;
+            }
+
+            const uint64_t voxel_count = grid.getVoxelCount();
+            const uint32_t start_linear = static_cast<uint32_t>(grid.toLinear(start));
+            const uint32_t goal_linear = static_cast<uint32_t>(grid.toLinear(goal));
+            parent_.clear();
+            open_.clear();
+            parent_[start_linear] = start_linear;
+            pushOpen(OpenEntry{ static_cast<float>(heuristic(start, goal)), 0, start_linear });
+
+            while (!open_.empty()) {
+                std::pop_heap(open_.begin(), open_.end());
+                OpenEntry current = open_.back();
+                open_.pop_back();
+
+                if (current.linear == goal_linear && table.canParkAt(goal_linear, current.step)) {
+                    //walk parents back in time
+                    path.resize(current.step + 1);
+                    uint64_t key = current.step * voxel_count + current.linear;
+                    for (uint32_t step = current.step; ; --step) {
+                        uint32_t linear = static_cast<uint32_t>(key % voxel_count);
+                        path[step] = linear;
+                        if (step == 0)
+                            break;
+                        key = (step - 1) * voxel_count + parent_[key];
+                    }
+                    return true;
+                }
+
+                //deadline is checked now and then, clock reads are not free
+                if (++expansions_ > params.max_expansions || ((expansions_ & 1023) == 0 && std::chrono::steady_clock::now() > deadline)) {
+                    message = expansions_ > params.max_expansions ? "search exceeded max expansions" : "planning time limit exceeded";
+                    return false;
+                }
+                uint32_t next_step = current.step + 1;
+                if (next_step > params.max_steps)
+                    continue;
+
+                VoxelGrid::Index index = grid.fromLinear(current.linear);
+                for (int dz = -1; dz <= 1; ++dz)
+                    for (int dy = -1; dy <= 1; ++dy)
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            VoxelGrid::Index offset(dx, dy, dz);
+                            VoxelGrid::Index next(index.x + dx, index.y + dy, index.z + dz);
+                            uint32_t next_linear = grid.isInside(next) ? static_cast<uint32_t>(grid.toLinear(next)) : 0;
+                            //start voxel may be blocked if vehicle is near obstacle, it can still wait there or leave it
+                            if (!grid.isInside(next) || (next_linear != start_linear && grid.isBlocked(next))
+                                || grid.isCuttingCorner(index, offset) || table.isReserved(next_linear, next_step))
+                                continue;
+
+                            uint64_t key = next_step * voxel_count + next_linear;
+                            if (parent_.find(key) != parent_.end())
+                                continue;   //every move takes one step so first visit of state is the cheapest
+                            parent_[key] = current.linear;
+                            pushOpen(OpenEntry{ static_cast<float>(next_step + heuristic(next, goal)), next_step, next_linear });
+                        }
+            }
+
+            message = "no conflict free trajectory within horizon";
+            return false;
+        }
+
+        uint getExpansions() const
+        {
+            return expansions_;
+        }
+
+    private:
+        struct OpenEntry {
+            float f;
+            uint32_t step;
+            uint32_t linear;
+
+            //max heap on priority: lower f first, ties go to later step which is closer to goal
+            bool operator<(const OpenEntry& other) const
+            {
+                return f > other.f || (f == other.f && step < other.step);
+            }
+        };
+
+        void pushOpen(const OpenEntry& entry)
+        {
+            open_.push_back(entry);
+            std::push_heap(open_.begin(), open_.end());
+        }
+
+        //steps needed on empty grid, each step can change every axis by one voxel
+        static int heuristic(const VoxelGrid::Index& a, const VoxelGrid::Index& b)
+        {
+            return std::max(std::abs(a.x - b.x), std::max(std::abs(a.y - b.y), std::abs(a.z - b.z)));
+        }
+
+    private:
+        //state key (step * voxel_count + linear) -> voxel at previous step
+        std::unordered_map<uint64_t, uint32_t> parent_;
+        vector<OpenEntry> open_;
+        uint expansions_ = 0;
+    };
+
+    struct AgentResult {
+        bool found;
+        vector<uint32_t> path;
+        string message;
+    };
+
+    void planAll(const VoxelGrid& grid, const vector<Agent>& agents, const Params& params, const TimePoint& start_time,
+        vector<Trajectory>& trajectories, Stats& stats)
+    {
+        const TimePoint deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(params.max_planning_sec));
+        //diagonal steps are the longest so they set step time for speed limit
+        const real_T step_sec = grid.getResolution() * std::sqrt(3.0f) / params.velocity;
+        //voxels closer than separation conflict
+        int radius = std::max(1, static_cast<int>(std::ceil(params.separation / grid.getResolution())) - 1);
+        table_.initialize(grid, radius);
+
+        vector<size_t> pending(agents.size());
+        for (size_t i = 0; i < pending.size(); ++i)
+            pending[i] = i;
+        std::stable_sort(pending.begin(), pending.end(), [&agents](size_t a, size_t b) {
+            return (agents[a].goal - agents[a].start).squaredNorm() > (agents[b].goal - agents[b].start).squaredNorm();
+        });
+
+        results_.resize(agents.size());
+        uint thread_count = params.threads > 0 ? params.threads : std::max(1u, std::thread::hardware_concurrency());
+        while (workers_.size() < thread_count)
+            workers_.push_back(std::unique_ptr<SpaceTimeSearch>(new SpaceTimeSearch()));
+
+        //agents are searched in batches of thread count, those that conflict with a
+        //trajectory accepted earlier in the same batch lead the next batch
+        size_t next = 0;
+        vector<size_t> batch, retry;
+        while (!retry.empty() || next < pending.size()) {
+            batch.swap(retry);
+            retry.clear();
+            while (batch.size() < thread_count && next < pending.size())
+                batch.push_back(pending[next++]);
+
+            ++stats.rounds;
+            searchParallel(grid, agents, params, deadline, batch, stats);
+
+            //accept in priority order, table only grows so failed search can't succeed later
+            for (size_t agent : batch) {
+                AgentResult& result = results_[agent];
+                if (!result.found) {
+                    if (stats.failed_agents++ == 0)
+                        stats.message = Utils::stringf("agent %u: %s", static_cast<uint>(agent), result.message.c_str());
+                }
+                else if (!table_.isFree(result.path))
+                    retry.push_back(agent);
+                else {
+                    table_.reserve(grid, result.path);
+                    Trajectory& trajectory = trajectories[agent];
+                    trajectory.step_sec = step_sec;
+                    for (uint32_t linear : result.path)
+                        trajectory.positions.push_back(grid.toPosition(grid.fromLinear(linear)));
+                    trajectory.positions.front() = agents[agent].start;
+                    if (trajectory.positions.size() > 1)
+                        trajectory.positions.back() = agents[agent].goal;
+                }
+            }
+        }
+    }
+
+    void searchParallel(const VoxelGrid& grid, const vector<Agent>& agents, const Params& params, const TimePoint& deadline,
+        const vector<size_t>& batch, Stats& stats)
+    {
+        std::atomic<size_t> next_index(0);
+        std::atomic<uint64_t> expansions(0);
+        auto work = [&](SpaceTimeSearch* worker) {
+            for (size_t i = next_index++; i < batch.size(); i = next_index++) {
+                AgentResult& result = results_[batch[i]];
+                result.found = worker->search(grid, table_, agents[batch[i]], params, deadline, result.path, result.message);
+                expansions += worker->getExpansions();
+            }
+        };
+
+        vector<std::thread> threads;
+        for (size_t t = 1; t < batch.size(); ++t)
+            threads.push_back(std::thread(work, workers_[t].get()));
+        work(workers_[0].get());
+        for (auto& thread : threads)
+            thread.join();
+
+        stats.expansions += expansions;
+    }
+
+private:
+    shared_ptr<PathPlanner> path_planner_;
+    std::mutex plan_mutex_;
+    mutable std::mutex stats_mutex_;
+
+    ReservationTable table_;
+    vector<std::unique_ptr<SpaceTimeSearch>> workers_;
+    vector<AgentResult> results_;
+    Stats last_stats_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,349 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_PathPlanner_hpp
+#define msr_airlib_PathPlanner_hpp
+
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "VoxelGrid.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Plans collision free paths over a VoxelGrid that is shared by all
+    vehicles. Search is A* over 26 connected voxels with octile distance
+    heuristic, blocked voxels (see VoxelGrid inflation) are never entered.
+    Resulting voxel path is shortened by line of sight checks so followers
+    get few, long straight segments instead of a voxel staircase.
+
+    Search buffers are allocated once for the grid size and reused with a
+    generation stamp, so planning doesn't allocate per call except for the
+    result. One mutex serializes planning and map updates; grid updates come
+    from game thread and planning from API threads.
+
+    Replanning: followers call isPathFree() while flying, which is cheap
+    when map version hasn't changed, and plan again from where they are
+    if the remaining path got blocked.
+*/
+class PathPlanner {
+public: //types
+    struct Params {
+        real_T resolution = 1;          //voxel size in meters
+        real_T inflation_radius = 1;    //clearance kept from occupied voxels
+        uint max_expansions = 500000;   //search gives up after this many voxels
+        bool shortcut = true;           //remove waypoints that have line of sight to later ones
+    };
+
+    struct Stats {
+        bool success = false;
+        uint expansions = 0;
+        double planning_sec = 0;
+        uint waypoints = 0;
+        string message;
+    };
+
+public:
+    PathPlanner(const Vector3r& min_corner, const Vector3r& max_corner, const Params& params)
+        : params_(params), grid_(min_corner, max_corner, params.resolution, params.inflation_radius)
+    {
+        size_t count = grid_.getVoxelCount();
+        cost_.resize(count);
+        parent_.resize(count);
+        stamp_.assign(count, 0);
+        closed_stamp_.assign(count, 0);
+
+        //26 neighbours, cost is distance in voxels
+        for (int dx = -1; dx <= 1; ++dx)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dz = -1; dz <= 1; ++dz) {
+                    if (dx == 0 && dy == 0 && dz == 0)
+                        continue;
+                    neighbours_.push_back(Neighbour{ VoxelGrid::Index(dx, dy, dz),
+                        std::sqrt(static_cast<float>(dx * dx + dy * dy + dz * dz)) });
+                }
+    }
+
+    //map updates take the same lock as planning
+    bool setOccupied(const Vector3r& position, bool occupied)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return grid_.setOccupied(position, occupied);
+    }
+
+    //for bulk updates, func is called as void(VoxelGrid&) under the lock
+    template<typename UpdateFunc>
+    void updateGrid(UpdateFunc func)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        func(grid_);
+    }
+
+    //for read only access to the map, func is called as void(const VoxelGrid&) under the lock
+    template<typename ReadFunc>
+    void readGrid(ReadFunc func) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        func(grid_);
+    }
+
+    uint64_t getVersion() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return grid_.getVersion();
+    }
+
+    bool isBlocked(const Vector3r& position) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return grid_.isBlocked(position);
+    }
+
+    /*
+        Plans from start to goal. On success path has waypoints after start
+        with goal as the last one. On failure path is empty and reason is in
+        getLastStats().message.
+    */
+    bool planPath(const Vector3r& start, const Vector3r& goal, vector<Vector3r>& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto start_time = std::chrono::steady_clock::now();
+
+        path.clear();
+        last_stats_ = Stats();
+        last_stats_.success = search(start, goal, path);
+        last_stats_.waypoints = static_cast<uint>(path.size());
+        last_stats_.planning_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        ++plan_count_;
+        total_planning_sec_ += last_stats_.planning_sec;
+        return last_stats_.success;
+    }
+
+    //true if segments from position through path[next_index..] are still free
+    bool isPathFree(const Vector3r& position, const vector<Vector3r>& path, size_t next_index) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Vector3r from = position;
+        for (size_t i = next_index; i < path.size(); ++i) {
+            //segment start may be inside inflation when vehicle flies close to an obstacle
+            if (!isSegmentFreeFrom(from, path[i]))
+                return false;
+            from = path[i];
+        }
+        return true;
+    }
+
+    Stats getLastStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_stats_;
+    }
+
+    const Params& getParams() const
+    {
+        return params_;
+    }
+
+    string getReport() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Planner: " << grid_.getSizeX() << "x" << grid_.getSizeY() << "x" << grid_.getSizeZ() << " voxels of "
+            << grid_.getResolution() << " m, " << plan_count_ << " plans, "
+            << (plan_count_ > 0 ? total_planning_sec_ * 1E3 / plan_count_ : 0) << " ms avg";
+        if (plan_count_ > 0) {
+            ss << ", last " << (last_stats_.success ? "ok " : "failed ") << last_stats_.planning_sec * 1E3 << " ms, "
+                << last_stats_.expansions << " expansions";
+            if (!last_stats_.success)
+                ss << " (" << last_stats_.message << ")";
+        }
+        ss << std::endl;
+        return ss.str();
+    }
+
+private:
+    struct Neighbour {
+        VoxelGrid::Index offset;
+        float cost;
+    };
+
+    struct OpenEntry {
+        float f;
+        uint32_t linear;
+
+        bool operator>(const OpenEntry& other) const
+        {
+            return f > other.f;
+        }
+    };
+
+    bool search(const Vector3r& start, const Vector3r& goal, vector<Vector3r>& path)
+    {
+        VoxelGrid::Index start_index = grid_.toIndex(start);
+        VoxelGrid::Index goal_index = grid_.toIndex(goal);
+        if (!grid_.isInside(start_index) || !grid_.isInside(goal_index)) {
+            last_stats_.message = "start or goal is outside of planning volume";
+            return false;
+        }
+        if (grid_.isBlocked(goal_index)) {
+            last_stats_.message = "goal is too close to an obstacle";
+            return false;
+        }
+
+        //new generation invalidates costs of previous search without clearing
+        if (++generation_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            std::fill(closed_stamp_.begin(), closed_stamp_.end(), 0);
+            generation_ = 1;
+        }
+
+        uint32_t start_linear = static_cast<uint32_t>(grid_.toLinear(start_index));
+        uint32_t goal_linear = static_cast<uint32_t>(grid_.toLinear(goal_index));
+        open_.clear();
+        visit(start_linear, 0, start_linear);
+        pushOpen(start_linear, heuristic(start_index, goal_index));
+
+        bool found = false;
+        while (!open_.empty()) {
+            std::pop_heap(open_.begin(), open_.end(), std::greater<OpenEntry>());
+            uint32_t current = open_.back().linear;
+            open_.pop_back();
+
+            if (closed_stamp_[current] == generation_)
+                continue;   //stale entry, voxel was reached cheaper already
+            closed_stamp_[current] = generation_;
+
+            if (current == goal_linear) {
+                found = true;
+                break;
+            }
+            if (++last_stats_.expansions > params_.max_expansions) {
+                last_stats_.message = "search exceeded max expansions";
+                return false;
+            }
+
+            VoxelGrid::Index current_index = grid_.fromLinear(current);
+            float current_cost = cost_[current];
+            for (const Neighbour& neighbour : neighbours_) {
+                VoxelGrid::Index next(current_index.x + neighbour.offset.x, current_index.y + neighbour.offset.y,
+                    current_index.z + neighbour.offset.z);
+                //start voxel may be blocked if vehicle is near obstacle, it can still leave it
+                if (grid_.isBlocked(next) || grid_.isCuttingCorner(current_index, neighbour.offset))
+                    continue;
+
+                uint32_t next_linear = static_cast<uint32_t>(grid_.toLinear(next));
+                if (closed_stamp_[next_linear] == generation_)
+                    continue;
+
+                float next_cost = current_cost + neighbour.cost;
+                if (stamp_[next_linear] != generation_ || next_cost < cost_[next_linear]) {
+                    visit(next_linear, next_cost, current);
+                    pushOpen(next_linear, next_cost + heuristic(next, goal_index));
+                }
+            }
+        }
+
+        if (!found) {
+            last_stats_.message = "no collision free path exists";
+            return false;
+        }
+
+        //walk back from goal, voxel centers in start to goal order
+        voxel_path_.clear();
+        for (uint32_t linear = goal_linear; linear != start_linear; linear = parent_[linear])
+            voxel_path_.push_back(grid_.toPosition(grid_.fromLinear(linear)));
+        std::reverse(voxel_path_.begin(), voxel_path_.end());
+        if (voxel_path_.empty())
+            voxel_path_.push_back(goal);
+        else
+            voxel_path_.back() = goal;
+
+        if (params_.shortcut)
+            shortcutPath(start, voxel_path_, path);
+        else
+            path = voxel_path_;
+        return true;
+    }
+
+    //greedily keep only waypoints that the previous kept point can't see past
+    void shortcutPath(const Vector3r& start, const vector<Vector3r>& points, vector<Vector3r>& path) const
+    {
+        Vector3r from = start;
+        size_t i = 0;
+        while (i < points.size()) {
+            size_t farthest = i;
+            for (size_t j = points.size(); j-- > i + 1;) {
+                if (isSegmentFreeFrom(from, points[j])) {
+                    farthest = j;
+                    break;
+                }
+            }
+            path.push_back(points[farthest]);
+            from = points[farthest];
+            i = farthest + 1;
+        }
+    }
+
+    //like VoxelGrid::isSegmentFree but ignores the blocked voxel the segment starts in
+    bool isSegmentFreeFrom(const Vector3r& from, const Vector3r& to) const
+    {
+        VoxelGrid::Index from_index = grid_.toIndex(from);
+        Vector3r delta = to - from;
+        real_T step = grid_.getResolution() / 4;
+        int steps = std::max(1, static_cast<int>(std::ceil(delta.norm() / step)));
+        for (int i = 1; i <= steps; ++i) {
+            VoxelGrid::Index index = grid_.toIndex(Vector3r(from + delta * (static_cast<real_T>(i) / steps)));
+            if (!(index == from_index) && grid_.isBlocked(index))
+                return false;
+        }
+        return true;
+    }
+
+    void visit(uint32_t linear, float cost, uint32_t parent)
+    {
+        stamp_[linear] = generation_;
+        cost_[linear] = cost;
+        parent_[linear] = parent;
+    }
+
+    void pushOpen(uint32_t linear, float f)
+    {
+        open_.push_back(OpenEntry{ f, linear });
+        std::push_heap(open_.begin(), open_.end(), std::greater<OpenEntry>());
+    }
+
+    //exact cost on empty 26 connected grid: diagonal moves first, then straight
+    static float heuristic(const VoxelGrid::Index& a, const VoxelGrid::Index& b)
+    {
+        int d[3] = { std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z) };
+        std::sort(d, d + 3);
+        return 1.7320508f * d[0] + 1.4142136f * (d[1] - d[0]) + (d[2] - d[1]);
+    }
+
+private:
+    Params params_;
+    VoxelGrid grid_;
+    mutable std::mutex mutex_;
+
+    //search state, indexed by linear voxel index
+    vector<float> cost_;
+    vector<uint32_t> parent_;
+    vector<uint32_t> stamp_;
+    vector<uint32_t> closed_stamp_;
+    uint32_t generation_ = 0;
+    vector<OpenEntry> open_;
+    vector<Neighbour> neighbours_;
+    vector<Vector3r> voxel_path_;
+
+    Stats last_stats_;
+    uint64_t plan_count_ = 0;
+    double total_planning_sec_ = 0;
+};
+
+}} //namespace
+#endif
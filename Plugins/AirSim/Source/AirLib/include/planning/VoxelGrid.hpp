@@ -0,0 +1,283 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_VoxelGrid_hpp
+#define msr_airlib_VoxelGrid_hpp
+
+#include <cmath>
+#include <cstdlib>
+#include "common/Common.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Fixed size 3D occupancy grid in NED meters. Besides raw occupancy each
+    voxel keeps count of occupied voxels within the inflation radius, so
+    "blocked" (too close to an obstacle for the vehicle) is maintained
+    incrementally as voxels are set or cleared instead of re-inflating
+    whole grid. Positions outside the grid are treated as blocked.
+
+    Version is bumped on every change so users such as path followers can
+    cheaply detect that map changed since they last looked.
+
+    Not thread safe, owner is expected to serialize access (see PathPlanner).
+*/
+class VoxelGrid {
+public: //types
+    struct Index {
+        int x, y, z;
+
+        Index()
+            : x(0), y(0), z(0)
+        {
+        }
+        Index(int x_val, int y_val, int z_val)
+            : x(x_val), y(y_val), z(z_val)
+        {
+        }
+        bool operator==(const Index& other) const
+        {
+            return x == other.x && y == other.y && z == other.z;
+        }
+    };
+
+public:
+    VoxelGrid()
+    {
+        initialize(Vector3r::Zero(), Vector3r::Zero(), 1, 0);
+    }
+    VoxelGrid(const Vector3r& min_corner, const Vector3r& max_corner, real_T resolution, real_T inflation_radius)
+    {
+        initialize(min_corner, max_corner, resolution, inflation_radius);
+    }
+
+    void initialize(const Vector3r& min_corner, const Vector3r& max_corner, real_T resolution, real_T inflation_radius)
+    {
+        min_corner_ = min_corner;
+        resolution_ = resolution;
+        size_x_ = std::max(0, static_cast<int>(std::ceil((max_corner.x() - min_corner.x()) / resolution)));
+        size_y_ = std::max(0, static_cast<int>(std::ceil((max_corner.y() - min_corner.y()) / resolution)));
+        size_z_ = std::max(0, static_cast<int>(std::ceil((max_corner.z() - min_corner.z()) / resolution)));
+
+        occupied_.assign(getVoxelCount(), 0);
+        blocking_count_.assign(getVoxelCount(), 0);
+
+        //offsets of voxels within inflation radius, including the voxel itself
+        inflation_offsets_.clear();
+        int r = static_cast<int>(std::ceil(inflation_radius / resolution));
+        for (int dx = -r; dx <= r; ++dx)
+            for (int dy = -r; dy <= r; ++dy)
+                for (int dz = -r; dz <= r; ++dz) {
+                    if ((dx * dx + dy * dy + dz * dz) * resolution * resolution <= inflation_radius * inflation_radius + 1E-6f)
+                        inflation_offsets_.push_back(Index(dx, dy, dz));
+                }
+        inflation_radius_ = inflation_radius;
+
+        ++version_;
+    }
+
+    int getSizeX() const
+    {
+        return size_x_;
+    }
+    int getSizeY() const
+    {
+        return size_y_;
+    }
+    int getSizeZ() const
+    {
+        return size_z_;
+    }
+    size_t getVoxelCount() const
+    {
+        return static_cast<size_t>(size_x_) * size_y_ * size_z_;
+    }
+    real_T getResolution() const
+    {
+        return resolution_;
+    }
+    real_T getInflationRadius() const
+    {
+        return inflation_radius_;
+    }
+    const Vector3r& getMinCorner() const
+    {
+        return min_corner_;
+    }
+    uint64_t getVersion() const
+    {
+        return version_;
+    }
+
+    bool isInside(const Index& index) const
+    {
+        return index.x >= 0 && index.y >= 0 && index.z >= 0
+            && index.x < size_x_ && index.y < size_y_ && index.z < size_z_;
+    }
+    Index toIndex(const Vector3r& position) const
+    {
+        Vector3r offset = (position - min_corner_) / resolution_;
+        return Index(static_cast<int>(std::floor(offset.x())), static_cast<int>(std::floor(offset.y())),
+            static_cast<int>(std::floor(offset.z())));
+    }
+    //center of the voxel
+    Vector3r toPosition(const Index& index) const
+    {
+        return min_corner_ + Vector3r(index.x + 0.5f, index.y + 0.5f, index.z + 0.5f) * resolution_;
+    }
+    size_t toLinear(const Index& index) const
+    {
+        return (static_cast<size_t>(index.z) * size_y_ + index.y) * size_x_ + index.x;
+    }
+    Index fromLinear(size_t linear) const
+    {
+        int x = static_cast<int>(linear % size_x_);
+        linear /= size_x_;
+        return Index(x, static_cast<int>(linear % size_y_), static_cast<int>(linear / size_y_));
+    }
+
+    bool isOccupied(const Index& index) const
+    {
+        return isInside(index) && occupied_[toLinear(index)] != 0;
+    }
+
+    //true if voxel is within inflation radius of an occupied voxel or outside the grid
+    bool isBlocked(const Index& index) const
+    {
+        return !isInside(index) || blocking_count_[toLinear(index)] != 0;
+    }
+    bool isBlocked(const Vector3r& position) const
+    {
+        return isBlocked(toIndex(position));
+    }
+
+    //returns true if occupancy changed
+    bool setOccupied(const Index& index, bool occupied)
+    {
+        if (!isInside(index))
+            return false;
+
+        uint8_t& cell = occupied_[toLinear(index)];
+        if ((cell != 0) == occupied)
+            return false;
+        cell = occupied ? 1 : 0;
+
+        for (const Index& offset : inflation_offsets_) {
+            Index neighbour(index.x + offset.x, index.y + offset.y, index.z + offset.z);
+            if (isInside(neighbour)) {
+                uint16_t& count = blocking_count_[toLinear(neighbour)];
+                count = occupied ? count + 1 : count - 1;
+            }
+        }
+
+        ++version_;
+        return true;
+    }
+    bool setOccupied(const Vector3r& position, bool occupied)
+    {
+        return setOccupied(toIndex(position), occupied);
+    }
+
+    void clear()
+    {
+        std::fill(occupied_.begin(), occupied_.end(), static_cast<uint8_t>(0));
+        std::fill(blocking_count_.begin(), blocking_count_.end(), static_cast<uint16_t>(0));
+        ++version_;
+    }
+
+    //walks the segment at quarter voxel steps, true if no sample is blocked
+    bool isSegmentFree(const Vector3r& start, const Vector3r& end) const
+    {
+        Vector3r delta = end - start;
+        real_T length = delta.norm();
+        int steps = std::max(1, static_cast<int>(std::ceil(length / (resolution_ / 4))));
+        for (int i = 0; i <= steps; ++i) {
+            if (isBlocked(Vector3r(start + delta * (static_cast<real_T>(i) / steps))))
+                return false;
+        }
+        return true;
+    }
+
+    //true if no occupied voxel lies on the segment, unlike isSegmentFree this ignores inflation and
+    //space outside the grid so it answers "can end be seen from start". Voxels are visited exactly
+    //once each by stepping across voxel boundaries (Amanatides-Woo traversal).
+    bool isLineOfSight(const Vector3r& start, const Vector3r& end) const
+    {
+        Index index = toIndex(start);
+        const Index last = toIndex(end);
+        const Vector3r delta = end - start;
+        const Vector3r offset = (start - min_corner_) / resolution_;
+
+        int step[3];
+        float t_max[3], t_delta[3];
+        const int cell[3] = { index.x, index.y, index.z };
+        for (int axis = 0; axis < 3; ++axis) {
+            if (delta(axis) > 0) {
+                step[axis] = 1;
+                t_delta[axis] = resolution_ / delta(axis);
+                t_max[axis] = (cell[axis] + 1 - offset(axis)) * t_delta[axis];
+            }
+            else if (delta(axis) < 0) {
+                step[axis] = -1;
+                t_delta[axis] = -resolution_ / delta(axis);
+                t_max[axis] = (offset(axis) - cell[axis]) * t_delta[axis];
+            }
+            else {
+                step[axis] = 0;
+                t_delta[axis] = t_max[axis] = Utils::max<float>();
+            }
+        }
+
+        //one voxel per iteration, bounded in case rounding makes us miss the last voxel
+        int remaining = std::abs(last.x - index.x) + std::abs(last.y - index.y) + std::abs(last.z - index.z) + 1;
+        while (remaining-- > 0) {
+            if (isOccupied(index))
+                return false;
+            if (index == last)
+                break;
+
+            int axis = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2) : (t_max[1] < t_max[2] ? 1 : 2);
+            if (t_max[axis] > 1)
+                break;
+            if (axis == 0)
+                index.x += step[0];
+            else if (axis == 1)
+                index.y += step[1];
+            else
+                index.z += step[2];
+            t_max[axis] += t_delta[axis];
+        }
+        return true;
+    }
+
+    //for moves to a neighbour voxel (offset of -1..1 per axis): diagonal move is only allowed if voxels
+    //it passes by are free too, otherwise straight line between voxel centers would clip blocked voxels
+    bool isCuttingCorner(const Index& from, const Index& offset) const
+    {
+        int axes = (offset.x != 0) + (offset.y != 0) + (offset.z != 0);
+        if (axes < 2)
+            return false;
+
+        //every proper sub-move of the offset, e.g. (1, 1, 0) checks (1, 0, 0) and (0, 1, 0)
+        for (int mask = 1; mask < 7; ++mask) {
+            Index side(from.x + ((mask & 1) ? offset.x : 0), from.y + ((mask & 2) ? offset.y : 0),
+                from.z + ((mask & 4) ? offset.z : 0));
+            if (!(side == from) && isBlocked(side))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    Vector3r min_corner_;
+    real_T resolution_;
+    real_T inflation_radius_;
+    int size_x_, size_y_, size_z_;
+    vector<uint8_t> occupied_;
+    vector<uint16_t> blocking_count_;
+    vector<Index> inflation_offsets_;
+    uint64_t version_ = 0;
+};
+
+}} //namespace
+#endif
@@ -8,6 +8,7 @@
 #include "common/CommonStructs.hpp"
 #include "controllers/DroneCommon.hpp"
 #include "controllers/DroneControllerBase.hpp"
+#include "controllers/CommandEngine.hpp"
 #include "safety/SafetyEval.hpp"
 #include "rpc/msgpack.hpp"
 
@@ -111,6 +112,78 @@ public:
         }
     };
 
+    struct Trajectory {
+        std::vector<Vector3r> positions;
+        float step_sec = 0;
+        MSGPACK_DEFINE_ARRAY(positions, step_sec);
+
+        Trajectory()
+        {}
+
+        Trajectory(const msr::airlib::MultiAgentPlanner::Trajectory& s)
+        {
+            from(s.positions, positions);
+            step_sec = s.step_sec;
+        }
+        msr::airlib::MultiAgentPlanner::Trajectory to() const
+        {
+            msr::airlib::MultiAgentPlanner::Trajectory d;
+            RpcLibAdapators::to(positions, d.positions);
+            d.step_sec = step_sec;
+            return d;
+        }
+    };
+
+    struct Detection {
+        int observer_id = 0, camera_id = 0, target_id = -1;
+        float azimuth = 0, elevation = 0, range = 0;
+        Vector3r position;
+        float box_left = 0, box_top = 0, box_right = 0, box_bottom = 0;
+        MSGPACK_DEFINE_ARRAY(observer_id, camera_id, target_id, azimuth, elevation, range, position,
+            box_left, box_top, box_right, box_bottom);
+
+        Detection()
+        {}
+
+        Detection(const msr::airlib::TargetDetector::Detection& s)
+        {
+            observer_id = s.observer_id;
+            camera_id = s.camera_id;
+            target_id = s.target_id;
+            azimuth = s.azimuth;
+            elevation = s.elevation;
+            range = s.range;
+            position = s.position;
+            box_left = s.box_left;
+            box_top = s.box_top;
+            box_right = s.box_right;
+            box_bottom = s.box_bottom;
+        }
+        msr::airlib::TargetDetector::Detection to() const
+        {
+            msr::airlib::TargetDetector::Detection d;
+            d.observer_id = observer_id;
+            d.camera_id = camera_id;
+            d.target_id = target_id;
+            d.azimuth = azimuth;
+            d.elevation = elevation;
+            d.range = range;
+            d.position = position.to();
+            d.box_left = box_left;
+            d.box_top = box_top;
+            d.box_right = box_right;
+            d.box_bottom = box_bottom;
+            return d;
+        }
+    };
+
+    //status of a non-blocking command and its error message if it failed
+    struct CommandResult {
+        msr::airlib::CommandEngine::Status status = msr::airlib::CommandEngine::Status::Unknown;
+        std::string message;
+        MSGPACK_DEFINE_ARRAY(status, message);
+    };
+
     struct RCData {
         uint64_t timestamp = 0;
         float pitch = 0, roll = 0, throttle = 0, yaw = 0;
@@ -167,6 +240,7 @@ MSGPACK_ADD_ENUM(msr::airlib::DrivetrainType);
 MSGPACK_ADD_ENUM(msr::airlib::SafetyEval::SafetyViolationType_);
 MSGPACK_ADD_ENUM(msr::airlib::SafetyEval::ObsAvoidanceStrategy);
 MSGPACK_ADD_ENUM(msr::airlib::DroneControllerBase::ImageType);
+MSGPACK_ADD_ENUM(msr::airlib::CommandEngine::Status);
 
 
 #endif
@@ -9,6 +9,7 @@
 #include "common/CommonStructs.hpp"
 #include "controllers/DroneCommon.hpp"
 #include "controllers/DroneControllerBase.hpp"
+#include "controllers/CommandEngine.hpp"
 #include "safety/SafetyEval.hpp"
 
 namespace msr { namespace airlib {
@@ -35,6 +36,16 @@ public:
         DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
     bool moveToPosition(float x, float y, float z, float velocity, 
         DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
+    bool moveToPositionPlanned(float x, float y, float z, float velocity, 
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
+    //collision free waypoints from current position to goal, empty if no path was found
+    vector<Vector3r> planPath(const Vector3r& goal);
+    //conflict free trajectories for a group of drones, all coordinates in this drone's frame
+    vector<MultiAgentPlanner::Trajectory> planTrajectories(const vector<Vector3r>& starts, const vector<Vector3r>& goals,
+        float velocity, float separation);
+    //NED origin of every simulated vehicle in this drone's frame, subtract to use planned positions on that vehicle
+    vector<Vector3r> getVehicleOrigins();
+    bool moveOnTrajectory(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode = YawMode());
     bool moveToZ(float z, float velocity, 
         const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
     bool moveByManual(float vx_max, float vy_max, float z_min, DrivetrainType drivetrain, const YawMode& yaw_mode, float duration);
@@ -42,6 +53,26 @@ public:
     bool rotateByYawRate(float yaw_rate, float duration);
     bool hover();
 
+    //non-blocking versions of move commands, return handle of the command running in the simulator
+    CommandEngine::Handle moveByVelocityAsync(float vx, float vy, float vz, float duration,
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode());
+    CommandEngine::Handle moveByVelocityZAsync(float vx, float vy, float z, float duration,
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode());
+    CommandEngine::Handle moveOnPathAsync(const vector<Vector3r>& path, float velocity,
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
+    CommandEngine::Handle moveToPositionAsync(float x, float y, float z, float velocity,
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedome, const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
+    CommandEngine::Handle moveOnTrajectoryAsync(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode = YawMode());
+    CommandEngine::Handle moveToZAsync(float z, float velocity,
+        const YawMode& yaw_mode = YawMode(), float lookahead = -1, float adaptive_lookahead = 1);
+    CommandEngine::Handle rotateToYawAsync(float yaw, float margin = 5);
+    CommandEngine::Handle rotateByYawRateAsync(float yaw_rate, float duration);
+    CommandEngine::Handle hoverAsync();
+    CommandEngine::Status getCommandStatus(CommandEngine::Handle handle, string* message = nullptr);
+    //negative timeout waits until command finishes
+    CommandEngine::Status waitForCommand(CommandEngine::Handle handle, float timeout_sec = -1, string* message = nullptr);
+    bool cancelCommand(CommandEngine::Handle handle);
+
     Vector3r getPosition();
     Vector3r getVelocity();
     Quaternionr getOrientation();
@@ -56,8 +87,11 @@ public:
     //request image
     void setImageTypeForCamera(int camera_id, DroneControllerBase::ImageType type);
     DroneControllerBase::ImageType getImageTypeForCamera(int camera_id);
+    void setImageRateForCamera(int camera_id, DroneControllerBase::ImageType type, float rate);
+    float getImageRateForCamera(int camera_id, DroneControllerBase::ImageType type);
     //get/set image
     vector<uint8_t> getImageForCamera(int camera_id, DroneControllerBase::ImageType type);
+    vector<TargetDetector::Detection> getDetections();
 
     bool setSafety(SafetyEval::SafetyViolationType enable_reasons, float obs_clearance, SafetyEval::ObsAvoidanceStrategy obs_startegy,
         float obs_avoidance_vel, const Vector3r& origin, float xy_length, float max_z, float min_z);
@@ -0,0 +1,410 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_RpcLoadBenchmark_hpp
+#define air_RpcLoadBenchmark_hpp
+
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include "common/Common.hpp"
+#include "controllers/DroneControllerBase.hpp"
+#include "controllers/DroneControllerCancelable.hpp"
+#include "rpc/RpcLibServer.hpp"
+#include "rpc/RpcLibClient.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Load generator for RpcLibServer. Starts a server on its own port over a
+    stub controller that has no physics, firmware or rendering, so only RPC
+    and DroneControllerCancelable costs are measured. Then many RpcLibClient
+    connections call it concurrently, each connection doing one kind of call
+    at a fixed rate:
+        getters   - getPosition, getVelocity, getOrientation, getGpsLocation in turn
+        images    - getImageForCamera of a stored image of image_bytes
+        commands  - moveByVelocity for command_duration_sec, a long running call
+    Latency is measured from the time a call was scheduled, not when it was
+    sent, so a server that falls behind shows in the tail instead of quietly
+    lowering the call rate. Results are p50/p99/p999 latency and achieved
+    calls per second per method.
+*/
+class RpcLoadBenchmark {
+public: //types
+    struct Params {
+        std::string address = "127.0.0.1";
+        uint16_t port = 41460;
+        float duration_sec = 10;
+
+        //connections per kind of call and calls per second of each connection, 0 connections disables the kind
+        uint getter_clients = 8;
+        float getter_rate = 100;
+        uint image_clients = 2;
+        float image_rate = 20;
+        uint command_clients = 1;
+        float command_rate = 2;
+
+        uint image_bytes = 256 * 144 * 3;
+        float command_duration_sec = 0.2f;
+    };
+
+    struct MethodResult {
+        std::string method;
+        uint64_t calls;
+        uint64_t errors;
+        double calls_per_sec;
+        double p50_ms, p99_ms, p999_ms, max_ms;
+    };
+
+public:
+    RpcLoadBenchmark()
+        : RpcLoadBenchmark(Params())
+    {
+    }
+
+    RpcLoadBenchmark(const Params& params)
+        : params_(params)
+    {
+    }
+
+    const Params& getParams() const
+    {
+        return params_;
+    }
+
+    //blocks for about duration_sec, throws if server can't be started or clients can't connect
+    const vector<MethodResult>& run()
+    {
+        results_.clear();
+
+        StubController controller(params_.image_bytes);
+        DroneControllerCancelable cancelable(&controller);
+        RpcLibServer server(&cancelable, params_.address, params_.port);
+        server.start();
+
+        vector<unique_ptr<Worker>> workers;
+        addWorkers(workers, Kind::Getter, params_.getter_clients, params_.getter_rate);
+        addWorkers(workers, Kind::Image, params_.image_clients, params_.image_rate);
+        addWorkers(workers, Kind::Command, params_.command_clients, params_.command_rate);
+
+        //connect everyone before timing starts
+        for (auto& worker : workers) {
+            worker->client.reset(new RpcLibClient(params_.address, params_.port));
+            worker->client->ping();
+        }
+
+        Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+        Clock::time_point end = start + toDuration(params_.duration_sec);
+        vector<std::thread> threads;
+        for (auto& worker : workers) {
+            Worker* worker_ptr = worker.get();
+            threads.emplace_back([this, worker_ptr, start, end]() { runWorker(*worker_ptr, start, end); });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        //long running command may still be in flight on server
+        cancelable.cancelAllTasks();
+        server.stop();
+
+        collectResults(workers);
+        return results_;
+    }
+
+    const vector<MethodResult>& getResults() const
+    {
+        return results_;
+    }
+
+    std::string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "RPC load: " << params_.getter_clients << " getter, " << params_.image_clients << " image, "
+            << params_.command_clients << " command clients for " << params_.duration_sec << " s" << std::endl;
+        for (const auto& result : results_) {
+            ss << std::left << std::setw(20) << result.method << std::right
+                << std::setw(10) << result.calls << " calls" << std::setw(10) << result.calls_per_sec << " /s"
+                << std::setprecision(3)
+                << "  p50 " << result.p50_ms << "  p99 " << result.p99_ms << "  p999 " << result.p999_ms
+                << "  max " << result.max_ms << " ms" << std::setprecision(1);
+            if (result.errors > 0)
+                ss << "  " << result.errors << " errors";
+            ss << std::endl;
+        }
+        return ss.str();
+    }
+
+    std::string toJson() const
+    {
+        std::ostringstream ss;
+        ss << std::setprecision(6);
+        ss << "{" << std::endl;
+        ss << "  \"timestamp\": " << Utils::getTimeSinceEpochNanos() / 1000000000ULL << "," << std::endl;
+        ss << "  \"duration_sec\": " << params_.duration_sec << "," << std::endl;
+        ss << "  \"clients\": { \"getter\": " << params_.getter_clients << ", \"image\": " << params_.image_clients
+            << ", \"command\": " << params_.command_clients << " }," << std::endl;
+        ss << "  \"rates\": { \"getter\": " << params_.getter_rate << ", \"image\": " << params_.image_rate
+            << ", \"command\": " << params_.command_rate << " }," << std::endl;
+        ss << "  \"image_bytes\": " << params_.image_bytes << "," << std::endl;
+        ss << "  \"methods\": [";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const MethodResult& result = results_[i];
+            ss << (i == 0 ? "" : ",") << std::endl;
+            ss << "    { \"method\": \"" << result.method << "\", \"calls\": " << result.calls
+                << ", \"errors\": " << result.errors << ", \"calls_per_sec\": " << result.calls_per_sec
+                << ", \"p50_ms\": " << result.p50_ms << ", \"p99_ms\": " << result.p99_ms
+                << ", \"p999_ms\": " << result.p999_ms << ", \"max_ms\": " << result.max_ms << " }";
+        }
+        ss << std::endl << "  ]" << std::endl << "}" << std::endl;
+        return ss.str();
+    }
+
+private: //types
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Kind {
+        Getter, Image, Command
+    };
+
+    static constexpr uint GetterMethodCount = 4;
+    static constexpr uint MethodCount = GetterMethodCount + 2;
+
+    struct Worker {
+        Kind kind;
+        float rate;
+        //fraction of period to wait before first call
+        float phase;
+        unique_ptr<RpcLibClient> client;
+        //latency samples in ms and error counts, by method index
+        vector<double> latencies[MethodCount];
+        uint64_t errors[MethodCount] = {};
+    };
+
+    /*
+        Controller with no physics. Position only changes by what commands
+        set, so getters and commands cost only locking and copying. Commands
+        still run the regular DroneControllerBase loops with their waits.
+    */
+    class StubController : public DroneControllerBase {
+    public:
+        StubController(uint image_bytes)
+        {
+            vector<uint8_t> image(std::max(image_bytes, 1u));
+            for (size_t i = 0; i < image.size(); ++i)
+                image[i] = static_cast<uint8_t>(i);
+            setImageForCamera(0, ImageType::Scene, image);
+        }
+
+        //*** Start: VehicleControllerBase implementation ***//
+        virtual void reset() override {}
+        virtual void update() override {}
+        virtual size_t getVertexCount() override { return 4; }
+        virtual real_T getVertexControlSignal(unsigned int rotor_index) override { unused(rotor_index); return 0; }
+        virtual bool isOffboardMode() override { return true; }
+        virtual bool isSimulationMode() override { return true; }
+        virtual void setOffboardMode(bool is_set) override { unused(is_set); }
+        virtual void setSimulationMode(bool is_set) override { unused(is_set); }
+        //*** End: VehicleControllerBase implementation ***//
+
+        //*** Start: DroneControllerBase implementation ***//
+        virtual bool armDisarm(bool arm, CancelableBase& cancelable_action) override { unused(arm); unused(cancelable_action); return true; }
+        virtual bool takeoff(float max_wait_seconds, CancelableBase& cancelable_action) override { unused(max_wait_seconds); unused(cancelable_action); return true; }
+        virtual bool land(CancelableBase& cancelable_action) override { unused(cancelable_action); return true; }
+        virtual bool goHome(CancelableBase& cancelable_action) override { unused(cancelable_action); return true; }
+
+        virtual Vector3r getPosition() override
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            return position_;
+        }
+        virtual Vector3r getVelocity() override
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            return velocity_;
+        }
+        virtual Quaternionr getOrientation() override
+        {
+            return Quaternionr::Identity();
+        }
+        virtual RCData getRCData() override { return RCData(); }
+        virtual void setRCData(const RCData& rcData) override { unused(rcData); }
+        virtual GeoPoint getHomePoint() override { return GeoPoint(47.641468, -122.140165, 122); }
+        virtual GeoPoint getGpsLocation() override { return getHomePoint(); }
+        virtual const VehicleParams& getVehicleParams() override
+        {
+            static const VehicleParams vehicle_params;
+            return vehicle_params;
+        }
+        virtual float getCommandPeriod() override { return 1.0f / 50; }
+        virtual float getTakeoffZ() override { return -3.0f; }
+        virtual float getDistanceAccuracy() override { return 0.5f; }
+
+    protected:
+        virtual void commandRollPitchZ(float pitch, float roll, float z, float yaw) override
+        {
+            unused(pitch); unused(roll); unused(yaw);
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            position_.z() = z;
+        }
+        virtual void commandVelocity(float vx, float vy, float vz, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            velocity_ = Vector3r(vx, vy, vz);
+        }
+        virtual void commandVelocityZ(float vx, float vy, float z, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            velocity_ = Vector3r(vx, vy, 0);
+            position_.z() = z;
+        }
+        virtual void commandPosition(float x, float y, float z, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            position_ = Vector3r(x, y, z);
+        }
+        //*** End: DroneControllerBase implementation ***//
+
+    private:
+        std::mutex state_mutex_;
+        Vector3r position_ = Vector3r::Zero();
+        Vector3r velocity_ = Vector3r::Zero();
+    };
+
+private:
+    static const char* getMethodName(uint method)
+    {
+        static const char* names[MethodCount] = { "getPosition", "getVelocity", "getOrientation", "getGpsLocation",
+            "getImageForCamera", "moveByVelocity" };
+        return names[method];
+    }
+
+    static Clock::duration toDuration(double seconds)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void addWorkers(vector<unique_ptr<Worker>>& workers, Kind kind, uint count, float rate)
+    {
+        if (rate <= 0)
+            return;
+        for (uint i = 0; i < count; ++i) {
+            unique_ptr<Worker> worker(new Worker());
+            worker->kind = kind;
+            worker->rate = rate;
+            worker->phase = static_cast<float>(i) / count;
+            uint samples = static_cast<uint>(rate * params_.duration_sec) + 1;
+            if (kind == Kind::Getter) {
+                for (uint m = 0; m < GetterMethodCount; ++m)
+                    worker->latencies[m].reserve(samples / GetterMethodCount + 1);
+            }
+            else
+                worker->latencies[kind == Kind::Image ? GetterMethodCount : GetterMethodCount + 1].reserve(samples);
+            workers.push_back(std::move(worker));
+        }
+    }
+
+    void runWorker(Worker& worker, Clock::time_point start, Clock::time_point end)
+    {
+        Clock::duration period = toDuration(1.0 / worker.rate);
+        //spread connections of same kind over the period so they don't all call at once
+        Clock::time_point scheduled = start + toDuration(worker.phase / worker.rate);
+        uint call_index = 0;
+
+        while (scheduled < end) {
+            std::this_thread::sleep_until(scheduled);
+
+            uint method = call(worker, call_index++);
+
+            //late calls are not skipped, their wait counts as latency
+            double latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - scheduled).count();
+            if (method < MethodCount)
+                worker.latencies[method].push_back(latency_ms);
+            scheduled += period;
+        }
+    }
+
+    //returns method index, or MethodCount plus method index if call failed
+    uint call(Worker& worker, uint call_index)
+    {
+        uint method = 0;
+        try {
+            RpcLibClient& client = *worker.client;
+            switch (worker.kind) {
+            case Kind::Getter:
+                method = call_index % GetterMethodCount;
+                switch (method) {
+                case 0: client.getPosition(); break;
+                case 1: client.getVelocity(); break;
+                case 2: client.getOrientation(); break;
+                default: client.getGpsLocation(); break;
+                }
+                break;
+            case Kind::Image:
+                method = GetterMethodCount;
+                client.getImageForCamera(0, DroneControllerBase::ImageType::Scene);
+                break;
+            case Kind::Command:
+                method = GetterMethodCount + 1;
+                client.moveByVelocity(1, 0, 0, params_.command_duration_sec);
+                break;
+            }
+            return method;
+        }
+        catch (std::exception&) {
+            ++worker.errors[method];
+            return MethodCount + method;
+        }
+    }
+
+    void collectResults(const vector<unique_ptr<Worker>>& workers)
+    {
+        for (uint method = 0; method < MethodCount; ++method) {
+            vector<double> latencies;
+            uint64_t errors = 0;
+            bool is_used = false;
+            for (const auto& worker : workers) {
+                latencies.insert(latencies.end(), worker->latencies[method].begin(), worker->latencies[method].end());
+                errors += worker->errors[method];
+                is_used = is_used || (worker->kind == Kind::Getter ? method < GetterMethodCount
+                    : method == (worker->kind == Kind::Image ? GetterMethodCount : GetterMethodCount + 1));
+            }
+            if (!is_used)
+                continue;
+
+            std::sort(latencies.begin(), latencies.end());
+            MethodResult result;
+            result.method = getMethodName(method);
+            result.calls = latencies.size();
+            result.errors = errors;
+            result.calls_per_sec = latencies.size() / params_.duration_sec;
+            result.p50_ms = percentile(latencies, 0.5);
+            result.p99_ms = percentile(latencies, 0.99);
+            result.p999_ms = percentile(latencies, 0.999);
+            result.max_ms = latencies.size() > 0 ? latencies.back() : 0;
+            results_.push_back(result);
+        }
+    }
+
+    //nearest rank on sorted samples
+    static double percentile(const vector<double>& sorted, double fraction)
+    {
+        if (sorted.size() == 0)
+            return 0;
+        size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::min(std::max(rank, static_cast<size_t>(1)), sorted.size()) - 1];
+    }
+
+private:
+    Params params_;
+    vector<MethodResult> results_;
+};
+
+}} //namespace
+#endif
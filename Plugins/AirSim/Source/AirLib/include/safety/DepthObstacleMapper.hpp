@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_DepthObstacleMapper_hpp
+#define air_DepthObstacleMapper_hpp
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include "common/Common.hpp"
+#include "ObstacleMap.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Feeds ObstacleMap from depth images of a camera mounted on the vehicle.
+
+    Depth image is reduced to one minimum per column over a horizontal band
+    of rows (so ground and sky can be left out). The reduction goes row by row
+    with coefficient-wise min over whole rows which Eigen vectorizes. Each
+    column is then converted from planar depth to range along its bearing and
+    folded in to the ObstacleMap tick that bearing falls in. Ticks outside
+    the camera field of view are reported as free, same as a new map.
+
+    Confidence follows ObstacleMap/SafetyEval convention of [0, 1] where 1 is
+    certain; it drops linearly with range because depth error grows with it.
+
+    Images are handed over with submit() from the game thread and processed on
+    a worker thread. Only the latest image is kept: if worker is still busy,
+    a newer image replaces the pending one and that counts as dropped.
+*/
+class DepthObstacleMapper {
+public: //types
+    struct Params {
+        real_T horizontal_fov = M_PIf / 2;  //radians
+        real_T yaw_offset = 0;              //camera heading in body frame, radians
+        real_T depth_scale = 100;           //multiplier from raw depth to meters (default is far plane of normalized depth capture)
+        real_T min_distance = 0.1f;         //closer values are treated as invalid
+        real_T max_distance = 50;           //further values are treated as no obstacle
+        real_T row_start = 0.25f;           //fraction of image height where band starts
+        real_T row_end = 0.75f;             //fraction of image height where band ends
+        real_T confidence_loss_per_meter = 0.01f;
+    };
+
+public:
+    DepthObstacleMapper(shared_ptr<ObstacleMap> obstacle_map, const Params& params)
+        : obstacle_map_(obstacle_map), params_(params), ticks_(obstacle_map->getTicks()),
+        tick_distances_(ticks_), tick_confidences_(ticks_),
+        is_running_(false), has_pending_(false), processed_count_(0), dropped_count_(0), last_process_sec_(0)
+    {
+    }
+
+    ~DepthObstacleMapper()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (is_running_)
+            return;
+        is_running_ = true;
+        worker_ = std::thread(&DepthObstacleMapper::workerLoop, this);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_running_ = false;
+        }
+        cond_.notify_one();
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    //copies depth image (row major, width * height values) for the worker, returns false if a pending image was replaced
+    bool submit(const float* depth, int width, int height)
+    {
+        bool was_pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            was_pending = has_pending_;
+            pending_.assign(depth, depth + width * height);
+            pending_width_ = width;
+            pending_height_ = height;
+            has_pending_ = true;
+        }
+        cond_.notify_one();
+
+        if (was_pending)
+            ++dropped_count_;
+        return !was_pending;
+    }
+
+    //reduces depth image and updates the map on calling thread
+    void process(const float* depth, int width, int height)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        if (width != columns_width_ || height != columns_height_)
+            computeColumnGeometry(width, height);
+
+        reduceColumns(depth, width);
+        updateTicks();
+        obstacle_map_->update(tick_distances_.data(), tick_confidences_.data());
+
+        ++processed_count_;
+        last_process_sec_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    uint64_t getProcessedCount() const
+    {
+        return processed_count_;
+    }
+    uint64_t getDroppedCount() const
+    {
+        return dropped_count_;
+    }
+    double getLastProcessSeconds() const
+    {
+        return last_process_sec_;
+    }
+    const shared_ptr<ObstacleMap>& getObstacleMap() const
+    {
+        return obstacle_map_;
+    }
+
+private:
+    typedef Eigen::Array<float, Eigen::Dynamic, 1> ArrayXf;
+
+    void workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait(lock, [this]() { return has_pending_ || !is_running_; });
+            if (!is_running_)
+                break;
+
+            //swap buffers so submit can fill the other one while we work
+            working_.swap(pending_);
+            int width = pending_width_, height = pending_height_;
+            has_pending_ = false;
+
+            lock.unlock();
+            process(working_.data(), width, height);
+            lock.lock();
+        }
+    }
+
+    void computeColumnGeometry(int width, int height)
+    {
+        columns_width_ = width;
+        columns_height_ = height;
+
+        row_begin_ = Utils::clip(static_cast<int>(params_.row_start * height), 0, height - 1);
+        row_end_ = Utils::clip(static_cast<int>(params_.row_end * height), row_begin_ + 1, height);
+
+        //pinhole camera: column offset from center maps to bearing via focal length in pixels
+        float focal = (width / 2.0f) / std::tan(params_.horizontal_fov / 2);
+        column_range_factor_.resize(width);
+        column_tick_.resize(width);
+        for (int c = 0; c < width; ++c) {
+            float angle = std::atan((c + 0.5f - width / 2.0f) / focal);
+            column_range_factor_[c] = params_.depth_scale / std::cos(angle);
+            column_tick_[c] = wrapTick(obstacle_map_->angleToTick(angle + params_.yaw_offset));
+        }
+        column_min_.resize(width);
+    }
+
+    void reduceColumns(const float* depth, int width)
+    {
+        const float min_raw = params_.min_distance / params_.depth_scale;
+        const float invalid = Utils::max<float>();
+
+        column_min_.setConstant(invalid);
+        for (int r = row_begin_; r < row_end_; ++r) {
+            Eigen::Map<const ArrayXf> row(depth + r * width, width);
+            //NaN and too close values fail the comparison and are skipped
+            column_min_ = column_min_.min((row >= min_raw).select(row, invalid));
+        }
+    }
+
+    void updateTicks()
+    {
+        const float free_distance = Utils::max<float>() / 2; //same as new ObstacleMap
+        std::fill(tick_distances_.begin(), tick_distances_.end(), free_distance);
+
+        for (int c = 0; c < columns_width_; ++c) {
+            float range = column_min_[c] * column_range_factor_[c];
+            if (range > params_.max_distance)
+                continue;
+            float& tick_distance = tick_distances_[column_tick_[c]];
+            tick_distance = std::min(tick_distance, range);
+        }
+
+        for (int t = 0; t < ticks_; ++t) {
+            if (tick_distances_[t] >= free_distance)
+                tick_confidences_[t] = 1;
+            else
+                tick_confidences_[t] = Utils::clip(1 - params_.confidence_loss_per_meter * tick_distances_[t], 0.0f, 1.0f);
+        }
+    }
+
+    int wrapTick(int tick) const
+    {
+        int wrapped = tick % ticks_;
+        return wrapped < 0 ? wrapped + ticks_ : wrapped;
+    }
+
+private:
+    shared_ptr<ObstacleMap> obstacle_map_;
+    Params params_;
+    int ticks_;
+
+    //per column geometry, recomputed when image size changes
+    int columns_width_ = 0, columns_height_ = 0;
+    int row_begin_ = 0, row_end_ = 0;
+    vector<float> column_range_factor_;
+    vector<int> column_tick_;
+    ArrayXf column_min_;
+
+    vector<float> tick_distances_;
+    vector<float> tick_confidences_;
+
+    //handoff between submit and worker
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool is_running_;
+    bool has_pending_;
+    vector<float> pending_, working_;
+    int pending_width_ = 0, pending_height_ = 0;
+
+    std::atomic<uint64_t> processed_count_;
+    std::atomic<uint64_t> dropped_count_;
+    std::atomic<double> last_process_sec_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,543 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_ReciprocalAvoidance_hpp
+#define msr_airlib_ReciprocalAvoidance_hpp
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/NeighborIndex.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Reciprocal collision avoidance between vehicles (ORCA, van den Berg et
+    al. "Reciprocal n-body collision avoidance", 3D as in RVO2-3D).
+
+    Every control period one pass over all agents takes snapshot of their
+    states, finds neighbors of each agent through a NeighborIndex and turns
+    each neighbor in to a half-space of velocities that keep the pair apart
+    for time_horizon, assuming the neighbor takes its half of the effort.
+    Agent's new velocity is the one closest to its preferred velocity inside
+    all half-spaces and max speed, found with a small 3D linear program; if
+    the half-spaces have no common velocity the one violating them least is
+    used. Because every agent yields by the same rule against the same
+    snapshot, vehicles pass each other instead of oscillating.
+
+    Preferred velocities come from SafetyEval of each vehicle: a velocity
+    command checked with Reciprocal enabled is recorded here and gets back
+    the velocity to fly, solved on the calling thread against the half-spaces
+    of the last pass. Agents that haven't been checked for cooperative_timeout
+    don't yield, so others take whole effort of avoiding them.
+
+    Agents are solved on several threads when there are enough of them.
+    Positions are in one shared NED frame, get_state of each agent returns
+    position in its own frame which is moved by its origin offset.
+*/
+class ReciprocalAvoidance {
+public: //types
+    struct Params {
+        real_T radius = 0.5f;                   //of each agent, including margin
+        real_T time_horizon = 2;                //seconds
+        real_T neighbor_distance = 15;
+        uint max_neighbors = 10;
+        real_T max_speed = 10;
+        real_T control_period = 0.02f;          //seconds between passes
+        real_T cooperative_timeout = 0.5f;      //seconds
+        uint threads = 0;                       //0 means one per hardware thread
+        uint min_agents_per_thread = 64;        //smaller swarms don't pay for threads
+        int stats_window = 1000;
+    };
+
+    //position in agent's own NED frame and velocity
+    typedef std::function<void(Vector3r& position, Vector3r& velocity)> StateGetter;
+
+public:
+    ReciprocalAvoidance()
+        : ReciprocalAvoidance(Params())
+    {
+    }
+    ReciprocalAvoidance(const Params& params)
+        : params_(params), index_(std::max(params.neighbor_distance, 1.0f)), is_running_(false), pass_count_(0), adjusted_count_(0)
+    {
+        pass_times_.initialize(params.stats_window);
+    }
+
+    ~ReciprocalAvoidance()
+    {
+        stop();
+    }
+
+    //returns index used to refer to the agent, origin_offset is agent's NED origin in the shared frame
+    uint addAgent(const Vector3r& origin_offset, const StateGetter& get_state)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Agent agent;
+        agent.origin_offset = origin_offset;
+        agent.get_state = get_state;
+        agents_.push_back(agent);
+        planes_.push_back(vector<Plane>());
+        return static_cast<uint>(agents_.size() - 1);
+    }
+
+    uint getAgentCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<uint>(agents_.size());
+    }
+
+    /*
+        Records preferred velocity of agent and returns the velocity it should
+        fly instead, which is the same if nothing is in the way. Called from
+        vehicle command threads.
+    */
+    Vector3r getSafeVelocity(uint agent, const Vector3r& preferred_velocity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (agent >= agents_.size())
+            throw std::out_of_range(Utils::stringf("Agent index %u is not valid", agent));
+
+        agents_[agent].preferred_velocity = preferred_velocity;
+        agents_[agent].last_preferred_time = ClockFactory::get()->nowNanos();
+
+        Vector3r velocity = solve(planes_[agent], preferred_velocity, params_.max_speed, check_scratch_);
+        if ((velocity - preferred_velocity).squaredNorm() > 1E-6f)
+            ++adjusted_count_;
+        return velocity;
+    }
+
+    void start()
+    {
+        if (is_running_)
+            return;
+        is_running_ = true;
+        worker_ = std::thread(&ReciprocalAvoidance::workerLoop, this);
+    }
+
+    void stop()
+    {
+        is_running_ = false;
+        if (worker_.joinable())
+            worker_.join();
+    }
+
+    //one pass over all agents on calling thread plus helpers, returns new velocities in agent order
+    void update(vector<Vector3r>* velocities = nullptr)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+
+        {
+            //states are read outside of lock, controllers may be slow to answer
+            std::lock_guard<std::mutex> lock(mutex_);
+            snapshot_.resize(agents_.size());
+            TTimePoint now = ClockFactory::get()->nowNanos();
+            for (size_t i = 0; i < agents_.size(); ++i) {
+                AgentState& state = snapshot_[i];
+                state.get_state = agents_[i].get_state;
+                state.origin_offset = agents_[i].origin_offset;
+                state.is_cooperative = agents_[i].last_preferred_time != 0
+                    && ClockBase::elapsedBetween(now, agents_[i].last_preferred_time) < params_.cooperative_timeout;
+                state.preferred_velocity = agents_[i].preferred_velocity;
+            }
+        }
+        for (AgentState& state : snapshot_) {
+            state.get_state(state.position, state.velocity);
+            state.position += state.origin_offset;
+            if (!state.is_cooperative)
+                state.preferred_velocity = state.velocity;
+        }
+
+        computeAll(snapshot_, next_planes_, next_velocities_);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            //agents added during the pass get their planes next pass
+            for (size_t i = 0; i < next_planes_.size(); ++i)
+                planes_[i].swap(next_planes_[i]);
+            ++pass_count_;
+            pass_times_.insert(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+        }
+
+        if (velocities != nullptr)
+            *velocities = next_velocities_;
+    }
+
+    /*
+        Velocities for given states without any of the bookkeeping, used by
+        update() and benchmarks. Positions must be in the shared frame.
+    */
+    void compute(const vector<Vector3r>& positions, const vector<Vector3r>& velocities, const vector<Vector3r>& preferred_velocities,
+        vector<Vector3r>& new_velocities)
+    {
+        snapshot_.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            snapshot_[i].position = positions[i];
+            snapshot_[i].velocity = velocities[i];
+            snapshot_[i].preferred_velocity = preferred_velocities[i];
+            snapshot_[i].is_cooperative = true;
+        }
+        computeAll(snapshot_, next_planes_, new_velocities);
+    }
+
+    string getReport() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Reciprocal avoidance: " << agents_.size() << " agents, " << pass_count_ << " passes, "
+            << adjusted_count_ << " adjusted commands";
+        if (pass_times_.size() > 0) {
+            ss << ", pass p50 " << pass_times_.percentile(0.5) * 1E6 << " us, p99 " << pass_times_.percentile(0.99) * 1E6
+                << " us, " << pass_times_.mean() / params_.control_period * 100 << "% of period";
+        }
+        ss << std::endl;
+        return ss.str();
+    }
+
+private: //types
+    //allowed velocities v are those with (v - point).dot(normal) >= 0
+    struct Plane {
+        Vector3r point;
+        Vector3r normal;
+    };
+
+    struct Line {
+        Vector3r point;
+        Vector3r direction;
+    };
+
+    struct Agent {
+        Vector3r origin_offset = Vector3r::Zero();
+        StateGetter get_state;
+        Vector3r preferred_velocity = Vector3r::Zero();
+        TTimePoint last_preferred_time = 0;
+    };
+
+    struct AgentState {
+        StateGetter get_state;
+        Vector3r origin_offset = Vector3r::Zero();
+        Vector3r position = Vector3r::Zero();
+        Vector3r velocity = Vector3r::Zero();
+        Vector3r preferred_velocity = Vector3r::Zero();
+        bool is_cooperative = false;
+    };
+
+    //per thread buffers, reused across agents and passes
+    struct Scratch {
+        vector<std::pair<real_T, uint>> neighbors;
+        vector<Plane> projected_planes;
+    };
+
+private:
+    void computeAll(const vector<AgentState>& states, vector<vector<Plane>>& planes, vector<Vector3r>& new_velocities)
+    {
+        const uint count = static_cast<uint>(states.size());
+        planes.resize(count);
+        new_velocities.resize(count);
+        index_.build(count, [&states](uint i) -> const Vector3r& { return states[i].position; });
+
+        uint thread_count = params_.threads > 0 ? params_.threads : std::max(1u, std::thread::hardware_concurrency());
+        thread_count = std::max(1u, std::min(thread_count, count / std::max(1u, params_.min_agents_per_thread)));
+        while (scratches_.size() < thread_count)
+            scratches_.push_back(std::unique_ptr<Scratch>(new Scratch()));
+
+        //agents are handed out in small chunks so threads finishing early take more
+        const uint chunk = 16;
+        std::atomic<uint> next_agent(0);
+        auto work = [&](Scratch* scratch) {
+            for (uint begin = next_agent.fetch_add(chunk); begin < count; begin = next_agent.fetch_add(chunk)) {
+                for (uint i = begin; i < std::min(begin + chunk, count); ++i) {
+                    computePlanes(states, i, *scratch, planes[i]);
+                    new_velocities[i] = solve(planes[i], states[i].preferred_velocity, params_.max_speed, *scratch);
+                }
+            }
+        };
+
+        vector<std::thread> threads;
+        for (uint t = 1; t < thread_count; ++t)
+            threads.push_back(std::thread(work, scratches_[t].get()));
+        work(scratches_[0].get());
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void computePlanes(const vector<AgentState>& states, uint agent, Scratch& scratch, vector<Plane>& planes) const
+    {
+        const AgentState& self = states[agent];
+        const real_T neighbor_distance_sq = params_.neighbor_distance * params_.neighbor_distance;
+
+        scratch.neighbors.clear();
+        index_.forEachNear(self.position, params_.neighbor_distance, [&](uint other) {
+            real_T distance_sq = (states[other].position - self.position).squaredNorm();
+            if (other != agent && distance_sq < neighbor_distance_sq)
+                scratch.neighbors.push_back(std::make_pair(distance_sq, other));
+        });
+        if (scratch.neighbors.size() > params_.max_neighbors) {
+            std::nth_element(scratch.neighbors.begin(), scratch.neighbors.begin() + params_.max_neighbors, scratch.neighbors.end());
+            scratch.neighbors.resize(params_.max_neighbors);
+        }
+
+        planes.clear();
+        const real_T inv_time_horizon = 1 / params_.time_horizon;
+        const real_T combined_radius = 2 * params_.radius;
+        const real_T combined_radius_sq = combined_radius * combined_radius;
+        for (const auto& neighbor : scratch.neighbors) {
+            const AgentState& other = states[neighbor.second];
+            Vector3r relative_position = other.position - self.position;
+            Vector3r relative_velocity = self.velocity - other.velocity;
+            real_T distance_sq = neighbor.first;
+
+            Vector3r u;
+            Plane plane;
+            if (distance_sq > combined_radius_sq) {
+                //vector from cutoff center to relative velocity
+                Vector3r w = relative_velocity - relative_position * inv_time_horizon;
+                real_T w_length_sq = w.squaredNorm();
+                real_T dot = w.dot(relative_position);
+
+                if (dot < 0 && dot * dot > combined_radius_sq * w_length_sq) {
+                    //project on cutoff sphere
+                    real_T w_length = std::sqrt(w_length_sq);
+                    Vector3r unit_w = w / w_length;
+                    plane.normal = unit_w;
+                    u = (combined_radius * inv_time_horizon - w_length) * unit_w;
+                }
+                else {
+                    //project on cone
+                    real_T a = distance_sq;
+                    real_T b = relative_position.dot(relative_velocity);
+                    real_T c = relative_velocity.squaredNorm() - relative_position.cross(relative_velocity).squaredNorm() / (distance_sq - combined_radius_sq);
+                    real_T t = (b + std::sqrt(std::max(0.0f, b * b - a * c))) / a;
+                    Vector3r ww = relative_velocity - t * relative_position;
+                    real_T ww_length = ww.norm();
+                    if (ww_length < 1E-9f)
+                        continue;
+                    Vector3r unit_ww = ww / ww_length;
+                    plane.normal = unit_ww;
+                    u = (combined_radius * t - ww_length) * unit_ww;
+                }
+            }
+            else {
+                //already overlapping, get apart within one control period
+                real_T inv_period = 1 / params_.control_period;
+                Vector3r w = relative_velocity - relative_position * inv_period;
+                real_T w_length = w.norm();
+                if (w_length < 1E-9f)
+                    continue;
+                Vector3r unit_w = w / w_length;
+                plane.normal = unit_w;
+                u = (combined_radius * inv_period - w_length) * unit_w;
+            }
+
+            //neighbor that doesn't yield leaves all of it to us
+            real_T responsibility = other.is_cooperative && self.is_cooperative ? 0.5f : 1.0f;
+            plane.point = self.velocity + responsibility * u;
+            planes.push_back(plane);
+        }
+    }
+
+    //velocity closest to preferred within all planes and max speed, least violating if planes are infeasible
+    static Vector3r solve(const vector<Plane>& planes, const Vector3r& preferred_velocity, real_T max_speed, Scratch& scratch)
+    {
+        Vector3r result;
+        size_t failed_plane = linearProgram3(planes, max_speed, preferred_velocity, false, result);
+        if (failed_plane < planes.size())
+            linearProgram4(planes, failed_plane, max_speed, scratch.projected_planes, result);
+        return result;
+    }
+
+    //optimum on line within sphere and first plane_count planes
+    static bool linearProgram1(const vector<Plane>& planes, size_t plane_count, const Line& line, real_T radius,
+        const Vector3r& optimum, bool is_direction, Vector3r& result)
+    {
+        real_T dot = line.point.dot(line.direction);
+        real_T discriminant = dot * dot + radius * radius - line.point.squaredNorm();
+        if (discriminant < 0)
+            return false;   //max speed sphere fully invalidates line
+
+        real_T sqrt_discriminant = std::sqrt(discriminant);
+        real_T t_left = -dot - sqrt_discriminant;
+        real_T t_right = -dot + sqrt_discriminant;
+
+        for (size_t i = 0; i < plane_count; ++i) {
+            real_T numerator = (planes[i].point - line.point).dot(planes[i].normal);
+            real_T denominator = line.direction.dot(planes[i].normal);
+            if (denominator * denominator <= Epsilon) {
+                //line is parallel to plane
+                if (numerator > 0)
+                    return false;
+                continue;
+            }
+
+            real_T t = numerator / denominator;
+            if (denominator >= 0)
+                t_left = std::max(t_left, t);
+            else
+                t_right = std::min(t_right, t);
+            if (t_left > t_right)
+                return false;
+        }
+
+        if (is_direction)
+            result = line.point + (optimum.dot(line.direction) > 0 ? t_right : t_left) * line.direction;
+        else {
+            real_T t = Utils::clip(line.direction.dot(optimum - line.point), t_left, t_right);
+            result = line.point + t * line.direction;
+        }
+        return true;
+    }
+
+    //optimum on plane plane_index within sphere and planes before it
+    static bool linearProgram2(const vector<Plane>& planes, size_t plane_index, real_T radius,
+        const Vector3r& optimum, bool is_direction, Vector3r& result)
+    {
+        const Plane& plane = planes[plane_index];
+        real_T plane_distance = plane.point.dot(plane.normal);
+        real_T plane_distance_sq = plane_distance * plane_distance;
+        real_T radius_sq = radius * radius;
+        if (plane_distance_sq > radius_sq)
+            return false;   //max speed sphere fully invalidates plane
+
+        real_T plane_radius_sq = radius_sq - plane_distance_sq;
+        Vector3r plane_center = plane_distance * plane.normal;
+
+        if (is_direction) {
+            Vector3r plane_optimum = optimum - optimum.dot(plane.normal) * plane.normal;
+            real_T plane_optimum_length_sq = plane_optimum.squaredNorm();
+            if (plane_optimum_length_sq <= Epsilon)
+                result = plane_center;
+            else
+                result = plane_center + std::sqrt(plane_radius_sq / plane_optimum_length_sq) * plane_optimum;
+        }
+        else {
+            //project optimum on plane
+            result = optimum + (plane.point - optimum).dot(plane.normal) * plane.normal;
+            if (result.squaredNorm() > radius_sq) {
+                Vector3r plane_result = result - plane_center;
+                result = plane_center + std::sqrt(plane_radius_sq / plane_result.squaredNorm()) * plane_result;
+            }
+        }
+
+        for (size_t i = 0; i < plane_index; ++i) {
+            if (planes[i].normal.dot(planes[i].point - result) <= 0)
+                continue;
+
+            //result doesn't satisfy plane i, optimum is on intersection line of the two planes
+            Vector3r cross = planes[i].normal.cross(plane.normal);
+            if (cross.squaredNorm() <= Epsilon)
+                return false;   //planes are parallel
+
+            Line line;
+            line.direction = cross.normalized();
+            Vector3r line_normal = line.direction.cross(plane.normal);
+            line.point = plane.point + ((planes[i].point - plane.point).dot(planes[i].normal) / line_normal.dot(planes[i].normal)) * line_normal;
+            if (!linearProgram1(planes, i, line, radius, optimum, is_direction, result))
+                return false;
+        }
+        return true;
+    }
+
+    //returns planes.size() on success, else index of the plane that couldn't be satisfied
+    static size_t linearProgram3(const vector<Plane>& planes, real_T radius, const Vector3r& optimum, bool is_direction, Vector3r& result)
+    {
+        if (is_direction)
+            result = optimum * radius;
+        else if (optimum.squaredNorm() > radius * radius)
+            result = optimum.normalized() * radius;
+        else
+            result = optimum;
+
+        for (size_t i = 0; i < planes.size(); ++i) {
+            if (planes[i].normal.dot(planes[i].point - result) > 0) {
+                Vector3r previous = result;
+                if (!linearProgram2(planes, i, radius, optimum, is_direction, result)) {
+                    result = previous;
+                    return i;
+                }
+            }
+        }
+        return planes.size();
+    }
+
+    //minimizes largest violation of planes from begin_plane on
+    static void linearProgram4(const vector<Plane>& planes, size_t begin_plane, real_T radius, vector<Plane>& projected_planes, Vector3r& result)
+    {
+        real_T distance = 0;
+        for (size_t i = begin_plane; i < planes.size(); ++i) {
+            if (planes[i].normal.dot(planes[i].point - result) <= distance)
+                continue;
+
+            //result violates plane i more than earlier ones
+            projected_planes.clear();
+            for (size_t j = 0; j < i; ++j) {
+                Plane plane;
+                Vector3r cross = planes[j].normal.cross(planes[i].normal);
+                if (cross.squaredNorm() <= Epsilon) {
+                    if (planes[i].normal.dot(planes[j].normal) > 0)
+                        continue;   //same direction
+                    plane.point = 0.5f * (planes[i].point + planes[j].point);
+                }
+                else {
+                    Vector3r line_normal = cross.cross(planes[i].normal);
+                    plane.point = planes[i].point + ((planes[j].point - planes[i].point).dot(planes[j].normal) / line_normal.dot(planes[j].normal)) * line_normal;
+                }
+                plane.normal = (planes[j].normal - planes[i].normal).normalized();
+                projected_planes.push_back(plane);
+            }
+
+            Vector3r previous = result;
+            if (linearProgram3(projected_planes, radius, planes[i].normal, true, result) < projected_planes.size()) {
+                //can only happen through floating point error, keep what we had
+                result = previous;
+            }
+            distance = planes[i].normal.dot(planes[i].point - result);
+        }
+    }
+
+    void workerLoop()
+    {
+        ClockBase* clock = ClockFactory::get();
+        while (is_running_) {
+            TTimePoint now = clock->nowNanos();
+            update();
+
+            double remaining = params_.control_period - clock->elapsedSince(now);
+            if (remaining > 0)
+                clock->sleep_for(clock->toWallDelta(remaining));
+        }
+    }
+
+private:
+    static constexpr real_T Epsilon = 1E-5f;
+
+    Params params_;
+    NeighborIndex index_;
+    mutable std::mutex mutex_;
+    vector<Agent> agents_;
+    //constraints of each agent from last pass, guarded by mutex_
+    vector<vector<Plane>> planes_;
+    Scratch check_scratch_;
+
+    //only touched by the pass
+    vector<AgentState> snapshot_;
+    vector<vector<Plane>> next_planes_;
+    vector<Vector3r> next_velocities_;
+    vector<std::unique_ptr<Scratch>> scratches_;
+
+    std::thread worker_;
+    std::atomic<bool> is_running_;
+    uint64_t pass_count_, adjusted_count_;
+    common_utils::RollingOnlineStats pass_times_;
+};
+
+}} //namespace
+#endif
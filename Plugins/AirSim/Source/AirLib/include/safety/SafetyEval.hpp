@@ -13,9 +13,12 @@
 #include "common/Common.hpp"
 #include "controllers/DroneCommon.hpp"
 #include "common/common_utils/EnumFlags.hpp"
+#include "common/common_utils/FixedString.hpp"
 
 namespace msr { namespace airlib {
 
+class ReciprocalAvoidance;
+
 //this class takes all inputs and outputs in NEU world coordinates in metric system
 class SafetyEval {
 public:
@@ -24,6 +27,7 @@ public:
         GeoFence =                  1 << 0,
         Obstacle =                  1 << 1,
         VelocityLimit =             1 << 2,
+        Reciprocal =                1 << 3,     //velocity commands yield to other vehicles, see ReciprocalAvoidance
         All =                       Utils::max<uint>()
     };
     //add bitwise operators for enum
@@ -47,9 +51,12 @@ public:
         Vector3r cur_pos, dest_pos;
         //transoformed cur to destination vector in body frame
         Vector3r cur_dest_body;
-        string message;
+        //fixed capacity so evaluating unsafe moves in command loops doesn't allocate
+        common_utils::FixedString<256> message;
         //suggested unit vector without obstacle, must be zero if no suggestions available
         Vector3r suggested_vec;
+        //velocity to fly instead of the checked one when reason is Reciprocal
+        Vector3r avoidance_vel;
         //risk distances indicates how far we are in to risk zone, lower (<= 0) better than higher
         //cur is for risk distance around current position
         //dest if risk distance towards destination
@@ -58,7 +65,7 @@ public:
         //setup default result
         EvalResult()
             :  is_safe(true), reason(SafetyViolationType_::NoSafetyViolation), suggested_vec(Vector3r::Zero()),
-                cur_risk_dist(Utils::nan<float>()), dest_risk_dist(Utils::nan<float>())
+                avoidance_vel(Vector3r::Zero()), cur_risk_dist(Utils::nan<float>()), dest_risk_dist(Utils::nan<float>())
         {}
 
         string toString() const
@@ -77,6 +84,8 @@ private:
     shared_ptr<ObstacleMap> obs_xy_ptr_;
     SafetyViolationType enable_reasons_ = SafetyEval::SafetyViolationType_::GeoFence;
     ObsAvoidanceStrategy obs_strategy_ = SafetyEval::ObsAvoidanceStrategy::RaiseException;
+    shared_ptr<ReciprocalAvoidance> reciprocal_ptr_;
+    uint reciprocal_agent_ = 0;
 
     void checkFence(const Vector3r& cur_pos, const Vector3r& dest_pos, EvalResult& appendToResult);
     void isSafeDestination(const Vector3r& dest,const Vector3r& cur_pos, const Quaternionr& quaternion, SafetyEval::EvalResult& result);
@@ -85,6 +94,7 @@ private:
     void isCurrentSafer(SafetyEval::EvalResult& result);
     void setSuggestedVelocity(SafetyEval::EvalResult& result, const Quaternionr& quaternion);
     float adjustClearanceForPrStl(float base_clearance, float obs_confidence);
+    void checkReciprocal(const Vector3r& velocity, EvalResult& result);
 public:
     SafetyEval(VehicleParams vehicle_params, shared_ptr<IGeoFence> fence_ptr, shared_ptr<ObstacleMap> obs_xy);
     EvalResult isSafeVelocity(const Vector3r& cur_pos, const Vector3r& velocity, const Quaternionr& quaternion);
@@ -96,6 +106,9 @@ public:
         const Vector3r& origin, float xy_length, float max_z, float min_z);
     void setObsAvoidanceStrategy(SafetyEval::ObsAvoidanceStrategy obs_strategy);
     SafetyEval::ObsAvoidanceStrategy getObsAvoidanceStrategy();
+    SafetyViolationType getEnableReasons() const;
+    //velocity checks yield to other agents of avoidance when Reciprocal is enabled
+    void setReciprocalAvoidance(shared_ptr<ReciprocalAvoidance> reciprocal_ptr, uint agent);
 };
 
 }} //namespace
@@ -0,0 +1,425 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_Scenario_hpp
+#define msr_airlib_Scenario_hpp
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include "common/Common.hpp"
+#include "controllers/Settings.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Match setup read from its own json file (see "Scenario" in settings) and
+    executed by ScenarioRunner on the simulator's timeline. Example:
+
+    {
+      "Name": "Chase",
+      "TimeLimit": 120,
+      "Vehicles": [
+        { "Name": "blue1", "Team": "blue", "X": 0, "Y": 0, "Z": 0 },
+        { "Name": "red1", "Team": "red", "X": 20, "Y": 0, "Z": 0, "Yaw": 180 }
+      ],
+      "Timeline": [
+        { "Time": 0, "Vehicle": "blue", "Command": "MoveToZ", "Z": -5, "Velocity": 2 },
+        { "Time": 0, "Vehicle": "red1", "Command": "MoveOnPath", "Velocity": 4,
+          "Path": [ { "X": 20, "Y": 20, "Z": -5 }, { "X": -20, "Y": 20, "Z": -5 } ] },
+        { "Time": 8, "Vehicle": "blue1", "Command": "MoveToPosition", "X": -20, "Y": 20, "Z": -5, "Velocity": 6 }
+      ],
+      "Triggers": [
+        { "Name": "Caught", "Type": "Proximity", "Vehicle": "blue", "Other": "red", "Distance": 2,
+          "Actions": [ { "Action": "End", "Winner": "blue" } ] },
+        { "Name": "RedCrashed", "Type": "Collision", "Vehicle": "red",
+          "Actions": [ { "Action": "End", "Winner": "blue" } ] }
+      ]
+    }
+
+    Positions are NED meters from the player start, vehicles are spawned
+    at their X, Y, Z and Yaw (degrees) and armed when the scenario starts
+    unless "Arm" is false. "Vehicle" and "Other" name a vehicle or a team,
+    a command sent to a team goes to each of its vehicles.
+
+    Actions are commands by default: MoveToPosition (X, Y, Z, Velocity),
+    MoveOnPath (Path, Velocity), MoveToZ (Z, Velocity), MoveByVelocity
+    (VX, VY, VZ, Duration), RotateToYaw (Yaw in degrees), Hover and Takeoff
+    (optional Timeout in seconds, climbs to the vehicle's takeoff height). With
+    "Action": "End" the match finishes with optional Winner, "Mark" only
+    records an event with its Label in the metrics.
+
+    Triggers fire when their condition becomes true: Proximity when any
+    vehicle of Vehicle comes within Distance of any other vehicle of Other,
+    Collision when any vehicle of Vehicle collides. They fire once unless
+    "Repeat" is true.
+
+    Like SimSettings the file is parsed once in to the plain structs below
+    and all problems are collected in getErrors().
+*/
+class Scenario {
+public: //types
+    enum class ActionType {
+        Command, End, Mark
+    };
+
+    enum class CommandType {
+        MoveToPosition, MoveOnPath, MoveToZ, MoveByVelocity, RotateToYaw, Hover, Takeoff
+    };
+
+    struct Action {
+        ActionType type = ActionType::Command;
+        //indices in to getVehicles()
+        vector<uint> vehicles;
+        CommandType command = CommandType::Hover;
+        //target for MoveToPosition, velocity for MoveByVelocity
+        Vector3r position = Vector3r::Zero();
+        vector<Vector3r> path;
+        real_T z = 0;
+        real_T velocity = 1;
+        //MoveByVelocity duration, Takeoff timeout
+        real_T duration = 0;
+        real_T yaw = 0;
+        string winner;
+        string label;
+    };
+
+    struct TimedAction {
+        real_T time;
+        Action action;
+    };
+
+    enum class TriggerType {
+        Proximity, Collision
+    };
+
+    struct Trigger {
+        string name;
+        TriggerType type = TriggerType::Proximity;
+        vector<uint> vehicles;
+        vector<uint> others;
+        real_T distance = 1;
+        bool repeat = false;
+        vector<Action> actions;
+    };
+
+    struct Vehicle {
+        string name;
+        string team;
+        Vector3r position = Vector3r::Zero();
+        real_T yaw = 0;     //degrees
+        bool arm = true;
+    };
+
+public:
+    //parse whole document, returns true if there were no errors
+    bool load(const Settings& settings)
+    {
+        errors_.clear();
+        vehicles_.clear();
+        timeline_.clear();
+        triggers_.clear();
+
+        name_ = readString(settings, "", "Name", "Scenario");
+        time_limit_ = static_cast<real_T>(readDouble(settings, "", "TimeLimit", 0));
+        if (time_limit_ < 0) {
+            addError("", "TimeLimit", "value must not be negative");
+            time_limit_ = 0;
+        }
+
+        vector<Settings> children;
+        if (!getChildren(settings, "", "Vehicles", children) || children.size() == 0)
+            addError("", "Vehicles", "at least one vehicle is required");
+        for (size_t i = 0; i < children.size(); ++i)
+            readVehicle(children[i], Utils::stringf("Vehicles[%d]", static_cast<int>(i)));
+
+        getChildren(settings, "", "Timeline", children);
+        for (size_t i = 0; i < children.size(); ++i) {
+            std::string path = Utils::stringf("Timeline[%d]", static_cast<int>(i));
+            TimedAction entry;
+            entry.time = static_cast<real_T>(readDouble(children[i], path, "Time", 0));
+            if (entry.time < 0) {
+                addError(path, "Time", "value must not be negative");
+                entry.time = 0;
+            }
+            if (readAction(children[i], path, entry.action))
+                timeline_.push_back(entry);
+        }
+        //stable so entries with same time keep file order
+        std::stable_sort(timeline_.begin(), timeline_.end(), [](const TimedAction& a, const TimedAction& b) {
+            return a.time < b.time;
+        });
+
+        getChildren(settings, "", "Triggers", children);
+        for (size_t i = 0; i < children.size(); ++i)
+            readTrigger(children[i], Utils::stringf("Triggers[%d]", static_cast<int>(i)));
+
+        return errors_.empty();
+    }
+
+    const string& getName() const
+    {
+        return name_;
+    }
+    //seconds after start, 0 means no limit
+    real_T getTimeLimit() const
+    {
+        return time_limit_;
+    }
+    const vector<Vehicle>& getVehicles() const
+    {
+        return vehicles_;
+    }
+    //sorted by time
+    const vector<TimedAction>& getTimeline() const
+    {
+        return timeline_;
+    }
+    const vector<Trigger>& getTriggers() const
+    {
+        return triggers_;
+    }
+    const vector<string>& getErrors() const
+    {
+        return errors_;
+    }
+
+    //-1 if there is no such vehicle
+    int getVehicleIndex(const string& name) const
+    {
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            if (vehicles_[i].name == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+private:
+    void readVehicle(const Settings& child, const string& path)
+    {
+        Vehicle vehicle;
+        vehicle.name = readString(child, path, "Name", "");
+        if (vehicle.name.empty()) {
+            addError(path, "Name", "vehicle name is required");
+            return;
+        }
+        if (getVehicleIndex(vehicle.name) >= 0) {
+            addError(path, "Name", "vehicle name '" + vehicle.name + "' is used more than once");
+            return;
+        }
+        vehicle.team = readString(child, path, "Team", "");
+        if (vehicle.team == vehicle.name)
+            addError(path, "Team", "team can't have the same name as a vehicle");
+        vehicle.position = readPosition(child, path, "X", "Y", "Z");
+        vehicle.yaw = static_cast<real_T>(readDouble(child, path, "Yaw", vehicle.yaw));
+        vehicle.arm = readBool(child, path, "Arm", vehicle.arm);
+        vehicles_.push_back(vehicle);
+    }
+
+    bool readAction(const Settings& child, const string& path, Action& action)
+    {
+        string type = readString(child, path, "Action", "Command");
+        if (type == "End") {
+            action.type = ActionType::End;
+            action.winner = readString(child, path, "Winner", "");
+            return true;
+        }
+        if (type == "Mark") {
+            action.type = ActionType::Mark;
+            action.label = readString(child, path, "Label", "");
+            return true;
+        }
+        if (type != "Command") {
+            addError(path, "Action", "value '" + type + "' must be Command, End or Mark");
+            return false;
+        }
+
+        action.type = ActionType::Command;
+        if (!readVehicles(child, path, "Vehicle", action.vehicles))
+            return false;
+
+        string command = readString(child, path, "Command", "");
+        action.velocity = static_cast<real_T>(readDouble(child, path, "Velocity", action.velocity));
+        if (command == "MoveToPosition") {
+            action.command = CommandType::MoveToPosition;
+            action.position = readPosition(child, path, "X", "Y", "Z");
+        }
+        else if (command == "MoveOnPath") {
+            action.command = CommandType::MoveOnPath;
+            vector<Settings> points;
+            getChildren(child, path, "Path", points);
+            for (size_t i = 0; i < points.size(); ++i)
+                action.path.push_back(readPosition(points[i], path + Utils::stringf(".Path[%d]", static_cast<int>(i)), "X", "Y", "Z"));
+            if (action.path.size() == 0) {
+                addError(path, "Path", "path needs at least one point");
+                return false;
+            }
+        }
+        else if (command == "MoveToZ") {
+            action.command = CommandType::MoveToZ;
+            action.z = static_cast<real_T>(readDouble(child, path, "Z", 0));
+        }
+        else if (command == "MoveByVelocity") {
+            action.command = CommandType::MoveByVelocity;
+            action.position = readPosition(child, path, "VX", "VY", "VZ");
+            action.duration = static_cast<real_T>(readDouble(child, path, "Duration", 0));
+            if (action.duration <= 0) {
+                addError(path, "Duration", "value must be positive");
+                return false;
+            }
+        }
+        else if (command == "RotateToYaw") {
+            action.command = CommandType::RotateToYaw;
+            action.yaw = static_cast<real_T>(readDouble(child, path, "Yaw", 0));
+        }
+        else if (command == "Hover") {
+            action.command = CommandType::Hover;
+        }
+        else if (command == "Takeoff") {
+            action.command = CommandType::Takeoff;
+            action.duration = static_cast<real_T>(readDouble(child, path, "Timeout", 15));
+            if (!(action.duration > 0)) {
+                addError(path, "Timeout", "value must be positive");
+                return false;
+            }
+        }
+        else {
+            addError(path, "Command", "value '" + command
+                + "' must be MoveToPosition, MoveOnPath, MoveToZ, MoveByVelocity, RotateToYaw, Hover or Takeoff");
+            return false;
+        }
+
+        if (action.command != CommandType::MoveByVelocity && action.command != CommandType::RotateToYaw
+            && action.command != CommandType::Hover && action.command != CommandType::Takeoff && !(action.velocity > 0)) {
+            addError(path, "Velocity", "value must be positive");
+            return false;
+        }
+        return true;
+    }
+
+    void readTrigger(const Settings& child, const string& path)
+    {
+        Trigger trigger;
+        trigger.name = readString(child, path, "Name", path);
+        string type = readString(child, path, "Type", "");
+        if (type == "Proximity") {
+            trigger.type = TriggerType::Proximity;
+            trigger.distance = static_cast<real_T>(readDouble(child, path, "Distance", trigger.distance));
+            if (!(trigger.distance > 0)) {
+                addError(path, "Distance", "value must be positive");
+                return;
+            }
+            if (!readVehicles(child, path, "Other", trigger.others))
+                return;
+        }
+        else if (type == "Collision") {
+            trigger.type = TriggerType::Collision;
+        }
+        else {
+            addError(path, "Type", "value '" + type + "' must be Proximity or Collision");
+            return;
+        }
+        if (!readVehicles(child, path, "Vehicle", trigger.vehicles))
+            return;
+        trigger.repeat = readBool(child, path, "Repeat", trigger.repeat);
+
+        vector<Settings> actions;
+        getChildren(child, path, "Actions", actions);
+        for (size_t i = 0; i < actions.size(); ++i) {
+            Action action;
+            if (readAction(actions[i], path + Utils::stringf(".Actions[%d]", static_cast<int>(i)), action))
+                trigger.actions.push_back(action);
+        }
+        if (trigger.actions.size() == 0) {
+            addError(path, "Actions", "trigger needs at least one action");
+            return;
+        }
+        triggers_.push_back(trigger);
+    }
+
+    //name can be a vehicle or a team
+    bool readVehicles(const Settings& child, const string& path, const string& name, vector<uint>& indices)
+    {
+        indices.clear();
+        string value = readString(child, path, name, "");
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            if (vehicles_[i].name == value || (!value.empty() && vehicles_[i].team == value))
+                indices.push_back(static_cast<uint>(i));
+        }
+        if (indices.size() == 0) {
+            addError(path, name, "value '" + value + "' is not a vehicle or team");
+            return false;
+        }
+        return true;
+    }
+
+    Vector3r readPosition(const Settings& child, const string& path, const string& x, const string& y, const string& z)
+    {
+        return Vector3r(static_cast<real_T>(readDouble(child, path, x, 0)), static_cast<real_T>(readDouble(child, path, y, 0)),
+            static_cast<real_T>(readDouble(child, path, z, 0)));
+    }
+
+    bool getChildren(const Settings& settings, const string& path, const string& name, vector<Settings>& children)
+    {
+        try {
+            if (settings.getChildren(name, children))
+                return true;
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, ex.what());
+        }
+        children.clear();
+        return false;
+    }
+
+    void addError(const string& path, const string& name, const string& message)
+    {
+        errors_.push_back((path.empty() ? name : path + "." + name) + ": " + message);
+    }
+
+    //getters in Settings throw if json type doesn't match, we record that and keep default
+    string readString(const Settings& settings, const string& path, const string& name, const string& default_val)
+    {
+        try {
+            return settings.getString(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, string("expected string, ") + ex.what());
+            return default_val;
+        }
+    }
+
+    bool readBool(const Settings& settings, const string& path, const string& name, bool default_val)
+    {
+        try {
+            return settings.getBool(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, string("expected true or false, ") + ex.what());
+            return default_val;
+        }
+    }
+
+    double readDouble(const Settings& settings, const string& path, const string& name, double default_val)
+    {
+        try {
+            return settings.getDouble(name, default_val);
+        }
+        catch (const std::exception& ex) {
+            addError(path, name, string("expected number, ") + ex.what());
+            return default_val;
+        }
+    }
+
+private:
+    string name_;
+    real_T time_limit_ = 0;
+    vector<Vehicle> vehicles_;
+    vector<TimedAction> timeline_;
+    vector<Trigger> triggers_;
+    vector<string> errors_;
+};
+
+}} //namespace
+#endif
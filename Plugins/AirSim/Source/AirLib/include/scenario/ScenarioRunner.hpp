@@ -0,0 +1,471 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_ScenarioRunner_hpp
+#define msr_airlib_ScenarioRunner_hpp
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "controllers/DroneControllerBase.hpp"
+#include "controllers/CommandEngine.hpp"
+#include "Scenario.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Executes a Scenario on simulation time. The simulator binds each
+    scenario vehicle to its controller and NED origin offset (player start
+    is the shared frame), then calls tick() every frame with the simulation
+    clock time passed since the last call. Timeline entries and trigger
+    actions become MotionTasks submitted to the CommandEngine, which steps
+    them with physics, so timing depends only on the simulation clock and
+    nothing waits on an external client. With a clock speed above 1 (see
+    ClockFactory) the run is faster than real time; triggers are still
+    checked once per frame, so they resolve to clock speed / fps seconds.
+
+    Arming is the only blocking part and runs in the background when the
+    scenario starts; scenario time 0 is when all vehicles are armed.
+
+    Metrics kept for the end of run: per vehicle distance flown, collisions,
+    closest approach to any other vehicle and command counts, plus a log of
+    fired triggers and timeline marks. toJson() writes them all.
+
+    Not thread safe, everything is expected to be called from the simulator tick.
+*/
+class ScenarioRunner {
+public: //types
+    enum class State {
+        Idle, Arming, Running, Finished
+    };
+
+    struct Event {
+        real_T time;
+        string source;
+        string description;
+    };
+
+public:
+    ScenarioRunner(const Scenario& scenario, std::shared_ptr<CommandEngine> command_engine)
+        : scenario_(scenario), command_engine_(command_engine), state_(State::Idle), time_(0), tick_count_(0),
+        wall_seconds_(0), next_timeline_(0), is_cancelled_(false)
+    {
+        vehicles_.resize(scenario.getVehicles().size());
+        triggers_.resize(scenario.getTriggers().size());
+    }
+
+    ~ScenarioRunner()
+    {
+        is_cancelled_ = true;
+        if (arming_.valid())
+            arming_.wait();
+    }
+
+    //index is in to scenario vehicles, origin_offset is vehicle's NED origin in the scenario frame
+    void setVehicle(uint index, DroneControllerBase* controller, const Vector3r& origin_offset)
+    {
+        VehicleState& vehicle = vehicles_.at(index);
+        vehicle.controller = controller;
+        vehicle.origin_offset = origin_offset;
+    }
+
+    void setCollisionCount(uint index, int count)
+    {
+        vehicles_.at(index).collision_count = count;
+    }
+
+    //starts arming, throws if any vehicle was not bound to a controller
+    void start()
+    {
+        if (state_ != State::Idle)
+            return;
+
+        std::vector<DroneControllerBase*> to_arm;
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            if (vehicles_[i].controller == nullptr)
+                throw std::invalid_argument("Scenario vehicle '" + scenario_.getVehicles()[i].name + "' has no controller");
+            if (scenario_.getVehicles()[i].arm)
+                to_arm.push_back(vehicles_[i].controller);
+        }
+
+        state_ = State::Arming;
+        arming_ = std::async(std::launch::async, [this, to_arm]() {
+            StopCancelable cancelable(is_cancelled_);
+            for (DroneControllerBase* controller : to_arm) {
+                if (!controller->armDisarm(true, cancelable))
+                    throw VehicleControllerException("Vehicle could not be armed");
+            }
+        });
+    }
+
+    //called by simulator every frame, dt in seconds
+    void tick(float dt)
+    {
+        if (state_ == State::Arming) {
+            if (arming_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
+            try {
+                arming_.get();
+            }
+            catch (const std::exception& ex) {
+                finish(string("Arming failed: ") + ex.what(), "");
+                return;
+            }
+            state_ = State::Running;
+            start_time_ = std::chrono::steady_clock::now();
+            updateVehicles(true);
+        }
+        if (state_ != State::Running)
+            return;
+
+        time_ += dt;
+        ++tick_count_;
+        updateVehicles(false);
+
+        const auto& timeline = scenario_.getTimeline();
+        while (next_timeline_ < timeline.size() && timeline[next_timeline_].time <= time_) {
+            runAction(timeline[next_timeline_].action, Utils::stringf("Timeline[%d]", static_cast<int>(next_timeline_)));
+            ++next_timeline_;
+            if (state_ != State::Running)
+                return;
+        }
+
+        const auto& triggers = scenario_.getTriggers();
+        for (size_t i = 0; i < triggers.size(); ++i) {
+            TriggerState& trigger_state = triggers_[i];
+            if (trigger_state.is_spent)
+                continue;
+            bool is_active = isActive(triggers[i]);
+            //proximity fires on entering range, collisions are new events on their own
+            bool fire = triggers[i].type == Scenario::TriggerType::Collision ? is_active : (is_active && !trigger_state.was_active);
+            trigger_state.was_active = is_active;
+            if (!fire)
+                continue;
+
+            ++trigger_state.fire_count;
+            trigger_state.is_spent = !triggers[i].repeat;
+            addEvent(triggers[i].name, "triggered");
+            for (const auto& action : triggers[i].actions) {
+                runAction(action, triggers[i].name);
+                if (state_ != State::Running)
+                    return;
+            }
+        }
+
+        if (scenario_.getTimeLimit() > 0 && time_ >= scenario_.getTimeLimit()) {
+            holdAll();
+            finish("TimeLimit", "");
+        }
+    }
+
+    //ends the run early, e.g. when simulation stops
+    void stop(const string& reason)
+    {
+        if (state_ == State::Finished)
+            return;
+        is_cancelled_ = true;
+        finish(reason, "");
+    }
+
+    State getState() const
+    {
+        return state_;
+    }
+    bool isFinished() const
+    {
+        return state_ == State::Finished;
+    }
+    //seconds since all vehicles were armed
+    real_T getTime() const
+    {
+        return time_;
+    }
+    const string& getResult() const
+    {
+        return result_;
+    }
+    const string& getWinner() const
+    {
+        return winner_;
+    }
+    const vector<Event>& getEvents() const
+    {
+        return events_;
+    }
+
+    string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Scenario " << scenario_.getName() << ": ";
+        switch (state_) {
+        case State::Idle: ss << "waiting"; break;
+        case State::Arming: ss << "arming"; break;
+        case State::Running: ss << "running " << time_ << " s"; break;
+        case State::Finished:
+            ss << "finished (" << result_ << ")";
+            if (!winner_.empty())
+                ss << ", winner " << winner_;
+            ss << " at " << time_ << " s";
+            if (wall_seconds_ > 0)
+                ss << ", " << time_ / wall_seconds_ << "x real time";
+            break;
+        }
+        ss << ", " << events_.size() << " events" << std::endl;
+        return ss.str();
+    }
+
+    string toJson() const
+    {
+        std::ostringstream ss;
+        ss << std::setprecision(6);
+        ss << "{" << std::endl;
+        ss << "  \"scenario\": \"" << escapeJson(scenario_.getName()) << "\"," << std::endl;
+        ss << "  \"result\": \"" << escapeJson(result_) << "\"," << std::endl;
+        ss << "  \"winner\": \"" << escapeJson(winner_) << "\"," << std::endl;
+        ss << "  \"sim_seconds\": " << time_ << "," << std::endl;
+        ss << "  \"wall_seconds\": " << wall_seconds_ << "," << std::endl;
+        ss << "  \"ticks\": " << tick_count_ << "," << std::endl;
+        ss << "  \"vehicles\": [";
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            const VehicleState& vehicle = vehicles_[i];
+            const Scenario::Vehicle& spec = scenario_.getVehicles()[i];
+            ss << (i == 0 ? "" : ",") << std::endl;
+            ss << "    { \"name\": \"" << escapeJson(spec.name) << "\", \"team\": \"" << escapeJson(spec.team)
+                << "\", \"distance\": " << vehicle.distance << ", \"collisions\": " << vehicle.collision_count - vehicle.start_collision_count
+                << ", \"min_separation\": ";
+            if (vehicle.min_separation < Utils::max<real_T>())
+                ss << vehicle.min_separation;
+            else
+                ss << "null";
+            ss << ", \"commands\": " << vehicle.handles.size() << ", \"failed_commands\": " << vehicle.failed_commands << " }";
+        }
+        ss << std::endl << "  ]," << std::endl;
+        ss << "  \"events\": [";
+        for (size_t i = 0; i < events_.size(); ++i) {
+            ss << (i == 0 ? "" : ",") << std::endl;
+            ss << "    { \"time\": " << events_[i].time << ", \"source\": \"" << escapeJson(events_[i].source)
+                << "\", \"description\": \"" << escapeJson(events_[i].description) << "\" }";
+        }
+        ss << std::endl << "  ]" << std::endl << "}" << std::endl;
+        return ss.str();
+    }
+
+private: //types
+    struct VehicleState {
+        DroneControllerBase* controller = nullptr;
+        Vector3r origin_offset = Vector3r::Zero();
+        Vector3r position = Vector3r::Zero();   //scenario frame
+        real_T distance = 0;
+        real_T min_separation = Utils::max<real_T>();
+        int collision_count = 0, start_collision_count = 0, last_collision_count = 0;
+        bool has_new_collision = false;
+        vector<CommandEngine::Handle> handles;
+        uint failed_commands = 0;
+    };
+
+    struct TriggerState {
+        bool was_active = false;
+        bool is_spent = false;
+        uint fire_count = 0;
+    };
+
+    //lets arming be abandoned when the run is stopped
+    class StopCancelable : public CancelableBase {
+    public:
+        StopCancelable(const std::atomic<bool>& is_cancelled)
+            : is_cancelled_(is_cancelled)
+        {
+        }
+        virtual bool isCancelled() override
+        {
+            return is_cancelled_;
+        }
+        virtual void cancelAllTasks() override
+        {
+        }
+
+    private:
+        const std::atomic<bool>& is_cancelled_;
+    };
+
+private:
+    void updateVehicles(bool is_first)
+    {
+        for (VehicleState& vehicle : vehicles_) {
+            Vector3r position = vehicle.controller->getPosition() + vehicle.origin_offset;
+            if (is_first) {
+                vehicle.start_collision_count = vehicle.last_collision_count = vehicle.collision_count;
+            }
+            else
+                vehicle.distance += (position - vehicle.position).norm();
+            vehicle.position = position;
+            vehicle.has_new_collision = vehicle.collision_count != vehicle.last_collision_count;
+            vehicle.last_collision_count = vehicle.collision_count;
+        }
+
+        for (size_t i = 0; i < vehicles_.size(); ++i) {
+            for (size_t j = i + 1; j < vehicles_.size(); ++j) {
+                real_T separation = (vehicles_[i].position - vehicles_[j].position).norm();
+                vehicles_[i].min_separation = std::min(vehicles_[i].min_separation, separation);
+                vehicles_[j].min_separation = std::min(vehicles_[j].min_separation, separation);
+            }
+        }
+    }
+
+    bool isActive(const Scenario::Trigger& trigger) const
+    {
+        if (trigger.type == Scenario::TriggerType::Collision) {
+            for (uint index : trigger.vehicles) {
+                if (vehicles_[index].has_new_collision)
+                    return true;
+            }
+            return false;
+        }
+
+        real_T distance_squared = trigger.distance * trigger.distance;
+        for (uint index : trigger.vehicles) {
+            for (uint other : trigger.others) {
+                if (index != other && (vehicles_[index].position - vehicles_[other].position).squaredNorm() <= distance_squared)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void runAction(const Scenario::Action& action, const string& source)
+    {
+        switch (action.type) {
+        case Scenario::ActionType::End:
+            addEvent(source, action.winner.empty() ? "end" : "end, winner " + action.winner);
+            holdAll();
+            finish(source, action.winner);
+            break;
+        case Scenario::ActionType::Mark:
+            addEvent(source, action.label);
+            break;
+        case Scenario::ActionType::Command:
+            for (uint index : action.vehicles) {
+                VehicleState& vehicle = vehicles_[index];
+                try {
+                    vehicle.handles.push_back(command_engine_->submit(vehicle.controller, createTask(action, vehicle)));
+                }
+                catch (const std::exception& ex) {
+                    ++vehicle.failed_commands;
+                    addEvent(source, "command for " + scenario_.getVehicles()[index].name + " failed: " + ex.what());
+                }
+            }
+            break;
+        }
+    }
+
+    DroneControllerBase::MotionTaskPtr createTask(const Scenario::Action& action, const VehicleState& vehicle) const
+    {
+        DroneControllerBase* controller = vehicle.controller;
+        const Vector3r& offset = vehicle.origin_offset;
+        switch (action.command) {
+        case Scenario::CommandType::MoveToPosition: {
+            Vector3r target = action.position - offset;
+            return controller->createMoveToPositionTask(target.x(), target.y(), target.z(), action.velocity,
+                DrivetrainType::MaxDegreeOfFreedome, YawMode(), -1, 1);
+        }
+        case Scenario::CommandType::MoveOnPath: {
+            vector<Vector3r> path;
+            for (const Vector3r& point : action.path)
+                path.push_back(point - offset);
+            return controller->createMoveOnPathTask(path, action.velocity, DrivetrainType::MaxDegreeOfFreedome, YawMode(), -1, 1);
+        }
+        case Scenario::CommandType::MoveToZ:
+            return controller->createMoveToZTask(action.z - offset.z(), action.velocity, YawMode(), -1, 1);
+        case Scenario::CommandType::MoveByVelocity:
+            return controller->createMoveByVelocityTask(action.position.x(), action.position.y(), action.position.z(),
+                action.duration, DrivetrainType::MaxDegreeOfFreedome, YawMode());
+        case Scenario::CommandType::RotateToYaw:
+            return controller->createRotateToYawTask(action.yaw, 5);
+        case Scenario::CommandType::Takeoff:
+            return controller->createTakeoffTask(action.duration);
+        default:
+            return controller->createHoverTask();
+        }
+    }
+
+    //vehicles hold where they are once the match is decided
+    void holdAll()
+    {
+        for (VehicleState& vehicle : vehicles_) {
+            try {
+                command_engine_->submit(vehicle.controller, vehicle.controller->createHoverTask());
+            }
+            catch (const std::exception&) {
+                //engine is shutting down, nothing to hold
+            }
+        }
+    }
+
+    void finish(const string& result, const string& winner)
+    {
+        if (state_ == State::Running)
+            wall_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+        state_ = State::Finished;
+        result_ = result;
+        winner_ = winner;
+
+        for (VehicleState& vehicle : vehicles_) {
+            for (CommandEngine::Handle handle : vehicle.handles) {
+                if (command_engine_->getStatus(handle) == CommandEngine::Status::Failed)
+                    ++vehicle.failed_commands;
+            }
+        }
+    }
+
+    void addEvent(const string& source, const string& description)
+    {
+        events_.push_back(Event{ time_, source, description });
+    }
+
+    //event descriptions carry exception messages, which may have line breaks or other control characters
+    static string escapeJson(const string& text)
+    {
+        string escaped;
+        for (char c : text) {
+            switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    escaped += Utils::stringf("\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+                else
+                    escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+private:
+    const Scenario scenario_;
+    std::shared_ptr<CommandEngine> command_engine_;
+    State state_;
+    real_T time_;
+    uint64_t tick_count_;
+    std::chrono::steady_clock::time_point start_time_;
+    double wall_seconds_;
+    size_t next_timeline_;
+    vector<VehicleState> vehicles_;
+    vector<TriggerState> triggers_;
+    vector<Event> events_;
+    string result_, winner_;
+
+    std::atomic<bool> is_cancelled_;
+    std::future<void> arming_;
+};
+
+}} //namespace
+#endif
@@ -10,6 +10,7 @@
 #include "BarometerSimpleParams.hpp"
 #include "BarometerBase.hpp"
 #include "common/GaussianMarkov.hpp"
+#include "common/common_utils/MedianFilter.hpp"
 
 
 namespace msr { namespace airlib {
@@ -23,11 +24,15 @@ public:
 
         uncorrelated_noise = RandomGeneratorGausianR(0.0f, params_.unnorrelated_noise_sigma);
         //correlated_noise.initialize(params_.correlated_noise_tau, params_.correlated_noise_sigma, 0.0f);
+
+        if (params_.median_filter_window > 0)
+            pressure_filter_.initialize(params_.median_filter_window, params_.median_filter_outlier_factor);
     }
 
     //*** Start: UpdatableState implementation ***//
     virtual void reset() override
     {
+        pressure_filter_.reset();
         updateOutput();
         pressure_factor.reset();
         correlated_noise.reset();
@@ -57,6 +62,9 @@ private: //methods
         pressure += EarthUtils::SeaLevelPressure - params_.qnh*100.0f;
         pressure += uncorrelated_noise.next();
 
+        if (params_.median_filter_window > 0)
+            pressure = static_cast<real_T>(std::get<0>(pressure_filter_.filter(pressure)));
+
         output.pressure = pressure;
         //apply altimeter formula
         //https://en.wikipedia.org/wiki/Pressure_altitude
@@ -73,6 +81,8 @@ private:
     GaussianMarkov pressure_factor;
     GaussianMarkov correlated_noise;
     RandomGeneratorGausianR uncorrelated_noise;
+
+    common_utils::MedianFilter<real_T> pressure_filter_;
 };
 
 }} //namespace
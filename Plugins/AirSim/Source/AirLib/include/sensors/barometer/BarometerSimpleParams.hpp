@@ -37,6 +37,12 @@ struct BarometerSimpleParams {
     //http://www.te.com/commerce/DocumentDelivery/DDEController?Action=srchrtrv&DocNm=MS5611-01BA03&DocType=Data+Sheet&DocLang=English
     real_T unnorrelated_noise_sigma = 0.027f * 100;
 
+    //optional post filter on pressure output: median over last median_filter_window
+    //samples with MAD based outlier rejection, 0 disables the filter and
+    //infinite outlier factor (in sigmas) disables rejection
+    int median_filter_window = 0;
+    real_T median_filter_outlier_factor = 3.0f;
+
 };
 
 
@@ -0,0 +1,300 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_TargetDetector_hpp
+#define msr_airlib_TargetDetector_hpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include "common/Common.hpp"
+#include "common/NeighborIndex.hpp"
+#include "planning/VoxelGrid.hpp"
+
+namespace msr { namespace airlib {
+
+/*
+    Analytic object detector: for every camera of every vehicle finds the
+    other vehicles inside the camera frustum and reports bearing, range and
+    pixel bounding box as a perfect detector would, optionally degraded by
+    noise, misses and phantom detections. This needs only world state, so it
+    can stand in for rendering + segmentation when training headless.
+
+    All vehicles are processed in one detect() call. Targets are bucketed in
+    to a NeighborIndex and each frustum only looks at cells overlapping its
+    bounding box, followed by exact sphere vs frustum test. Targets are
+    spheres of target_radius.
+
+    Occlusion is checked against static world occupancy (VoxelGrid), other
+    vehicles don't occlude each other.
+
+    Frames: positions and orientations of vehicles are in one shared NED
+    frame, cameras are relative to vehicle body. Camera frame is x forward,
+    y right, z down, so image u grows with y and v grows with z.
+
+    Not thread safe, intended to be driven from one thread.
+*/
+class TargetDetector {
+public: //types
+    struct Params {
+        real_T min_range = 0.5f;
+        real_T max_range = 100;
+        real_T target_radius = 0.3f;
+        //detection probability falls linearly from reliable_range to zero at max_range
+        real_T reliable_range = 60;
+        //probability of missing a visible target within reliable range
+        real_T false_negative_rate = 0;
+        //expected phantom detections per camera per detect() call
+        real_T false_positive_rate = 0;
+        real_T bearing_noise_sigma = 0;     //radians
+        real_T range_noise_sigma = 0;       //as fraction of range
+        real_T min_box_pixels = 2;          //smaller targets are not detected
+        bool occlusion = true;
+        real_T cell_size = 20;              //of spatial index, meters
+    };
+
+    struct Camera {
+        int camera_id = 0;
+        Vector3r position = Vector3r::Zero();             //in vehicle body frame
+        Quaternionr orientation = Quaternionr::Identity();
+        real_T horizontal_fov = Utils::degreesToRadians(90.0f);
+        int width = 256, height = 144;
+    };
+
+    struct Vehicle {
+        int id = 0;
+        Vector3r position = Vector3r::Zero();             //shared frame
+        Quaternionr orientation = Quaternionr::Identity();
+        vector<Camera> cameras;
+    };
+
+    struct Detection {
+        int observer_id = 0;
+        int camera_id = 0;
+        int target_id = -1;                 //-1 for false positives
+        real_T azimuth = 0;                 //radians, positive to the right of camera axis
+        real_T elevation = 0;               //radians, positive up
+        real_T range = 0;
+        Vector3r position = Vector3r::Zero();             //in camera frame
+        //pixels, clipped to image
+        real_T box_left = 0, box_top = 0, box_right = 0, box_bottom = 0;
+    };
+
+    struct Stats {
+        uint64_t calls = 0;
+        uint64_t candidates = 0;            //targets that passed spatial index
+        uint64_t detections = 0;
+        uint64_t occluded = 0;
+        uint64_t missed = 0;                //dropped by false negative model
+        double last_sec = 0;
+    };
+
+public:
+    TargetDetector()
+    {
+        initialize(Params());
+    }
+    TargetDetector(const Params& params)
+    {
+        initialize(params);
+    }
+
+    void initialize(const Params& params)
+    {
+        params_ = params;
+        index_.setCellSize(params.cell_size);
+        uniform_ = RandomGeneratorR(0.0f, 1.0f);
+        gaussian_ = RandomGeneratorGausianR(0.0f, 1.0f);
+        stats_ = Stats();
+    }
+
+    const Params& getParams() const
+    {
+        return params_;
+    }
+
+    /*
+        Replaces detections with those of all cameras of all vehicles, grouped by
+        observer in order of vehicles. Pass null grid to skip occlusion.
+    */
+    void detect(const vector<Vehicle>& vehicles, const VoxelGrid* grid, vector<Detection>& detections)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        detections.clear();
+        index_.build(static_cast<uint>(vehicles.size()), [&vehicles](uint i) -> const Vector3r& { return vehicles[i].position; });
+
+        for (uint observer = 0; observer < vehicles.size(); ++observer) {
+            const Vehicle& vehicle = vehicles[observer];
+            for (const Camera& camera : vehicle.cameras) {
+                Frustum frustum = makeFrustum(vehicle, camera);
+                index_.forEachInBox(frustum.min_corner, frustum.max_corner, [&](uint target) {
+                    if (target != observer)
+                        detectTarget(frustum, vehicle, camera, vehicles[target], grid, detections);
+                });
+                addFalsePositives(frustum, vehicle, camera, detections);
+            }
+        }
+
+        ++stats_.calls;
+        stats_.last_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    const Stats& getStats() const
+    {
+        return stats_;
+    }
+
+    string getReport() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        ss << "Detection: " << stats_.calls << " calls, " << stats_.last_sec * 1E6 << " us last, "
+            << stats_.candidates << " candidates, " << stats_.detections << " detections, "
+            << stats_.occluded << " occluded, " << stats_.missed << " missed" << std::endl;
+        return ss.str();
+    }
+
+    //projects point in camera frame to pixel coordinates, false if behind camera
+    static bool project(const Camera& camera, const Vector3r& point, real_T& u, real_T& v)
+    {
+        if (point.x() <= 0)
+            return false;
+        real_T focal = getFocalLength(camera);
+        u = camera.width / 2.0f + focal * point.y() / point.x();
+        v = camera.height / 2.0f + focal * point.z() / point.x();
+        return true;
+    }
+
+    static real_T getFocalLength(const Camera& camera)
+    {
+        return (camera.width / 2.0f) / std::tan(camera.horizontal_fov / 2);
+    }
+
+private: //types
+    struct Frustum {
+        Vector3r origin;                    //shared frame
+        Matrix3x3r world_to_camera;
+        real_T tan_half_h, tan_half_v;
+        Vector3r min_corner, max_corner;    //bounds including target radius
+    };
+
+private:
+    Frustum makeFrustum(const Vehicle& vehicle, const Camera& camera) const
+    {
+        Frustum frustum;
+        frustum.origin = vehicle.position + VectorMath::rotateVector(camera.position, vehicle.orientation, true);
+        Quaternionr camera_to_world = vehicle.orientation * camera.orientation;
+        frustum.world_to_camera = camera_to_world.toRotationMatrix().transpose();
+        frustum.tan_half_h = std::tan(camera.horizontal_fov / 2);
+        frustum.tan_half_v = frustum.tan_half_h * camera.height / std::max(1, camera.width);
+
+        //bounds of apex and four far corners
+        frustum.min_corner = frustum.max_corner = frustum.origin;
+        Matrix3x3r camera_to_world_matrix = frustum.world_to_camera.transpose();
+        for (int corner = 0; corner < 4; ++corner) {
+            Vector3r direction(1, (corner & 1) ? frustum.tan_half_h : -frustum.tan_half_h,
+                (corner & 2) ? frustum.tan_half_v : -frustum.tan_half_v);
+            Vector3r point = frustum.origin + camera_to_world_matrix * (direction * params_.max_range);
+            frustum.min_corner = frustum.min_corner.cwiseMin(point);
+            frustum.max_corner = frustum.max_corner.cwiseMax(point);
+        }
+        frustum.min_corner.array() -= params_.target_radius;
+        frustum.max_corner.array() += params_.target_radius;
+        return frustum;
+    }
+
+    void detectTarget(const Frustum& frustum, const Vehicle& observer, const Camera& camera, const Vehicle& target,
+        const VoxelGrid* grid, vector<Detection>& detections)
+    {
+        ++stats_.candidates;
+
+        //exact test of target sphere against frustum planes
+        const real_T radius = params_.target_radius;
+        Vector3r point = frustum.world_to_camera * (target.position - frustum.origin);
+        real_T range = point.norm();
+        if (range < params_.min_range || range > params_.max_range || point.x() <= 0)
+            return;
+        if (std::abs(point.y()) - frustum.tan_half_h * point.x() > radius * std::sqrt(1 + frustum.tan_half_h * frustum.tan_half_h))
+            return;
+        if (std::abs(point.z()) - frustum.tan_half_v * point.x() > radius * std::sqrt(1 + frustum.tan_half_v * frustum.tan_half_v))
+            return;
+
+        if (params_.occlusion && grid != nullptr && !grid->isLineOfSight(frustum.origin, target.position)) {
+            ++stats_.occluded;
+            return;
+        }
+
+        real_T probability = 1 - params_.false_negative_rate;
+        if (range > params_.reliable_range && params_.max_range > params_.reliable_range)
+            probability *= (params_.max_range - range) / (params_.max_range - params_.reliable_range);
+        if (probability < 1 && uniform_.next() >= probability) {
+            ++stats_.missed;
+            return;
+        }
+
+        if (params_.bearing_noise_sigma > 0 || params_.range_noise_sigma > 0) {
+            real_T azimuth = std::atan2(point.y(), point.x()) + gaussian_.next() * params_.bearing_noise_sigma;
+            real_T elevation = std::atan2(-point.z(), Vector2r(point.x(), point.y()).norm()) + gaussian_.next() * params_.bearing_noise_sigma;
+            range = std::max(params_.min_range, range * (1 + gaussian_.next() * params_.range_noise_sigma));
+            point = range * Vector3r(std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth), -std::sin(elevation));
+        }
+
+        addDetection(observer, camera, target.id, point, detections);
+    }
+
+    void addFalsePositives(const Frustum& frustum, const Vehicle& observer, const Camera& camera, vector<Detection>& detections)
+    {
+        if (params_.false_positive_rate <= 0)
+            return;
+
+        //whole part always, fractional part with its probability, keeps expected count equal to rate
+        int count = static_cast<int>(params_.false_positive_rate);
+        if (uniform_.next() < params_.false_positive_rate - count)
+            ++count;
+
+        for (int i = 0; i < count; ++i) {
+            real_T range = params_.min_range + uniform_.next() * (params_.max_range - params_.min_range);
+            Vector3r point(1, (2 * uniform_.next() - 1) * frustum.tan_half_h, (2 * uniform_.next() - 1) * frustum.tan_half_v);
+            addDetection(observer, camera, -1, point.normalized() * range, detections);
+        }
+    }
+
+    void addDetection(const Vehicle& observer, const Camera& camera, int target_id, const Vector3r& point, vector<Detection>& detections)
+    {
+        real_T u, v;
+        if (!project(camera, point, u, v))
+            return;
+
+        real_T half_size = getFocalLength(camera) * params_.target_radius / point.x();
+        Detection detection;
+        detection.box_left = Utils::clip<real_T>(u - half_size, 0, static_cast<real_T>(camera.width));
+        detection.box_right = Utils::clip<real_T>(u + half_size, 0, static_cast<real_T>(camera.width));
+        detection.box_top = Utils::clip<real_T>(v - half_size, 0, static_cast<real_T>(camera.height));
+        detection.box_bottom = Utils::clip<real_T>(v + half_size, 0, static_cast<real_T>(camera.height));
+        if (detection.box_right - detection.box_left < params_.min_box_pixels
+            || detection.box_bottom - detection.box_top < params_.min_box_pixels)
+            return;
+
+        detection.observer_id = observer.id;
+        detection.camera_id = camera.camera_id;
+        detection.target_id = target_id;
+        detection.range = point.norm();
+        detection.azimuth = std::atan2(point.y(), point.x());
+        detection.elevation = std::atan2(-point.z(), Vector2r(point.x(), point.y()).norm());
+        detection.position = point;
+        detections.push_back(detection);
+        ++stats_.detections;
+    }
+
+private:
+    Params params_;
+    NeighborIndex index_;
+    RandomGeneratorR uniform_;
+    RandomGeneratorGausianR gaussian_;
+    Stats stats_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_DistanceBase_hpp
+#define msr_airlib_DistanceBase_hpp
+
+
+#include "sensors/SensorBase.hpp"
+
+
+namespace msr { namespace airlib {
+
+//downward facing range finder
+class DistanceBase  : public SensorBase {
+public: //types
+    struct Output { //same fields as ROS Range message
+        real_T distance = 0;    //meters
+        real_T min_distance = 0;
+        real_T max_distance = 0;
+        bool is_valid = false;  //false when ground is out of range
+        TTimePoint time_stamp = 0;
+    };
+
+
+public:
+    virtual void reportState(StateReporter& reporter) override
+    {
+        //call base
+        UpdatableObject::reportState(reporter);
+
+        reporter.writeValue("Dist", output_.distance);
+        reporter.writeValue("Dist-Valid", output_.is_valid);
+    }
+
+    const Output& getOutput() const
+    {
+        return output_;
+    }
+
+    /*
+        True distance from vehicle to ground along body down axis. Ground
+        height comes from environment (traced by rendering engine below the
+        vehicle), without it ground is taken as flat at vehicle start.
+        Returns infinity when axis doesn't point towards ground.
+    */
+    static real_T getGroundDistance(const Kinematics::State& kinematics, const Environment& environment)
+    {
+        real_T ground_z = environment.getState().ground_z;
+        if (std::isnan(ground_z))
+            ground_z = environment.getInitialState().position.z();
+        real_T height = ground_z - kinematics.pose.position.z();
+
+        //z component of body down axis in world frame, cos(roll) * cos(pitch)
+        real_T down_cos = VectorMath::transformToWorldFrame(Vector3r(0, 0, 1), kinematics.pose.orientation, true).z();
+        if (down_cos < 1E-3f)
+            return Utils::max<real_T>();
+        return std::max(height, 0.0f) / down_cos;
+    }
+
+protected:
+    void setOutput(const Output& output)
+    {
+        output_ = output;
+    }
+
+
+private: 
+    Output output_;
+};
+
+
+}} //namespace
+#endif 
@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_DistanceSimple_hpp
+#define msr_airlib_DistanceSimple_hpp
+
+#include <random>
+#include "common/Common.hpp"
+#include "DistanceSimpleParams.hpp"
+#include "DistanceBase.hpp"
+#include "common/FrequencyLimiter.hpp"
+#include "common/DelayLine.hpp"
+
+
+namespace msr { namespace airlib {
+
+/*
+    Analytic range finder: distance is computed from ground truth pose and
+    ground height instead of rendering, so cost per sample is a handful of
+    multiplies. Samples outside min/max distance are reported as invalid
+    with max_distance, as real sensors do.
+*/
+class DistanceSimple : public DistanceBase {
+public:
+    DistanceSimple(const DistanceSimpleParams& params = DistanceSimpleParams())
+        : params_(params)
+    {
+        freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
+        delay_line_.initialize(params_.update_latency);
+        uncorrelated_noise_ = RandomGeneratorGausianR(0.0f, 1.0f);
+    }
+
+    //*** Start: UpdatableState implementation ***//
+    virtual void reset() override
+    {
+        freq_limiter_.reset();
+        delay_line_.reset();
+        uncorrelated_noise_.reset();
+
+        addOutputToDelayLine();
+    }
+
+    virtual void update() override
+    {
+        freq_limiter_.update();
+
+        if (freq_limiter_.isWaitComplete())
+            addOutputToDelayLine();
+
+        delay_line_.update();
+
+        if (freq_limiter_.isWaitComplete())
+            setOutput(delay_line_.getOutput());
+    }
+    //*** End: UpdatableState implementation ***//
+
+    virtual ~DistanceSimple() = default;
+
+private: //methods
+    void addOutputToDelayLine()
+    {
+        Output output;
+        const GroundTruth& ground_truth = getGroundTruth();
+
+        real_T distance = getGroundDistance(*ground_truth.kinematics, *ground_truth.environment);
+        output.min_distance = params_.min_distance;
+        output.max_distance = params_.max_distance;
+        output.is_valid = distance >= params_.min_distance && distance <= params_.max_distance;
+        if (output.is_valid) {
+            real_T sigma = params_.noise_sigma + distance * params_.relative_noise_sigma;
+            output.distance = Utils::clip(distance + sigma * uncorrelated_noise_.next(), params_.min_distance, params_.max_distance);
+        }
+        else
+            output.distance = params_.max_distance;
+        output.time_stamp = clock()->nowNanos();
+
+        delay_line_.push_back(output);
+    }
+
+private:
+    DistanceSimpleParams params_;
+
+    FrequencyLimiter freq_limiter_;
+    DelayLine<Output> delay_line_;
+    RandomGeneratorGausianR uncorrelated_noise_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_DistanceSimpleParams_hpp
+#define msr_airlib_DistanceSimpleParams_hpp
+
+#include "common/Common.hpp"
+
+
+namespace msr { namespace airlib {
+
+
+struct DistanceSimpleParams {
+    //defaults are roughly Garmin LIDAR-Lite v3
+    real_T min_distance = 0.2f;     //meters
+    real_T max_distance = 40;
+
+    //noise sigma grows with distance: noise_sigma + distance * relative_noise_sigma
+    real_T noise_sigma = 0.025f;
+    real_T relative_noise_sigma = 0.001f;
+
+    real_T update_latency = 0.01f;  //sec
+    real_T update_frequency = 50;   //Hz
+    real_T startup_delay = 0;       //sec
+};
+
+
+}} //namespace
+#endif
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_OpticalFlowBase_hpp
+#define msr_airlib_OpticalFlowBase_hpp
+
+
+#include "sensors/SensorBase.hpp"
+
+
+namespace msr { namespace airlib {
+
+//downward facing optical flow camera, e.g. PX4Flow
+class OpticalFlowBase  : public SensorBase {
+public: //types
+    struct Output { //same fields as MAVLink OPTICAL_FLOW_RAD message
+        real_T integration_time = 0;    //sec over which flow and gyro were integrated
+        //flow in radians, RH rotation about the axis gives positive flow,
+        //translation along +y gives negative x flow and along +x positive y flow
+        real_T integrated_x = 0;
+        real_T integrated_y = 0;
+        Vector3r integrated_gyro = Vector3r::Zero();   //radians
+        uint8_t quality = 0;            //0 is bad, 255 is best
+        real_T distance = -1;           //meters, negative if unknown
+        TTimePoint time_stamp = 0;
+    };
+
+
+public:
+    virtual void reportState(StateReporter& reporter) override
+    {
+        //call base
+        UpdatableObject::reportState(reporter);
+
+        reporter.writeValue("Flow-X", output_.integrated_x);
+        reporter.writeValue("Flow-Y", output_.integrated_y);
+        reporter.writeValue("Flow-Q", static_cast<int>(output_.quality));
+    }
+
+    const Output& getOutput() const
+    {
+        return output_;
+    }
+
+protected:
+    void setOutput(const Output& output)
+    {
+        output_ = output;
+    }
+
+
+private: 
+    Output output_;
+};
+
+
+}} //namespace
+#endif 
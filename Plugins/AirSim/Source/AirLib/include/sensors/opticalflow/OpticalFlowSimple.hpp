@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_OpticalFlowSimple_hpp
+#define msr_airlib_OpticalFlowSimple_hpp
+
+#include <random>
+#include "common/Common.hpp"
+#include "OpticalFlowSimpleParams.hpp"
+#include "OpticalFlowBase.hpp"
+#include "sensors/distance/DistanceBase.hpp"
+#include "common/FrequencyLimiter.hpp"
+#include "common/DelayLine.hpp"
+
+
+namespace msr { namespace airlib {
+
+/*
+    Analytic optical flow: instead of matching features in rendered images
+    flow rate of the ground point under the camera is computed from ground
+    truth as
+
+        flow_x = wx - vy / d,   flow_y = wy + vx / d
+
+    where w is body angular rate, v is body velocity and d is distance to
+    ground along the camera axis. Rates are integrated every tick and
+    published once per update interval, the way flow sensors report.
+    Quality goes to 0 when ground is out of focus range and falls with
+    angular rate to mimic motion blur.
+*/
+class OpticalFlowSimple : public OpticalFlowBase {
+public:
+    OpticalFlowSimple(const OpticalFlowSimpleParams& params = OpticalFlowSimpleParams())
+        : params_(params)
+    {
+        freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
+        delay_line_.initialize(params_.update_latency);
+        flow_noise_ = RandomGeneratorGausianR(0.0f, params_.flow_noise_sigma);
+        gyro_noise_ = RandomVectorGaussianR(0.0f, params_.gyro_noise_sigma);
+    }
+
+    //*** Start: UpdatableState implementation ***//
+    virtual void reset() override
+    {
+        freq_limiter_.reset();
+        delay_line_.reset();
+        flow_noise_.reset();
+        gyro_noise_.reset();
+
+        resetIntegration();
+        last_time_ = clock()->nowNanos();
+    }
+
+    virtual void update() override
+    {
+        TTimePoint now = clock()->nowNanos();
+        integrate(static_cast<real_T>(ClockBase::elapsedBetween(now, last_time_)));
+        last_time_ = now;
+
+        freq_limiter_.update();
+
+        if (freq_limiter_.isWaitComplete()) {
+            addOutputToDelayLine();
+            resetIntegration();
+        }
+
+        delay_line_.update();
+
+        if (freq_limiter_.isWaitComplete())
+            setOutput(delay_line_.getOutput());
+    }
+    //*** End: UpdatableState implementation ***//
+
+    virtual ~OpticalFlowSimple() = default;
+
+private: //methods
+    void integrate(real_T dt)
+    {
+        if (dt <= 0)
+            return;
+
+        const GroundTruth& ground_truth = getGroundTruth();
+        const Kinematics::State& kinematics = *ground_truth.kinematics;
+
+        const Vector3r& angular = kinematics.twist.angular;
+        integrated_gyro_ += (angular + gyro_noise_.next()) * dt;
+
+        distance_ = DistanceBase::getGroundDistance(kinematics, *ground_truth.environment);
+        if (distance_ < params_.min_distance || distance_ > params_.max_distance) {
+            in_range_ = false;
+        }
+        else {
+            Vector3r velocity = VectorMath::transformToBodyFrame(kinematics.twist.linear, kinematics.pose.orientation, true);
+            integrated_x_ += (angular.x() - velocity.y() / distance_ + flow_noise_.next()) * dt;
+            integrated_y_ += (angular.y() + velocity.x() / distance_ + flow_noise_.next()) * dt;
+        }
+
+        real_T rate = Vector2r(angular.x(), angular.y()).norm();
+        max_rate_ = std::max(max_rate_, rate);
+        integration_time_ += dt;
+    }
+
+    void resetIntegration()
+    {
+        integration_time_ = 0;
+        integrated_x_ = integrated_y_ = 0;
+        integrated_gyro_ = Vector3r::Zero();
+        max_rate_ = 0;
+        in_range_ = true;
+        distance_ = -1;
+    }
+
+    void addOutputToDelayLine()
+    {
+        Output output;
+        output.integration_time = integration_time_;
+        output.integrated_gyro = integrated_gyro_;
+
+        //whole interval must be in range, otherwise part of flow is missing
+        real_T quality = 0;
+        if (in_range_ && integration_time_ > 0)
+            quality = 255 * Utils::clip(1 - max_rate_ / params_.max_angular_rate, 0.0f, 1.0f);
+        output.quality = static_cast<uint8_t>(quality);
+        if (output.quality >= params_.min_quality) {
+            output.integrated_x = integrated_x_;
+            output.integrated_y = integrated_y_;
+        }
+        output.distance = in_range_ ? distance_ : -1;
+        output.time_stamp = clock()->nowNanos();
+
+        delay_line_.push_back(output);
+    }
+
+private:
+    OpticalFlowSimpleParams params_;
+
+    FrequencyLimiter freq_limiter_;
+    DelayLine<Output> delay_line_;
+    RandomGeneratorGausianR flow_noise_;
+    RandomVectorGaussianR gyro_noise_;
+
+    TTimePoint last_time_;
+    real_T integration_time_;
+    real_T integrated_x_, integrated_y_;
+    Vector3r integrated_gyro_;
+    real_T max_rate_;
+    real_T distance_;
+    bool in_range_;
+};
+
+}} //namespace
+#endif
@@ -0,0 +1,33 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_OpticalFlowSimpleParams_hpp
+#define msr_airlib_OpticalFlowSimpleParams_hpp
+
+#include "common/Common.hpp"
+
+
+namespace msr { namespace airlib {
+
+
+struct OpticalFlowSimpleParams {
+    //flow is only measured while ground is in focus
+    real_T min_distance = 0.3f;     //meters
+    real_T max_distance = 20;
+
+    real_T flow_noise_sigma = 0.02f;    //rad/s on flow rate
+    real_T gyro_noise_sigma = 0.002f;   //rad/s on integrated gyro rate
+
+    //quality drops linearly to 0 as angular rate goes up to this (motion blur), rad/s
+    real_T max_angular_rate = 6;
+    //below this quality flow is reported as 0
+    uint8_t min_quality = 10;
+
+    real_T update_latency = 0.02f;  //sec
+    real_T update_frequency = 50;   //Hz, also the integration interval
+    real_T startup_delay = 0;       //sec
+};
+
+
+}} //namespace
+#endif
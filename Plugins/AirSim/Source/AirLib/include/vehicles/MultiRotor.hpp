@@ -141,6 +141,21 @@ public:
     {
         return params_->getParams().friction;
     }
+    //encloses body box and propeller discs
+    virtual real_T getCollisionRadius() const override
+    {
+        const auto& params = params_->getParams();
+        real_T radius = Vector3r(params.body_box.x, params.body_box.y, params.body_box.z).norm() / 2;
+        for (const auto& rotor_pose : params.rotor_poses)
+            radius = std::max(radius, rotor_pose.position.norm() + params.rotor_params.propeller_diameter / 2);
+        return radius;
+    }
+    //sphere inside body box, vehicle stands on its legs below the box so it can land on static floors
+    virtual real_T getStaticCollisionRadius() const override
+    {
+        const auto& box = params_->getParams().body_box;
+        return std::min(box.x, std::min(box.y, box.z)) / 2;
+    }
 
     Rotor::Output getRotorOutput(uint rotor_index) const
     {
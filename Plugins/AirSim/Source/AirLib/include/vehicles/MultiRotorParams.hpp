@@ -14,6 +14,8 @@
 #include "sensors/imu/ImuSimple.hpp"
 #include "sensors/gps/GpsSimple.hpp"
 #include "sensors/magnetometer/MagnetometerSimple.hpp"
+#include "sensors/distance/DistanceSimple.hpp"
+#include "sensors/opticalflow/OpticalFlowSimple.hpp"
 
 //below includes are because of setPhysicsGroundTruth methog
 #include "physics/Environment.hpp"
@@ -41,6 +43,8 @@ public: //types
         bool magnetometer = true;
         bool gps = true;
         bool barometer = true;
+        bool distance = false;
+        bool optical_flow = false;
     };
 
     //TODO: support arbitrary shapes for cor body via interfaces
@@ -220,7 +224,9 @@ protected: //static utility functions for derived classes to use
         }
     }
 
-    static void createStandardSensors(vector<unique_ptr<SensorBase>>& sensor_storage, SensorCollection& sensors, const EnabledSensors& enabled_sensors)
+    static void createStandardSensors(vector<unique_ptr<SensorBase>>& sensor_storage, SensorCollection& sensors, const EnabledSensors& enabled_sensors,
+        const BarometerSimpleParams& barometer_params = BarometerSimpleParams(), const DistanceSimpleParams& distance_params = DistanceSimpleParams(),
+        const OpticalFlowSimpleParams& optical_flow_params = OpticalFlowSimpleParams())
     {
         sensor_storage.clear();
         if (enabled_sensors.imu)
@@ -230,13 +236,17 @@ protected: //static utility functions for derived classes to use
         if (enabled_sensors.gps)
             sensors.insert(createSensor<GpsSimple>(sensor_storage), SensorCollection::SensorType::Gps);
         if (enabled_sensors.barometer)
-            sensors.insert(createSensor<BarometerSimple>(sensor_storage), SensorCollection::SensorType::Barometer);
+            sensors.insert(createSensor<BarometerSimple>(sensor_storage, barometer_params), SensorCollection::SensorType::Barometer);
+        if (enabled_sensors.distance)
+            sensors.insert(createSensor<DistanceSimple>(sensor_storage, distance_params), SensorCollection::SensorType::Distance);
+        if (enabled_sensors.optical_flow)
+            sensors.insert(createSensor<OpticalFlowSimple>(sensor_storage, optical_flow_params), SensorCollection::SensorType::OpticalFlow);
     }
 
-    template<typename SensorClass>
-    static SensorBase* createSensor(vector<unique_ptr<SensorBase>>& sensor_storage)
+    template<typename SensorClass, typename... SensorArgs>
+    static SensorBase* createSensor(vector<unique_ptr<SensorBase>>& sensor_storage, SensorArgs&&... args)
     {
-        sensor_storage.emplace_back(unique_ptr<SensorClass>(new SensorClass()));
+        sensor_storage.emplace_back(unique_ptr<SensorClass>(new SensorClass(std::forward<SensorArgs>(args)...)));
         return sensor_storage.back().get();
     }
 
@@ -5,8 +5,9 @@
 #define msr_airlib_vehicles_MultiRotorParamsFactory_hpp
 
 #include "vehicles/configs/RosFlightQuadX.hpp"
+#include "vehicles/configs/PluginQuadX.hpp"
 #include "controllers/MavLinkDroneController.hpp"
-#include "controllers/Settings.hpp"
+#include "controllers/SimSettings.hpp"
 #include "vehicles/configs/Px4MultiRotor.hpp"
 
 
@@ -16,17 +17,15 @@ class MultiRotorParamsFactory {
 public:
     static std::unique_ptr<MultiRotorParams> createConfig(const std::string& vehicle_name)
     {
-        //read settings and override defaults
-        Settings& settings = Settings::singleton();
-        Settings child;
-        settings.getChild(vehicle_name, child);
-
+        //settings were already parsed and validated at load time
         std::unique_ptr<MultiRotorParams> config;
 
         if (vehicle_name == "Pixhawk") {
-            config.reset(new Px4MultiRotor(child));
+            config.reset(new Px4MultiRotor(SimSettings::singleton().getVehicleSettings(vehicle_name)));
         } else if (vehicle_name == "RosFlight") {
-            config.reset(new RosFlightQuadX(child));
+            config.reset(new RosFlightQuadX(SimSettings::singleton().getVehicleSettings(vehicle_name)));
+        } else if (vehicle_name == "Plugin") {
+            config.reset(new PluginQuadX(SimSettings::singleton().getVehicleSettings(vehicle_name)));
         } else
             throw std::runtime_error(Utils::stringf("Cannot create vehicle config because vehicle name '%s' is not recognized", vehicle_name.c_str()));
 
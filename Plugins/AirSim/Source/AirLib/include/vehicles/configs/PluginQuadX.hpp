@@ -0,0 +1,34 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_vehicles_PluginQuadX_hpp
+#define msr_airlib_vehicles_PluginQuadX_hpp
+
+#include "vehicles/configs/RosFlightQuadX.hpp"
+#include "controllers/plugin/PluginDroneController.hpp"
+
+
+namespace msr { namespace airlib {
+
+//F450 frame of RosFlightQuadX flown by controller from shared library
+class PluginQuadX : public RosFlightQuadX {
+public:
+    PluginQuadX(const SimSettings::VehicleSettings& vehicle_settings)
+        : RosFlightQuadX(vehicle_settings)
+    {
+    }
+
+    virtual void initializePhysics(const Environment* environment, const Kinematics::State* kinematics) override
+    {
+        static_cast<PluginDroneController*>(getController())->initializePhysics(environment, kinematics);
+    }
+
+protected:
+    virtual void createController(unique_ptr<DroneControllerBase>& controller, SensorCollection& sensors) override
+    {
+        controller.reset(new PluginDroneController(&sensors, this, getVehicleSettings()));
+    }
+};
+
+}} //namespace
+#endif
@@ -5,34 +5,43 @@
 #define msr_airlib_vehicles_Px4MultiRotor_hpp
 
 #include "controllers/MavLinkDroneController.hpp"
-#include "controllers/Settings.hpp"
+#include "controllers/SimSettings.hpp"
 
 
 namespace msr { namespace airlib {
 
 class Px4MultiRotor : public MultiRotorParams {
 public:
-    Px4MultiRotor(Settings& settings)
+    Px4MultiRotor(const SimSettings::VehicleSettings& vehicle_settings)
+        : vehicle_settings_(vehicle_settings)
     {
-        connection_info_ = getConnectionInfo(settings);
     }
 
     virtual void setup(Params& params, SensorCollection& sensors, unique_ptr<DroneControllerBase>& controller) override
     {
-        if (connection_info_.model == "Blacksheep") {
+        const auto& model = vehicle_settings_.connection_info.model;
+        if (model == "Blacksheep") {
             setupFrameBlacksheep(params);
         }
-        else if (connection_info_.model == "Flamewheel") {
+        else if (model == "Flamewheel") {
             setupFrameFlamewheel(params);
         }
-        else if (connection_info_.model == "Hexacopter") {
+        else if (model == "Hexacopter") {
             setupFrameGenericHex(params);
         }
         else
             setupFrameGenericQuad(params);
 
         //create sensors
-        createStandardSensors(sensor_storage_, sensors, params.enabled_sensors);
+        const auto& sensor_settings = vehicle_settings_.sensors;
+        params.enabled_sensors.imu = sensor_settings.imu;
+        params.enabled_sensors.magnetometer = sensor_settings.magnetometer;
+        params.enabled_sensors.gps = sensor_settings.gps;
+        params.enabled_sensors.barometer = sensor_settings.barometer;
+        params.enabled_sensors.distance = sensor_settings.distance;
+        params.enabled_sensors.optical_flow = sensor_settings.optical_flow;
+        createStandardSensors(sensor_storage_, sensors, params.enabled_sensors, sensor_settings.barometer_params,
+            sensor_settings.distance_params, sensor_settings.optical_flow_params);
         //create MavLink controller for PX4
         createController(controller, sensors);
     }
@@ -195,53 +204,16 @@ private:
     }
 
 
-    static MavLinkDroneController::ConnectionInfo getConnectionInfo(const Settings& child)
-    {
-        //start with defaults
-        MavLinkDroneController::ConnectionInfo connection_info;
-        // allow json overrides on a per-vehicle basis.
-        connection_info.sim_sysid = static_cast<uint8_t>(child.getInt("SimSysID", connection_info.sim_sysid));
-        connection_info.sim_compid = child.getInt("SimCompID", connection_info.sim_compid);
-
-        connection_info.vehicle_sysid = static_cast<uint8_t>(child.getInt("VehicleSysID", connection_info.vehicle_sysid));
-        connection_info.vehicle_compid = child.getInt("VehicleCompID", connection_info.vehicle_compid);
-
-        connection_info.offboard_sysid = static_cast<uint8_t>(child.getInt("OffboardSysID", connection_info.offboard_sysid));
-        connection_info.offboard_compid = child.getInt("OffboardCompID", connection_info.offboard_compid);
-
-        connection_info.logviewer_ip_address = child.getString("LogViewerHostIp", connection_info.logviewer_ip_address);
-        connection_info.logviewer_ip_port = child.getInt("LogViewerPort", connection_info.logviewer_ip_port);
-        connection_info.logviewer_ip_sport = child.getInt("LogViewerSendPort", connection_info.logviewer_ip_sport);
-
-        connection_info.qgc_ip_address = child.getString("QgcHostIp", connection_info.qgc_ip_address);
-        connection_info.qgc_ip_port = child.getInt("QgcPort", connection_info.qgc_ip_port);
-
-        connection_info.sitl_ip_address = child.getString("SitlIp", connection_info.sitl_ip_address);
-        connection_info.sitl_ip_port = child.getInt("SitlPort", connection_info.sitl_ip_port);
-
-        connection_info.local_host_ip = child.getString("LocalHostIp", connection_info.local_host_ip);
-
-
-        connection_info.use_serial = child.getBool("UseSerial", connection_info.use_serial);
-        connection_info.ip_address = child.getString("UdpIp", connection_info.ip_address);
-        connection_info.ip_port = child.getInt("UdpPort", connection_info.ip_port);
-        connection_info.serial_port = child.getString("SerialPort", connection_info.serial_port);
-        connection_info.baud_rate = child.getInt("SerialBaudRate", connection_info.baud_rate);
-        connection_info.model = child.getString("Model", connection_info.model);
-        
-        return connection_info;
-    }
-
     void createController(unique_ptr<DroneControllerBase>& controller, SensorCollection& sensors)
     {
         controller.reset(new MavLinkDroneController());
         auto mav_controller = static_cast<MavLinkDroneController*>(controller.get());
-        mav_controller->initialize(connection_info_, &sensors, true);
+        mav_controller->initialize(vehicle_settings_.connection_info, &sensors, true);
     }
 
 private:
     vector<unique_ptr<SensorBase>> sensor_storage_;
-    MavLinkDroneController::ConnectionInfo connection_info_;
+    SimSettings::VehicleSettings vehicle_settings_;
 };
 
 }} //namespace
@@ -4,23 +4,27 @@
 #ifndef msr_airlib_vehicles_RosFlightQuadX_hpp
 #define msr_airlib_vehicles_RosFlightQuadX_hpp
 
+#include <sstream>
+#include <iomanip>
 #include "controllers/rosflight/RosFlightDroneController.hpp"
 #include "vehicles/MultiRotorParams.hpp"
-#include "controllers/Settings.hpp"
+#include "sensors/imu/ImuSimpleParams.hpp"
+#include "controllers/SimSettings.hpp"
 
 
 namespace msr { namespace airlib {
 
 class RosFlightQuadX : public MultiRotorParams {
 public:
-    RosFlightQuadX(Settings& settings)
+    RosFlightQuadX(const SimSettings::VehicleSettings& vehicle_settings)
+        : vehicle_settings_(vehicle_settings)
     {
     }
 
     virtual void initializePhysics(const Environment* environment, const Kinematics::State* kinematics) override
     {
         //supply this to controller so it can use physics ground truth instead of state estimation (because ROSFlight doesn't have state estimation)
-        static_cast<RosFlightDroneController*>(getController())->initializePhysics(environment_, kinematics_);
+        static_cast<RosFlightDroneController*>(getController())->initializePhysics(environment, kinematics);
     }
 
 protected:
@@ -59,22 +63,63 @@ protected:
         params.inertia(1, 1) = 0.08f;
         params.inertia(2, 2) = 0.12f;
 
-        createStandardSensors(sensor_storage_, sensors, params.enabled_sensors);
+        const auto& sensor_settings = vehicle_settings_.sensors;
+        params.enabled_sensors.imu = sensor_settings.imu;
+        params.enabled_sensors.magnetometer = sensor_settings.magnetometer;
+        params.enabled_sensors.gps = sensor_settings.gps;
+        params.enabled_sensors.barometer = sensor_settings.barometer;
+        params.enabled_sensors.distance = sensor_settings.distance;
+        params.enabled_sensors.optical_flow = sensor_settings.optical_flow;
+        createStandardSensors(sensor_storage_, sensors, params.enabled_sensors, sensor_settings.barometer_params,
+            sensor_settings.distance_params, sensor_settings.optical_flow_params);
         createController(controller, sensors);
 
         //leave everything else to defaults
     }
 
-private:
-    void createController(unique_ptr<DroneControllerBase>& controller, SensorCollection& sensors)
+    //frame is shared by other ground truth controllers, they only replace the controller
+    virtual void createController(unique_ptr<DroneControllerBase>& controller, SensorCollection& sensors)
+    {
+        const auto& rosflight_settings = vehicle_settings_.rosflight;
+        RosFlightDroneController::CalibrationParams calibration_params;
+        calibration_params.use_cache = rosflight_settings.cache_calibration;
+        //standard sensors use default IMU params
+        calibration_params.cache_key = getCalibrationCacheKey(vehicle_settings_.vehicle_name, vehicle_settings_.sensors, ImuSimpleParams());
+        calibration_params.cache_file = rosflight_settings.calibration_file;
+        calibration_params.burst = rosflight_settings.burst_calibration;
+        controller.reset(new RosFlightDroneController(&sensors, this, vehicle_settings_.remote_control_id, calibration_params));
+    }
+
+    const SimSettings::VehicleSettings& getVehicleSettings() const
+    {
+        return vehicle_settings_;
+    }
+
+    //calibration is only valid for the sensors it was made with, so a hash of their params is part of the key
+    static std::string getCalibrationCacheKey(const std::string& vehicle_name, const SimSettings::SensorSettings& sensor_settings,
+        const ImuSimpleParams& imu_params)
     {
-        controller.reset(new RosFlightDroneController(&sensors, this));
+        std::ostringstream ss;
+        ss << std::setprecision(9) << sensor_settings.imu << sensor_settings.magnetometer << sensor_settings.gps
+            << sensor_settings.barometer << sensor_settings.distance << sensor_settings.optical_flow;
+        ss << ' ' << imu_params.gyro.arw << ' ' << imu_params.gyro.tau << ' ' << imu_params.gyro.bias_stability
+            << ' ' << imu_params.gyro.turn_on_bias.x() << ' ' << imu_params.gyro.turn_on_bias.y() << ' ' << imu_params.gyro.turn_on_bias.z();
+        ss << ' ' << imu_params.accel.vrw << ' ' << imu_params.accel.tau << ' ' << imu_params.accel.bias_stability
+            << ' ' << imu_params.accel.turn_on_bias.x() << ' ' << imu_params.accel.turn_on_bias.y() << ' ' << imu_params.accel.turn_on_bias.z();
+        ss << ' ' << imu_params.min_sample_time;
+
+        //FNV-1a, unlike std::hash it is the same in every build so keys in the calibration file stay valid
+        uint32_t hash = 2166136261u;
+        for (char c : ss.str()) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619u;
+        }
+        return Utils::stringf("%s/%08x", vehicle_name.c_str(), hash);
     }
 
 private:
     vector<unique_ptr<SensorBase>> sensor_storage_;
-    const Kinematics::State* kinematics_;
-    const Environment* environment_;
+    SimSettings::VehicleSettings vehicle_settings_;
 };
 
 }} //namespace
@@ -0,0 +1,75 @@
+// in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+//if using Unreal Build system then include precompiled header file first
+#ifdef AIRLIB_PCH
+#include "AirSim.h"
+#endif
+
+#include "common/AllocationAudit.hpp"
+
+//Unreal has its own operator new, replacements below are for standalone builds only
+#if defined(AIRLIB_ALLOCATION_AUDIT) && !defined(AIRLIB_PCH)
+
+#include <cstdlib>
+#include <new>
+
+using namespace msr::airlib;
+
+namespace {
+    void* auditedAlloc(std::size_t size)
+    {
+        AllocationAudit::recordAllocation();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    void* ptr = auditedAlloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](std::size_t size)
+{
+    void* ptr = auditedAlloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return auditedAlloc(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return auditedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+#endif
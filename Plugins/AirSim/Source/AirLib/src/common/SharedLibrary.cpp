@@ -0,0 +1,69 @@
+// in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+//if using Unreal Build system then include precompiled header file first
+#ifdef AIRLIB_PCH
+#include "AirSim.h"
+#endif
+
+#include "common/SharedLibrary.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+using namespace msr::airlib;
+
+SharedLibrary::~SharedLibrary()
+{
+    unload();
+}
+
+void SharedLibrary::load(const std::string& path)
+{
+    unload();
+
+#ifdef _WIN32
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (module == nullptr)
+        throw std::runtime_error("Cannot load library '" + path + "', error " + std::to_string(GetLastError()));
+    handle_ = module;
+#else
+    handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle_ == nullptr) {
+        const char* error = dlerror();
+        throw std::runtime_error("Cannot load library '" + path + "': " + (error != nullptr ? error : "unknown error"));
+    }
+#endif
+    path_ = path;
+}
+
+void SharedLibrary::unload()
+{
+    if (handle_ == nullptr)
+        return;
+
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(handle_));
+#else
+    dlclose(handle_);
+#endif
+    handle_ = nullptr;
+    path_.clear();
+}
+
+void* SharedLibrary::getSymbol(const std::string& name) const
+{
+    if (handle_ == nullptr)
+        return nullptr;
+
+#ifdef _WIN32
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(handle_), name.c_str()));
+#else
+    return dlsym(handle_, name.c_str());
+#endif
+}
+
+#endif
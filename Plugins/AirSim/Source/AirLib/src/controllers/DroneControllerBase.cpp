@@ -50,15 +50,106 @@ void DroneControllerBase::loopCommandPost()
     //no-op by default. derived class can override it if needed
 }
 
+bool DroneControllerBase::runTask(MotionTask& task, CancelableBase& cancelable_action)
+{
+    Waiter waiter(task.getStepPeriod());
+    while (!task.step()) {
+        //sleep for rest of the cycle
+        if (!waiter.sleep(cancelable_action))
+            return false;
+    }
+    return true;
+}
+
+void DroneControllerBase::setCommandEngine(const shared_ptr<CommandEngine> command_engine)
+{
+    command_engine_ = command_engine;
+}
+
+shared_ptr<CommandEngine> DroneControllerBase::getCommandEngine() const
+{
+    return command_engine_;
+}
+
+//moveByAngle, moveByVelocity and moveByVelocityZ: same setpoint is sent every step for the duration
+class DroneControllerBase::SetpointTask : public DroneControllerBase::MotionTask {
+public:
+    enum class Kind {
+        RollPitchZ, Velocity, VelocityZ
+    };
+
+    SetpointTask(DroneControllerBase& controller, Kind kind, const Vector3r& values, float yaw, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float duration)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), kind_(kind), values_(values), yaw_(yaw),
+        drivetrain_(drivetrain), yaw_mode_(yaw_mode), duration_(duration), is_started_(false)
+    {
+    }
+
+    virtual bool step() override
+    {
+        if (!is_started_) {
+            if (duration_ <= 0)
+                return true;
+            start_time_ = controller_.clock()->nowNanos();
+            is_started_ = true;
+        }
+        else if (controller_.clock()->elapsedSince(start_time_) >= duration_)
+            return true;
+
+        switch (kind_) {
+        case Kind::RollPitchZ:
+            controller_.moveByRollPitchZ(values_.x(), values_.y(), values_.z(), yaw_); break;
+        case Kind::Velocity:
+            controller_.moveByVelocity(values_.x(), values_.y(), values_.z(), drivetrain_, yaw_mode_); break;
+        case Kind::VelocityZ:
+            controller_.moveByVelocityZ(values_.x(), values_.y(), values_.z(), drivetrain_, yaw_mode_); break;
+        }
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    Kind kind_;
+    Vector3r values_;
+    float yaw_;
+    DrivetrainType drivetrain_;
+    YawMode yaw_mode_;
+    float duration_;
+    bool is_started_;
+    TTimePoint start_time_;
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveByAngleTask(float pitch, float roll, float z, float yaw, float duration)
+{
+    return MotionTaskPtr(new SetpointTask(*this, SetpointTask::Kind::RollPitchZ, Vector3r(pitch, roll, z), yaw,
+        DrivetrainType::MaxDegreeOfFreedome, YawMode(), duration));
+}
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveByVelocityTask(float vx, float vy, float vz, float duration,
+    DrivetrainType drivetrain, const YawMode& yaw_mode)
+{
+    YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
+    adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
+    return MotionTaskPtr(new SetpointTask(*this, SetpointTask::Kind::Velocity, Vector3r(vx, vy, vz), 0, drivetrain, adj_yaw_mode,
+        duration));
+}
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveByVelocityZTask(float vx, float vy, float z, float duration,
+    DrivetrainType drivetrain, const YawMode& yaw_mode)
+{
+    YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
+    adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
+    return MotionTaskPtr(new SetpointTask(*this, SetpointTask::Kind::VelocityZ, Vector3r(vx, vy, z), 0, drivetrain, adj_yaw_mode,
+        duration));
+}
+
 bool DroneControllerBase::moveByAngle(float pitch, float roll, float z, float yaw, float duration
     , CancelableBase& cancelable_action)
 {
     if (duration <= 0)
         return true;
 
-    return !waitForFunction([&]() {
-        return !moveByRollPitchZ(pitch, roll, z, yaw);
-    }, duration, cancelable_action);
+    return runTask(*createMoveByAngleTask(pitch, roll, z, yaw, duration), cancelable_action);
 }
 
 bool DroneControllerBase::moveByVelocity(float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode,
@@ -67,12 +158,7 @@ bool DroneControllerBase::moveByVelocity(float vx, float vy, float vz, float dur
     if (duration <= 0)
         return true;
 
-    YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
-    adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
-
-    return !waitForFunction([&]() {
-        return !moveByVelocity(vx, vy, vz, adj_yaw_mode);
-    }, duration, cancelable_action);
+    return runTask(*createMoveByVelocityTask(vx, vy, vz, duration, drivetrain, yaw_mode), cancelable_action);
 }
 
 bool DroneControllerBase::moveByVelocityZ(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode,
@@ -81,107 +167,128 @@ bool DroneControllerBase::moveByVelocityZ(float vx, float vy, float z, float dur
     if (duration <= 0)
         return false;
 
-    YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
-    adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
-
-    return !waitForFunction([&]() {
-        return !moveByVelocityZ(vx, vy, z, adj_yaw_mode);
-    }, duration, cancelable_action);
-
+    return runTask(*createMoveByVelocityZTask(vx, vy, z, duration, drivetrain, yaw_mode), cancelable_action);
 }
 
-bool DroneControllerBase::moveOnPath(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode,
-    float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
-{
-    //validate path size
-    if (path.size() == 0) {
-        Utils::logMessage("moveOnPath terminated because path has no points");
-        return true;
+/*
+    Path following of moveOnPath. Arguments are validated when task is
+    created, path starts from where the drone is at the first step. Each
+    step first advances current position on path by how far the drone got
+    towards the previous goal and then commands the drone towards the next
+    goal, lookahead meters further along the path.
+*/
+class DroneControllerBase::PathTask : public DroneControllerBase::MotionTask {
+public:
+    PathTask(DroneControllerBase& controller, const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain,
+        const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), path_(path), velocity_(velocity), drivetrain_(drivetrain),
+        yaw_mode_(yaw_mode), lookahead_(lookahead), adaptive_lookahead_(adaptive_lookahead), is_started_(false)
+    {
+        //validate path size
+        if (path.size() == 0) {
+            Utils::logMessage("moveOnPath terminated because path has no points");
+            return;
+        }
+
+        //validate yaw mode
+        if (drivetrain == DrivetrainType::ForwardOnly && yaw_mode.is_rate)
+            throw std::invalid_argument("Yaw cannot be specified as rate if drivetrain is ForwardOnly");
+
+        //validate and set auto-lookahead value
+        float command_period_dist = velocity * controller.getCommandPeriod();
+        if (lookahead == 0)
+            throw std::invalid_argument("lookahead distance cannot be 0"); //won't allow progress on path
+        else if (lookahead > 0) {
+            if (command_period_dist > lookahead)
+                throw std::invalid_argument(Utils::stringf("lookahead value %f is too small for velocity %f. It must be at least %f", lookahead, velocity, command_period_dist));
+            if (controller.getDistanceAccuracy() > lookahead)
+                throw std::invalid_argument(Utils::stringf("lookahead value %f is smaller than drone's distance accuracy %f.", lookahead, controller.getDistanceAccuracy()));
+        }
+        else {
+            //if auto mode requested for lookahead then calculate based on velocity
+            lookahead_ = controller.getAutoLookahead(velocity, adaptive_lookahead);
+            Utils::logMessage("lookahead = %f, adaptive_lookahead = %f", lookahead_, adaptive_lookahead);
+        }
     }
 
-    //validate yaw mode
-    if (drivetrain == DrivetrainType::ForwardOnly && yaw_mode.is_rate)
-        throw std::invalid_argument("Yaw cannot be specified as rate if drivetrain is ForwardOnly");
+    virtual bool step() override
+    {
+        if (path_.size() == 0)
+            return true;
 
-    //validate and set auto-lookahead value
-    float command_period_dist = velocity * getCommandPeriod();
-    if (lookahead == 0)
-        throw std::invalid_argument("lookahead distance cannot be 0"); //won't allow progress on path
-    else if (lookahead > 0) {
-        if (command_period_dist > lookahead)
-            throw std::invalid_argument(Utils::stringf("lookahead value %f is too small for velocity %f. It must be at least %f", lookahead, velocity, command_period_dist));
-        if (getDistanceAccuracy() > lookahead)
-            throw std::invalid_argument(Utils::stringf("lookahead value %f is smaller than drone's distance accuracy %f.", lookahead, getDistanceAccuracy()));
-    }
-    else {
-        //if auto mode requested for lookahead then calculate based on velocity
-        lookahead = getAutoLookahead(velocity, adaptive_lookahead);
-        Utils::logMessage("lookahead = %f, adaptive_lookahead = %f", lookahead, adaptive_lookahead);        
-    }
-
-    //add current position as starting point
-    vector<Vector3r> path3d;
-    vector<PathSegment> path_segs;
-    path3d.push_back(getPosition());
-
-    std::ofstream flog;
-    if (log_to_file_) {
-        common_utils::FileSystem::createLogFile("MoveToPosition", flog);
-        flog << "seg_index\toffset\tx\ty\tz\tgoal_dist\tseg_index\toffset\tx\ty\tz\tlookahead\tlookahead_error\tseg_index\toffset\tx\ty\tz";
-    }
-
-    Vector3r point;
-    float path_length = 0;
-    //append the input path and compute segments
-    for(uint i = 0; i < path.size(); ++i) {
-        point = path.at(i);
-        PathSegment path_seg(path3d.at(i), point, velocity, path_length);
-        path_length += path_seg.seg_length;
-        path_segs.push_back(path_seg);
-        path3d.push_back(point);
-    }
-    //add last segment as zero length segment so we have equal number of segments and points. 
-    //path_segs[i] refers to segment that starts at point i
-    path_segs.push_back(PathSegment(point, point, velocity, path_length));
-
-    //when path ends, we want to slow down
-    float breaking_dist = 0;
-    if (velocity > getVehicleParams().breaking_vel) {
-        breaking_dist = std::max(velocity * getVehicleParams().vel_to_breaking_dist, getVehicleParams().min_vel_to_breaking_dist);
-    }
-    //else no need to change velocities for last segments
-
-    //setup current position on path to 0 offset
-    PathPosition cur_path_loc, next_path_loc;
-    cur_path_loc.seg_index = 0;
-    cur_path_loc.offset = 0;
-    cur_path_loc.position = path3d[0];
-
-    float lookahead_error_increasing = 0;
-    float lookahead_error = 0;
-    Waiter waiter(getCommandPeriod());
-
-    //initialize next path position
-    setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
-
-    while (next_path_loc.seg_index < path_segs.size()-1 || //until we are at the end of the path (last seg is always zero size)
-        ((next_path_loc.position - getPosition()).norm() > getDistanceAccuracy())) { //current position is approximately at the last end point
-
-        float seg_velocity = path_segs.at(next_path_loc.seg_index).seg_velocity;
-        float path_length_remaining = path_length - path_segs.at(cur_path_loc.seg_index).seg_path_length - cur_path_loc.offset;
-        if (path_length_remaining <= breaking_dist) {
-            seg_velocity = getVehicleParams().breaking_vel;
+        if (!is_started_) {
+            start();
+            is_started_ = true;
+        }
+        else
+            advance();
+
+        //until we are at the end of the path (last seg is always zero size) and
+        //current position is approximately at the last end point
+        if (next_path_loc_.seg_index >= path_segs_.size() - 1 &&
+            (next_path_loc_.position - controller_.getPosition()).norm() <= controller_.getDistanceAccuracy())
+            return true;
+
+        float seg_velocity = path_segs_.at(next_path_loc_.seg_index).seg_velocity;
+        float path_length_remaining = path_length_ - path_segs_.at(cur_path_loc_.seg_index).seg_path_length - cur_path_loc_.offset;
+        if (path_length_remaining <= breaking_dist_) {
+            seg_velocity = controller_.getVehicleParams().breaking_vel;
             //Utils::logMessage("path_length_remaining = %f, Switched to breaking vel %f", path_length_remaining, seg_velocity);
         }
 
         //send drone command to get to next lookahead
-        moveToPathPosition(next_path_loc.position, seg_velocity, drivetrain, 
-            yaw_mode, path_segs.at(cur_path_loc.seg_index).start_z);
+        controller_.moveToPathPosition(next_path_loc_.position, seg_velocity, drivetrain_,
+            yaw_mode_, path_segs_.at(cur_path_loc_.seg_index).start_z);
+        return false;
+    }
 
-        //sleep for rest of the cycle
-        if (!waiter.sleep(cancelable_action))
-            return false;
+private:
+    void start()
+    {
+        //add current position as starting point
+        path3d_.push_back(controller_.getPosition());
 
+        if (controller_.log_to_file_) {
+            common_utils::FileSystem::createLogFile("MoveToPosition", flog_);
+            flog_ << "seg_index\toffset\tx\ty\tz\tgoal_dist\tseg_index\toffset\tx\ty\tz\tlookahead\tlookahead_error\tseg_index\toffset\tx\ty\tz";
+        }
+
+        Vector3r point;
+        path_length_ = 0;
+        //append the input path and compute segments
+        for(uint i = 0; i < path_.size(); ++i) {
+            point = path_.at(i);
+            PathSegment path_seg(path3d_.at(i), point, velocity_, path_length_);
+            path_length_ += path_seg.seg_length;
+            path_segs_.push_back(path_seg);
+            path3d_.push_back(point);
+        }
+        //add last segment as zero length segment so we have equal number of segments and points. 
+        //path_segs[i] refers to segment that starts at point i
+        path_segs_.push_back(PathSegment(point, point, velocity_, path_length_));
+
+        //when path ends, we want to slow down
+        breaking_dist_ = 0;
+        const VehicleParams& params = controller_.getVehicleParams();
+        if (velocity_ > params.breaking_vel) {
+            breaking_dist_ = std::max(velocity_ * params.vel_to_breaking_dist, params.min_vel_to_breaking_dist);
+        }
+        //else no need to change velocities for last segments
+
+        //setup current position on path to 0 offset
+        cur_path_loc_.seg_index = 0;
+        cur_path_loc_.offset = 0;
+        cur_path_loc_.position = path3d_[0];
+
+        lookahead_error_increasing_ = 0;
+        lookahead_error_ = 0;
+
+        //initialize next path position
+        controller_.setNextPathPosition(path3d_, path_segs_, cur_path_loc_, lookahead_ + lookahead_error_, next_path_loc_);
+    }
+
+    void advance()
+    {
         /*  Below, P is previous position on path, N is next goal and C is our current position.
 
         N
@@ -214,50 +321,50 @@ bool DroneControllerBase::moveOnPath(const vector<Vector3r>& path, float velocit
         */
 
         //how much have we moved towards last goal?
-        const Vector3r& goal_vect = next_path_loc.position - cur_path_loc.position;
+        const Vector3r& goal_vect = next_path_loc_.position - cur_path_loc_.position;
 
         float goal_dist;
         if (!goal_vect.isZero()) { //goal can only be zero if we are at the end of path
-            const Vector3r& actual_vect = getPosition() - cur_path_loc.position;
+            const Vector3r& actual_vect = controller_.getPosition() - cur_path_loc_.position;
 
             //project actual vector on goal vector
             const Vector3r& goal_normalized = goal_vect.normalized();    
             goal_dist = actual_vect.dot(goal_normalized); //dist could be -ve if drone moves away from goal
 
                                                             //if adaptive lookahead is enabled the calculate lookahead error (see above fig)
-            if (adaptive_lookahead) {
+            if (adaptive_lookahead_) {
                 const Vector3r& actual_on_goal = goal_normalized * goal_dist;
-                float error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead;
-                if (error > lookahead_error) {
-                    lookahead_error_increasing++;
-                    if (lookahead_error_increasing > 100) {
+                float error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead_;
+                if (error > lookahead_error_) {
+                    lookahead_error_increasing_++;
+                    if (lookahead_error_increasing_ > 100) {
                         throw std::runtime_error("lookahead error is continually increasing so we do not have safe control, aborting moveOnPath operation");
                     }
                 }
                 else { 
-                    lookahead_error_increasing = 0; 
+                    lookahead_error_increasing_ = 0; 
                 }
-                lookahead_error = error;
+                lookahead_error_ = error;
             }
         }
         else {
-            lookahead_error_increasing = 0;
+            lookahead_error_increasing_ = 0;
             goal_dist = 0;
-            lookahead_error = 0; //this is not really required because we will exit
+            lookahead_error_ = 0; //this is not really required because we will exit
         }
 
         // Utils::logMessage("PF: cur=%s, goal_dist=%f, cur_path_loc=%s, next_path_loc=%s, lookahead_error=%f",
         //     VectorMath::toString(getPosition()).c_str(), goal_dist, VectorMath::toString(cur_path_loc.position).c_str(),
         //     VectorMath::toString(next_path_loc.position).c_str(), lookahead_error);
 
-        if (log_to_file_)
-            flog << cur_path_loc.seg_index << "\t" << cur_path_loc.offset << "\t" << cur_path_loc.position.x() << "\t" << cur_path_loc.position.y() << "\t" << cur_path_loc.position.z() << "\t" << goal_dist << "\t";
+        if (controller_.log_to_file_)
+            flog_ << cur_path_loc_.seg_index << "\t" << cur_path_loc_.offset << "\t" << cur_path_loc_.position.x() << "\t" << cur_path_loc_.position.y() << "\t" << cur_path_loc_.position.z() << "\t" << goal_dist << "\t";
 
         //if drone moved backward, we don't want goal to move backward as well
         //so only climb forward on the path, never back. Also note >= which means
         //we climb path even if distance was 0 to take care of duplicated points on path
         if (goal_dist >= 0) {
-            float overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, goal_dist, cur_path_loc);
+            float overshoot = controller_.setNextPathPosition(path3d_, path_segs_, cur_path_loc_, goal_dist, cur_path_loc_);
             if (overshoot)
                 Utils::logMessage("overshoot=%f", overshoot);
         }
@@ -265,48 +372,464 @@ bool DroneControllerBase::moveOnPath(const vector<Vector3r>& path, float velocit
         //    Utils::logMessage("goal_dist was negative: %f", goal_dist);
 
         //compute next target on path
-        setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
+        controller_.setNextPathPosition(path3d_, path_segs_, cur_path_loc_, lookahead_ + lookahead_error_, next_path_loc_);
 
-        if (log_to_file_) {
-            flog << cur_path_loc.seg_index << "\t" << cur_path_loc.offset << "\t" << cur_path_loc.position.x() << "\t" << cur_path_loc.position.y() << "\t" << cur_path_loc.position.z() << "\t" << lookahead  << "\t" << lookahead_error  << "\t";
-            flog << next_path_loc.seg_index << "\t" << next_path_loc.offset << "\t" << next_path_loc.position.x() << "\t" << next_path_loc.position.y() << "\t" << next_path_loc.position.z() << std::endl;
+        if (controller_.log_to_file_) {
+            flog_ << cur_path_loc_.seg_index << "\t" << cur_path_loc_.offset << "\t" << cur_path_loc_.position.x() << "\t" << cur_path_loc_.position.y() << "\t" << cur_path_loc_.position.z() << "\t" << lookahead_  << "\t" << lookahead_error_  << "\t";
+            flog_ << next_path_loc_.seg_index << "\t" << next_path_loc_.offset << "\t" << next_path_loc_.position.x() << "\t" << next_path_loc_.position.y() << "\t" << next_path_loc_.position.z() << std::endl;
         }
     }
 
-    return true;
+private:
+    DroneControllerBase& controller_;
+    vector<Vector3r> path_;
+    float velocity_;
+    DrivetrainType drivetrain_;
+    YawMode yaw_mode_;
+    float lookahead_, adaptive_lookahead_;
+    bool is_started_;
+
+    vector<Vector3r> path3d_;
+    vector<PathSegment> path_segs_;
+    float path_length_, breaking_dist_;
+    PathPosition cur_path_loc_, next_path_loc_;
+    float lookahead_error_increasing_, lookahead_error_;
+    std::ofstream flog_;
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveOnPathTask(const vector<Vector3r>& path, float velocity,
+    DrivetrainType drivetrain, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+{
+    return MotionTaskPtr(new PathTask(*this, path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead));
 }
 
-bool DroneControllerBase::moveToPosition(float x, float y, float z, float velocity, DrivetrainType drivetrain,
-    const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveToPositionTask(float x, float y, float z, float velocity,
+    DrivetrainType drivetrain, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
 {
     vector<Vector3r> path { Vector3r(x, y, z) };
-    return moveOnPath(path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead, cancelable_action);
+    return createMoveOnPathTask(path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead);
 }
 
-bool DroneControllerBase::moveToZ(float z, float velocity, const YawMode& yaw_mode,
+bool DroneControllerBase::moveOnPath(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode,
     float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
 {
-    Vector2r cur_xy = getPositionXY();
-    vector<Vector3r> path { Vector3r(cur_xy.x(), cur_xy.y(), z) };
-    return moveOnPath(path, velocity, DrivetrainType::MaxDegreeOfFreedome, yaw_mode, lookahead, adaptive_lookahead,
-        cancelable_action);
+    return runTask(*createMoveOnPathTask(path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead), cancelable_action);
 }
 
-bool DroneControllerBase::rotateToYaw(float yaw, float margin, CancelableBase& cancelable_action)
+bool DroneControllerBase::moveToPosition(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+    const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
 {
-    YawMode yaw_mode(false, VectorMath::normalizeAngleDegrees(yaw));
-    Waiter waiter(getCommandPeriod());
-    auto start_pos = getPosition();
-    bool is_yaw_reached;
-    while ((is_yaw_reached = isYawWithinMargin(yaw, margin)) == false) {
-        if (!moveToPosition(start_pos, yaw_mode))
+    return runTask(*createMoveToPositionTask(x, y, z, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead), cancelable_action);
+}
+
+/*
+    Passes cancellation through from the command and also cancels path
+    following when map changes block the part of planned path that is still
+    ahead, so moveToPositionPlanned can plan again. Path is in planner
+    coordinates. Check is only done when map version changed.
+*/
+class PlannedPathMonitor : public CancelableBase {
+public:
+    PlannedPathMonitor(CancelableBase& cancelable_action, DroneControllerBase& controller, PathPlanner& planner,
+        const Vector3r& offset, const Vector3r& start, const vector<Vector3r>& path)
+        : cancelable_action_(cancelable_action), controller_(controller), planner_(planner),
+        offset_(offset), start_(start), path_(path), checked_version_(planner.getVersion()), is_blocked_(false)
+    {
+    }
+
+    virtual bool isCancelled() override
+    {
+        return cancelable_action_.isCancelled() || isPathBlocked();
+    }
+
+    virtual void cancelAllTasks() override
+    {
+        cancelable_action_.cancelAllTasks();
+    }
+
+    bool isPathBlocked()
+    {
+        if (is_blocked_)
+            return true;
+
+        uint64_t version = planner_.getVersion();
+        if (version == checked_version_)
             return false;
+        checked_version_ = version;
 
-        if (!waiter.sleep(cancelable_action))
+        Vector3r position = controller_.getPosition() + offset_;
+        is_blocked_ = !planner_.isPathFree(position, path_, getNextWaypoint(position));
+        return is_blocked_;
+    }
+
+private:
+    //waypoint at the end of path segment closest to position
+    size_t getNextWaypoint(const Vector3r& position) const
+    {
+        size_t next = 0;
+        float min_dist = Utils::max<float>();
+        Vector3r from = start_;
+        for (size_t i = 0; i < path_.size(); ++i) {
+            Vector3r seg = path_[i] - from;
+            float seg_len_sq = seg.squaredNorm();
+            float t = seg_len_sq > 0 ? Utils::clip((position - from).dot(seg) / seg_len_sq, 0.0f, 1.0f) : 0;
+            float dist = (from + seg * t - position).norm();
+            if (dist < min_dist) {
+                min_dist = dist;
+                next = i;
+            }
+            from = path_[i];
+        }
+        return next;
+    }
+
+private:
+    CancelableBase& cancelable_action_;
+    DroneControllerBase& controller_;
+    PathPlanner& planner_;
+    Vector3r offset_, start_;
+    const vector<Vector3r>& path_;
+    uint64_t checked_version_;
+    bool is_blocked_;
+};
+
+void DroneControllerBase::setPathPlanner(const shared_ptr<PathPlanner> path_planner, const Vector3r& origin_offset,
+    const vector<Vector3r>& vehicle_origins)
+{
+    path_planner_ = path_planner;
+    path_planner_offset_ = origin_offset;
+    vehicle_origins_ = vehicle_origins;
+    multi_agent_planner_ = path_planner != nullptr ? std::make_shared<MultiAgentPlanner>(path_planner) : nullptr;
+}
+
+vector<Vector3r> DroneControllerBase::planPath(const Vector3r& goal)
+{
+    vector<Vector3r> path;
+    if (path_planner_ == nullptr)
+        return path;
+
+    if (path_planner_->planPath(getPosition() + path_planner_offset_, goal + path_planner_offset_, path)) {
+        for (auto& point : path)
+            point -= path_planner_offset_;
+    }
+    return path;
+}
+
+vector<MultiAgentPlanner::Trajectory> DroneControllerBase::planTrajectories(const vector<Vector3r>& starts, const vector<Vector3r>& goals,
+    float velocity, float separation)
+{
+    if (multi_agent_planner_ == nullptr)
+        throw std::invalid_argument("The planTrajectories call requires path planning to be enabled in settings");
+    if (starts.size() != goals.size())
+        throw std::invalid_argument(Utils::stringf("planTrajectories got %u starts but %u goals",
+            static_cast<uint>(starts.size()), static_cast<uint>(goals.size())));
+    if (velocity <= 0)
+        throw std::invalid_argument("velocity must be positive");
+
+    vector<MultiAgentPlanner::Agent> agents;
+    for (size_t i = 0; i < starts.size(); ++i)
+        agents.push_back(MultiAgentPlanner::Agent{ starts[i] + path_planner_offset_, goals[i] + path_planner_offset_ });
+
+    MultiAgentPlanner::Params params;
+    params.velocity = velocity;
+    params.separation = separation;
+    vector<MultiAgentPlanner::Trajectory> trajectories;
+    if (!multi_agent_planner_->plan(agents, params, trajectories))
+        Utils::logMessage("planTrajectories: %s", multi_agent_planner_->getLastStats().message.c_str());
+
+    for (auto& trajectory : trajectories) {
+        for (auto& position : trajectory.positions)
+            position -= path_planner_offset_;
+    }
+    return trajectories;
+}
+
+vector<Vector3r> DroneControllerBase::getVehicleOrigins()
+{
+    vector<Vector3r> origins;
+    if (path_planner_ == nullptr)
+        return origins;
+
+    for (const Vector3r& origin : vehicle_origins_)
+        origins.push_back(origin - path_planner_offset_);
+    return origins;
+}
+
+bool DroneControllerBase::moveToPositionPlanned(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+    const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
+{
+    static constexpr uint kMaxReplans = 20;
+
+    if (path_planner_ == nullptr)
+        throw std::invalid_argument("The moveToPositionPlanned call requires path planning to be enabled in settings");
+
+    const Vector3r goal = Vector3r(x, y, z) + path_planner_offset_;
+    vector<Vector3r> planned_path, path;
+    for (uint replans = 0; ; ++replans) {
+        Vector3r start = getPosition() + path_planner_offset_;
+        if (!path_planner_->planPath(start, goal, planned_path))
+            throw VehicleMoveException(Utils::stringf("Cannot plan path to (%f, %f, %f): %s", x, y, z,
+                path_planner_->getLastStats().message.c_str()));
+
+        path.clear();
+        for (const auto& point : planned_path)
+            path.push_back(point - path_planner_offset_);
+
+        PlannedPathMonitor monitor(cancelable_action, *this, *path_planner_, path_planner_offset_, start, planned_path);
+        if (moveOnPath(path, velocity, drivetrain, yaw_mode, lookahead, adaptive_lookahead, monitor))
+            return true;
+        if (cancelable_action.isCancelled() || !monitor.isPathBlocked())
             return false;
+
+        if (replans >= kMaxReplans)
+            throw VehicleMoveException(Utils::stringf("Path to (%f, %f, %f) got blocked %u times, giving up", x, y, z, replans + 1));
+        Utils::logMessage("Planned path got blocked by map change, planning again");
     }
+}
 
-    return true;
+//moveOnTrajectory: target moves along trajectory with time, after the end drone
+//gets the same time again to settle at the last point
+class DroneControllerBase::TrajectoryTask : public DroneControllerBase::MotionTask {
+public:
+    TrajectoryTask(DroneControllerBase& controller, const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), positions_(positions), step_sec_(step_sec),
+        yaw_mode_(yaw_mode), is_started_(false)
+    {
+        if (positions.size() == 0) {
+            Utils::logMessage("moveOnTrajectory terminated because trajectory has no points");
+            return;
+        }
+        if (step_sec <= 0)
+            throw std::invalid_argument("step_sec must be positive");
+
+        duration_ = step_sec * (positions.size() - 1);
+    }
+
+    virtual bool step() override
+    {
+        if (positions_.size() == 0)
+            return true;
+
+        MpcController* mpc = controller_.mpc_.get();
+        if (!is_started_) {
+            if (mpc != nullptr)
+                mpc->reset();
+            start_time_ = controller_.clock()->nowNanos();
+            is_started_ = true;
+        }
+
+        float elapsed = static_cast<float>(controller_.clock()->elapsedSince(start_time_));
+        if (mpc != nullptr) {
+            //MPC gives acceleration, velocity setpoint is where it wants to be after one prediction step
+            float dt = mpc->getParams().dt;
+            for (int k = 0; k < MpcController::Horizon; ++k)
+                reference_[k] = getTrajectoryPosition(positions_, step_sec_, elapsed + (k + 1) * dt);
+            Vector3r velocity = controller_.getVelocity();
+            Vector3r accel = mpc->solve(controller_.getPosition(), velocity, reference_);
+            Vector3r velocity_setpoint = velocity + accel * dt;
+            controller_.moveByVelocity(velocity_setpoint.x(), velocity_setpoint.y(), velocity_setpoint.z(),
+                DrivetrainType::MaxDegreeOfFreedome, yaw_mode_);
+        }
+        else
+            controller_.moveToPosition(getTrajectoryPosition(positions_, step_sec_, elapsed), DrivetrainType::MaxDegreeOfFreedome, yaw_mode_);
+
+        if (elapsed >= duration_) {
+            if ((controller_.getPosition() - positions_.back()).norm() <= controller_.getDistanceAccuracy())
+                return true;
+            if (elapsed >= 2 * duration_ + 1)
+                throw VehicleMoveException("moveOnTrajectory could not reach the end of trajectory");
+        }
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    vector<Vector3r> positions_;
+    float step_sec_, duration_;
+    YawMode yaw_mode_;
+    bool is_started_;
+    TTimePoint start_time_;
+    Vector3r reference_[MpcController::Horizon];
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveOnTrajectoryTask(const vector<Vector3r>& positions, float step_sec,
+    const YawMode& yaw_mode)
+{
+    return MotionTaskPtr(new TrajectoryTask(*this, positions, step_sec, yaw_mode));
+}
+
+bool DroneControllerBase::moveOnTrajectory(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode,
+    CancelableBase& cancelable_action)
+{
+    return runTask(*createMoveOnTrajectoryTask(positions, step_sec, yaw_mode), cancelable_action);
+}
+
+Vector3r DroneControllerBase::getTrajectoryPosition(const vector<Vector3r>& positions, float step_sec, float time_sec)
+{
+    float t = time_sec / step_sec;
+    size_t index = std::min(static_cast<size_t>(t), positions.size() - 1);
+    if (index + 1 >= positions.size())
+        return positions.back();
+    return positions[index] + (positions[index + 1] - positions[index]) * (t - index);
+}
+
+void DroneControllerBase::enableMpc(const MpcController::Params& params)
+{
+    mpc_.reset(new MpcController(params, getCommandPeriod()));
+}
+
+const MpcController* DroneControllerBase::getMpcController() const
+{
+    return mpc_.get();
+}
+
+string DroneControllerBase::getReport()
+{
+    return "";
+}
+
+bool DroneControllerBase::setVelocitySetpoint(const Vector3r& velocity, const YawMode& yaw_mode)
+{
+    return moveByVelocity(velocity.x(), velocity.y(), velocity.z(), DrivetrainType::MaxDegreeOfFreedome, yaw_mode);
+}
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createMoveToZTask(float z, float velocity, const YawMode& yaw_mode,
+    float lookahead, float adaptive_lookahead)
+{
+    Vector2r cur_xy = getPositionXY();
+    vector<Vector3r> path { Vector3r(cur_xy.x(), cur_xy.y(), z) };
+    return createMoveOnPathTask(path, velocity, DrivetrainType::MaxDegreeOfFreedome, yaw_mode, lookahead, adaptive_lookahead);
+}
+
+bool DroneControllerBase::moveToZ(float z, float velocity, const YawMode& yaw_mode,
+    float lookahead, float adaptive_lookahead, CancelableBase& cancelable_action)
+{
+    return runTask(*createMoveToZTask(z, velocity, yaw_mode, lookahead, adaptive_lookahead), cancelable_action);
+}
+
+//hold position where the task starts while turning to yaw
+class DroneControllerBase::RotateToYawTask : public DroneControllerBase::MotionTask {
+public:
+    RotateToYawTask(DroneControllerBase& controller, float yaw, float margin)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), yaw_(yaw), margin_(margin),
+        yaw_mode_(false, VectorMath::normalizeAngleDegrees(yaw)), is_started_(false)
+    {
+    }
+
+    virtual bool step() override
+    {
+        if (!is_started_) {
+            start_pos_ = controller_.getPosition();
+            is_started_ = true;
+        }
+        if (controller_.isYawWithinMargin(yaw_, margin_))
+            return true;
+
+        controller_.moveToPosition(start_pos_, DrivetrainType::MaxDegreeOfFreedome, yaw_mode_);
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    float yaw_, margin_;
+    YawMode yaw_mode_;
+    bool is_started_;
+    Vector3r start_pos_;
+};
+
+class DroneControllerBase::RotateByYawRateTask : public DroneControllerBase::MotionTask {
+public:
+    RotateByYawRateTask(DroneControllerBase& controller, float yaw_rate, float duration)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), yaw_mode_(true, yaw_rate), duration_(duration),
+        is_started_(false)
+    {
+    }
+
+    virtual bool step() override
+    {
+        if (!is_started_) {
+            if (duration_ <= 0)
+                return true;
+            start_pos_ = controller_.getPosition();
+            start_time_ = controller_.clock()->nowNanos();
+            is_started_ = true;
+        }
+        else if (controller_.clock()->elapsedSince(start_time_) >= duration_)
+            return true;
+
+        controller_.moveToPosition(start_pos_, DrivetrainType::MaxDegreeOfFreedome, yaw_mode_);
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    YawMode yaw_mode_;
+    float duration_;
+    bool is_started_;
+    Vector3r start_pos_;
+    TTimePoint start_time_;
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createRotateToYawTask(float yaw, float margin)
+{
+    return MotionTaskPtr(new RotateToYawTask(*this, yaw, margin));
+}
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createRotateByYawRateTask(float yaw_rate, float duration)
+{
+    return MotionTaskPtr(new RotateByYawRateTask(*this, yaw_rate, duration));
+}
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createHoverTask()
+{
+    return createMoveToZTask(getZ(), 0.5f, YawMode{ true,0 }, 1.0f, false);
+}
+
+//climb straight up from where the task starts, holding heading
+class DroneControllerBase::TakeoffTask : public DroneControllerBase::MotionTask {
+public:
+    TakeoffTask(DroneControllerBase& controller, float max_wait_seconds)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), max_wait_seconds_(max_wait_seconds),
+        is_started_(false)
+    {
+    }
+
+    virtual bool step() override
+    {
+        if (!is_started_) {
+            target_ = controller_.getPosition();
+            target_.z() += controller_.getTakeoffZ();
+            start_time_ = controller_.clock()->nowNanos();
+            is_started_ = true;
+        }
+
+        float cur_z = controller_.getZ();
+        if (std::abs(cur_z - target_.z()) <= controller_.getDistanceAccuracy())
+            return true;
+        if (controller_.clock()->elapsedSince(start_time_) >= max_wait_seconds_)
+            throw VehicleMoveException(Utils::stringf("Drone hasn't reached takeoff z of %f within time %f sec (current z = %f)",
+                target_.z(), max_wait_seconds_, cur_z));
+
+        controller_.moveToPosition(target_, DrivetrainType::MaxDegreeOfFreedome, YawMode(true, 0));
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    float max_wait_seconds_;
+    bool is_started_;
+    Vector3r target_;
+    TTimePoint start_time_;
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createTakeoffTask(float max_wait_seconds)
+{
+    return MotionTaskPtr(new TakeoffTask(*this, max_wait_seconds));
+}
+
+bool DroneControllerBase::rotateToYaw(float yaw, float margin, CancelableBase& cancelable_action)
+{
+    return runTask(*createRotateToYawTask(yaw, margin), cancelable_action);
 }
 
 bool DroneControllerBase::rotateByYawRate(float yaw_rate, float duration, CancelableBase& cancelable_action)
@@ -314,41 +837,33 @@ bool DroneControllerBase::rotateByYawRate(float yaw_rate, float duration, Cancel
     if (duration <= 0)
         return true;
 
-    auto start_pos = getPosition();
-    YawMode yaw_mode(true, yaw_rate);
-    Waiter waiter(getCommandPeriod(), duration);
-    do {
-        if (!moveToPosition(start_pos, yaw_mode))
-            return false;
-    } while (waiter.sleep(cancelable_action) && !waiter.is_timeout());
-
-    return waiter.is_timeout();
+    return runTask(*createRotateByYawRateTask(yaw_rate, duration), cancelable_action);
 }
 
 bool DroneControllerBase::hover(CancelableBase& cancelable_action)
 {
-    return moveToZ(getZ(), 0.5f, YawMode{ true,0 }, 1.0f, false, cancelable_action);
+    return runTask(*createHoverTask(), cancelable_action);
 }
 
-bool DroneControllerBase::moveByVelocity(float vx, float vy, float vz, const YawMode& yaw_mode)
+bool DroneControllerBase::moveByVelocity(float vx, float vy, float vz, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
-    if (safetyCheckVelocity(Vector3r(vx, vy, vz)))
+    if (safetyCheckVelocity(Vector3r(vx, vy, vz), drivetrain, yaw_mode))
         commandVelocity(vx, vy, vz, yaw_mode);
 
     return true;
 }
 
-bool DroneControllerBase::moveByVelocityZ(float vx, float vy, float z, const YawMode& yaw_mode)
+bool DroneControllerBase::moveByVelocityZ(float vx, float vy, float z, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
-    if (safetyCheckVelocityZ(vx, vy, z))
+    if (safetyCheckVelocityZ(vx, vy, z, drivetrain, yaw_mode))
         commandVelocityZ(vx, vy, z, yaw_mode);
 
     return true;
 }
 
-bool DroneControllerBase::moveToPosition(const Vector3r& dest, const YawMode& yaw_mode)
+bool DroneControllerBase::moveToPosition(const Vector3r& dest, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
-    if (safetyCheckDestination(dest))
+    if (safetyCheckDestination(dest, drivetrain, yaw_mode))
         commandPosition(dest.x(), dest.y(), dest.z(), yaw_mode);
 
     return true;
@@ -356,7 +871,7 @@ bool DroneControllerBase::moveToPosition(const Vector3r& dest, const YawMode& ya
 
 bool DroneControllerBase::moveByRollPitchZ(float pitch, float roll, float z, float yaw)
 {
-    if (safetyCheckVelocity(getVelocity()))
+    if (safetyCheckVelocity(getVelocity(), DrivetrainType::MaxDegreeOfFreedome, YawMode(false, yaw)))
         commandRollPitchZ(pitch, roll, z, yaw);
 
     return true;
@@ -431,7 +946,7 @@ bool DroneControllerBase::moveByManual(float vx_max, float vy_max, float z_min,
             //execute command
             try {
                 float vz = (rc_data.throttle / kMaxRCValue) * z_min + getZ();
-                moveByVelocityZ(vel_body.x(), vel_body.y(), vz, adj_yaw_mode);
+                moveByVelocityZ(vel_body.x(), vel_body.y(), vz, drivetrain, adj_yaw_mode);
             }
             catch(const DroneControllerBase::UnsafeMoveException& ex) {
                 Utils::logError("Safety violation: %s", ex.result.message.c_str());
@@ -475,23 +990,52 @@ bool DroneControllerBase::waitForFunction(WaitFunction function, float max_wait_
     return found;
 }
 
-bool DroneControllerBase::waitForZ(float max_wait_seconds, float z, float margin, CancelableBase& cancelable_action)
-{
-    float cur_z = 100000;
-    if (!waitForFunction([&]() {
-        cur_z = getZ();
-        return (std::abs(cur_z - z) <= margin);
-    }, max_wait_seconds, cancelable_action))
+class DroneControllerBase::WaitForZTask : public DroneControllerBase::MotionTask {
+public:
+    WaitForZTask(DroneControllerBase& controller, float max_wait_seconds, float z, float margin)
+        : MotionTask(controller.getCommandPeriod()), controller_(controller), max_wait_seconds_(max_wait_seconds), z_(z), margin_(margin),
+        is_started_(false)
     {
-        //Only raise exception is time out occurred. If preempted then return status.
-        throw VehicleMoveException(Utils::stringf("Drone hasn't came to expected z of %f within time %f sec within error margin %f (current z = %f)",
-            z, max_wait_seconds, margin, cur_z));
     }
-    return true;
+
+    virtual bool step() override
+    {
+        if (!is_started_) {
+            start_time_ = controller_.clock()->nowNanos();
+            is_started_ = true;
+        }
+
+        float cur_z = controller_.getZ();
+        if (max_wait_seconds_ >= 0 && std::abs(cur_z - z_) <= margin_)
+            return true;
+
+        //only raise exception if time out occurred, if preempted then runTask returns status
+        if (max_wait_seconds_ < 0 || controller_.clock()->elapsedSince(start_time_) >= max_wait_seconds_)
+            throw VehicleMoveException(Utils::stringf("Drone hasn't came to expected z of %f within time %f sec within error margin %f (current z = %f)",
+                z_, max_wait_seconds_, margin_, cur_z));
+        return false;
+    }
+
+private:
+    DroneControllerBase& controller_;
+    float max_wait_seconds_, z_, margin_;
+    bool is_started_;
+    TTimePoint start_time_;
+};
+
+DroneControllerBase::MotionTaskPtr DroneControllerBase::createWaitForZTask(float max_wait_seconds, float z, float margin)
+{
+    return MotionTaskPtr(new WaitForZTask(*this, max_wait_seconds, z, margin));
+}
+
+bool DroneControllerBase::waitForZ(float max_wait_seconds, float z, float margin, CancelableBase& cancelable_action)
+{
+    return runTask(*createWaitForZTask(max_wait_seconds, z, margin), cancelable_action);
 }
 
 
-bool DroneControllerBase::emergencyManeuverIfUnsafe(const SafetyEval::EvalResult& result)
+bool DroneControllerBase::emergencyManeuverIfUnsafe(const SafetyEval::EvalResult& result, const Vector3r& heading,
+    DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
     if (!result.is_safe) {
         if (result.reason == SafetyEval::SafetyViolationType_::Obstacle) {
@@ -508,6 +1052,17 @@ bool DroneControllerBase::emergencyManeuverIfUnsafe(const SafetyEval::EvalResult
             }
             //other wise throw exception
         }
+        else if (result.reason == SafetyEval::SafetyViolationType_::Reciprocal) {
+            //yield to other vehicles with the unchecked command, same velocity comes back while they are in the way;
+            //forward only drones keep facing where they fly, so yaw is turned from planned heading to avoidance velocity
+            YawMode avoidance_yaw_mode = yaw_mode;
+            if (drivetrain == DrivetrainType::ForwardOnly && !yaw_mode.is_rate) {
+                avoidance_yaw_mode.yaw_or_rate -= std::atan2(heading.y(), heading.x()) * 180 / M_PIf;
+                adjustYaw(result.avoidance_vel, drivetrain, avoidance_yaw_mode);
+            }
+            commandVelocity(result.avoidance_vel.x(), result.avoidance_vel.y(), result.avoidance_vel.z(), avoidance_yaw_mode);
+            return false;
+        }
         //otherwise there is some other reason why we are in unsafe situation
         //send last command to come to full stop
         commandVelocity(0, 0, 0, YawMode::Zero());
@@ -518,29 +1073,30 @@ bool DroneControllerBase::emergencyManeuverIfUnsafe(const SafetyEval::EvalResult
     return true;
 }
 
-bool DroneControllerBase::safetyCheckVelocity(const Vector3r& velocity)
+bool DroneControllerBase::safetyCheckVelocity(const Vector3r& velocity, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
     if (safety_eval_ptr_ == nullptr) //safety checks disabled
         return true;
 
     const auto& result = safety_eval_ptr_->isSafeVelocity(getPosition(), velocity, getOrientation());
-    return emergencyManeuverIfUnsafe(result);
+    return emergencyManeuverIfUnsafe(result, velocity, drivetrain, yaw_mode);
 }
-bool DroneControllerBase::safetyCheckVelocityZ(float vx, float vy, float z)
+bool DroneControllerBase::safetyCheckVelocityZ(float vx, float vy, float z, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
     if (safety_eval_ptr_ == nullptr) //safety checks disabled
         return true;
 
     const auto& result = safety_eval_ptr_->isSafeVelocityZ(getPosition(), vx, vy, z, getOrientation());
-    return emergencyManeuverIfUnsafe(result);
+    return emergencyManeuverIfUnsafe(result, Vector3r(vx, vy, 0), drivetrain, yaw_mode);
 }
-bool DroneControllerBase::safetyCheckDestination(const Vector3r& dest_pos)
+bool DroneControllerBase::safetyCheckDestination(const Vector3r& dest_pos, DrivetrainType drivetrain, const YawMode& yaw_mode)
 {
     if (safety_eval_ptr_ == nullptr) //safety checks disabled
         return true;
 
-    const auto& result = safety_eval_ptr_->isSafeDestination(getPosition(), dest_pos, getOrientation());
-    return emergencyManeuverIfUnsafe(result);
+    const Vector3r cur_pos = getPosition();
+    const auto& result = safety_eval_ptr_->isSafeDestination(cur_pos, dest_pos, getOrientation());
+    return emergencyManeuverIfUnsafe(result, dest_pos - cur_pos, drivetrain, yaw_mode);
 }    
 
 void DroneControllerBase::logHomePoint()
@@ -640,9 +1196,9 @@ void DroneControllerBase::moveToPathPosition(const Vector3r& dest, float velocit
     //send commands
     //try to maintain altitude if path was in XY plan only, velocity based control is not as good
     if (std::abs(cur.z() - dest.z()) <= getDistanceAccuracy()) //for paths in XY plan current code leaves z untouched, so we can compare with strict equality
-        moveByVelocityZ(velocity_vect.x(), velocity_vect.y(), dest.z(), yaw_mode);
+        moveByVelocityZ(velocity_vect.x(), velocity_vect.y(), dest.z(), drivetrain, yaw_mode);
     else
-        moveByVelocity(velocity_vect.x(), velocity_vect.y(), velocity_vect.z(), yaw_mode);
+        moveByVelocity(velocity_vect.x(), velocity_vect.y(), velocity_vect.z(), drivetrain, yaw_mode);
 }
 
 bool DroneControllerBase::isYawWithinMargin(float yaw_target, float margin)
@@ -671,18 +1227,69 @@ DroneControllerBase::ImageType DroneControllerBase::getImageTypeForCamera(int ca
     return ImageType::None;
 }
 
+void DroneControllerBase::setImageRateForCamera(int camera_id, ImageType type, float rate)
+{
+    StatusLock lock(this);
+
+    image_rates[camera_id][type] = std::max(rate, 0.0f);
+}
+
+float DroneControllerBase::getImageRateForCamera(int camera_id, ImageType type)
+{
+    StatusLock lock(this);
+
+    auto it = image_rates.find(camera_id);
+    if (it != image_rates.end()) {
+        auto it2 = it->second.find(type);
+        if (it2 != it->second.end())
+            return it2->second;
+    }
+    return 0;
+}
+
+void DroneControllerBase::getImageRequests(vector<ImageRequest>& requests)
+{
+    StatusLock lock(this);
+
+    static const ImageType single_types[] = { ImageType::Scene, ImageType::Depth, ImageType::Segmentation };
+
+    requests.clear();
+    for (const auto& enabled : enabled_images) {
+        for (ImageType type : single_types) {
+            if ((static_cast<uint>(enabled.second) & static_cast<uint>(type)) != 0)
+                requests.push_back(ImageRequest{ enabled.first, type, getImageRateForCamera(enabled.first, type) });
+        }
+    }
+}
+
 void DroneControllerBase::setImageForCamera(int camera_id, ImageType type, const vector<uint8_t>& image)
 {
     StatusLock lock(this);
 
-    //TODO: perf work
-    auto it = images.find(camera_id);
-    if (it != images.end())
-        (it->second)[type] = image;
-    
-    auto new_list = EnumClassUnorderedMap<ImageType, vector<uint8_t>>();
-    new_list[type] = image;
-    images[camera_id] = new_list;
+    //each camera may have several image types so only replace this one
+    images[camera_id][type] = image;
+}
+
+void DroneControllerBase::setImageForCamera(int camera_id, ImageType type, const uint8_t* data, size_t size)
+{
+    StatusLock lock(this);
+
+    //assign reuses capacity of the previous image of this type
+    images[camera_id][type].assign(data, data + size);
+}
+
+void DroneControllerBase::setDetections(const TargetDetector::Detection* data, size_t count)
+{
+    StatusLock lock(this);
+
+    detections.assign(data, data + count);
+}
+
+vector<TargetDetector::Detection> DroneControllerBase::getDetections()
+{
+    StatusLock lock(this);
+
+    return detections;
 }
 
 vector<uint8_t> DroneControllerBase::getImageForCamera(int camera_id, ImageType type)
@@ -12,6 +12,7 @@
 #include <memory>
 #include <exception>
 #include "controllers/PidController.hpp"
+#include "common/StartupProfiler.hpp"
 #include "MavLinkMessages.hpp"
 #include "MavLinkConnection.hpp"
 #include "MavLinkNode.hpp"
@@ -23,6 +24,8 @@
 #include "sensors/imu/ImuBase.hpp"
 #include "sensors/gps/GpsBase.hpp"
 #include "sensors/magnetometer/MagnetometerBase.hpp"
+#include "sensors/distance/DistanceBase.hpp"
+#include "sensors/opticalflow/OpticalFlowBase.hpp"
 
 namespace msr { namespace airlib {
 
@@ -36,6 +39,10 @@ static const int pixhawkFMUV2OldBootloaderProductId = 22;     ///< Product ID fo
 static const int pixhawkFMUV1ProductId = 16;     ///< Product ID for PX4 FMU V1 board
 static const int RotorControlsCount = 8;
 
+//serial port enumeration is slow so result of auto detection is kept for process lifetime
+static std::mutex pixhawk_port_mutex;
+static std::string pixhawk_port_cache;
+
 class MavLinkLogViewerLog : public MavLinkLog
 {
     std::shared_ptr<mavlinkcom::MavLinkNode> proxy_;
@@ -91,6 +98,7 @@ struct MavLinkDroneController::impl {
     bool actuators_message_supported_;
     const SensorCollection* sensors_;    //this is optional
     uint64_t last_gps_time_;
+    TTimePoint last_distance_time_, last_optical_flow_time_;
     bool was_reset_;
     Pose debug_pose_;
 
@@ -252,7 +260,17 @@ struct MavLinkDroneController::impl {
         }
     }
 
-    static std::string findPixhawk()
+    static std::string findPixhawk(bool use_cache = true)
+    {
+        std::lock_guard<std::mutex> guard(pixhawk_port_mutex);
+        if (!use_cache || pixhawk_port_cache == "") {
+            StartupProfiler::Scope profile("MavLink serial port enumeration");
+            pixhawk_port_cache = findPixhawkPort();
+        }
+        return pixhawk_port_cache;
+    }
+
+    static std::string findPixhawkPort()
     {
         auto result = MavLinkConnection::findSerialPorts(0, 0);
         for (auto iter = result.begin(); iter != result.end(); iter++)
@@ -325,7 +343,8 @@ struct MavLinkDroneController::impl {
         close();
 
         std::string port_name_auto = port_name;
-        if (port_name_auto == "" || port_name_auto == "*") {
+        bool is_auto_port = port_name_auto == "" || port_name_auto == "*";
+        if (is_auto_port) {
             port_name_auto = findPixhawk();
             if (port_name_auto == "") {
                 throw std::domain_error("Could not find a connected PX4 flight controller");
@@ -340,7 +359,20 @@ struct MavLinkDroneController::impl {
             throw std::invalid_argument("SerialBaudRate has an invalid value");
         }
 
-        connection_ = MavLinkConnection::connectSerial("hil", port_name_auto, baud_rate);
+        try {
+            connection_ = MavLinkConnection::connectSerial("hil", port_name_auto, baud_rate);
+        }
+        catch (const std::exception&) {
+            if (!is_auto_port)
+                throw;
+
+            //board may have been re-plugged on different port since we last enumerated
+            port_name_auto = findPixhawk(false);
+            if (port_name_auto == "") {
+                throw std::domain_error("Could not find a connected PX4 flight controller");
+            }
+            connection_ = MavLinkConnection::connectSerial("hil", port_name_auto, baud_rate);
+        }
         connection_->ignoreMessage(MavLinkAttPosMocap::kMessageId); //TODO: find better way to communicate debug pose instead of using fake Mocap messages
         hil_node_ = std::make_shared<MavLinkNode>(connection_info_.sim_sysid, connection_info_.sim_compid);
         hil_node_->connect(connection_);
@@ -512,6 +544,50 @@ struct MavLinkDroneController::impl {
         last_gps_message_ = hil_gps;
     }
 
+    void sendDistanceSensor(const DistanceBase::Output& output)
+    {
+        if (!is_simulation_mode_)
+            throw std::logic_error("Attempt to send simulated distance sensor messages while not in simulation mode");
+
+        mavlinkcom::MavLinkDistanceSensor distance_sensor;
+        distance_sensor.time_boot_ms = static_cast<uint32_t>(Utils::getTimeSinceEpochNanos() / 1.0E6);
+        distance_sensor.min_distance = static_cast<uint16_t>(output.min_distance * 100);
+        distance_sensor.max_distance = static_cast<uint16_t>(output.max_distance * 100);
+        distance_sensor.current_distance = static_cast<uint16_t>(output.distance * 100);
+        distance_sensor.type = 0;           //MAV_DISTANCE_SENSOR_LASER
+        distance_sensor.id = 0;
+        distance_sensor.orientation = 25;   //MAV_SENSOR_ROTATION_PITCH_270, i.e. facing down
+        distance_sensor.covariance = 0;     //unknown
+
+        if (hil_node_ != nullptr) {
+            hil_node_->sendMessage(distance_sensor);
+        }
+    }
+
+    void sendHILOpticalFlow(const OpticalFlowBase::Output& output)
+    {
+        if (!is_simulation_mode_)
+            throw std::logic_error("Attempt to send simulated optical flow messages while not in simulation mode");
+
+        mavlinkcom::MavLinkHilOpticalFlow hil_optical_flow;
+        hil_optical_flow.time_usec = static_cast<uint64_t>(Utils::getTimeSinceEpochNanos() / 1000.0);
+        hil_optical_flow.sensor_id = 0;
+        hil_optical_flow.integration_time_us = static_cast<uint32_t>(output.integration_time * 1E6);
+        hil_optical_flow.integrated_x = output.integrated_x;
+        hil_optical_flow.integrated_y = output.integrated_y;
+        hil_optical_flow.integrated_xgyro = output.integrated_gyro.x();
+        hil_optical_flow.integrated_ygyro = output.integrated_gyro.y();
+        hil_optical_flow.integrated_zgyro = output.integrated_gyro.z();
+        hil_optical_flow.temperature = 2000;  //centi-degrees
+        hil_optical_flow.quality = output.quality;
+        hil_optical_flow.time_delta_distance_us = 0;
+        hil_optical_flow.distance = output.distance;
+
+        if (hil_node_ != nullptr) {
+            hil_node_->sendMessage(hil_optical_flow);
+        }
+    }
+
     real_T getVertexControlSignal(unsigned int rotor_index)
     {
         if (!is_simulation_mode_)
@@ -529,6 +605,7 @@ struct MavLinkDroneController::impl {
         hil_state_freq_ = -1;
         actuators_message_supported_ = false;
         last_gps_time_ = 0;
+        last_distance_time_ = last_optical_flow_time_ = 0;
         state_version_ = 0;
         current_state = mavlinkcom::VehicleState();
         target_height_ = 0;
@@ -565,6 +642,14 @@ struct MavLinkDroneController::impl {
     {
         return static_cast<const GpsBase*>(sensors_->getByType(SensorCollection::SensorType::Gps));
     }
+    const DistanceBase* getDistance()
+    {
+        return static_cast<const DistanceBase*>(sensors_->getByType(SensorCollection::SensorType::Distance));
+    }
+    const OpticalFlowBase* getOpticalFlow()
+    {
+        return static_cast<const OpticalFlowBase*>(sensors_->getByType(SensorCollection::SensorType::OpticalFlow));
+    }
 
     void update()
     {
@@ -604,6 +689,18 @@ struct MavLinkDroneController::impl {
             }
         }
 
+        //distance and flow are sent only when sensors produced new samples
+        const auto distance = getDistance();
+        if (distance != nullptr && distance->getOutput().time_stamp > last_distance_time_) {
+            last_distance_time_ = distance->getOutput().time_stamp;
+            sendDistanceSensor(distance->getOutput());
+        }
+        const auto optical_flow = getOpticalFlow();
+        if (optical_flow != nullptr && optical_flow->getOutput().time_stamp > last_optical_flow_time_) {
+            last_optical_flow_time_ = optical_flow->getOutput().time_stamp;
+            sendHILOpticalFlow(optical_flow->getOutput());
+        }
+
         //must be done at the end
         if (was_reset_)
             was_reset_ = false;
@@ -615,7 +712,7 @@ struct MavLinkDroneController::impl {
         std::lock_guard<std::mutex> guard(status_text_mutex_);
 
         while (!status_messages_.empty()) {
-            messages.push_back(status_messages_.front());
+            messages.push_back(std::move(status_messages_.front()));
             status_messages_.pop();
         }
     }
@@ -630,9 +727,15 @@ struct MavLinkDroneController::impl {
         close(); //just in case if connections were open
         resetState(); //reset all variables we might have changed during last session
 
-        connect();
-        connectToLogViewer();
-        connectToQGC();
+        {
+            StartupProfiler::Scope profile("MavLink connection");
+            connect();
+        }
+        {
+            StartupProfiler::Scope profile("MavLink log viewer and QGC proxies");
+            connectToLogViewer();
+            connectToQGC();
+        }
 
     }
     void stop()
@@ -113,6 +113,44 @@ bool RpcLibClient::moveToPosition(float x, float y, float z, float velocity, Dri
     return pimpl_->client.call("moveToPosition", x, y, z, velocity, drivetrain, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<bool>();
 }
 
+bool RpcLibClient::moveToPositionPlanned(float x, float y, float z, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+{
+    return pimpl_->client.call("moveToPositionPlanned", x, y, z, velocity, drivetrain, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<bool>();
+}
+
+vector<Vector3r> RpcLibClient::planPath(const Vector3r& goal)
+{
+    vector<Vector3r> path;
+    RpcLibAdapators::to(pimpl_->client.call("planPath", RpcLibAdapators::Vector3r(goal)).as<vector<RpcLibAdapators::Vector3r>>(), path);
+    return path;
+}
+
+vector<MultiAgentPlanner::Trajectory> RpcLibClient::planTrajectories(const vector<Vector3r>& starts, const vector<Vector3r>& goals,
+    float velocity, float separation)
+{
+    vector<RpcLibAdapators::Vector3r> conv_starts, conv_goals;
+    RpcLibAdapators::from(starts, conv_starts);
+    RpcLibAdapators::from(goals, conv_goals);
+    vector<MultiAgentPlanner::Trajectory> trajectories;
+    RpcLibAdapators::to(pimpl_->client.call("planTrajectories", conv_starts, conv_goals, velocity, separation)
+        .as<vector<RpcLibAdapators::Trajectory>>(), trajectories);
+    return trajectories;
+}
+
+vector<Vector3r> RpcLibClient::getVehicleOrigins()
+{
+    vector<Vector3r> origins;
+    RpcLibAdapators::to(pimpl_->client.call("getVehicleOrigins").as<vector<RpcLibAdapators::Vector3r>>(), origins);
+    return origins;
+}
+
+bool RpcLibClient::moveOnTrajectory(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode)
+{
+    vector<RpcLibAdapators::Vector3r> conv_positions;
+    RpcLibAdapators::from(positions, conv_positions);
+    return pimpl_->client.call("moveOnTrajectory", conv_positions, step_sec, RpcLibAdapators::YawMode(yaw_mode)).as<bool>();
+}
+
 bool RpcLibClient::moveToZ(float z, float velocity, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
 {
     return pimpl_->client.call("moveToZ", z, velocity, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<bool>();
@@ -138,6 +176,77 @@ bool RpcLibClient::hover()
     return pimpl_->client.call("hover").as<bool>();
 }
 
+CommandEngine::Handle RpcLibClient::moveByVelocityAsync(float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
+{
+    return pimpl_->client.call("moveByVelocityAsync", vx, vy, vz, duration, drivetrain, RpcLibAdapators::YawMode(yaw_mode)).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::moveByVelocityZAsync(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
+{
+    return pimpl_->client.call("moveByVelocityZAsync", vx, vy, z, duration, drivetrain, RpcLibAdapators::YawMode(yaw_mode)).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::moveOnPathAsync(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+{
+    vector<RpcLibAdapators::Vector3r> conv_path;
+    RpcLibAdapators::from(path, conv_path);
+    return pimpl_->client.call("moveOnPathAsync", conv_path, velocity, drivetrain, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::moveToPositionAsync(float x, float y, float z, float velocity, DrivetrainType drivetrain,
+    const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+{
+    return pimpl_->client.call("moveToPositionAsync", x, y, z, velocity, drivetrain, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::moveOnTrajectoryAsync(const vector<Vector3r>& positions, float step_sec, const YawMode& yaw_mode)
+{
+    vector<RpcLibAdapators::Vector3r> conv_positions;
+    RpcLibAdapators::from(positions, conv_positions);
+    return pimpl_->client.call("moveOnTrajectoryAsync", conv_positions, step_sec, RpcLibAdapators::YawMode(yaw_mode)).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::moveToZAsync(float z, float velocity, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead)
+{
+    return pimpl_->client.call("moveToZAsync", z, velocity, RpcLibAdapators::YawMode(yaw_mode), lookahead, adaptive_lookahead).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::rotateToYawAsync(float yaw, float margin)
+{
+    return pimpl_->client.call("rotateToYawAsync", yaw, margin).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::rotateByYawRateAsync(float yaw_rate, float duration)
+{
+    return pimpl_->client.call("rotateByYawRateAsync", yaw_rate, duration).as<CommandEngine::Handle>();
+}
+
+CommandEngine::Handle RpcLibClient::hoverAsync()
+{
+    return pimpl_->client.call("hoverAsync").as<CommandEngine::Handle>();
+}
+
+CommandEngine::Status RpcLibClient::getCommandStatus(CommandEngine::Handle handle, string* message)
+{
+    auto result = pimpl_->client.call("getCommandStatus", handle).as<RpcLibAdapators::CommandResult>();
+    if (message != nullptr)
+        *message = result.message;
+    return result.status;
+}
+
+CommandEngine::Status RpcLibClient::waitForCommand(CommandEngine::Handle handle, float timeout_sec, string* message)
+{
+    auto result = pimpl_->client.call("waitForCommand", handle, timeout_sec).as<RpcLibAdapators::CommandResult>();
+    if (message != nullptr)
+        *message = result.message;
+    return result.status;
+}
+
+bool RpcLibClient::cancelCommand(CommandEngine::Handle handle)
+{
+    return pimpl_->client.call("cancelCommand", handle).as<bool>();
+}
+
 bool RpcLibClient::setSafety(SafetyEval::SafetyViolationType enable_reasons, float obs_clearance, SafetyEval::ObsAvoidanceStrategy obs_startegy,
     float obs_avoidance_vel, const Vector3r& origin, float xy_length, float max_z, float min_z)
 {
@@ -206,12 +315,29 @@ DroneControllerBase::ImageType RpcLibClient::getImageTypeForCamera(int camera_id
     return pimpl_->client.call("getImageTypeForCamera", camera_id).as<DroneControllerBase::ImageType>();
 }
 
+void RpcLibClient::setImageRateForCamera(int camera_id, DroneControllerBase::ImageType type, float rate)
+{
+    pimpl_->client.call("setImageRateForCamera", camera_id, type, rate);
+}
+
+float RpcLibClient::getImageRateForCamera(int camera_id, DroneControllerBase::ImageType type)
+{
+    return pimpl_->client.call("getImageRateForCamera", camera_id, type).as<float>();
+}
+
 //get/set image
 vector<uint8_t> RpcLibClient::getImageForCamera(int camera_id, DroneControllerBase::ImageType type)
 {
     return pimpl_->client.call("getImageForCamera", camera_id, type).as<vector<uint8_t>>();
 }
 
+vector<TargetDetector::Detection> RpcLibClient::getDetections()
+{
+    vector<TargetDetector::Detection> detections;
+    RpcLibAdapators::to(pimpl_->client.call("getDetections").as<vector<RpcLibAdapators::Detection>>(), detections);
+    return detections;
+}
+
 
 }} //namespace
 
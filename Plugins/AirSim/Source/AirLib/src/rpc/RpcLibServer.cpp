@@ -68,6 +68,34 @@ RpcLibServer::RpcLibServer(DroneControllerCancelable* drone, string server_addre
     pimpl_->server.bind("moveToPosition", [&](float x, float y, float z, float velocity, DrivetrainType drivetrain,
         const RpcLibAdapators::YawMode& yaw_mode, float lookahead, float adaptive_lookahead) -> 
         bool { return drone_->moveToPosition(x, y, z, velocity, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead); });
+    pimpl_->server.bind("moveToPositionPlanned", [&](float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const RpcLibAdapators::YawMode& yaw_mode, float lookahead, float adaptive_lookahead) -> 
+        bool { return drone_->moveToPositionPlanned(x, y, z, velocity, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead); });
+    pimpl_->server.bind("planPath", [&](const RpcLibAdapators::Vector3r& goal) -> vector<RpcLibAdapators::Vector3r> {
+        vector<RpcLibAdapators::Vector3r> conv_path;
+        RpcLibAdapators::from(drone_->planPath(goal.to()), conv_path);
+        return conv_path;
+    });
+    pimpl_->server.bind("planTrajectories", [&](const vector<RpcLibAdapators::Vector3r>& starts, const vector<RpcLibAdapators::Vector3r>& goals,
+        float velocity, float separation) -> vector<RpcLibAdapators::Trajectory> {
+        vector<Vector3r> conv_starts, conv_goals;
+        RpcLibAdapators::to(starts, conv_starts);
+        RpcLibAdapators::to(goals, conv_goals);
+        vector<RpcLibAdapators::Trajectory> conv_trajectories;
+        RpcLibAdapators::from(drone_->planTrajectories(conv_starts, conv_goals, velocity, separation), conv_trajectories);
+        return conv_trajectories;
+    });
+    pimpl_->server.bind("getVehicleOrigins", [&]() -> vector<RpcLibAdapators::Vector3r> {
+        vector<RpcLibAdapators::Vector3r> conv_origins;
+        RpcLibAdapators::from(drone_->getVehicleOrigins(), conv_origins);
+        return conv_origins;
+    });
+    pimpl_->server.bind("moveOnTrajectory", [&](const vector<RpcLibAdapators::Vector3r>& positions, float step_sec,
+        const RpcLibAdapators::YawMode& yaw_mode) -> bool {
+        vector<Vector3r> conv_positions;
+        RpcLibAdapators::to(positions, conv_positions);
+        return drone_->moveOnTrajectory(conv_positions, step_sec, yaw_mode.to());
+    });
     pimpl_->server.bind("moveToZ", [&](float z, float velocity, const RpcLibAdapators::YawMode& yaw_mode, float lookahead, float adaptive_lookahead) -> 
         bool { return drone_->moveToZ(z, velocity, yaw_mode.to(), lookahead, adaptive_lookahead); });
     pimpl_->server.bind("moveByManual", [&](float vx_max, float vy_max, float z_min, DrivetrainType drivetrain, const RpcLibAdapators::YawMode& yaw_mode, float duration) -> 
@@ -79,13 +107,68 @@ RpcLibServer::RpcLibServer(DroneControllerCancelable* drone, string server_addre
         bool { return drone_->rotateByYawRate(yaw_rate, duration); });
     pimpl_->server.bind("hover", [&]() -> bool { return drone_->hover(); });
 
+    //non-blocking move commands return handle right away, see CommandEngine
+    pimpl_->server.bind("moveByVelocityAsync", [&](float vx, float vy, float vz, float duration, DrivetrainType drivetrain,
+        const RpcLibAdapators::YawMode& yaw_mode) -> CommandEngine::Handle {
+        return drone_->moveByVelocityAsync(vx, vy, vz, duration, drivetrain, yaw_mode.to());
+    });
+    pimpl_->server.bind("moveByVelocityZAsync", [&](float vx, float vy, float z, float duration, DrivetrainType drivetrain,
+        const RpcLibAdapators::YawMode& yaw_mode) -> CommandEngine::Handle {
+        return drone_->moveByVelocityZAsync(vx, vy, z, duration, drivetrain, yaw_mode.to());
+    });
+    pimpl_->server.bind("moveOnPathAsync", [&](const vector<RpcLibAdapators::Vector3r>& path, float velocity, DrivetrainType drivetrain,
+        const RpcLibAdapators::YawMode& yaw_mode, float lookahead, float adaptive_lookahead) -> CommandEngine::Handle {
+        vector<Vector3r> conv_path;
+        RpcLibAdapators::to(path, conv_path);
+        return drone_->moveOnPathAsync(conv_path, velocity, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
+    });
+    pimpl_->server.bind("moveToPositionAsync", [&](float x, float y, float z, float velocity, DrivetrainType drivetrain,
+        const RpcLibAdapators::YawMode& yaw_mode, float lookahead, float adaptive_lookahead) -> CommandEngine::Handle {
+        return drone_->moveToPositionAsync(x, y, z, velocity, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
+    });
+    pimpl_->server.bind("moveOnTrajectoryAsync", [&](const vector<RpcLibAdapators::Vector3r>& positions, float step_sec,
+        const RpcLibAdapators::YawMode& yaw_mode) -> CommandEngine::Handle {
+        vector<Vector3r> conv_positions;
+        RpcLibAdapators::to(positions, conv_positions);
+        return drone_->moveOnTrajectoryAsync(conv_positions, step_sec, yaw_mode.to());
+    });
+    pimpl_->server.bind("moveToZAsync", [&](float z, float velocity, const RpcLibAdapators::YawMode& yaw_mode, float lookahead,
+        float adaptive_lookahead) -> CommandEngine::Handle {
+        return drone_->moveToZAsync(z, velocity, yaw_mode.to(), lookahead, adaptive_lookahead);
+    });
+    pimpl_->server.bind("rotateToYawAsync", [&](float yaw, float margin) -> CommandEngine::Handle {
+        return drone_->rotateToYawAsync(yaw, margin);
+    });
+    pimpl_->server.bind("rotateByYawRateAsync", [&](float yaw_rate, float duration) -> CommandEngine::Handle {
+        return drone_->rotateByYawRateAsync(yaw_rate, duration);
+    });
+    pimpl_->server.bind("hoverAsync", [&]() -> CommandEngine::Handle { return drone_->hoverAsync(); });
+    pimpl_->server.bind("getCommandStatus", [&](CommandEngine::Handle handle) -> RpcLibAdapators::CommandResult {
+        RpcLibAdapators::CommandResult result;
+        result.status = drone_->getCommandStatus(handle, &result.message);
+        return result;
+    });
+    pimpl_->server.bind("waitForCommand", [&](CommandEngine::Handle handle, float timeout_sec) -> RpcLibAdapators::CommandResult {
+        RpcLibAdapators::CommandResult result;
+        result.status = drone_->waitForCommand(handle, timeout_sec, &result.message);
+        return result;
+    });
+    pimpl_->server.bind("cancelCommand", [&](CommandEngine::Handle handle) -> bool { return drone_->cancelCommand(handle); });
+
     pimpl_->server.bind("setSafety", [&](uint enable_reasons, float obs_clearance, SafetyEval::ObsAvoidanceStrategy obs_startegy,
         float obs_avoidance_vel, const RpcLibAdapators::Vector3r& origin, float xy_length, float max_z, float min_z) -> 
         bool { return drone_->setSafety(SafetyEval::SafetyViolationType(enable_reasons), obs_clearance, obs_startegy,
             obs_avoidance_vel, origin.to(), xy_length, max_z, min_z); });
     pimpl_->server.bind("setImageTypeForCamera", [&](int camera_id, DroneControllerBase::ImageType type) -> void { drone_->setImageTypeForCamera(camera_id, type); });
     pimpl_->server.bind("getImageTypeForCamera", [&](int camera_id) -> DroneControllerBase::ImageType { return drone_->getImageTypeForCamera(camera_id); });
+    pimpl_->server.bind("setImageRateForCamera", [&](int camera_id, DroneControllerBase::ImageType type, float rate) -> void { drone_->setImageRateForCamera(camera_id, type, rate); });
+    pimpl_->server.bind("getImageRateForCamera", [&](int camera_id, DroneControllerBase::ImageType type) -> float { return drone_->getImageRateForCamera(camera_id, type); });
     pimpl_->server.bind("getImageForCamera", [&](int camera_id, DroneControllerBase::ImageType type) -> vector<uint8_t> { return drone_->getImageForCamera(camera_id, type); });
+    pimpl_->server.bind("getDetections", [&]() -> vector<RpcLibAdapators::Detection> {
+        vector<RpcLibAdapators::Detection> conv_detections;
+        RpcLibAdapators::from(drone_->getDetections(), conv_detections);
+        return conv_detections;
+    });
 
 
     //getters
@@ -9,6 +9,7 @@
 #endif
 
 #include "safety/SafetyEval.hpp"
+#include "safety/ReciprocalAvoidance.hpp"
 
 #include <cmath>
 #include <sstream>
@@ -34,9 +35,8 @@ void SafetyEval::checkFence(const Vector3r& dest_pos, const Vector3r& cur_pos, S
     if (!allow) {
         appendToResult.is_safe = false;
         appendToResult.reason |= SafetyViolationType_::GeoFence;
-        appendToResult.message.append(
-            common_utils::Utils::stringf("Destination %s is outside geo fence and is worse off than current %s in geofence=[%s]",
-                VectorMath::toString(dest_pos).c_str(), VectorMath::toString(cur_pos).c_str(), fence_ptr_->toString().c_str()));
+        appendToResult.message.appendf("Destination (%f, %f, %f) is outside geo fence and is worse off than current (%f, %f, %f)",
+            dest_pos.x(), dest_pos.y(), dest_pos.z(), cur_pos.x(), cur_pos.y(), cur_pos.z());
     }
 }
 
@@ -77,8 +77,7 @@ void SafetyEval::isCurrentSafer(SafetyEval::EvalResult& result)
     if (!isThisRiskDistLess(result.cur_risk_dist, result.dest_risk_dist)) {
         result.is_safe = false;
         result.reason |= SafetyViolationType_::Obstacle;
-        result.message.append(
-            common_utils::Utils::stringf("Current position is safer"));
+        result.message.append("Current position is safer");
     }
     //else we are better of moving to dest
 }
@@ -141,10 +140,8 @@ void SafetyEval::isSafeDestination(const Vector3r& dest_pos, const Vector3r& cur
 float SafetyEval::adjustClearanceForPrStl(float base_clearance, float obs_confidence)
 {
     //3.2 comes from inverse CDF for epsilone = 0.05 (i.e. 95% confidence), author: akapoor
-    float additional_clearance = (1 - obs_confidence) * 3.2f;   
-    if (additional_clearance != 0)
-        Utils::logMessage("additional_clearance=%f", additional_clearance);
-
+    //not logged: depth mapped obstacles are never fully certain, so this runs with nonzero clearance on every check
+    float additional_clearance = (1 - obs_confidence) * 3.2f;
     return base_clearance + additional_clearance;
 }
 
@@ -198,10 +195,29 @@ SafetyEval::EvalResult SafetyEval::isSafeVelocityZ(const Vector3r& cur_pos, floa
 
     //check if dest_pos is safe
     isSafeDestination(dest_pos, cur_pos, quaternion, result);
+
+    //altitude error closed in a second is good enough as preferred climb rate
+    checkReciprocal(Vector3r(vx, vy, z - cur_pos.z()), result);
  
     return result;
 }
 
+void SafetyEval::checkReciprocal(const Vector3r& velocity, SafetyEval::EvalResult& result)
+{
+    //other violations are handled first
+    if (!result.is_safe || !(enable_reasons_ & SafetyViolationType_::Reciprocal) || reciprocal_ptr_ == nullptr)
+        return;
+
+    Vector3r avoidance_vel = reciprocal_ptr_->getSafeVelocity(reciprocal_agent_, velocity);
+    if ((avoidance_vel - velocity).norm() > vehicle_params_.distance_accuracy) {
+        result.is_safe = false;
+        result.reason |= SafetyViolationType_::Reciprocal;
+        result.avoidance_vel = avoidance_vel;
+        result.message.appendf("Velocity (%f, %f, %f) changed to (%f, %f, %f) to avoid other vehicles",
+            velocity.x(), velocity.y(), velocity.z(), avoidance_vel.x(), avoidance_vel.y(), avoidance_vel.z());
+    }
+}
+
 Vector3r SafetyEval::getDestination(const Vector3r& cur_pos, const Vector3r& velocity) const
 {
     //breaking distance at this velocity
@@ -222,6 +238,8 @@ SafetyEval::EvalResult SafetyEval::isSafeVelocity(const Vector3r& cur_pos, const
 
     //check if dest_pos is safe
     isSafeDestination(dest_pos, cur_pos, quaternion, result);
+
+    checkReciprocal(velocity, result);
  
     return result;
 }
@@ -250,6 +268,15 @@ SafetyEval::ObsAvoidanceStrategy SafetyEval::getObsAvoidanceStrategy()
 {
     return obs_strategy_;
 }
+SafetyEval::SafetyViolationType SafetyEval::getEnableReasons() const
+{
+    return enable_reasons_;
+}
+void SafetyEval::setReciprocalAvoidance(shared_ptr<ReciprocalAvoidance> reciprocal_ptr, uint agent)
+{
+    reciprocal_ptr_ = reciprocal_ptr;
+    reciprocal_agent_ = agent;
+}
 
 
 }} //namespace
@@ -94,6 +94,11 @@ public class AirSim : ModuleRules
             //typically gets installed with Visual Studio
             PublicAdditionalLibraries.Add("xinput9_1_0.lib");
         }
+        else if (Target.Platform == UnrealTargetPlatform.Linux)
+        {
+            // dlopen for controller plugins
+            PublicAdditionalLibraries.Add("dl");
+        }
     }
 
     private bool LoadAirSimDependency(TargetInfo Target, string LibName, string LibFileName)
@@ -232,9 +232,8 @@ bool ACameraDirector::togglePIPAll()
 
 APIPCamera* ACameraDirector::getCamera(int id)
 {
-    //TODO: support multiple camera
     if (TargetPawn != nullptr)
-        return TargetPawn->getFpvCamera();
+        return TargetPawn->getCamera(id);
     else
         return nullptr;
 }
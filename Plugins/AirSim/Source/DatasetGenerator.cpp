@@ -0,0 +1,587 @@
+#include "AirSim.h"
+#include "DatasetGenerator.h"
+#include "AirBlueprintLib.h"
+#include "ImageUtils.h"
+#include "Engine/DirectionalLight.h"
+#include "Components/LightComponent.h"
+#include "common/ClockFactory.hpp"
+#include "common/common_utils/FileSystem.hpp"
+#include <sstream>
+#include <iomanip>
+
+namespace {
+    typedef msr::airlib::DatasetSampler DatasetSampler;
+
+    DatasetSampler::Params toSamplerParams(const DatasetGenerator::Settings& settings, uint32_t seed)
+    {
+        DatasetSampler::Params params;
+        params.seed = seed;
+        float half_size = settings.area_size / 2;
+        params.position_min = msr::airlib::Vector3r(-half_size, -half_size, -settings.max_altitude);
+        params.position_max = msr::airlib::Vector3r(half_size, half_size, -settings.min_altitude);
+        params.pitch_min = settings.pitch_min_deg;
+        params.pitch_max = settings.pitch_max_deg;
+        params.fov_min = settings.fov_min_deg;
+        params.fov_max = settings.fov_max_deg;
+        params.exposure_min = settings.exposure_min;
+        params.exposure_max = settings.exposure_max;
+        params.randomize_light = settings.randomize_light;
+        params.light_intensity_min = settings.light_intensity_min;
+        params.light_intensity_max = settings.light_intensity_max;
+        return params;
+    }
+
+    //one image of a slot, copied on GPU from its render target in to a CPU readable staging texture
+    struct CopyRequest {
+        FTextureRenderTargetResource* resource;
+        FTexture2DRHIRef* staging;              //render thread only, recreated when target changes
+    };
+
+    //staging texture of an image, mapped once its copy is done and copied in to the writer frame
+    struct MapRequest {
+        FTexture2DRHIRef* staging;
+        std::vector<uint8_t>* data;
+    };
+
+    void copyOnRenderThread(FRHICommandListImmediate& RHICmdList, const CopyRequest& request)
+    {
+        const FTexture2DRHIRef& source = request.resource->GetRenderTargetTexture();
+        FTexture2DRHIRef& staging = *request.staging;
+        if (!staging.IsValid() || staging->GetSizeX() != source->GetSizeX() || staging->GetSizeY() != source->GetSizeY()
+            || staging->GetFormat() != source->GetFormat()) {
+            FRHIResourceCreateInfo create_info;
+            staging = RHICreateTexture2D(source->GetSizeX(), source->GetSizeY(), source->GetFormat(), 1, 1, TexCreate_CPUReadback, create_info);
+        }
+        //only queues the copy, GPU does it while next frame renders
+        RHICmdList.CopyToResolveTarget(source, staging, false, FResolveParams());
+    }
+
+    void mapOnRenderThread(FRHICommandListImmediate& RHICmdList, const MapRequest& request)
+    {
+        FTexture2DRHIRef& staging = *request.staging;
+        const int32 width = staging->GetSizeX(), height = staging->GetSizeY();
+        void* mapped = nullptr;
+        int32 pitch = 0, rows = 0;  //pitch is row length in pixels
+        RHICmdList.MapStagingSurface(staging, mapped, pitch, rows);
+        if (mapped == nullptr) {
+            request.data->clear();
+            return;
+        }
+
+        const uint8* bytes = static_cast<const uint8*>(mapped);
+        const int32 pixel_bytes = GPixelFormats[staging->GetFormat()].BlockBytes;
+        if (staging->GetFormat() == PF_FloatRGBA) {
+            //half floats are widened so depth records are always Rgba32F
+            request.data->resize(static_cast<size_t>(width) * height * sizeof(FLinearColor));
+            FLinearColor* out = reinterpret_cast<FLinearColor*>(request.data->data());
+            for (int32 r = 0; r < height; ++r) {
+                const FFloat16Color* row = reinterpret_cast<const FFloat16Color*>(bytes + static_cast<size_t>(r) * pitch * pixel_bytes);
+                for (int32 c = 0; c < width; ++c)
+                    out[r * width + c] = FLinearColor(row[c]);
+            }
+        }
+        else {
+            request.data->resize(static_cast<size_t>(width) * height * pixel_bytes);
+            for (int32 r = 0; r < height; ++r) {
+                FMemory::Memcpy(request.data->data() + static_cast<size_t>(r) * width * pixel_bytes,
+                    bytes + static_cast<size_t>(r) * pitch * pixel_bytes, width * pixel_bytes);
+            }
+        }
+        RHICmdList.UnmapStagingSurface(staging);
+    }
+}
+
+DatasetGenerator::DatasetGenerator(const Settings& settings)
+    : settings_(settings), is_flight_(settings.mode == "Flight"), fpv_pawn_(nullptr), camera_(nullptr), spawned_camera_(nullptr),
+    controller_(nullptr), flight_handle_(0), saved_camera_types_(EPIPCameraType::PIP_CAMERA_TYPE_NONE), light_(nullptr), light_intensity_(0),
+    sampler_(toSamplerParams(settings, settings.seed)), waypoint_sampler_(toSamplerParams(settings, settings.seed + 1)),
+    slot_count_(0), next_slot_(0), is_started_(false), is_sampling_done_(false), is_finished_(false), tick_count_(0),
+    posed_count_(0), captured_count_(0), failed_count_(0), writer_stall_count_(0)
+{
+    if (settings.scene)
+        image_types_.push_back(EPIPCameraType::PIP_CAMERA_TYPE_SCENE);
+    if (settings.depth)
+        image_types_.push_back(EPIPCameraType::PIP_CAMERA_TYPE_DEPTH);
+    if (settings.segmentation)
+        image_types_.push_back(EPIPCameraType::PIP_CAMERA_TYPE_SEG);
+}
+
+DatasetGenerator::~DatasetGenerator()
+{
+    stop();
+}
+
+bool DatasetGenerator::start(AVehiclePawnBase* fpv_pawn, UClass* camera_class, msr::airlib::DroneControllerBase* controller,
+    std::shared_ptr<msr::airlib::CommandEngine> command_engine)
+{
+    if (fpv_pawn == nullptr || image_types_.size() == 0) {
+        UAirBlueprintLib::LogMessage(TEXT("Dataset generation needs a vehicle and at least one image type"), TEXT(""), LogDebugLevel::Failure);
+        return false;
+    }
+    fpv_pawn_ = fpv_pawn;
+
+    EPIPCameraType types = EPIPCameraType::PIP_CAMERA_TYPE_NONE;
+    for (EPIPCameraType type : image_types_)
+        types |= type;
+
+    if (is_flight_) {
+        camera_ = fpv_pawn->getCamera(settings_.camera_id);
+        if (camera_ == nullptr || controller == nullptr || command_engine == nullptr) {
+            UAirBlueprintLib::LogMessage(TEXT("Dataset Flight mode needs FPV vehicle camera "), FString::FromInt(settings_.camera_id),
+                LogDebugLevel::Failure);
+            return false;
+        }
+        controller_ = controller;
+        command_engine_ = command_engine;
+        saved_camera_types_ = camera_->getEnableCameraTypes();
+        saved_captures_.clear();
+        for (EPIPCameraType type : image_types_) {
+            USceneCaptureComponent2D* capture = camera_->getCaptureComponent(type, false);
+            if (capture != nullptr) {
+                saved_captures_.push_back(SavedCapture{ capture, capture->FOVAngle,
+                    capture->PostProcessSettings.bOverride_AutoExposureBias != 0, capture->PostProcessSettings.AutoExposureBias });
+            }
+        }
+        //capture components only render in PIP view
+        camera_->setEnableCameraTypes(saved_camera_types_ | types);
+        camera_->setToPIPView();
+    }
+    else {
+        FActorSpawnParameters spawn_params;
+        spawn_params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        spawned_camera_ = fpv_pawn->GetWorld()->SpawnActor<APIPCamera>(camera_class, fpv_pawn->GetActorTransform(), spawn_params);
+        if (spawned_camera_ == nullptr) {
+            UAirBlueprintLib::LogMessage(TEXT("Cannot spawn dataset camera"), TEXT(""), LogDebugLevel::Failure);
+            return false;
+        }
+        camera_ = spawned_camera_;
+        camera_->setEnableCameraTypes(types);
+        camera_->useOwnRenderTargets(settings_.width, settings_.height);
+        camera_->setToPIPView();
+    }
+
+    DatasetWriter::Params writer_params;
+    writer_params.encoder_threads = settings_.encoder_threads;
+    //frames in slots come from the same pool
+    writer_params.max_frames = settings_.max_queued_frames + settings_.pipeline_depth;
+    writer_params.chunk_bytes = static_cast<uint64_t>(settings_.chunk_mb) * 1024 * 1024;
+    writer_.reset(new DatasetWriter(writer_params));
+
+    std::string base_path = common_utils::FileSystem::getLogFileNamePath(settings_.file_prefix, "", "", true);
+    bool compress = settings_.compress;
+    try {
+        writer_->open(base_path, DatasetSampler::getValueNames(), [compress](DatasetWriter::Image& image, std::vector<uint8_t>& scratch) {
+            encodeImage(image, scratch, compress);
+        });
+        if (settings_.segmentation)
+            labelObjects(base_path + "_labels.tsv");
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("Cannot create dataset: "), FString(ex.what()), LogDebugLevel::Failure);
+        writer_.reset();
+        if (spawned_camera_ != nullptr) {
+            spawned_camera_->Destroy();
+            spawned_camera_ = nullptr;
+        }
+        return false;
+    }
+
+    setupLight();
+
+    slot_count_ = static_cast<uint>(settings_.pipeline_depth);
+    slots_.reset(new Slot[slot_count_]);
+    next_slot_ = 0;
+    readback_times_.initialize(100);
+    capture_intervals_.initialize(100);
+    start_time_ = last_capture_time_ = WallClock::now();
+    is_started_ = true;
+
+    UAirBlueprintLib::LogMessage(TEXT("Dataset generation started: "), FString(base_path.c_str()), LogDebugLevel::Informational, 30);
+    return true;
+}
+
+void DatasetGenerator::tick()
+{
+    if (!is_started_)
+        return;
+    ++tick_count_;
+
+    finishReadbacks(false);
+
+    //pose set on last tick has been rendered, queue its readback ahead of rendering of this tick
+    for (uint i = 0; i < slot_count_; ++i) {
+        Slot& slot = slots_[i];
+        if (slot.state == SlotState::Posed && slot.posed_tick < tick_count_)
+            startReadback(slot);
+    }
+
+    if (is_sampling_done_) {
+        bool is_idle = true;
+        for (uint i = 0; i < slot_count_; ++i)
+            is_idle = is_idle && slots_[i].state == SlotState::Free;
+        if (is_idle)
+            stop();
+        return;
+    }
+
+    if (is_flight_)
+        updateFlight();
+    poseNextFrame();
+}
+
+void DatasetGenerator::stop()
+{
+    if (!is_started_)
+        return;
+    is_started_ = false;
+
+    //posed frames have no readback yet, drop them; frames being read back are waited for
+    for (uint i = 0; i < slot_count_; ++i) {
+        Slot& slot = slots_[i];
+        if (slot.state == SlotState::Posed) {
+            writer_->release(slot.frame);
+            slot.frame = nullptr;
+            slot.state = SlotState::Free;
+        }
+    }
+    finishReadbacks(true);
+
+    if (flight_handle_ != 0 && command_engine_ != nullptr)
+        command_engine_->cancel(flight_handle_);
+    flight_handle_ = 0;
+
+    writer_->close();
+    msr::airlib::Utils::logMessage("%s", getReport().c_str());
+    UAirBlueprintLib::LogMessage(TEXT("Dataset frames written: "), FString::FromInt(static_cast<int32>(writer_->getWrittenCount())),
+        LogDebugLevel::Success, 30);
+
+    if (light_ != nullptr) {
+        light_->SetActorRotation(light_rotation_);
+        light_->GetLightComponent()->SetIntensity(light_intensity_);
+        light_ = nullptr;
+    }
+    if (spawned_camera_ != nullptr) {
+        spawned_camera_->Destroy();
+        spawned_camera_ = nullptr;
+    }
+    else if (camera_ != nullptr) {
+        for (const SavedCapture& saved : saved_captures_) {
+            saved.capture->FOVAngle = saved.fov;
+            saved.capture->PostProcessSettings.bOverride_AutoExposureBias = saved.is_exposure_overridden;
+            saved.capture->PostProcessSettings.AutoExposureBias = saved.exposure;
+        }
+        saved_captures_.clear();
+        camera_->setEnableCameraTypes(saved_camera_types_);
+    }
+    camera_ = nullptr;
+    is_finished_ = true;
+}
+
+bool DatasetGenerator::isFinished() const
+{
+    return is_finished_;
+}
+
+std::string DatasetGenerator::getReport() const
+{
+    if (writer_ == nullptr)
+        return std::string();
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "Dataset: " << captured_count_;
+    if (settings_.frames > 0)
+        ss << "/" << settings_.frames;
+    ss << " frames";
+    if (capture_intervals_.size() > 0 && capture_intervals_.mean() > 0)
+        ss << ", " << 1 / capture_intervals_.mean() << " frames/s";
+    double elapsed = std::chrono::duration<double>(last_capture_time_ - start_time_).count();
+    if (elapsed > 0)
+        ss << " (" << captured_count_ / elapsed << " overall)";
+    if (readback_times_.size() > 0)
+        ss << ", readback " << readback_times_.mean() * 1E3 << " ms";
+    ss << ", writer stalls " << writer_stall_count_ << ", queued " << writer_->getQueuedCount();
+    if (failed_count_ > 0)
+        ss << ", " << failed_count_ << " failed";
+    ss << std::endl;
+    ss << writer_->getReport();
+    return ss.str();
+}
+
+void DatasetGenerator::labelObjects(const std::string& file_path)
+{
+    //stencil is 8 bit with 0 as background
+    static constexpr int max_labels = 255;
+
+    TArray<AActor*> actors;
+    UAirBlueprintLib::FindAllActor<AActor>(fpv_pawn_, actors);
+    TArray<AActor*> labelled;
+    for (AActor* actor : actors) {
+        TArray<UMeshComponent*> meshes;
+        actor->GetComponents<UMeshComponent>(meshes);
+        if (meshes.Num() > 0)
+            labelled.Add(actor);
+    }
+
+    //one id per actor while they fit, otherwise one id per actor class so no id means two different things
+    bool is_per_class = labelled.Num() > max_labels;
+    TMap<FString, int> class_ids;
+    std::ofstream file;
+    common_utils::FileSystem::createTextFile(file_path, file);
+    file << (is_per_class ? "id\tclass\n" : "id\tactor\n");
+
+    for (int i = 0; i < labelled.Num(); ++i) {
+        AActor* actor = labelled[i];
+        int id;
+        if (is_per_class) {
+            FString class_name = actor->GetClass()->GetName();
+            const int* class_id = class_ids.Find(class_name);
+            if (class_id != nullptr)
+                id = *class_id;
+            else {
+                id = class_ids.Num() % max_labels + 1;
+                class_ids.Add(class_name, id);
+                file << id << "\t" << TCHAR_TO_UTF8(*class_name) << "\n";
+            }
+        }
+        else {
+            id = i + 1;
+            file << id << "\t" << TCHAR_TO_UTF8(*actor->GetName()) << "\n";
+        }
+
+        TArray<UMeshComponent*> meshes;
+        actor->GetComponents<UMeshComponent>(meshes);
+        for (UMeshComponent* mesh : meshes) {
+            mesh->SetRenderCustomDepth(true);
+            mesh->SetCustomDepthStencilValue(id);
+        }
+    }
+
+    if (is_per_class) {
+        UAirBlueprintLib::LogMessage(TEXT("Dataset segmentation: "), FString::Printf(TEXT("%d objects exceed %d stencil ids, labelled by class"),
+            labelled.Num(), max_labels), LogDebugLevel::Failure, 30);
+    }
+    if (class_ids.Num() > max_labels) {
+        UAirBlueprintLib::LogMessage(TEXT("Dataset segmentation: "), FString::Printf(TEXT("%d classes exceed %d stencil ids, some ids are shared"),
+            class_ids.Num(), max_labels), LogDebugLevel::Failure, 30);
+    }
+}
+
+void DatasetGenerator::setupLight()
+{
+    light_ = nullptr;
+    if (!settings_.randomize_light)
+        return;
+
+    TArray<AActor*> lights;
+    UAirBlueprintLib::FindAllActor<ADirectionalLight>(fpv_pawn_, lights);
+    if (lights.Num() == 0)
+        return;
+
+    light_ = static_cast<ADirectionalLight*>(lights[0]);
+    light_rotation_ = light_->GetActorRotation();
+    light_intensity_ = light_->GetLightComponent()->Intensity;
+    //static and stationary lights can't be moved at runtime
+    light_->GetLightComponent()->SetMobility(EComponentMobility::Movable);
+}
+
+void DatasetGenerator::applySample(const DatasetSampler::Sample& sample)
+{
+    if (!is_flight_)
+        camera_->SetActorLocationAndRotation(fpv_pawn_->toNeuUU(sample.position), AVehiclePawnBase::toFQuat(sample.orientation, true));
+
+    for (EPIPCameraType type : image_types_) {
+        USceneCaptureComponent2D* capture = camera_->getCaptureComponent(type, true);
+        if (capture == nullptr)
+            continue;
+        //all image types get same FOV so labels line up with scene
+        capture->FOVAngle = sample.fov;
+        if (type == EPIPCameraType::PIP_CAMERA_TYPE_SCENE) {
+            capture->PostProcessSettings.bOverride_AutoExposureBias = true;
+            capture->PostProcessSettings.AutoExposureBias = sample.exposure;
+        }
+    }
+
+    if (light_ != nullptr && !std::isnan(sample.light_pitch)) {
+        light_->SetActorRotation(FRotator(sample.light_pitch, sample.light_yaw, 0));
+        light_->GetLightComponent()->SetIntensity(sample.light_intensity);
+    }
+}
+
+void DatasetGenerator::updateFlight()
+{
+    using namespace msr::airlib;
+
+    if (flight_handle_ != 0 && command_engine_->getStatus(flight_handle_) == CommandEngine::Status::Running)
+        return;
+
+    Vector3r waypoint = waypoint_sampler_.next().position;
+    try {
+        flight_handle_ = command_engine_->submit(controller_, controller_->createMoveToPositionTask(waypoint.x(), waypoint.y(), waypoint.z(),
+            settings_.flight_speed, DrivetrainType::ForwardOnly, YawMode(false, 0), -1, 1));
+    }
+    catch (std::exception& ex) {
+        //engine is stopped or waypoint is invalid, keep capturing wherever the vehicle is
+        UAirBlueprintLib::LogMessage(TEXT("Dataset flight: "), FString(ex.what()), LogDebugLevel::Failure);
+        flight_handle_ = 0;
+    }
+}
+
+void DatasetGenerator::poseNextFrame()
+{
+    Slot& slot = slots_[next_slot_];
+    //pipeline is full, GPU is behind
+    if (slot.state != SlotState::Free)
+        return;
+
+    DatasetWriter::Frame* frame = writer_->acquireFrame();
+    if (frame == nullptr) {
+        ++writer_stall_count_;
+        return;
+    }
+
+    slot.sample = sampler_.next();
+    applySample(slot.sample);
+
+    frame->index = slot.sample.index;
+    frame->timestamp = msr::airlib::ClockFactory::get()->nowNanos();
+    //pose of the camera as rendered, in Flight mode this is where the vehicle is
+    msr::airlib::Vector3r position = fpv_pawn_->toNedMeters(camera_->GetActorLocation());
+    msr::airlib::Quaternionr orientation = AVehiclePawnBase::toQuaternionr(camera_->GetActorQuat(), true);
+    DatasetSampler::toValues(slot.sample, position, orientation, frame->values);
+
+    slot.frame = frame;
+    slot.posed_tick = tick_count_;
+    slot.state = SlotState::Posed;
+    next_slot_ = (next_slot_ + 1) % slot_count_;
+
+    ++posed_count_;
+    if (settings_.frames > 0 && posed_count_ >= static_cast<uint64_t>(settings_.frames))
+        is_sampling_done_ = true;
+}
+
+void DatasetGenerator::startReadback(Slot& slot)
+{
+    //check all targets first, once a command is queued the frame can't go back to the pool before its fence
+    FTextureRenderTargetResource* resources[3];
+    DatasetWriter::PixelFormat formats[3];
+    for (size_t i = 0; i < image_types_.size(); ++i) {
+        USceneCaptureComponent2D* capture = camera_->getCaptureComponent(image_types_[i], true);
+        resources[i] = capture != nullptr && capture->TextureTarget != nullptr
+            ? capture->TextureTarget->GameThread_GetRenderTargetResource() : nullptr;
+        //staging copy keeps target's pixel format, only formats the writer has are supported
+        bool is_depth = image_types_[i] == EPIPCameraType::PIP_CAMERA_TYPE_DEPTH;
+        EPixelFormat target_format = resources[i] != nullptr ? capture->TextureTarget->GetFormat() : PF_Unknown;
+        bool is_supported = is_depth ? target_format == PF_FloatRGBA || target_format == PF_A32B32G32R32F
+            : target_format == PF_B8G8R8A8;
+        formats[i] = is_depth ? DatasetWriter::PixelFormat::Rgba32F : DatasetWriter::PixelFormat::Bgra8;
+        if (resources[i] == nullptr || !is_supported) {
+            ++failed_count_;
+            writer_->release(slot.frame);
+            slot.frame = nullptr;
+            slot.state = SlotState::Free;
+            return;
+        }
+    }
+
+    DatasetWriter::Frame& frame = *slot.frame;
+    frame.images.resize(image_types_.size());
+    for (size_t i = 0; i < image_types_.size(); ++i) {
+        EPIPCameraType type = image_types_[i];
+        UTextureRenderTarget2D* target = camera_->getCaptureComponent(type, true)->TextureTarget;
+
+        DatasetWriter::Image& image = frame.images[i];
+        image.camera_id = settings_.camera_id;
+        image.image_type = static_cast<uint>(type);
+        image.width = target->GetSurfaceWidth();
+        image.height = target->GetSurfaceHeight();
+        image.format = formats[i];
+
+        CopyRequest request = { resources[i], &slot.staging[i] };
+        ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(
+            DatasetCopyCommand,
+            CopyRequest, Request, request,
+            {
+                copyOnRenderThread(RHICmdList, Request);
+            });
+    }
+
+    slot.fence.BeginFence();
+    slot.readback_start = WallClock::now();
+    slot.state = SlotState::Copying;
+}
+
+void DatasetGenerator::startMap(Slot& slot)
+{
+    for (size_t i = 0; i < image_types_.size(); ++i) {
+        MapRequest request = { &slot.staging[i], &slot.frame->images[i].data };
+        ENQUEUE_UNIQUE_RENDER_COMMAND_ONEPARAMETER(
+            DatasetMapCommand,
+            MapRequest, Request, request,
+            {
+                mapOnRenderThread(RHICmdList, Request);
+            });
+    }
+    slot.fence.BeginFence();
+    slot.state = SlotState::Mapping;
+}
+
+void DatasetGenerator::finishReadbacks(bool wait)
+{
+    //oldest first so frames reach the writer in capture order
+    for (uint i = 0; i < slot_count_; ++i) {
+        Slot& slot = slots_[(next_slot_ + i) % slot_count_];
+        if (slot.state != SlotState::Copying && slot.state != SlotState::Mapping)
+            continue;
+        if (!slot.fence.IsFenceComplete()) {
+            if (!wait)
+                break;
+            slot.fence.Wait();
+        }
+
+        if (slot.state == SlotState::Copying) {
+            //copy was queued at least a tick ago, so mapping rarely waits for the GPU
+            startMap(slot);
+            //newer slots wait so frames stay in order
+            if (!wait)
+                break;
+            slot.fence.Wait();
+        }
+
+        WallClock::time_point now = WallClock::now();
+        readback_times_.insert(std::chrono::duration<double>(now - slot.readback_start).count());
+        if (captured_count_ > 0)
+            capture_intervals_.insert(std::chrono::duration<double>(now - last_capture_time_).count());
+        last_capture_time_ = now;
+        ++captured_count_;
+
+        writer_->submit(slot.frame);
+        slot.frame = nullptr;
+        slot.state = SlotState::Free;
+    }
+}
+
+void DatasetGenerator::encodeImage(DatasetWriter::Image& image, std::vector<uint8_t>& scratch, bool compress)
+{
+    if (image.format == DatasetWriter::PixelFormat::Rgba32F) {
+        //depth is in red channel, keep one float per pixel
+        size_t count = image.data.size() / sizeof(FLinearColor);
+        scratch.resize(count * sizeof(float));
+        const FLinearColor* pixels = reinterpret_cast<const FLinearColor*>(image.data.data());
+        float* depth = reinterpret_cast<float*>(scratch.data());
+        for (size_t i = 0; i < count; ++i)
+            depth[i] = pixels[i].R;
+        image.data.swap(scratch);
+        image.format = DatasetWriter::PixelFormat::Float32;
+    }
+    else if (compress && image.format == DatasetWriter::PixelFormat::Bgra8
+        && image.data.size() == static_cast<size_t>(image.width) * image.height * sizeof(FColor)) {
+        TArray<FColor> pixels;
+        pixels.SetNumUninitialized(image.width * image.height);
+        FMemory::Memcpy(pixels.GetData(), image.data.data(), image.data.size());
+        TArray<uint8> png;
+        FImageUtils::CompressImageArray(image.width, image.height, pixels, png);
+        image.data.assign(png.GetData(), png.GetData() + png.Num());
+        image.format = DatasetWriter::PixelFormat::Png;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "common/Common.hpp"
+#include "common/common_utils/OnlineStats.hpp"
+#include "controllers/SimSettings.hpp"
+#include "controllers/DroneControllerBase.hpp"
+#include "controllers/CommandEngine.hpp"
+#include "dataset/DatasetSampler.hpp"
+#include "dataset/DatasetWriter.hpp"
+#include "VehiclePawnBase.h"
+#include "PIPCamera.h"
+
+class ADirectionalLight;
+
+/*
+    Generates perception datasets without a pilot. Each frame draws a
+    DatasetSampler sample (camera pose, FOV, exposure, sun direction and
+    intensity), captures the requested image types and hands raw pixels to
+    DatasetWriter, which encodes and stores them in its chunked container
+    with pose and sample values per frame. Objects get segmentation stencil
+    ids at start, the id to actor name map is written next to the dataset;
+    stencil has only 255 ids, so with more objects ids are per actor class.
+
+    Poses mode spawns a free camera with its own render targets and moves it
+    to a new random pose every frame. Flight mode captures from a camera of
+    the FPV vehicle while it flies to random waypoints through the command
+    engine; the vehicle must be armed and airborne, e.g. by a scenario.
+
+    Capture is pipelined over a ring of pipeline_depth slots so neither the
+    game thread nor the render thread waits on the GPU: the pose set on tick
+    k is rendered at the end of tick k, on tick k+1 a GPU copy of its render
+    targets in to staging textures is queued ahead of rendering of the next
+    pose, and once that command went through the staging textures are mapped
+    on a later tick, by when the copy is normally done. After the map fence
+    passes the frame goes to the encoder threads. A new pose is set only
+    when a slot and a pooled writer frame are free, so encoding slower than
+    rendering throttles sampling instead of growing memory. All methods
+    must be called on game thread.
+*/
+class DatasetGenerator
+{
+public:
+    typedef msr::airlib::SimSettings::DatasetSettings Settings;
+
+public:
+    DatasetGenerator(const Settings& settings);
+    ~DatasetGenerator();
+
+    //camera_class is spawned in Poses mode, controller and command_engine are only used in Flight mode
+    bool start(AVehiclePawnBase* fpv_pawn, UClass* camera_class, msr::airlib::DroneControllerBase* controller,
+        std::shared_ptr<msr::airlib::CommandEngine> command_engine);
+    //call after vehicles have been rendered for this tick
+    void tick();
+    //waits for frames in flight and closes the dataset
+    void stop();
+
+    bool isFinished() const;
+    std::string getReport() const;
+
+private:
+    typedef msr::airlib::DatasetWriter DatasetWriter;
+    typedef msr::airlib::DatasetSampler DatasetSampler;
+    typedef std::chrono::steady_clock WallClock;
+
+    enum class SlotState {
+        Free, Posed, Copying, Mapping
+    };
+
+    //frame on its way from pose to writer
+    struct Slot {
+        SlotState state = SlotState::Free;
+        DatasetWriter::Frame* frame = nullptr;
+        DatasetSampler::Sample sample;
+        uint64_t posed_tick = 0;
+        WallClock::time_point readback_start;
+        FRenderCommandFence fence;
+        //CPU readable copies of render targets per image, only used on render thread
+        FTexture2DRHIRef staging[3];
+    };
+
+    //FPV capture component as it was before Flight mode randomized it
+    struct SavedCapture {
+        USceneCaptureComponent2D* capture;
+        float fov;
+        bool is_exposure_overridden;
+        float exposure;
+    };
+
+private:
+    void labelObjects(const std::string& file_path);
+    void setupLight();
+    void applySample(const DatasetSampler::Sample& sample);
+    void updateFlight();
+    void poseNextFrame();
+    void startReadback(Slot& slot);
+    void startMap(Slot& slot);
+    void finishReadbacks(bool wait);
+    static void encodeImage(DatasetWriter::Image& image, std::vector<uint8_t>& scratch, bool compress);
+
+private:
+    Settings settings_;
+    bool is_flight_;
+    std::vector<EPIPCameraType> image_types_;
+
+    AVehiclePawnBase* fpv_pawn_;
+    APIPCamera* camera_;
+    //camera spawned by us in Poses mode, destroyed on stop
+    APIPCamera* spawned_camera_;
+    msr::airlib::DroneControllerBase* controller_;
+    std::shared_ptr<msr::airlib::CommandEngine> command_engine_;
+    msr::airlib::CommandEngine::Handle flight_handle_;
+    //Flight mode changes the vehicle's own camera, restored on stop
+    EPIPCameraType saved_camera_types_;
+    std::vector<SavedCapture> saved_captures_;
+
+    ADirectionalLight* light_;
+    FRotator light_rotation_;
+    float light_intensity_;
+
+    DatasetSampler sampler_;
+    DatasetSampler waypoint_sampler_;
+    std::unique_ptr<DatasetWriter> writer_;
+    std::unique_ptr<Slot[]> slots_;
+    uint slot_count_;
+    uint next_slot_;        //slot next pose goes in, slots are used in ring order so this is also the oldest
+
+    bool is_started_, is_sampling_done_, is_finished_;
+    uint64_t tick_count_;
+    uint64_t posed_count_, captured_count_, failed_count_, writer_stall_count_;
+    WallClock::time_point start_time_, last_capture_time_;
+    common_utils::RollingOnlineStats readback_times_;
+    common_utils::RollingOnlineStats capture_intervals_;
+};
@@ -50,23 +50,51 @@ APIPCamera* AFlyingPawn::getFpvCamera()
     return fpv_camera_;
 }
 
+APIPCamera* AFlyingPawn::getCamera(int id)
+{
+    return id >= 0 && id < cameras_.Num() ? cameras_[id] : nullptr;
+}
+
 void AFlyingPawn::setRotorSpeed(int rotor_index, float radsPerSec)
 {
     if (rotor_index >= 0 && rotor_index < rotor_count) {
         auto comp = rotating_movements_[rotor_index];
-        if (comp != nullptr) {
+        //NaN speed of rotor not set yet never compares equal
+        if (comp != nullptr && !(FMath::Abs(radsPerSec - rotor_speeds_[rotor_index]) <= rotor_speed_tolerance_)) {
+            rotor_speeds_[rotor_index] = radsPerSec;
             comp->RotationRate.Yaw = radsPerSec * 180.0f / M_PIf * RotatorFactor;
+            //stopped rotors don't need their movement component ticked every frame
+            bool is_spinning = radsPerSec != 0;
+            if (comp->IsComponentTickEnabled() != is_spinning)
+                comp->SetComponentTickEnabled(is_spinning);
         }
     }
 }
 
+void AFlyingPawn::setRotorSpeedTolerance(float tolerance)
+{
+    rotor_speed_tolerance_ = tolerance;
+}
+
 void AFlyingPawn::setupComponentReferences()
 {
     fpv_camera_ = Cast<APIPCamera>(
         (UAirBlueprintLib::GetActorComponent<UChildActorComponent>(this, TEXT("LeftPIPCamera")))->GetChildActor());
 
+    //FPV camera keeps id 0, remaining cameras follow in component order
+    cameras_.Empty();
+    cameras_.Add(fpv_camera_);
+    TArray<UChildActorComponent*> child_components;
+    GetComponents(child_components);
+    for (UChildActorComponent* child_component : child_components) {
+        APIPCamera* camera = Cast<APIPCamera>(child_component->GetChildActor());
+        if (camera != nullptr && camera != fpv_camera_)
+            cameras_.Add(camera);
+    }
+
     for (auto i = 0; i < rotor_count; ++i) {
         rotating_movements_[i] = UAirBlueprintLib::GetActorComponent<URotatingMovementComponent>(this, TEXT("Rotation") + FString::FromInt(i));
+        rotor_speeds_[i] = Utils::nan<float>();
     }
 }
 
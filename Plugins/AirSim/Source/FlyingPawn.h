@@ -13,11 +13,15 @@ class AIRSIM_API AFlyingPawn : public AVehiclePawnBase
 
 public: //interface
     void setRotorSpeed(int rotor_index, float radsPerSec);
+    //rotor animation is left as is when speed changed by less than this, rad/s
+    void setRotorSpeedTolerance(float tolerance);
     std::string getVehicleName();
 
 public:
     //overrides from VehiclePawnBase
     virtual APIPCamera* getFpvCamera() override;
+    //id 0 is the FPV camera, further ids are the other PIP cameras of the blueprint
+    virtual APIPCamera* getCamera(int id) override;
     virtual void initialize() override;
     virtual void reset() override;
 
@@ -36,5 +40,8 @@ private: //variables
          //Unreal components
     static constexpr size_t rotor_count = 4;
     UPROPERTY() APIPCamera* fpv_camera_;
+    UPROPERTY() TArray<APIPCamera*> cameras_;
     UPROPERTY() URotatingMovementComponent* rotating_movements_[rotor_count];
+    float rotor_speeds_[rotor_count];
+    float rotor_speed_tolerance_ = 0;
 };
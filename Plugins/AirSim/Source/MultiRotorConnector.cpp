@@ -5,10 +5,11 @@
 
 using namespace msr::airlib;
 
-void MultiRotorConnector::initialize(AFlyingPawn* vehicle_pawn, msr::airlib::MultiRotorParams* vehicle_params, bool enable_rpc, std::string api_server_address)
+void MultiRotorConnector::initialize(AFlyingPawn* vehicle_pawn, msr::airlib::MultiRotorParams* vehicle_params, bool enable_rpc, std::string api_server_address, uint16_t api_server_port)
 {
     enable_rpc_ = enable_rpc;
     api_server_address_ = api_server_address;
+    api_server_port_ = api_server_port;
     vehicle_pawn_ = vehicle_pawn;
     vehicle_pawn_->initialize();
 
@@ -52,14 +53,16 @@ void MultiRotorConnector::beginPlay()
     last_debug_pose = Pose::nanPose();
 
     //connect to HIL
+    //this may run on worker thread so errors are reported later in updateRendering
+    start_error_.clear();
     try {
 
         controller_->start();
     }
-    catch (std::exception ex) {
-
-        UAirBlueprintLib::LogMessage(FString("Vehicle controller cannot be started, please check your settings.json"), FString(ex.what()), LogDebugLevel::Failure, 180);
-        UAirBlueprintLib::LogMessage(FString(ex.what()), TEXT(""), LogDebugLevel::Failure, 180);
+    catch (std::exception& ex) {
+        start_error_ = ex.what();
+        if (start_error_.empty())
+            start_error_ = "unknown error";
     }
 }
 
@@ -132,6 +135,10 @@ void MultiRotorConnector::updateRenderedState()
     vehicle_.setCollisionInfo(vehicle_pawn_->getCollisonInfo());
     //update ground level
     environment_.getState().min_z_over_ground = vehicle_pawn_->getMinZOverGround();
+    //one trace per frame is enough for analytic distance and flow sensors, ground under vehicle changes slowly
+    const auto& enabled_sensors = vehicle_params_->getParams().enabled_sensors;
+    if (enabled_sensors.distance || enabled_sensors.optical_flow)
+        environment_.getState().ground_z = vehicle_pawn_->getGroundZ(GroundTraceDistance);
     //update pose of object for rendering engine
     last_pose = vehicle_.getPose();
     last_debug_pose = controller_->getDebugPose();
@@ -154,6 +161,12 @@ void MultiRotorConnector::updateRenderedState()
 
 void MultiRotorConnector::updateRendering(float dt)
 {
+    if (!start_error_.empty()) {
+        UAirBlueprintLib::LogMessage(FString("Vehicle controller cannot be started, please check your settings.json"), FString(start_error_.c_str()), LogDebugLevel::Failure, 180);
+        UAirBlueprintLib::LogMessage(FString(start_error_.c_str()), TEXT(""), LogDebugLevel::Failure, 180);
+        start_error_.clear();
+    }
+
     try {
         controller_->reportTelemetry(dt);
     }
@@ -182,7 +195,7 @@ void MultiRotorConnector::startApiServer()
     if (enable_rpc_) {
         controller_cancelable_.reset(new msr::airlib::DroneControllerCancelable(
             vehicle_.getController()));
-        rpclib_server_.reset(new msr::airlib::RpcLibServer(controller_cancelable_.get(), api_server_address_));
+        rpclib_server_.reset(new msr::airlib::RpcLibServer(controller_cancelable_.get(), api_server_address_, api_server_port_));
         rpclib_server_->start();
     }
 
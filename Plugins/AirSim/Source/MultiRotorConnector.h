@@ -28,7 +28,7 @@ public:
 
     //VehicleConnectorBase interface
     //implements game interface to update pawn
-    void initialize(AFlyingPawn* vehicle_pawn, msr::airlib::MultiRotorParams* vehicle_params, bool enable_rpc, std::string api_server_address);
+    void initialize(AFlyingPawn* vehicle_pawn, msr::airlib::MultiRotorParams* vehicle_params, bool enable_rpc, std::string api_server_address, uint16_t api_server_port);
     virtual void beginPlay() override;
     virtual void endPlay() override;
     virtual void updateRenderedState() override;
@@ -52,6 +52,9 @@ private:
     const msr::airlib::RCData& getRCData();
 
 private:
+    //meters, longer than range of any analytic ground sensor
+    static constexpr float GroundTraceDistance = 100;
+
     MultiRotor vehicle_;
     std::vector<std::string> controller_messages_;
     msr::airlib::Environment environment_;
@@ -74,7 +77,9 @@ private:
 
     bool enable_rpc_;
     std::string api_server_address_;
+    uint16_t api_server_port_;
     msr::airlib::DroneControllerBase* controller_;
+    std::string start_error_;
 
     SimJoyStick joystick_;
     SimJoyStick::State joystick_state_;
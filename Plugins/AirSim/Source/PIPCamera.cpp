@@ -203,13 +203,40 @@ bool APIPCamera::getScreenshot(EPIPCameraType camera_type, TArray<uint8>& compre
     width = capture->TextureTarget->GetSurfaceWidth();
     height = capture->TextureTarget->GetSurfaceHeight();
 
-    TArray<FColor> bmp;
-    bmp.AddUninitialized(width * height);
+    //member buffer keeps its allocation between captures
+    screenshot_pixels_.Reset();
+    screenshot_pixels_.AddUninitialized(width * height);
 
-    resource->ReadPixels(bmp);
+    resource->ReadPixels(screenshot_pixels_);
 
     FIntPoint dest(width, height);
-    FImageUtils::CompressImageArray(dest.X, dest.Y, bmp, compressedPng);
+    FImageUtils::CompressImageArray(dest.X, dest.Y, screenshot_pixels_, compressedPng);
+
+    return true;
+}
+
+bool APIPCamera::getDepthBuffer(std::vector<float>& depth, int& width, int& height)
+{
+    //no logging here, caller polls this at camera rate and counts failures
+    USceneCaptureComponent2D* capture = getCaptureComponent(EPIPCameraType::PIP_CAMERA_TYPE_DEPTH, true);
+    if (capture == nullptr || capture->TextureTarget == nullptr)
+        return false;
+
+    FTextureRenderTargetResource* resource = capture->TextureTarget->GameThread_GetRenderTargetResource();
+    if (resource == nullptr)
+        return false;
+
+    width = capture->TextureTarget->GetSurfaceWidth();
+    height = capture->TextureTarget->GetSurfaceHeight();
+
+    //works for both 8 bit and float render targets
+    resource->ReadLinearColorPixels(depth_pixels_);
+    if (depth_pixels_.Num() != width * height)
+        return false;
+
+    depth.resize(depth_pixels_.Num());
+    for (int i = 0; i < depth_pixels_.Num(); ++i)
+        depth[i] = depth_pixels_[i].R;
 
     return true;
 }
@@ -228,4 +255,24 @@ void APIPCamera::saveScreenshot(EPIPCameraType camera_type, FString fileSavePath
             UAirBlueprintLib::LogMessage(TEXT("Screenshot saved to:"), filePath, LogDebugLevel::Success);
         }
     }
-}
\ No newline at end of file
+}
+
+void APIPCamera::useOwnRenderTargets(int width, int height)
+{
+    auto duplicate = [this, width, height](UTextureRenderTarget2D* source) -> UTextureRenderTarget2D* {
+        if (source == nullptr)
+            return nullptr;
+        UTextureRenderTarget2D* target = DuplicateObject<UTextureRenderTarget2D>(source, this);
+        if (width > 0 && height > 0) {
+            target->SizeX = width;
+            target->SizeY = height;
+        }
+        target->UpdateResource();
+        return target;
+    };
+
+    scene_render_target_ = duplicate(scene_render_target_);
+    depth_render_target_ = duplicate(depth_render_target_);
+    seg_render_target_ = duplicate(seg_render_target_);
+    refreshCurrentMode();
+}
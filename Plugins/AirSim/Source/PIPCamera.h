@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "Camera/CameraActor.h"
 #include "PIPCamera.generated.h"
 
@@ -55,7 +56,12 @@ public:
 	USceneCaptureComponent2D* getCaptureComponent(const EPIPCameraType type, bool if_active);
 
     bool getScreenshot(EPIPCameraType camera_type, TArray<uint8>& compressedPng, float& width, float& height);
+    //raw values of depth render target (red channel), row major, depth view must be active
+    bool getDepthBuffer(std::vector<float>& depth, int& width, int& height);
     void saveScreenshot(EPIPCameraType camera_type, FString fileSavePathPrefix, int fileSuffix);
+    //replaces render targets shared with other cameras and the HUD by copies owned by this camera,
+    //for cameras that capture on their own; 0 width or height keeps size of the shared target
+    void useOwnRenderTargets(int width, int height);
 
 private:
     UPROPERTY() USceneCaptureComponent2D* screen_capture_;
@@ -72,6 +78,10 @@ private:
     //UPROPERTY(BlueprintReadWrite, Category = "Cameras", meta = (Bitmask, BitmaskEnum = "EPIPCameraType"))
     EPIPCameraType enabled_camera_types_ = DefaultEnabledCameras;
 
+    //reused by getDepthBuffer and getScreenshot
+    TArray<FLinearColor> depth_pixels_;
+    TArray<FColor> screenshot_pixels_;
+
 private:
     void activateCaptureComponent(const EPIPCameraType type);
     void deactivateCaptureComponent(const EPIPCameraType type);
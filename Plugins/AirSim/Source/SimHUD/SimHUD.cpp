@@ -2,6 +2,7 @@
 #include "SimHUD.h"
 #include "SimMode/SimModeWorldMultiRotor.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "controllers/SimSettings.hpp"
 
 ASimHUD::ASimHUD()
 {
@@ -32,6 +33,9 @@ void ASimHUD::BeginPlay()
 
     setupInputBindings();
 
+    report_period_ = 1 / msr::airlib::SimSettings::singleton().getHudSettings().report_rate;
+    report_elapsed_ = 0;
+
     widget_->AddToViewport();
 
     //synchronize PIP views
@@ -42,8 +46,27 @@ void ASimHUD::BeginPlay()
 
 void ASimHUD::Tick( float DeltaSeconds )
 {
-    if (simmode_->EnableReport)
-        widget_->updateReport(simmode_->getReport());
+    if (!simmode_->EnableReport)
+        return;
+
+    report_elapsed_ += DeltaSeconds;
+    if (report_elapsed_ >= report_period_)
+        refreshReport();
+}
+
+void ASimHUD::refreshReport()
+{
+    report_elapsed_ = 0;
+
+    int page_count = simmode_->getReportPageCount();
+    std::string report;
+    if (page_count > 1) {
+        int page = simmode_->getReportPage();
+        std::string page_name = page == 0 ? "summary" : msr::airlib::Utils::stringf("vehicle %d", page - 1);
+        report = msr::airlib::Utils::stringf("Page %d/%d: %s (, and . to change)\n", page + 1, page_count, page_name.c_str());
+    }
+    report += simmode_->getReport();
+    widget_->updateReport(report);
 }
 
 void ASimHUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -69,6 +92,22 @@ void ASimHUD::inputEventToggleReport()
 {
     simmode_->EnableReport = !simmode_->EnableReport;
     widget_->setReportVisible(simmode_->EnableReport);
+    if (simmode_->EnableReport)
+        refreshReport();
+}
+
+void ASimHUD::inputEventNextReportPage()
+{
+    simmode_->setReportPage(simmode_->getReportPage() + 1);
+    if (simmode_->EnableReport)
+        refreshReport();
+}
+
+void ASimHUD::inputEventPreviousReportPage()
+{
+    simmode_->setReportPage(simmode_->getReportPage() - 1);
+    if (simmode_->EnableReport)
+        refreshReport();
 }
 
 void ASimHUD::inputEventToggleHelp()
@@ -113,6 +152,8 @@ void ASimHUD::setupInputBindings()
     UAirBlueprintLib::BindActionToKey("InputEventToggleReport", EKeys::R, this, &ASimHUD::inputEventToggleReport);
     UAirBlueprintLib::BindActionToKey("InputEventToggleHelp", EKeys::F1, this, &ASimHUD::inputEventToggleHelp);
     UAirBlueprintLib::BindActionToKey("InputEventToggleTrace", EKeys::T, this, &ASimHUD::inputEventToggleTrace);
+    UAirBlueprintLib::BindActionToKey("InputEventNextReportPage", EKeys::Period, this, &ASimHUD::inputEventNextReportPage);
+    UAirBlueprintLib::BindActionToKey("InputEventPreviousReportPage", EKeys::Comma, this, &ASimHUD::inputEventPreviousReportPage);
     
     UAirBlueprintLib::BindActionToKey("InputEventTogglePIPScene", EKeys::Three, this, &ASimHUD::inputEventTogglePIPScene);
     UAirBlueprintLib::BindActionToKey("InputEventTogglePIPDepth", EKeys::One, this, &ASimHUD::inputEventTogglePIPDepth);
@@ -25,6 +25,8 @@ public:
     void inputEventTogglePIPDepth();
     void inputEventTogglePIPSeg();
     void inputEventToggleAll();
+    void inputEventNextReportPage();
+    void inputEventPreviousReportPage();
 
     ASimHUD();
     virtual void BeginPlay() override;
@@ -35,6 +37,8 @@ protected:
     virtual void setupInputBindings();
     std::string reportRefreshHandler();
     void toggleRecordHandler();
+    //pulls report of current page and shows it if text changed
+    void refreshReport();
 
 private:
     UClass* widget_class_;
@@ -44,4 +48,8 @@ private:
     UPROPERTY()
     ASimModeBase* simmode_;
 
+    //report is pulled at HudSettings::report_rate, not every frame
+    float report_period_;
+    float report_elapsed_;
+
 };
@@ -3,6 +3,9 @@
 
 void USimHUDWidget::updateReport(const std::string& text)
 {
+    if (text == report_text_)
+        return;
+    report_text_ = text;
     setReportText(FString(text.c_str()));
 }
 
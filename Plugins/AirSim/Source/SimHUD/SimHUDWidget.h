@@ -22,6 +22,7 @@ public:
     //TODO: Tick is not working
     //virtual void Tick_Implementation(FGeometry MyGeometry, float InDeltaTime) override;
     
+    //UMG text is only set when it differs from what is shown, setting it forces a relayout
     void updateReport(const std::string& text);
     void setReportVisible(bool is_visible);
     void toggleHelpVisibility();
@@ -55,4 +56,5 @@ protected:
 
 private:
     OnToggleRecording on_toggle_recording_;
+    std::string report_text_;
 };
@@ -3,6 +3,11 @@
 #include "AirBlueprintLib.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "controllers/Settings.hpp"
+#include "controllers/SimSettings.hpp"
+#include "common/StartupProfiler.hpp"
+#include "common/AirLibBenchmarks.hpp"
+#include "rpc/RpcLoadBenchmark.hpp"
+#include "common/common_utils/FileSystem.hpp"
 
 ASimModeBase::ASimModeBase()
 {
@@ -13,7 +18,19 @@ void ASimModeBase::BeginPlay()
 {
     Super::BeginPlay();
 
-    initializeSettings();
+    //startup stages of this session are timed from here until the first tick
+    msr::airlib::StartupProfiler::singleton().clear();
+    is_startup_report_pending_ = true;
+
+    {
+        msr::airlib::StartupProfiler::Scope profile("Settings");
+        initializeSettings();
+    }
+
+    if (msr::airlib::SimSettings::singleton().getBenchmarkSettings().enabled)
+        runBenchmarks();
+    if (msr::airlib::SimSettings::singleton().getRpcBenchmarkSettings().enabled)
+        runRpcBenchmark();
 
     is_recording = false;
     record_tick_count = 0;
@@ -37,25 +54,17 @@ void ASimModeBase::initializeSettings()
     //TODO: should this be done somewhere else?
     //load settings file if found
     typedef msr::airlib::Settings Settings;
+    typedef msr::airlib::SimSettings SimSettings;
     try {
         Settings& settings = Settings::loadJSonFile("settings.json");
         auto settings_filename = Settings::singleton().getFileName();
         if (settings.isLoadSuccess()) {
             std::string msg = "Loaded settings from " + settings_filename;
             UAirBlueprintLib::LogMessage(FString(msg.c_str()), TEXT(""), LogDebugLevel::Informational);
-
-            enable_rpc = settings.getBool("RpcEnabled", true);
-            api_server_address = settings.getString("LocalHostIp", "127.0.0.1");
-
-            //do not save this default in json as this will change in near future
-            fpv_vehicle_name = settings.getString("FpvVehicleName", "Pixhawk");
-
-            UAirBlueprintLib::LogMessage("Vehicle name: ", fpv_vehicle_name.c_str(), LogDebugLevel::Informational);
-
         }
         else {
             //write some settings in new file otherwise the string "null" is written if all settigs are empty
-            enable_rpc = settings.setBool("RpcEnabled", true);
+            settings.setBool("RpcEnabled", true);
             settings.setString("LocalHostIp", "127.0.0.1");
             Settings rosflight_child;
             rosflight_child.setInt("RemoteControlID", 0);
@@ -65,20 +74,112 @@ void ASimModeBase::initializeSettings()
             std::string msg = "Settings file " + settings_filename + " is created.";
             UAirBlueprintLib::LogMessage(FString(msg.c_str()), TEXT("See docs at https://git.io/v9mYY"), LogDebugLevel::Informational);
         }
+
+        //parse everything once so vehicle spawns and resets don't need json
+        SimSettings& sim_settings = SimSettings::singleton();
+        if (!sim_settings.load(settings)) {
+            for (const auto& error : sim_settings.getErrors())
+                UAirBlueprintLib::LogMessage(FString("Invalid setting: "), FString(error.c_str()), LogDebugLevel::Failure, 30);
+        }
     }
     catch (std::exception ex) {
         UAirBlueprintLib::LogMessage(FString("Error loading settings from ~/Documents/AirSim/settings.json"), TEXT(""), LogDebugLevel::Failure, 30);
         UAirBlueprintLib::LogMessage(FString(ex.what()), TEXT(""), LogDebugLevel::Failure, 30);
     }
+
+    const SimSettings& sim_settings = SimSettings::singleton();
+    enable_rpc = sim_settings.getRpcSettings().enabled;
+    api_server_address = sim_settings.getRpcSettings().server_address;
+    api_server_port = sim_settings.getRpcSettings().port;
+    fpv_vehicle_name = sim_settings.getFpvVehicleName();
+    record_filename = sim_settings.getRecordingSettings().record_filename;
+
+    UAirBlueprintLib::LogMessage("Vehicle name: ", fpv_vehicle_name.c_str(), LogDebugLevel::Informational);
 }
 
 void ASimModeBase::Tick(float DeltaSeconds)
 {
+    if (is_startup_report_pending_) {
+        is_startup_report_pending_ = false;
+        logStartupReport();
+    }
+
     if (is_recording)
         ++record_tick_count;
     Super::Tick(DeltaSeconds);
 }
 
+void ASimModeBase::logStartupReport()
+{
+    const auto& profiler = msr::airlib::StartupProfiler::singleton();
+    common_utils::Utils::logMessage("%s", profiler.getReport().c_str());
+
+    UAirBlueprintLib::LogMessage(TEXT("Startup time (ms): "), FString::SanitizeFloat(profiler.getTotalSeconds() * 1E3), LogDebugLevel::Informational, 30);
+    for (const auto& entry : profiler.getEntries()) {
+        UAirBlueprintLib::LogMessage(FString(("  " + entry.stage + ": ").c_str()), FString::SanitizeFloat(entry.duration_sec * 1E3),
+            LogDebugLevel::Unimportant, 30);
+    }
+}
+
+void ASimModeBase::runBenchmarks()
+{
+    const auto& settings = msr::airlib::SimSettings::singleton().getBenchmarkSettings();
+
+    msr::airlib::Benchmark benchmark(settings.min_time_ms / 1E3);
+    msr::airlib::AirLibBenchmarks::addAll(benchmark);
+    benchmark.run(settings.filter);
+    common_utils::Utils::logMessage("%s", benchmark.getReport().c_str());
+
+    try {
+        std::string file_path = common_utils::FileSystem::getLogFileNamePath(settings.file_prefix, "", ".json", true);
+        std::ofstream file;
+        common_utils::FileSystem::createTextFile(file_path, file);
+        file << benchmark.toJson();
+        UAirBlueprintLib::LogMessage(TEXT("Benchmark results saved to: "), FString(file_path.c_str()), LogDebugLevel::Informational, 30);
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("Could not save benchmark results: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+    }
+}
+
+void ASimModeBase::runRpcBenchmark()
+{
+    const auto& settings = msr::airlib::SimSettings::singleton().getRpcBenchmarkSettings();
+
+    msr::airlib::RpcLoadBenchmark::Params params;
+    params.port = settings.port;
+    params.duration_sec = settings.duration_sec;
+    params.getter_clients = settings.getter_clients;
+    params.getter_rate = settings.getter_rate;
+    params.image_clients = settings.image_clients;
+    params.image_rate = settings.image_rate;
+    params.command_clients = settings.command_clients;
+    params.command_rate = settings.command_rate;
+    params.image_bytes = settings.image_bytes;
+    params.command_duration_sec = settings.command_duration_ms / 1E3f;
+
+    msr::airlib::RpcLoadBenchmark benchmark(params);
+    try {
+        benchmark.run();
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("RPC benchmark failed: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+        return;
+    }
+    common_utils::Utils::logMessage("%s", benchmark.getReport().c_str());
+
+    try {
+        std::string file_path = common_utils::FileSystem::getLogFileNamePath(settings.file_prefix, "", ".json", true);
+        std::ofstream file;
+        common_utils::FileSystem::createTextFile(file_path, file);
+        file << benchmark.toJson();
+        UAirBlueprintLib::LogMessage(TEXT("RPC benchmark results saved to: "), FString(file_path.c_str()), LogDebugLevel::Informational, 30);
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("Could not save RPC benchmark results: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+    }
+}
+
 void ASimModeBase::reset()
 {
     //Should be overridden by derived classes
@@ -91,6 +192,23 @@ std::string ASimModeBase::getReport()
     return empty_string;
 }
 
+int ASimModeBase::getReportPageCount()
+{
+    return 1;
+}
+
+void ASimModeBase::setReportPage(int page)
+{
+    //wraps around so paging past the last vehicle goes back to summary
+    int page_count = std::max(getReportPageCount(), 1);
+    report_page_ = ((page % page_count) + page_count) % page_count;
+}
+
+int ASimModeBase::getReportPage() const
+{
+    return report_page_;
+}
+
 void ASimModeBase::setupInputBindings()
 {
     UAirBlueprintLib::EnableInput(this);
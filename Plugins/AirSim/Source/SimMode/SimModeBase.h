@@ -28,7 +28,11 @@ public:
 
     //additional overridable methods
     virtual void reset();
+    //report of the current page, page 0 is the summary and derived classes may add a page per vehicle
     virtual std::string getReport();
+    virtual int getReportPageCount();
+    void setReportPage(int page);
+    int getReportPage() const;
     virtual void startRecording();
     virtual void stopRecording();
     virtual bool isRecording();
@@ -42,10 +46,17 @@ protected:
     int record_tick_count;
     bool enable_rpc;
     std::string api_server_address;
+    uint16_t api_server_port;
     std::string fpv_vehicle_name;
+    int report_page_ = 0;
 
 
 private:
     void initializeSettings();
+    void logStartupReport();
+    void runBenchmarks();
+    void runRpcBenchmark();
+
+    bool is_startup_report_pending_ = false;
 
 };
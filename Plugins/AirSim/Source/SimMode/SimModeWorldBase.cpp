@@ -1,15 +1,29 @@
 #include "AirSim.h"
 #include "SimModeWorldBase.h"
+#include <future>
+#include <algorithm>
+#include "common/StartupProfiler.hpp"
+#include "controllers/SimSettings.hpp"
+
+DECLARE_CYCLE_STAT(TEXT("Vehicle state sync"), STAT_AirSim_VehicleStateSync, STATGROUP_AirSim);
+DECLARE_CYCLE_STAT(TEXT("Vehicle pose sync"), STAT_AirSim_VehiclePoseSync, STATGROUP_AirSim);
 
 
 void ASimModeWorldBase::BeginPlay()
 {
     Super::BeginPlay();
 
+    //before anything reads the clock, so all time points are on the same scale
+    const float clock_speed = msr::airlib::SimSettings::singleton().getPhysicsSettings().clock_speed;
+    msr::airlib::ClockFactory::setSpeed(clock_speed);
+
     setupInputBindings();
 
     //call virtual method in derived class
-    createVehicles(vehicles_);
+    {
+        msr::airlib::StartupProfiler::Scope profile("Vehicles and cameras");
+        createVehicles(vehicles_);
+    }
 
     createWorld();
 
@@ -22,21 +36,35 @@ void ASimModeWorldBase::BeginPlay()
     HP Z840 desktop high-end config seems to be able to go up to 500Hz.
     To increase freq with limited CPU power, switch Barometer to constant ref mode.
     */
-    world_.startAsyncUpdator(3000000LL);
+    state_sync_us_.initialize(300);
+    pose_sync_us_.initialize(300);
+
+    //period is in wall time, so with a faster clock physics runs unthrottled as needed for each tick
+    //to still cover 3 ms of simulated time
+    world_.startAsyncUpdator(static_cast<long long>(3000000LL / clock_speed));
 }
 
 void ASimModeWorldBase::createWorld()
 {
     world_.initialize(&physics_engine_);
     reporter_.initialize(false);
+    reporter_.setReportFreq(msr::airlib::SimSettings::singleton().getHudSettings().report_rate);
 
     //add default objects to world
     world_.insert(&reporter_);
     for(size_t vi = 0; vi < vehicles_.size(); vi++)
         world_.insert(vehicles_.at(vi).get());
+    for (msr::airlib::UpdatableObject* member : world_members_)
+        world_.insert(member);
 
+    //vehicle controllers may need to open connections which can take a while,
+    //so all of them are started in parallel and we wait before physics starts
+    msr::airlib::StartupProfiler::Scope profile("Vehicle controllers (parallel)");
+    std::vector<std::future<void>> begin_plays;
     for (auto& vehicle : vehicles_)
-        vehicle->beginPlay();
+        begin_plays.push_back(std::async(std::launch::async, [&vehicle]() { vehicle->beginPlay(); }));
+    for (auto& begin_play : begin_plays)
+        begin_play.get();
 }
 
 size_t ASimModeWorldBase::getVehicleCount() const
@@ -44,6 +72,24 @@ size_t ASimModeWorldBase::getVehicleCount() const
     return vehicles_.size();
 }
 
+msr::airlib::FastPhysicsEngine& ASimModeWorldBase::getPhysicsEngine()
+{
+    return physics_engine_;
+}
+
+void ASimModeWorldBase::addWorldMember(msr::airlib::UpdatableObject* member)
+{
+    world_members_.push_back(member);
+}
+
+void ASimModeWorldBase::removeWorldMember(msr::airlib::UpdatableObject* member)
+{
+    world_.lock();
+    world_.erase_remove(member);
+    world_.unlock();
+    world_members_.erase(std::remove(world_members_.begin(), world_members_.end(), member), world_members_.end());
+}
+
 
 void ASimModeWorldBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
@@ -59,20 +105,32 @@ void ASimModeWorldBase::Tick(float DeltaSeconds)
 {
     world_.lock();
 
-    for (auto& vehicle : vehicles_)
-        vehicle->updateRenderedState();
+    double start_time = FPlatformTime::Seconds();
+    {
+        SCOPE_CYCLE_COUNTER(STAT_AirSim_VehicleStateSync);
+        for (auto& vehicle : vehicles_)
+            vehicle->updateRenderedState();
+    }
+    double state_time = FPlatformTime::Seconds();
 
     reporter_.setEnable(EnableReport);
-    if (reporter_.canReport()) {
-        reporter_.clearReport();
-        world_.reportState(*reporter_.getReporter());
-    }
+    if (reporter_.canReport())
+        updateWorldReport();
 
     world_.unlock();
 
     //perfom any expensive rendering update outside of lock region
-    for (auto& vehicle : vehicles_)
-        vehicle->updateRendering(DeltaSeconds);
+    double pose_start_time = FPlatformTime::Seconds();
+    {
+        SCOPE_CYCLE_COUNTER(STAT_AirSim_VehiclePoseSync);
+        for (auto& vehicle : vehicles_)
+            vehicle->updateRendering(DeltaSeconds);
+    }
+    if (vehicles_.size() > 0) {
+        double to_us_per_vehicle = 1E6 / vehicles_.size();
+        state_sync_us_.insert((state_time - start_time) * to_us_per_vehicle);
+        pose_sync_us_.insert((FPlatformTime::Seconds() - pose_start_time) * to_us_per_vehicle);
+    }
 
     Super::Tick(DeltaSeconds);
 }
@@ -86,9 +144,47 @@ void ASimModeWorldBase::reset()
     Super::reset();
 }
 
+void ASimModeWorldBase::updateWorldReport()
+{
+    //reporting every vehicle costs time linear in vehicle count, so only the page on screen is reported
+    reporter_.clearReport();
+    msr::airlib::StateReporter& reporter = *reporter_.getReporter();
+    int page = getReportPage();
+    if (page == 0) {
+        world_.reportSummary(reporter);
+        physics_engine_.reportSummary(reporter);
+        reporter_.reportState(reporter);
+    }
+    else if (page <= static_cast<int>(vehicles_.size())) {
+        VehicleConnectorBase* vehicle = vehicles_.at(page - 1).get();
+        vehicle->reportState(reporter);
+        if (vehicle->getPhysicsBody() != nullptr)
+            physics_engine_.reportBody(*static_cast<msr::airlib::PhysicsBody*>(vehicle->getPhysicsBody()), reporter);
+    }
+    reported_page_ = page;
+}
+
+int ASimModeWorldBase::getReportPageCount()
+{
+    return 1 + static_cast<int>(vehicles_.size());
+}
+
 std::string ASimModeWorldBase::getReport()
 {
-    return reporter_.getOutput();
+    //page changed since last snapshot, don't show previous page's values until next report tick
+    if (reported_page_ != getReportPage()) {
+        world_.lock();
+        updateWorldReport();
+        world_.unlock();
+    }
+
+    std::string report = reporter_.getOutput();
+    if (getReportPage() == 0 && pose_sync_us_.size() > 0) {
+        report += msr::airlib::Utils::stringf("Vehicle sync: %u vehicles, state %.1f us/vehicle, pose %.1f us/vehicle (p99 %.1f), %.2f ms/frame\n",
+            static_cast<unsigned int>(vehicles_.size()), state_sync_us_.mean(), pose_sync_us_.mean(), pose_sync_us_.percentile(0.99),
+            (state_sync_us_.mean() + pose_sync_us_.mean()) * vehicles_.size() / 1E3);
+    }
+    return report;
 }
 
 void ASimModeWorldBase::createVehicles(std::vector<VehiclePtr>& vehicles)
@@ -6,6 +6,7 @@
 #include "physics/FastPhysicsEngine.hpp"
 #include "physics/World.hpp"
 #include "common/StateReporterWrapper.hpp"
+#include "common/common_utils/OnlineStats.hpp"
 #include "rpc/ControlServerBase.hpp"
 #include "SimModeBase.h"
 #include "SimModeWorldBase.generated.h"
@@ -25,20 +26,37 @@ public:
 
     virtual void reset() override;
     virtual std::string getReport() override;
+    //summary page, then one page per vehicle in creation order
+    virtual int getReportPageCount() override;
     virtual void setupInputBindings() override;
 
 protected:
     typedef std::shared_ptr<VehicleConnectorBase> VehiclePtr;
     virtual void createVehicles(std::vector<VehiclePtr>& vehicles);
     size_t getVehicleCount() const;
+    //derived classes may configure physics such as collision while creating vehicles
+    msr::airlib::FastPhysicsEngine& getPhysicsEngine();
+    //object updated on physics thread after the vehicles, add from createVehicles
+    void addWorldMember(msr::airlib::UpdatableObject* member);
+    //takes a member out while physics may still be running, before it is destroyed
+    void removeWorldMember(msr::airlib::UpdatableObject* member);
 
 private:
     void createWorld();
+    //snapshot of world state for current report page, world lock must be held
+    void updateWorldReport();
 
 private:
     msr::airlib::World world_;
     msr::airlib::FastPhysicsEngine physics_engine_;
 
     std::vector<VehiclePtr> vehicles_;
+    std::vector<msr::airlib::UpdatableObject*> world_members_;
     msr::airlib::StateReporterWrapper reporter_;
+    //page the reporter_ snapshot was taken for, -1 if none
+    int reported_page_ = -1;
+
+    //game thread cost of moving state between physics and pawns, microseconds per vehicle
+    common_utils::RollingOnlineStats state_sync_us_;
+    common_utils::RollingOnlineStats pose_sync_us_;
 };
@@ -7,7 +7,12 @@
 #include "FlyingPawn.h"
 #include "Logging/MessageLog.h"
 #include "vehicles/MultiRotorParamsFactory.hpp"
+#include "controllers/SimSettings.hpp"
+#include "common/StartupProfiler.hpp"
 #include "common/common_utils/Log.hpp"
+#include "safety/SafetyEval.hpp"
+#include "safety/CubeGeoFence.hpp"
+#include "PhysicsEngine/BodySetup.h"
 
 using namespace common_utils;
 
@@ -38,17 +43,28 @@ ASimModeWorldMultiRotor::ASimModeWorldMultiRotor()
     camera_director_class_ = camera_director_class.Succeeded() ? camera_director_class.Class : nullptr;
     static ConstructorHelpers::FClassFinder<AVehiclePawnBase> vehicle_pawn_class(TEXT("Blueprint'/AirSim/Blueprints/BP_FlyingPawn'"));
     vehicle_pawn_class_ = vehicle_pawn_class.Succeeded() ? vehicle_pawn_class.Class : nullptr;
+    is_scenario_saved_ = false;
+    scenario_time_ = 0;
 }
 
 void ASimModeWorldMultiRotor::BeginPlay()
 {
     Super::BeginPlay();
 
+    //vehicle controllers and physics run now, opponents can take off
+    if (opponent_ai_ != nullptr)
+        opponent_ai_->start();
+
+    const auto& capture_settings = msr::airlib::SimSettings::singleton().getCaptureSettings();
+    capture_scheduler_.initialize(capture_settings.frame_budget_ms / 1000.0,
+        capture_settings.mode == "Batch" ? msr::airlib::CaptureScheduler::Mode::Batch : msr::airlib::CaptureScheduler::Mode::RoundRobin);
+
     // bugbug: this is corrupting memory after a while, seems Unreal doesn't like us continually writing to the BlueprintLog.
     //Log::setLog(&GlobalASimLog);
 
     if (fpv_vehicle_connector_ != nullptr) {
         //create its control server
+        msr::airlib::StartupProfiler::Scope profile("RPC server");
         try {
             fpv_vehicle_connector_->startApiServer();
         }
@@ -89,7 +105,14 @@ void ASimModeWorldMultiRotor::setupVehiclesAndCamera()
         //find all vehicle pawns
         TArray<AActor*> pawns;
         UAirBlueprintLib::FindAllActor<AVehiclePawnBase>(this, pawns);
-        if (pawns.Num() == 0) {
+        AVehiclePawnBase* scenario_pawn = spawnScenarioVehicles(actor_transform);
+        if (scenario_pawn != nullptr) {
+            //scenario replaces vehicles of the level, they would fly uncontrolled among its vehicles
+            for (AActor* pawn : pawns)
+                pawn->Destroy();
+            CameraDirector->TargetPawn = scenario_pawn;
+        }
+        else if (pawns.Num() == 0) {
             //create vehicle pawn
             FActorSpawnParameters pawn_spawn_params;
             pawn_spawn_params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
@@ -107,39 +130,16 @@ void ASimModeWorldMultiRotor::setupVehiclesAndCamera()
 
 void ASimModeWorldMultiRotor::Tick(float DeltaSeconds)
 {
-    if (fpv_vehicle_connector_ != nullptr && fpv_vehicle_connector_->isApiServerStarted() && getVehicleCount() > 0) {
-
-        using namespace msr::airlib;
-        auto controller = static_cast<DroneControllerBase*>(fpv_vehicle_connector_->getController());
-        auto camera_type = controller->getImageTypeForCamera(0);
-        if (camera_type != DroneControllerBase::ImageType::None) { 
-            if (CameraDirector != nullptr) {
-                APIPCamera* camera = CameraDirector->getCamera(0);
-                EPIPCameraType pip_type;
-                if (camera != nullptr) {
-                    //TODO: merge these two different types?
-                    switch (camera_type) {
-                    case DroneControllerBase::ImageType::Scene:
-                        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_SCENE; break;
-                    case DroneControllerBase::ImageType::Depth:
-                        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_DEPTH; break;
-                    case DroneControllerBase::ImageType::Segmentation:
-                        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_SEG; break;
-                    default:
-                        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_NONE;
-                    }
-                    float width, height;
-                    image_.Empty();
-                    camera->getScreenshot(pip_type, image_, width, height);
-                    controller->setImageForCamera(0, camera_type, std::vector<uint8_t>(image_.GetData(), image_.GetData() + image_.Num()));
-                }
-            }
-        }
+    updateScenario();
+    captureImages();
+    updateDetections(DeltaSeconds);
 
+    if (fpv_vehicle_connector_ != nullptr && fpv_vehicle_connector_->isApiServerStarted() && getVehicleCount() > 0) {
         if (isRecording() && record_file.is_open()) {
             if (!isLoggingStarted)
             {
-                FString imagePathPrefix = common_utils::FileSystem::getLogFileNamePath("img_", "", "", false).c_str();
+                const auto& image_prefix = msr::airlib::SimSettings::singleton().getRecordingSettings().image_prefix;
+                FString imagePathPrefix = common_utils::FileSystem::getLogFileNamePath(image_prefix, "", "", false).c_str();
                 FRecordingThread::ThreadInit(imagePathPrefix, this);
                 isLoggingStarted = true;
             }
@@ -153,6 +153,690 @@ void ASimModeWorldMultiRotor::Tick(float DeltaSeconds)
     }
 
     Super::Tick(DeltaSeconds);
+
+    //after vehicle poses for this frame are set, so they are what gets rendered with the dataset pose
+    if (dataset_generator_ != nullptr)
+        dataset_generator_->tick();
+}
+
+void ASimModeWorldMultiRotor::captureImages()
+{
+    //mirror image requests of all vehicles in to the scheduler
+    for (uint vi = 0; vi < capture_vehicles_.size(); ++vi) {
+        capture_vehicles_[vi].controller->getImageRequests(image_requests_);
+        capture_scheduler_.markStale(vi);
+        for (const auto& request : image_requests_) {
+            msr::airlib::CaptureScheduler::StreamKey key{ static_cast<int>(vi), request.camera_id, static_cast<uint>(request.image_type),
+                CaptureForApi };
+            capture_scheduler_.setStream(key, request.rate);
+        }
+
+        const CaptureVehicle& vehicle = capture_vehicles_[vi];
+        if (vehicle.obstacle_mapper != nullptr) {
+            msr::airlib::CaptureScheduler::StreamKey key{ static_cast<int>(vi), vehicle.obstacle_map_camera_id,
+                static_cast<uint>(msr::airlib::DroneControllerBase::ImageType::Depth), CaptureForObstacleMap };
+            capture_scheduler_.setStream(key, vehicle.obstacle_map_rate);
+        }
+    }
+    capture_scheduler_.removeStale();
+
+    if (capture_scheduler_.getStreamCount() > 0) {
+        capture_scheduler_.runFrame([this](const msr::airlib::CaptureScheduler::StreamKey& key) {
+            return captureImage(key);
+        });
+    }
+}
+
+bool ASimModeWorldMultiRotor::captureImage(const msr::airlib::CaptureScheduler::StreamKey& key)
+{
+    using namespace msr::airlib;
+
+    const CaptureVehicle& vehicle = capture_vehicles_.at(key.vehicle_index);
+    APIPCamera* camera = vehicle.pawn->getCamera(key.camera_id);
+    if (camera == nullptr)
+        return false;
+
+    if (key.consumer == CaptureForObstacleMap) {
+        int width, height;
+        if (!camera->getDepthBuffer(depth_buffer_, width, height))
+            return false;
+        //processing happens on mapper's worker thread
+        vehicle.obstacle_mapper->submit(depth_buffer_.data(), width, height);
+        return true;
+    }
+
+    auto image_type = static_cast<DroneControllerBase::ImageType>(key.image_type);
+    EPIPCameraType pip_type;
+    //TODO: merge these two different types?
+    switch (image_type) {
+    case DroneControllerBase::ImageType::Scene:
+        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_SCENE; break;
+    case DroneControllerBase::ImageType::Depth:
+        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_DEPTH; break;
+    case DroneControllerBase::ImageType::Segmentation:
+        pip_type = EPIPCameraType::PIP_CAMERA_TYPE_SEG; break;
+    default:
+        return false;
+    }
+
+    float width, height;
+    image_.Reset();
+    if (!camera->getScreenshot(pip_type, image_, width, height))
+        return false;
+
+    vehicle.controller->setImageForCamera(key.camera_id, image_type, image_.GetData(), image_.Num());
+    return true;
+}
+
+void ASimModeWorldMultiRotor::addCaptureVehicle(AFlyingPawn* pawn, msr::airlib::DroneControllerBase* controller)
+{
+    using namespace msr::airlib;
+
+    CaptureVehicle vehicle;
+    vehicle.pawn = pawn;
+    vehicle.controller = controller;
+    vehicle.obstacle_map_camera_id = 0;
+    vehicle.obstacle_map_rate = 0;
+
+    const auto& settings = SimSettings::singleton().getVehicleSettings(fpv_vehicle_name).obstacle_map;
+    //reciprocal avoidance works through safety checks, so it needs SafetyEval even without obstacle map
+    std::shared_ptr<ObstacleMap> obstacle_map;
+    if (settings.enabled || SimSettings::singleton().getReciprocalAvoidanceSettings().enabled) {
+        obstacle_map = std::make_shared<ObstacleMap>(settings.ticks);
+
+        //fence is effectively disabled until client sets it via setSafety
+        const auto& vehicle_params = controller->getVehicleParams();
+        auto fence = std::make_shared<CubeGeoFence>(VectorMath::Vector3f(-1E10, -1E10, -1E10), VectorMath::Vector3f(1E10, 1E10, 1E10),
+            vehicle_params.distance_accuracy);
+        vehicle.safety_eval = std::make_shared<SafetyEval>(vehicle_params, fence, obstacle_map);
+        controller->setSafetyEval(vehicle.safety_eval);
+    }
+    if (settings.enabled && pawn->getCamera(settings.camera_id) == nullptr) {
+        UAirBlueprintLib::LogMessage(TEXT("ObstacleMap disabled, vehicle has no camera "), FString::FromInt(settings.camera_id),
+            LogDebugLevel::Failure, 30);
+    }
+    else if (settings.enabled) {
+        DepthObstacleMapper::Params params;
+        params.horizontal_fov = Utils::degreesToRadians(settings.horizontal_fov_deg);
+        params.depth_scale = settings.depth_scale;
+        params.max_distance = settings.max_distance;
+        params.row_start = settings.row_start;
+        params.row_end = settings.row_end;
+        vehicle.obstacle_mapper.reset(new DepthObstacleMapper(obstacle_map, params));
+        vehicle.obstacle_mapper->start();
+        vehicle.obstacle_map_camera_id = settings.camera_id;
+        vehicle.obstacle_map_rate = settings.rate;
+    }
+
+    const auto& mpc_settings = SimSettings::singleton().getMpcSettings();
+    if (mpc_settings.enabled) {
+        MpcController::Params mpc_params;
+        mpc_params.dt = mpc_settings.prediction_step;
+        mpc_params.max_tilt = Utils::degreesToRadians(mpc_settings.max_tilt_deg);
+        mpc_params.max_thrust_accel = mpc_settings.max_thrust_accel;
+        mpc_params.min_thrust_accel = mpc_settings.min_thrust_accel;
+        mpc_params.max_iterations = mpc_settings.max_iterations;
+        controller->enableMpc(mpc_params);
+    }
+
+    capture_vehicles_.push_back(std::move(vehicle));
+}
+
+void ASimModeWorldMultiRotor::setupPathPlanner(AVehiclePawnBase* frame_pawn)
+{
+    using namespace msr::airlib;
+
+    const auto& settings = SimSettings::singleton().getPathPlanningSettings();
+    if (!settings.enabled || frame_pawn == nullptr)
+        return;
+
+    PathPlanner::Params params;
+    params.resolution = settings.resolution;
+    params.inflation_radius = settings.inflation_radius;
+    params.max_expansions = settings.max_expansions;
+    //keep a little room below start so vehicles on the ground still start inside the grid
+    path_planner_ = std::make_shared<PathPlanner>(Vector3r(-settings.size_x / 2, -settings.size_y / 2, -settings.size_z),
+        Vector3r(settings.size_x / 2, settings.size_y / 2, 2), params);
+
+    {
+        StartupProfiler::Scope profile("Path planner map");
+        fillPathPlannerGrid(frame_pawn);
+    }
+
+    //each pawn has its own NED origin so controllers need offset of their origin in planner frame,
+    //all origins let clients move planned trajectories in to the frame of the vehicle flying them
+    vector<Vector3r> origins;
+    for (const CaptureVehicle& vehicle : capture_vehicles_)
+        origins.push_back(frame_pawn->toNedMeters(vehicle.pawn->toNeuUU(Vector3r::Zero())));
+    for (size_t i = 0; i < capture_vehicles_.size(); ++i)
+        capture_vehicles_[i].controller->setPathPlanner(path_planner_, origins[i], origins);
+}
+
+void ASimModeWorldMultiRotor::fillPathPlannerGrid(AVehiclePawnBase* frame_pawn)
+{
+    using namespace msr::airlib;
+
+    //static geometry is found by box overlap queries, first over blocks of voxels and
+    //then per voxel only inside blocks that overlap something, so open space stays cheap
+    const int block_size = 8;
+    const float world_to_meters = UAirBlueprintLib::GetWorldToMetersScale(this);
+    FCollisionQueryParams query_params(FName(TEXT("PathPlannerMap")), false);
+    FCollisionObjectQueryParams object_params(ECC_WorldStatic);
+    UWorld* world = this->GetWorld();
+
+    auto overlaps = [&](const Vector3r& center, float half_size) {
+        FCollisionShape box = FCollisionShape::MakeBox(FVector(half_size * world_to_meters));
+        return world->OverlapAnyTestByObjectType(frame_pawn->toNeuUU(center), FQuat::Identity, object_params, box, query_params);
+    };
+
+    path_planner_->updateGrid([&](VoxelGrid& grid) {
+        const float resolution = grid.getResolution();
+        for (int bz = 0; bz < grid.getSizeZ(); bz += block_size) {
+            for (int by = 0; by < grid.getSizeY(); by += block_size) {
+                for (int bx = 0; bx < grid.getSizeX(); bx += block_size) {
+                    Vector3r block_min = grid.getMinCorner() + Vector3r(bx, by, bz) * resolution;
+                    if (!overlaps(block_min + Vector3r::Constant(block_size * resolution / 2), block_size * resolution / 2))
+                        continue;
+
+                    for (int z = bz; z < std::min(bz + block_size, grid.getSizeZ()); ++z)
+                        for (int y = by; y < std::min(by + block_size, grid.getSizeY()); ++y)
+                            for (int x = bx; x < std::min(bx + block_size, grid.getSizeX()); ++x) {
+                                VoxelGrid::Index index(x, y, z);
+                                if (overlaps(grid.toPosition(index), resolution / 2))
+                                    grid.setOccupied(index, true);
+                            }
+                }
+            }
+        }
+    });
+}
+
+void ASimModeWorldMultiRotor::setupOpponents(AVehiclePawnBase* fpv_pawn)
+{
+    using namespace msr::airlib;
+
+    const auto& settings = SimSettings::singleton().getOpponentSettings();
+    if (!settings.enabled || fpv_pawn == nullptr || capture_vehicles_.size() < 2)
+        return;
+
+    OpponentAi::Params params;
+    params.max_speed = settings.max_speed;
+    params.max_accel = settings.max_accel;
+    params.control_period = settings.control_period_ms / 1000;
+    opponent_ai_.reset(new OpponentAi(params));
+
+    //shared frame is the FPV vehicle's NED frame, same as path planner
+    int fpv_index = -1;
+    vector<Vector3r> origins;
+    for (const CaptureVehicle& vehicle : capture_vehicles_) {
+        Vector3r origin_offset = fpv_pawn->toNedMeters(vehicle.pawn->toNeuUU(Vector3r::Zero()));
+        int index = opponent_ai_->addVehicle(vehicle.controller, origin_offset);
+        if (vehicle.pawn == fpv_pawn)
+            fpv_index = index;
+        origins.push_back(origin_offset);
+    }
+    if (fpv_index < 0) {
+        opponent_ai_.reset();
+        return;
+    }
+
+    for (int index = 0; index < static_cast<int>(origins.size()); ++index) {
+        if (index == fpv_index)
+            continue;
+
+        if (settings.behavior == "Pursuit")
+            opponent_ai_->setPursuit(index, fpv_index);
+        else if (settings.behavior == "Evasion")
+            opponent_ai_->setEvasion(index, fpv_index);
+        else if (settings.behavior == "Formation")
+            opponent_ai_->setFormation(index, fpv_index, origins[index] - origins[fpv_index]);
+        else {
+            //square around where the vehicle starts
+            const Vector3r center = origins[index] - Vector3r(0, 0, settings.patrol_altitude);
+            const float r = settings.patrol_radius;
+            opponent_ai_->setPatrol(index, { center + Vector3r(r, 0, 0), center + Vector3r(0, r, 0),
+                center + Vector3r(-r, 0, 0), center + Vector3r(0, -r, 0) });
+        }
+    }
+    //started in BeginPlay once controllers are running
+}
+
+void ASimModeWorldMultiRotor::setupReciprocalAvoidance(AVehiclePawnBase* frame_pawn)
+{
+    using namespace msr::airlib;
+
+    const auto& settings = SimSettings::singleton().getReciprocalAvoidanceSettings();
+    if (!settings.enabled || frame_pawn == nullptr)
+        return;
+
+    ReciprocalAvoidance::Params params;
+    params.radius = settings.radius;
+    params.time_horizon = settings.time_horizon;
+    params.neighbor_distance = settings.neighbor_distance;
+    params.max_neighbors = static_cast<uint>(settings.max_neighbors);
+    params.max_speed = settings.max_speed;
+    params.control_period = settings.control_period_ms / 1000;
+    params.threads = static_cast<uint>(settings.threads);
+    reciprocal_avoidance_ = std::make_shared<ReciprocalAvoidance>(params);
+
+    //shared frame is the FPV vehicle's NED frame, same as opponents
+    for (const CaptureVehicle& vehicle : capture_vehicles_) {
+        Vector3r origin_offset = frame_pawn->toNedMeters(vehicle.pawn->toNeuUU(Vector3r::Zero()));
+        DroneControllerBase* controller = vehicle.controller;
+        uint agent = reciprocal_avoidance_->addAgent(origin_offset, [controller](Vector3r& position, Vector3r& velocity) {
+            position = controller->getPosition();
+            velocity = controller->getVelocity();
+        });
+        vehicle.safety_eval->setReciprocalAvoidance(reciprocal_avoidance_, agent);
+        if (settings.enable_for_all) {
+            vehicle.safety_eval->setSafety(vehicle.safety_eval->getEnableReasons() | SafetyEval::SafetyViolationType_::Reciprocal,
+                Utils::nan<float>(), vehicle.safety_eval->getObsAvoidanceStrategy(),
+                VectorMath::nanVector(), Utils::nan<float>(), Utils::nan<float>(), Utils::nan<float>());
+        }
+    }
+
+    reciprocal_avoidance_->start();
+}
+
+void ASimModeWorldMultiRotor::setupCommandEngine()
+{
+    command_engine_ = std::make_shared<msr::airlib::CommandEngine>();
+    //stepped with physics so command rate doesn't depend on frame rate
+    addWorldMember(command_engine_.get());
+    for (const CaptureVehicle& vehicle : capture_vehicles_)
+        vehicle.controller->setCommandEngine(command_engine_);
+}
+
+void ASimModeWorldMultiRotor::setupDataset(AVehiclePawnBase* fpv_pawn)
+{
+    const auto& settings = msr::airlib::SimSettings::singleton().getDatasetSettings();
+    if (!settings.enabled || fpv_pawn == nullptr)
+        return;
+
+    msr::airlib::DroneControllerBase* controller = nullptr;
+    for (const CaptureVehicle& vehicle : capture_vehicles_) {
+        if (vehicle.pawn == fpv_pawn)
+            controller = vehicle.controller;
+    }
+
+    dataset_generator_.reset(new DatasetGenerator(settings));
+    if (!dataset_generator_->start(fpv_pawn, external_camera_class_, controller, command_engine_))
+        dataset_generator_.reset();
+}
+
+void ASimModeWorldMultiRotor::setupContinuousCollision(AVehiclePawnBase* frame_pawn, const std::vector<VehiclePtr>& vehicles)
+{
+    using namespace msr::airlib;
+
+    is_static_world_complete_ = false;
+    const auto& settings = SimSettings::singleton().getPhysicsSettings();
+    if (!settings.continuous_collision || frame_pawn == nullptr)
+        return;
+
+    auto collision_world = std::make_shared<CollisionWorld>(settings.collision_cell_size);
+    uint left_out;
+    {
+        StartupProfiler::Scope profile("Static collision boxes");
+        left_out = addStaticCollisionBoxes(frame_pawn, *collision_world);
+    }
+    is_static_world_complete_ = left_out == 0;
+    UAirBlueprintLib::LogMessage(TEXT("Static collision boxes: "), FString::Printf(TEXT("%d, %u colliders left to pawn sweeps"),
+        static_cast<int>(collision_world->getBoxCount()), left_out), LogDebugLevel::Informational);
+
+    FastPhysicsEngine& physics_engine = getPhysicsEngine();
+    physics_engine.setContinuousCollision(true, collision_world);
+    //vehicles are in same order as capture_vehicles_, each pawn has its own NED origin
+    for (size_t i = 0; i < vehicles.size() && i < capture_vehicles_.size(); ++i) {
+        auto body = static_cast<const PhysicsBody*>(vehicles[i]->getPhysicsBody());
+        if (body != nullptr)
+            physics_engine.setCollisionOrigin(body, frame_pawn->toNedMeters(capture_vehicles_[i].pawn->toNeuUU(Vector3r::Zero())));
+    }
+}
+
+void ASimModeWorldMultiRotor::setupRenderSync(AVehiclePawnBase* frame_pawn)
+{
+    using namespace msr::airlib;
+
+    const auto& settings = SimSettings::singleton().getRenderSyncSettings();
+    //sweeping pawns only repeats work of continuous collision when its static world has every collider of the level,
+    //otherwise teleported pawns never get NotifyHit from buildings or terrain and fly through them
+    bool skip_sweeps = settings.skip_sweeps && is_static_world_complete_;
+    if (settings.skip_sweeps && !is_static_world_complete_)
+        UAirBlueprintLib::LogMessage(TEXT("Pawn sweeps: "), TEXT("kept on, static collision world doesn't cover the level"), LogDebugLevel::Informational);
+    for (CaptureVehicle& vehicle : capture_vehicles_) {
+        vehicle.pawn->setSweepEnabled(!skip_sweeps);
+        vehicle.pawn->setRotorSpeedTolerance(settings.rotor_speed_tolerance);
+    }
+    if (skip_sweeps)
+        UAirBlueprintLib::LogMessage(TEXT("Pawn sweeps: "), TEXT("off, physics handles collisions"), LogDebugLevel::Informational);
+}
+
+uint ASimModeWorldMultiRotor::addStaticCollisionBoxes(AVehiclePawnBase* frame_pawn, msr::airlib::CollisionWorld& collision_world)
+{
+    using namespace msr::airlib;
+
+    //simple collision shapes of static meshes are converted to boxes in NED frame of frame_pawn,
+    //spheres and capsules become their bounding boxes and convex hulls their local bounds
+    const float world_to_meters = UAirBlueprintLib::GetWorldToMetersScale(this);
+    const float max_box_size = SimSettings::singleton().getPhysicsSettings().max_static_box_size;
+
+    auto add_box = [&](const FTransform& transform, const FVector& half_extents_uu) {
+        FVector half_extents = (half_extents_uu * transform.GetScale3D()).GetAbs() / world_to_meters;
+        collision_world.addBox(frame_pawn->toNedMeters(transform.GetLocation()),
+            AVehiclePawnBase::toQuaternionr(transform.GetRotation(), true),
+            Vector3r(half_extents.X, half_extents.Y, half_extents.Z));
+    };
+
+    //colliders blocking pawns that couldn't be converted, e.g. landscapes, movable or large triangle meshes
+    uint left_out = 0;
+
+    TArray<AActor*> actors;
+    UAirBlueprintLib::FindAllActor<AActor>(this, actors);
+    for (AActor* actor : actors) {
+        if (actor == nullptr || actor->IsA(APawn::StaticClass()))
+            continue;
+
+        TArray<UPrimitiveComponent*> primitives;
+        actor->GetComponents<UPrimitiveComponent>(primitives);
+        for (UPrimitiveComponent* primitive : primitives) {
+            if (!primitive->IsCollisionEnabled() || primitive->GetCollisionResponseToChannel(ECC_Pawn) != ECR_Block)
+                continue;
+            UStaticMeshComponent* component = Cast<UStaticMeshComponent>(primitive);
+            if (component == nullptr || component->Mobility != EComponentMobility::Static
+                || component->GetCollisionObjectType() != ECC_WorldStatic) {
+                ++left_out;
+                continue;
+            }
+
+            const FTransform& component_transform = component->GetComponentTransform();
+            UBodySetup* body_setup = component->GetBodySetup();
+            int shape_count = 0;
+            if (body_setup != nullptr) {
+                const FKAggregateGeom& geom = body_setup->AggGeom;
+                for (const FKBoxElem& box : geom.BoxElems)
+                    add_box(box.GetTransform() * component_transform, FVector(box.X, box.Y, box.Z) / 2);
+                for (const FKSphereElem& sphere : geom.SphereElems)
+                    add_box(sphere.GetTransform() * component_transform, FVector(sphere.Radius));
+                for (const FKSphylElem& sphyl : geom.SphylElems)
+                    add_box(sphyl.GetTransform() * component_transform, FVector(sphyl.Radius, sphyl.Radius, sphyl.Radius + sphyl.Length / 2));
+                for (const FKConvexElem& convex : geom.ConvexElems) {
+                    FTransform center(convex.ElemBox.GetCenter());
+                    add_box(center * convex.GetTransform() * component_transform, convex.ElemBox.GetExtent());
+                }
+                shape_count = geom.GetElementCount();
+            }
+
+            //meshes colliding with their triangles only have bounds, which would block
+            //whole buildings or terrain pieces so only small ones are used
+            if (shape_count == 0) {
+                FBox bounds = component->Bounds.GetBox();
+                if (bounds.GetSize().GetMax() / world_to_meters <= max_box_size)
+                    add_box(FTransform(bounds.GetCenter()), bounds.GetExtent());
+                else
+                    ++left_out;
+            }
+        }
+    }
+    return left_out;
+}
+
+void ASimModeWorldMultiRotor::loadScenario()
+{
+    using namespace msr::airlib;
+
+    scenario_.reset();
+    const auto& settings = SimSettings::singleton().getScenarioSettings();
+    if (settings.file.empty())
+        return;
+
+    std::unique_ptr<Scenario> scenario(new Scenario());
+    try {
+        Settings scenario_file;
+        if (!scenario_file.loadFile(settings.file)) {
+            UAirBlueprintLib::LogMessage(TEXT("Cannot open scenario file: "), FString(settings.file.c_str()), LogDebugLevel::Failure, 30);
+            return;
+        }
+        if (!scenario->load(scenario_file)) {
+            for (const auto& error : scenario->getErrors())
+                UAirBlueprintLib::LogMessage(FString("Invalid scenario: "), FString(error.c_str()), LogDebugLevel::Failure, 30);
+            return;
+        }
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("Cannot parse scenario file: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+        return;
+    }
+
+    scenario_ = std::move(scenario);
+    UAirBlueprintLib::LogMessage(TEXT("Loaded scenario: "), FString(scenario_->getName().c_str()), LogDebugLevel::Informational);
+}
+
+AVehiclePawnBase* ASimModeWorldMultiRotor::spawnScenarioVehicles(const FTransform& start_transform)
+{
+    using namespace msr::airlib;
+
+    scenario_pawns_.clear();
+    scenario_origin_ = start_transform.GetLocation();
+    loadScenario();
+    if (scenario_ == nullptr)
+        return nullptr;
+
+    const float world_to_meters = UAirBlueprintLib::GetWorldToMetersScale(this);
+    FActorSpawnParameters pawn_spawn_params;
+    pawn_spawn_params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+    for (const auto& vehicle : scenario_->getVehicles()) {
+        FTransform transform(FRotator(0, vehicle.yaw, 0),
+            scenario_origin_ + AVehiclePawnBase::toFVector(vehicle.position, world_to_meters, true));
+        AVehiclePawnBase* pawn = this->GetWorld()->SpawnActor<AVehiclePawnBase>(vehicle_pawn_class_, transform, pawn_spawn_params);
+        spawned_actors_.Add(pawn);
+        scenario_pawns_.push_back(pawn);
+    }
+
+    //first one becomes FPV pawn and is initialized with the camera director
+    for (size_t i = 1; i < scenario_pawns_.size(); ++i)
+        scenario_pawns_[i]->initializeForBeginPlay();
+    return scenario_pawns_.size() > 0 ? scenario_pawns_[0] : nullptr;
+}
+
+void ASimModeWorldMultiRotor::setupScenario()
+{
+    using namespace msr::airlib;
+
+    is_scenario_saved_ = false;
+    if (scenario_ == nullptr || command_engine_ == nullptr)
+        return;
+
+    scenario_runner_.reset(new ScenarioRunner(*scenario_, command_engine_));
+    scenario_time_ = ClockFactory::get()->nowNanos();
+    const float world_to_meters = UAirBlueprintLib::GetWorldToMetersScale(this);
+    for (size_t i = 0; i < scenario_pawns_.size(); ++i) {
+        for (const CaptureVehicle& vehicle : capture_vehicles_) {
+            if (vehicle.pawn == scenario_pawns_[i]) {
+                Vector3r origin_offset = AVehiclePawnBase::toVector3r(vehicle.pawn->toNeuUU(Vector3r::Zero()) - scenario_origin_,
+                    1 / world_to_meters, true);
+                scenario_runner_->setVehicle(static_cast<uint>(i), vehicle.controller, origin_offset);
+            }
+        }
+    }
+}
+
+void ASimModeWorldMultiRotor::updateScenario()
+{
+    using namespace msr::airlib;
+
+    if (scenario_runner_ == nullptr)
+        return;
+
+    //vehicles connect to their flight stacks in BeginPlay, so arming waits for first tick
+    if (scenario_runner_->getState() == ScenarioRunner::State::Idle) {
+        try {
+            scenario_runner_->start();
+        }
+        catch (std::exception& ex) {
+            UAirBlueprintLib::LogMessage(TEXT("Cannot start scenario: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+            scenario_runner_->stop(ex.what());
+        }
+    }
+
+    for (size_t i = 0; i < scenario_pawns_.size(); ++i)
+        scenario_runner_->setCollisionCount(static_cast<uint>(i), scenario_pawns_[i]->getCollisonInfo().collison_count);
+    scenario_runner_->tick(static_cast<float>(ClockFactory::get()->updateSince(scenario_time_)));
+
+    if (scenario_runner_->isFinished() && !is_scenario_saved_) {
+        saveScenarioMetrics();
+        if (SimSettings::singleton().getScenarioSettings().exit_on_finish)
+            FGenericPlatformMisc::RequestExit(false);
+    }
+}
+
+void ASimModeWorldMultiRotor::saveScenarioMetrics()
+{
+    is_scenario_saved_ = true;
+    UAirBlueprintLib::LogMessage(TEXT("Scenario: "), FString(scenario_runner_->getReport().c_str()), LogDebugLevel::Informational, 30);
+    try {
+        const auto& settings = msr::airlib::SimSettings::singleton().getScenarioSettings();
+        std::string file_path = common_utils::FileSystem::getLogFileNamePath(settings.metrics_file_prefix, "", ".json", true);
+        std::ofstream file;
+        common_utils::FileSystem::createTextFile(file_path, file);
+        file << scenario_runner_->toJson();
+        UAirBlueprintLib::LogMessage(TEXT("Scenario metrics saved to: "), FString(file_path.c_str()), LogDebugLevel::Informational, 30);
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessage(TEXT("Could not save scenario metrics: "), FString(ex.what()), LogDebugLevel::Failure, 30);
+    }
+}
+
+void ASimModeWorldMultiRotor::setupDetection(AVehiclePawnBase* frame_pawn)
+{
+    using namespace msr::airlib;
+
+    const auto& settings = SimSettings::singleton().getDetectionSettings();
+    if (!settings.enabled || frame_pawn == nullptr)
+        return;
+
+    TargetDetector::Params params;
+    params.min_range = settings.min_range;
+    params.max_range = settings.max_range;
+    params.reliable_range = settings.reliable_range;
+    params.target_radius = settings.target_radius;
+    params.false_negative_rate = settings.false_negative_rate;
+    params.false_positive_rate = settings.false_positive_rate;
+    params.bearing_noise_sigma = Utils::degreesToRadians(settings.bearing_noise_deg);
+    params.range_noise_sigma = settings.range_noise;
+    params.occlusion = settings.occlusion;
+    target_detector_.reset(new TargetDetector(params));
+    detection_period_ = 1 / settings.rate;
+    detection_elapsed_ = 0;
+
+    //cameras don't move relative to pawn so their pose and intrinsics are read once
+    const float world_to_meters = UAirBlueprintLib::GetWorldToMetersScale(this);
+    detection_vehicles_.clear();
+    detection_origins_.clear();
+    for (uint vi = 0; vi < capture_vehicles_.size(); ++vi) {
+        AFlyingPawn* pawn = capture_vehicles_[vi].pawn;
+        TargetDetector::Vehicle vehicle;
+        vehicle.id = static_cast<int>(vi);
+        APIPCamera* camera;
+        for (int camera_id = 0; (camera = pawn->getCamera(camera_id)) != nullptr; ++camera_id) {
+            FTransform relative = camera->GetActorTransform().GetRelativeTransform(pawn->GetActorTransform());
+            TargetDetector::Camera detector_camera;
+            detector_camera.camera_id = camera_id;
+            detector_camera.position = AVehiclePawnBase::toVector3r(relative.GetLocation(), 1 / world_to_meters, true);
+            detector_camera.orientation = AVehiclePawnBase::toQuaternionr(relative.GetRotation(), true);
+            USceneCaptureComponent2D* capture = camera->getCaptureComponent(EPIPCameraType::PIP_CAMERA_TYPE_SCENE, false);
+            if (capture != nullptr) {
+                detector_camera.horizontal_fov = Utils::degreesToRadians(capture->FOVAngle);
+                if (capture->TextureTarget != nullptr) {
+                    detector_camera.width = capture->TextureTarget->SizeX;
+                    detector_camera.height = capture->TextureTarget->SizeY;
+                }
+            }
+            vehicle.cameras.push_back(detector_camera);
+        }
+        detection_vehicles_.push_back(vehicle);
+        //shared frame is the frame pawn's NED frame, same as path planner so its voxel map can be used for occlusion
+        detection_origins_.push_back(frame_pawn->toNedMeters(pawn->toNeuUU(Vector3r::Zero())));
+    }
+}
+
+void ASimModeWorldMultiRotor::updateDetections(float delta_seconds)
+{
+    using namespace msr::airlib;
+
+    if (target_detector_ == nullptr)
+        return;
+    detection_elapsed_ += delta_seconds;
+    if (detection_elapsed_ < detection_period_)
+        return;
+    //don't try to catch up after a long frame
+    detection_elapsed_ = std::fmod(detection_elapsed_, detection_period_);
+
+    for (uint vi = 0; vi < capture_vehicles_.size(); ++vi) {
+        AVehiclePawnBase::Pose pose = capture_vehicles_[vi].pawn->getPose();
+        detection_vehicles_[vi].position = pose.position + detection_origins_[vi];
+        detection_vehicles_[vi].orientation = pose.orientation;
+    }
+
+    if (path_planner_ != nullptr && target_detector_->getParams().occlusion) {
+        path_planner_->readGrid([this](const VoxelGrid& grid) {
+            target_detector_->detect(detection_vehicles_, &grid, detections_);
+        });
+    }
+    else
+        target_detector_->detect(detection_vehicles_, nullptr, detections_);
+
+    //detections come grouped by observer in vehicle order
+    size_t begin = 0;
+    for (uint vi = 0; vi < capture_vehicles_.size(); ++vi) {
+        size_t end = begin;
+        while (end < detections_.size() && detections_[end].observer_id == static_cast<int>(vi))
+            ++end;
+        capture_vehicles_[vi].controller->setDetections(detections_.data() + begin, end - begin);
+        begin = end;
+    }
+}
+
+std::string ASimModeWorldMultiRotor::getReport()
+{
+    std::string report = Super::getReport();
+
+    //vehicle pages, capture_vehicles_ is in same order as vehicles in base class
+    int page = getReportPage();
+    if (page > 0) {
+        uint vi = static_cast<uint>(page - 1);
+        if (vi >= capture_vehicles_.size())
+            return report;
+        const CaptureVehicle& vehicle = capture_vehicles_[vi];
+        const msr::airlib::MpcController* mpc = vehicle.controller->getMpcController();
+        if (mpc != nullptr)
+            report += mpc->getReport();
+        report += vehicle.controller->getReport();
+        if (vehicle.obstacle_mapper != nullptr) {
+            report += msr::airlib::Utils::stringf("Obstacle map: processed %llu, dropped %llu, %.2f ms\n",
+                static_cast<unsigned long long>(vehicle.obstacle_mapper->getProcessedCount()),
+                static_cast<unsigned long long>(vehicle.obstacle_mapper->getDroppedCount()),
+                vehicle.obstacle_mapper->getLastProcessSeconds() * 1E3);
+        }
+        return report;
+    }
+
+    if (dataset_generator_ != nullptr)
+        report += dataset_generator_->getReport();
+    if (path_planner_ != nullptr)
+        report += path_planner_->getReport();
+    if (scenario_runner_ != nullptr)
+        report += scenario_runner_->getReport();
+    if (command_engine_ != nullptr)
+        report += command_engine_->getReport();
+    if (opponent_ai_ != nullptr)
+        report += opponent_ai_->getReport();
+    if (reciprocal_avoidance_ != nullptr)
+        report += reciprocal_avoidance_->getReport();
+    if (target_detector_ != nullptr)
+        report += target_detector_->getReport();
+    if (capture_scheduler_.getStreamCount() > 0)
+        report += capture_scheduler_.getReport();
+    return report;
 }
 
 void ASimModeWorldMultiRotor::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -160,6 +844,25 @@ void ASimModeWorldMultiRotor::EndPlay(const EEndPlayReason::Type EndPlayReason)
     if (fpv_vehicle_connector_ != nullptr) {
         fpv_vehicle_connector_->stopApiServer();
     }
+    //stop commanding vehicles before they go away
+    if (scenario_runner_ != nullptr) {
+        scenario_runner_->stop("Aborted");
+        if (!is_scenario_saved_)
+            saveScenarioMetrics();
+        scenario_runner_.reset();
+    }
+    //flushes frames in flight and cancels its flight command
+    dataset_generator_.reset();
+    if (command_engine_ != nullptr) {
+        removeWorldMember(command_engine_.get());
+        command_engine_->stop();
+        command_engine_.reset();
+    }
+    opponent_ai_.reset();
+    if (reciprocal_avoidance_ != nullptr) {
+        reciprocal_avoidance_->stop();
+        reciprocal_avoidance_.reset();
+    }
 
     if (isLoggingStarted)
     {
@@ -176,6 +879,10 @@ void ASimModeWorldMultiRotor::EndPlay(const EEndPlayReason::Type EndPlayReason)
         CameraDirector = nullptr;
     }
     spawned_actors_.Empty();
+    target_detector_.reset();
+    detection_vehicles_.clear();
+    capture_vehicles_.clear();
+    path_planner_.reset();
 
     Super::EndPlay(EndPlayReason);
 }
@@ -192,7 +899,10 @@ void ASimModeWorldMultiRotor::createVehicles(std::vector<VehiclePtr>& vehicles)
 
     //find vehicles and cameras available in environment
     //if none available then we will create one
-    setupVehiclesAndCamera();
+    {
+        msr::airlib::StartupProfiler::Scope profile("Pawns and camera director");
+        setupVehiclesAndCamera();
+    }
 
     //get FPV drone
     AActor* fpv_pawn = nullptr;
@@ -201,12 +911,14 @@ void ASimModeWorldMultiRotor::createVehicles(std::vector<VehiclePtr>& vehicles)
     }
 
     //detect vehicles in the project and create connector for it
+    msr::airlib::StartupProfiler::Scope profile("Vehicle connectors");
     TArray<AActor*> pawns;
     UAirBlueprintLib::FindAllActor<AFlyingPawn>(this, pawns);
     for (AActor* pawn : pawns) {
         auto vehicle = createVehicle(static_cast<AFlyingPawn*>(pawn));
         if (vehicle != nullptr) {
             vehicles.push_back(vehicle);
+            addCaptureVehicle(static_cast<AFlyingPawn*>(pawn), static_cast<msr::airlib::DroneControllerBase*>(vehicle->getController()));
 
             if (pawn == fpv_pawn) {
                 fpv_vehicle_connector_ = vehicle;
@@ -214,14 +926,24 @@ void ASimModeWorldMultiRotor::createVehicles(std::vector<VehiclePtr>& vehicles)
         }
         //else we don't have vehicle for this pawn
     }
+
+    setupPathPlanner(static_cast<AVehiclePawnBase*>(fpv_pawn));
+    setupOpponents(static_cast<AVehiclePawnBase*>(fpv_pawn));
+    setupReciprocalAvoidance(static_cast<AVehiclePawnBase*>(fpv_pawn));
+    setupDetection(static_cast<AVehiclePawnBase*>(fpv_pawn));
+    setupCommandEngine();
+    setupScenario();
+    setupContinuousCollision(static_cast<AVehiclePawnBase*>(fpv_pawn), vehicles);
+    setupRenderSync(static_cast<AVehiclePawnBase*>(fpv_pawn));
+    setupDataset(static_cast<AVehiclePawnBase*>(fpv_pawn));
 }
 
 ASimModeWorldBase::VehiclePtr ASimModeWorldMultiRotor::createVehicle(AFlyingPawn* pawn)
 {
-    vehicle_params_ = MultiRotorParamsFactory::createConfig(fpv_vehicle_name);
+    vehicle_params_.push_back(MultiRotorParamsFactory::createConfig(fpv_vehicle_name));
 
     auto vehicle = std::make_shared<MultiRotorConnector>();
-    vehicle->initialize(pawn, vehicle_params_.get(), enable_rpc, api_server_address);
+    vehicle->initialize(pawn, vehicle_params_.back().get(), enable_rpc, api_server_address, api_server_port);
     return std::static_pointer_cast<VehicleConnectorBase>(vehicle);
 }
 
@@ -3,7 +3,18 @@
 #include "common/Common.hpp"
 #include "MultiRotorConnector.h"
 #include "vehicles/MultiRotorParams.hpp"
+#include "controllers/DroneControllerBase.hpp"
+#include "common/CaptureScheduler.hpp"
+#include "safety/DepthObstacleMapper.hpp"
+#include "safety/ReciprocalAvoidance.hpp"
+#include "planning/PathPlanner.hpp"
+#include "controllers/OpponentAi.hpp"
+#include "controllers/CommandEngine.hpp"
+#include "physics/CollisionWorld.hpp"
+#include "sensors/detection/TargetDetector.hpp"
+#include "scenario/ScenarioRunner.hpp"
 #include "SimModeWorldBase.h"
+#include "DatasetGenerator.h"
 #include "SimModeWorldMultiRotor.generated.h"
 
 
@@ -18,6 +29,7 @@ public:
 
     virtual void Tick( float DeltaSeconds ) override;
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual std::string getReport() override;
 	std::shared_ptr<VehicleConnectorBase> fpv_vehicle_connector_;
 
 protected:
@@ -27,10 +39,81 @@ protected:
 
 private:
     void setupVehiclesAndCamera();
+    void captureImages();
+    void addCaptureVehicle(AFlyingPawn* pawn, msr::airlib::DroneControllerBase* controller);
+    bool captureImage(const msr::airlib::CaptureScheduler::StreamKey& key);
+    void setupPathPlanner(AVehiclePawnBase* frame_pawn);
+    void fillPathPlannerGrid(AVehiclePawnBase* frame_pawn);
+    void setupOpponents(AVehiclePawnBase* fpv_pawn);
+    void setupReciprocalAvoidance(AVehiclePawnBase* frame_pawn);
+    void setupDetection(AVehiclePawnBase* frame_pawn);
+    void updateDetections(float delta_seconds);
+    void setupCommandEngine();
+    void setupContinuousCollision(AVehiclePawnBase* frame_pawn, const std::vector<VehiclePtr>& vehicles);
+    void setupRenderSync(AVehiclePawnBase* frame_pawn);
+    void setupDataset(AVehiclePawnBase* fpv_pawn);
+    //returns number of colliders that could not be converted to boxes
+    uint addStaticCollisionBoxes(AVehiclePawnBase* frame_pawn, msr::airlib::CollisionWorld& collision_world);
+    void loadScenario();
+    AVehiclePawnBase* spawnScenarioVehicles(const FTransform& start_transform);
+    void setupScenario();
+    void updateScenario();
+    void saveScenarioMetrics();
 
 private:    
     TArray<uint8> image_;
-    std::unique_ptr<msr::airlib::MultiRotorParams> vehicle_params_;
+
+    //who asked for the capture, goes in to stream key
+    enum CaptureConsumer {
+        CaptureForApi = 0,
+        CaptureForObstacleMap = 1
+    };
+
+    //vehicles whose controllers can request images, index is used in capture stream keys
+    struct CaptureVehicle {
+        AFlyingPawn* pawn;
+        msr::airlib::DroneControllerBase* controller;
+        //null if neither obstacle map nor reciprocal avoidance is enabled in settings
+        std::shared_ptr<msr::airlib::SafetyEval> safety_eval;
+        //null if obstacle map is not enabled in settings
+        std::unique_ptr<msr::airlib::DepthObstacleMapper> obstacle_mapper;
+        int obstacle_map_camera_id;
+        float obstacle_map_rate;
+    };
+    std::vector<CaptureVehicle> capture_vehicles_;
+    std::vector<msr::airlib::DroneControllerBase::ImageRequest> image_requests_;
+    std::vector<float> depth_buffer_;
+    msr::airlib::CaptureScheduler capture_scheduler_;
+    //shared by all vehicles, in NED frame of the FPV vehicle; null if path planning is not enabled in settings
+    std::shared_ptr<msr::airlib::PathPlanner> path_planner_;
+    //steps non-blocking API commands of all vehicles with physics
+    std::shared_ptr<msr::airlib::CommandEngine> command_engine_;
+    //null if no scenario file is set or it could not be loaded
+    std::unique_ptr<msr::airlib::Scenario> scenario_;
+    std::unique_ptr<msr::airlib::ScenarioRunner> scenario_runner_;
+    //simulation clock at last scenario tick, runs faster than frame time with ClockSpeed above 1
+    msr::airlib::TTimePoint scenario_time_;
+    //pawn spawned for each scenario vehicle, in scenario order
+    std::vector<AVehiclePawnBase*> scenario_pawns_;
+    //player start, origin of scenario frame
+    FVector scenario_origin_;
+    bool is_scenario_saved_;
+    //continuous collision is on and its static world has every collider that blocks pawns
+    bool is_static_world_complete_ = false;
+    //null if opponents are not enabled in settings
+    std::unique_ptr<msr::airlib::OpponentAi> opponent_ai_;
+    //null if reciprocal avoidance is not enabled in settings, shared with SafetyEval of each vehicle
+    std::shared_ptr<msr::airlib::ReciprocalAvoidance> reciprocal_avoidance_;
+    //null if detection is not enabled in settings, vehicles are in same order as capture_vehicles_
+    std::unique_ptr<msr::airlib::TargetDetector> target_detector_;
+    std::vector<msr::airlib::TargetDetector::Vehicle> detection_vehicles_;
+    std::vector<msr::airlib::Vector3r> detection_origins_;
+    std::vector<msr::airlib::TargetDetector::Detection> detections_;
+    float detection_period_, detection_elapsed_;
+    //null if dataset generation is not enabled in settings or could not start
+    std::unique_ptr<DatasetGenerator> dataset_generator_;
+    //each vehicle connector keeps pointer to its params so they must outlive connectors
+    std::vector<std::unique_ptr<msr::airlib::MultiRotorParams>> vehicle_params_;
 	bool isLoggingStarted;
 
     UClass* external_camera_class_;
@@ -12,7 +12,8 @@ public:
 
     //pure abstract methods in addition to UpdatableObject
 
-    //called when game starts
+    //called when game starts, may run on worker thread in parallel with other
+    //vehicles so it must not use game thread only APIs such as on-screen logging
     virtual void beginPlay() = 0;
     //called when game ends
     virtual void endPlay() = 0;
@@ -1,9 +1,11 @@
 #include "AirSim.h"
 #include "VehiclePawnBase.h"
 #include "AirBlueprintLib.h"
+#include "VehicleTrailComponent.h"
 
 
 AVehiclePawnBase::AVehiclePawnBase()
+    : trail_(nullptr), debug_trail_(nullptr), sweep_enabled_(true)
 {
     static ConstructorHelpers::FObjectFinder<UParticleSystem> collison_display(TEXT("ParticleSystem'/AirSim/StarterContent/Particles/P_Explosion.P_Explosion'"));
     if (!collison_display.Succeeded())
@@ -24,6 +26,7 @@ void AVehiclePawnBase::BeginPlay()
 
 void AVehiclePawnBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+    clearTrails();
     state_ = initial_state_ = State();
 
     Super::EndPlay(EndPlayReason);
@@ -68,8 +71,6 @@ void AVehiclePawnBase::initialize()
     ground_trace_end = initial_state_.ground_offset + ground_margin; 
 
     initial_state_.start_location = getPosition();
-    initial_state_.last_position = initial_state_.start_location;
-    initial_state_.last_debug_position = initial_state_.start_location;
     initial_state_.start_rotation = getOrientation();
 
     initial_state_.tracing_enabled = EnableTrace;
@@ -82,6 +83,7 @@ void AVehiclePawnBase::initialize()
     initial_state_.was_last_move_teleport = false;
     initial_state_.was_last_move_teleport = canTeleportWhileMove();
 
+    setupTrails();
     reset();
 }
 
@@ -97,6 +99,12 @@ APIPCamera* AVehiclePawnBase::getFpvCamera()
     return nullptr;
 }
 
+APIPCamera* AVehiclePawnBase::getCamera(int id)
+{
+    //derived class with more cameras should override this
+    return id == 0 ? getFpvCamera() : nullptr;
+}
+
 void AVehiclePawnBase::reset()
 {
     state_ = initial_state_;
@@ -150,11 +158,33 @@ void AVehiclePawnBase::toggleTrace()
     state_.tracing_enabled = !state_.tracing_enabled;
 
     if (!state_.tracing_enabled)
-        FlushPersistentDebugLines(this->GetWorld());
-    else {     
+        clearTrails();
+    else
         state_.debug_position_offset = state_.current_debug_position - state_.current_position;
-        state_.last_debug_position = state_.last_position;
+}
+
+void AVehiclePawnBase::setupTrails()
+{
+    if (trail_ == nullptr) {
+        trail_ = NewObject<UVehicleTrailComponent>(this);
+        trail_->RegisterComponent();
     }
+    if (debug_trail_ == nullptr) {
+        debug_trail_ = NewObject<UVehicleTrailComponent>(this);
+        debug_trail_->RegisterComponent();
+    }
+
+    float min_segment = TraceMinSegment * world_to_meters;
+    trail_->setup(TraceMaxPoints, min_segment, FColor::Purple, 10.0f);
+    debug_trail_->setup(TraceMaxPoints, min_segment, FColor(0xaa, 0x33, 0x11), 10.0f);
+}
+
+void AVehiclePawnBase::clearTrails()
+{
+    if (trail_ != nullptr)
+        trail_->clearTrail();
+    if (debug_trail_ != nullptr)
+        debug_trail_->clearTrail();
 }
 
 void AVehiclePawnBase::allowPassthroughToggleInput()
@@ -202,40 +232,40 @@ void AVehiclePawnBase::setPose(const Pose& pose, const Pose& debug_pose)
     //quaternion formula comes from http://stackoverflow.com/a/40334755/207661
     FQuat orientation = toFQuat(pose.orientation, true);
 
-    bool enable_teleport = canTeleportWhileMove();
+    bool enable_teleport = !sweep_enabled_ || canTeleportWhileMove();
 
     //must reset collison before we set pose. Setting pose will immediately call NotifyHit if there was collison
     //if there was no collison than has_collided would remain false, else it will be set so its value can be
     //checked at the start of next tick
     state_.collison_info.has_collided = false;
-    state_.was_last_move_teleport = enable_teleport;
-
-    if (enable_teleport)
-        this->SetActorLocationAndRotation(position, orientation, false, nullptr, ETeleportType::TeleportPhysics);
-    else
-        this->SetActorLocationAndRotation(position, orientation, true);
 
-    if (state_.tracing_enabled && (state_.last_position - position).SizeSquared() > 0.25) {
-        DrawDebugLine(this->GetWorld(), state_.last_position, position, FColor::Purple, true, -1.0F, 0, 10.0F);
-        state_.last_position = position;
-    }
-    else if (!state_.tracing_enabled) {
-        state_.last_position = position;
+    //parked vehicles don't move, skip updating transforms of all their components
+    bool is_moved = !position.Equals(this->GetActorLocation(), 1E-3f) || !orientation.Equals(this->GetActorQuat(), 1E-6f);
+    if (is_moved) {
+        state_.was_last_move_teleport = enable_teleport;
+        if (enable_teleport)
+            this->SetActorLocationAndRotation(position, orientation, false, nullptr, ETeleportType::TeleportPhysics);
+        else
+            this->SetActorLocationAndRotation(position, orientation, true);
     }
+
+    //trails drop points closer than TraceMinSegment and overwrite their oldest segments when full
+    if (state_.tracing_enabled && trail_ != nullptr)
+        trail_->addPoint(position);
+
     state_.current_debug_position = toNeuUU(debug_pose.position);
-    if (state_.tracing_enabled && !VectorMath::hasNan(debug_pose.position)) {
+    if (state_.tracing_enabled && debug_trail_ != nullptr && !VectorMath::hasNan(debug_pose.position)) {
         FVector debug_position = state_.current_debug_position - state_.debug_position_offset;
-        if ((state_.last_debug_position - debug_position).SizeSquared() > 0.25) {
-            DrawDebugLine(this->GetWorld(), state_.last_debug_position, debug_position, FColor(0xaa, 0x33, 0x11), true, -1.0F, 0, 10.0F);
+        if (debug_trail_->addPoint(debug_position))
             UAirBlueprintLib::LogMessage("Debug Pose: ", debug_position.ToCompactString(), LogDebugLevel::Informational);
-            state_.last_debug_position = debug_position;
-        }
-    }
-    else if (!state_.tracing_enabled) {
-        state_.last_debug_position = state_.current_debug_position - state_.debug_position_offset;
     }
 }
 
+void AVehiclePawnBase::setSweepEnabled(bool enabled)
+{
+    sweep_enabled_ = enabled;
+}
+
 bool AVehiclePawnBase::canTeleportWhileMove()  const
 {
     //allow teleportation
@@ -255,6 +285,16 @@ AVehiclePawnBase::real_T AVehiclePawnBase::getMinZOverGround() const
         return Utils::max<float>();
 }
 
+AVehiclePawnBase::real_T AVehiclePawnBase::getGroundZ(real_T max_distance) const
+{
+    FVector location = this->GetActorLocation();
+    FHitResult hit;
+    if (UAirBlueprintLib::GetObstacle(this, location, location - FVector(0, 0, max_distance * world_to_meters), hit))
+        return toNedMeters(hit.ImpactPoint).z();
+    else
+        return Utils::nan<real_T>();
+}
+
 FVector AVehiclePawnBase::toFVector(const Vector3r& vec, float scale, bool convert_from_ned)
 {
     return FVector(vec.x() * scale, vec.y() * scale, 
@@ -42,6 +42,12 @@ public: //modifiable properties
     //trace settings
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debugging")
     bool EnableTrace = false; 
+    //oldest points are dropped once trace has this many
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debugging")
+    int32 TraceMaxPoints = 2000;
+    //meters vehicle must move before next trace point is added
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debugging")
+    float TraceMinSegment = 0.1f;
 
     UFUNCTION(BlueprintCallable, Category = "Debugging")
     void toggleTrace();
@@ -62,17 +68,24 @@ public: //interface
     virtual void reset();
     UFUNCTION(BlueprintCallable, Category = "Camera")
     virtual APIPCamera* getFpvCamera();
+    //camera ids used by image APIs, 0 is FPV camera, returns nullptr for unknown id
+    UFUNCTION(BlueprintCallable, Category = "Camera")
+    virtual APIPCamera* getCamera(int id = 0);
     virtual void displayCollisonEffect(FVector hit_location, const FHitResult& hit);
 
     //get/set pose
     //parameters in NED frame
     Pose getPose() const;
     void setPose(const Pose& pose, const Pose& debug_pose);
+    //when disabled pawn is always teleported, for use when physics detects collisions on its own
+    void setSweepEnabled(bool enabled);
     FVector getPosition() const;
     FRotator getOrientation() const;
 
     //get configurations
     real_T getMinZOverGround() const;
+    //NED z of first hit straight below the vehicle within max_distance meters, NaN if none
+    real_T getGroundZ(real_T max_distance) const;
     const GeoPoint& getHomePoint() const;
     const CollisionInfo& getCollisonInfo() const;
 
@@ -87,10 +100,16 @@ public: //interface
 protected:
     UPROPERTY(VisibleAnywhere)
         UParticleSystem* collison_display_template;
+    UPROPERTY()
+        class UVehicleTrailComponent* trail_;
+    UPROPERTY()
+        class UVehicleTrailComponent* debug_trail_;
 
 private: //methods
     bool canTeleportWhileMove()  const;
     void allowPassthroughToggleInput();
+    void setupTrails();
+    void clearTrails();
 
     //these methods are for future usage
     void plot(std::istream& s, FColor color, const Vector3r& offset);
@@ -101,12 +120,11 @@ private: //vars
     FVector ground_margin;
     float world_to_meters;
     GeoPoint home_point;
+    bool sweep_enabled_;
 
     struct State {
         FVector start_location;
         FRotator start_rotation;
-        FVector last_position;
-        FVector last_debug_position;
         FVector current_position;
         FVector current_debug_position;
         FVector debug_position_offset;        
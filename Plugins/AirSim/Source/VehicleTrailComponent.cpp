@@ -0,0 +1,56 @@
+#include "AirSim.h"
+#include "VehicleTrailComponent.h"
+
+
+UVehicleTrailComponent::UVehicleTrailComponent()
+{
+    //base class ticks only to expire lines with lifetime, ours never expire
+    PrimaryComponentTick.bCanEverTick = false;
+
+    setup(2000, 10.0f, FColor::Purple, 10.0f);
+}
+
+void UVehicleTrailComponent::setup(int32 max_points, float min_segment, const FColor& color, float thickness)
+{
+    max_segments_ = FMath::Max(max_points - 1, 1);
+    min_segment_sq_ = min_segment * min_segment;
+    color_ = FLinearColor(color);
+    thickness_ = thickness;
+
+    clearTrail();
+    BatchedLines.Reserve(max_segments_);
+}
+
+bool UVehicleTrailComponent::addPoint(const FVector& point)
+{
+    if (!has_last_point_) {
+        last_point_ = point;
+        has_last_point_ = true;
+        return true;
+    }
+    if ((point - last_point_).SizeSquared() <= min_segment_sq_)
+        return false;
+
+    FBatchedLine segment(last_point_, point, color_, 0, thickness_, SDPG_World);
+    if (BatchedLines.Num() < max_segments_)
+        BatchedLines.Add(segment);
+    else
+        BatchedLines[next_segment_] = segment;
+    next_segment_ = (next_segment_ + 1) % max_segments_;
+    last_point_ = point;
+
+    MarkRenderStateDirty();
+    return true;
+}
+
+void UVehicleTrailComponent::clearTrail()
+{
+    has_last_point_ = false;
+    next_segment_ = 0;
+    Flush();
+}
+
+int32 UVehicleTrailComponent::getSegmentCount() const
+{
+    return BatchedLines.Num();
+}
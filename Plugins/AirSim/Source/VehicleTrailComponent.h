@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Components/LineBatchComponent.h"
+#include "VehicleTrailComponent.generated.h"
+
+/*
+    Trail of one vehicle drawn as a single line batch. Segments are kept in a
+    fixed size ring directly in BatchedLines: once the ring is full every new
+    segment overwrites the oldest one, so memory and draw cost stay the same
+    no matter how long tracing is on. Points closer than min_segment to the
+    last one are dropped.
+
+    Lines are world space and never expire on their own, the owner clears
+    the trail instead of flushing persistent debug lines of the whole world.
+*/
+UCLASS()
+class AIRSIM_API UVehicleTrailComponent : public ULineBatchComponent
+{
+    GENERATED_BODY()
+
+public:
+    UVehicleTrailComponent();
+
+    //max_points includes the current end of the trail, min_segment is in Unreal units
+    void setup(int32 max_points, float min_segment, const FColor& color, float thickness);
+    //returns true if point was far enough from last point to be added
+    bool addPoint(const FVector& point);
+    void clearTrail();
+
+    int32 getSegmentCount() const;
+
+private:
+    FVector last_point_;
+    bool has_last_point_;
+    int32 max_segments_;
+    int32 next_segment_;
+    float min_segment_sq_;
+    FLinearColor color_;
+    float thickness_;
+};